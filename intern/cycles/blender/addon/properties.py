@@ -57,6 +57,7 @@ enum_displacement_methods = (
 
 enum_bvh_layouts = (
     ('BVH2', "BVH2", "", 1),
+    ('BVH4', "BVH4", "", 32),
     ('EMBREE', "Embree", "", 4),
 )
 
@@ -385,6 +386,12 @@ class CyclesRenderSettings(bpy.types.PropertyGroup):
         description="Sample all lights (for indirect samples), rather than randomly picking one",
         default=True,
     )
+    use_light_tree: BoolProperty(
+        name="Light Tree",
+        description="Pick lights based on their distance and orientation to the shading point, "
+        "which reduces noise in scenes with many lights (only used for path tracing)",
+        default=False,
+    )
     light_sampling_threshold: FloatProperty(
         name="Light Sampling Threshold",
         description="Probabilistically terminate light samples when the light contribution is below this threshold (more noise but faster rendering). "
@@ -678,6 +685,20 @@ class CyclesRenderSettings(bpy.types.PropertyGroup):
         items=enum_bvh_types,
         default='DYNAMIC_BVH',
     )
+    use_texture_cache: BoolProperty(
+        name="Texture Cache",
+        description="Load tiled and mipmapped images (such as .tx files) on demand through a texture cache, "
+        "instead of fully loading them into memory (CPU only)",
+        default=False,
+    )
+    texture_cache_size: IntProperty(
+        name="Texture Cache Size",
+        description="Maximum memory used by the texture cache, in megabytes",
+        min=64, max=1048576,
+        default=4096,
+        subtype='UNSIGNED',
+    )
+
     debug_use_spatial_splits: BoolProperty(
         name="Use Spatial Splits",
         description="Use BVH spatial splits: longer builder time, faster render",
@@ -68,6 +68,9 @@ BlenderSession::BlenderSession(BL::RenderEngine &b_engine,
       b_render(b_engine.render()),
       b_depsgraph(PointerRNA_NULL),
       b_scene(PointerRNA_NULL),
+      synced_depsgraph(NULL),
+      synced_scene(NULL),
+      synced_view_layer(NULL),
       b_v3d(PointerRNA_NULL),
       b_rv3d(PointerRNA_NULL),
       width(0),
@@ -98,6 +101,9 @@ BlenderSession::BlenderSession(BL::RenderEngine &b_engine,
       b_render(b_engine.render()),
       b_depsgraph(PointerRNA_NULL),
       b_scene(PointerRNA_NULL),
+      synced_depsgraph(NULL),
+      synced_scene(NULL),
+      synced_view_layer(NULL),
       b_v3d(b_v3d),
       b_rv3d(b_rv3d),
       width(width),
@@ -179,6 +185,16 @@ void BlenderSession::reset_session(BL::BlendData &b_data, BL::Depsgraph &b_depsg
     sync->reset(this->b_data, this->b_scene);
   }
 
+  /* With persistent data Blender keeps the dependency graph between frames, and its recalc
+   * flags tell what changed since the previous render. Any other depsgraph, for example of
+   * another view layer, has no relation to the synced data. */
+  const bool is_same_depsgraph = b_depsgraph.ptr.data == synced_depsgraph &&
+                                 b_depsgraph.scene().ptr.data == synced_scene &&
+                                 b_depsgraph.view_layer().ptr.data == synced_view_layer;
+  synced_depsgraph = b_depsgraph.ptr.data;
+  synced_scene = b_depsgraph.scene().ptr.data;
+  synced_view_layer = b_depsgraph.view_layer().ptr.data;
+
   if (preview_osl) {
     PointerRNA cscene = RNA_pointer_get(&b_scene.ptr, "cycles");
     RNA_boolean_set(&cscene, "shading_system", preview_osl);
@@ -225,7 +241,6 @@ void BlenderSession::reset_session(BL::BlendData &b_data, BL::Depsgraph &b_depsg
   }
 
   session->progress.reset();
-  scene->reset();
 
   session->tile_manager.set_tile_order(session_params.tile_order);
 
@@ -234,12 +249,18 @@ void BlenderSession::reset_session(BL::BlendData &b_data, BL::Depsgraph &b_depsg
    */
   session->stats.mem_peak = session->stats.mem_used;
 
-  /* There is no single depsgraph to use for the entire render.
-   * See note on create_session().
-   */
-  /* sync object should be re-created */
-  delete sync;
-  sync = new BlenderSync(b_engine, b_data, b_scene, scene, !background, session->progress);
+  /* Only sync data that changed since the previous frame, the rest of the scene, its BVH and
+   * images stay on the device. Otherwise the scene is reset and the sync object re-created. */
+  if (is_same_depsgraph) {
+    BL::SpaceView3D b_null_space_view3d(PointerRNA_NULL);
+    sync->sync_recalc(b_depsgraph, b_null_space_view3d);
+  }
+  else if (!is_new_session) {
+    scene->reset();
+
+    delete sync;
+    sync = new BlenderSync(b_engine, b_data, b_scene, scene, !background, session->progress);
+  }
 
   BL::SpaceView3D b_null_space_view3d(PointerRNA_NULL);
   BL::RegionView3D b_null_region_view3d(PointerRNA_NULL);
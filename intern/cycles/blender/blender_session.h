@@ -107,6 +107,11 @@ class BlenderSession {
    * free_blender_memory_if_possible().
    */
   BL::Scene b_scene;
+  /* Dependency graph the scene was last synchronized from, and the original scene and view
+   * layer it was built for. Used to detect changes between frames with persistent data. */
+  void *synced_depsgraph;
+  void *synced_scene;
+  void *synced_view_layer;
   BL::SpaceView3D b_v3d;
   BL::RegionView3D b_rv3d;
   string b_rlay_name;
@@ -311,6 +311,7 @@ void BlenderSync::sync_integrator()
   integrator->set_sample_all_lights_direct(get_boolean(cscene, "sample_all_lights_direct"));
   integrator->set_sample_all_lights_indirect(get_boolean(cscene, "sample_all_lights_indirect"));
   integrator->set_light_sampling_threshold(get_float(cscene, "light_sampling_threshold"));
+  integrator->set_use_light_tree(get_boolean(cscene, "use_light_tree"));
 
   SamplingPattern sampling_pattern = (SamplingPattern)get_enum(
       cscene, "sampling_pattern", SAMPLING_NUM_PATTERNS, SAMPLING_PATTERN_SOBOL);
@@ -741,7 +742,10 @@ void BlenderSync::free_data_after_sync(BL::Depsgraph &b_depsgraph)
                                /* Baking re-uses the depsgraph multiple times, clearing crashes
                                 * reading un-evaluated mesh data which isn't aligned with the
                                 * geometry we're baking, see T71012. */
-                               !scene->bake_manager->get_baking();
+                               !scene->bake_manager->get_baking() &&
+                               /* Persistent data keeps the dependency graph for the next frame,
+                                * where unchanged objects are not evaluated again. */
+                               !scene->params.persistent_data;
   if (!can_free_caches) {
     return;
   }
@@ -767,6 +771,8 @@ SceneParams BlenderSync::get_scene_params(BL::Scene &b_scene, bool background)
   else if (shadingsystem == 1)
     params.shadingsystem = SHADINGSYSTEM_OSL;
 
+  /* With persistent data the static BVH is kept as well. Geometry with an applied transform is
+   * synced again when its object moves, see sync_geometry(). */
   if (background || DebugFlags().viewport_static_bvh)
     params.bvh_type = SceneParams::BVH_STATIC;
   else
@@ -800,6 +806,9 @@ SceneParams BlenderSync::get_scene_params(BL::Scene &b_scene, bool background)
     params.texture_limit = 0;
   }
 
+  params.use_texture_cache = get_boolean(cscene, "use_texture_cache");
+  params.texture_cache_size = get_int(cscene, "texture_cache_size");
+
   params.bvh_layout = DebugFlags().cpu.bvh_layout;
 
   params.background = background;
@@ -26,7 +26,10 @@
 #include "bvh/bvh_unaligned.h"
 
 #include "util/util_foreach.h"
+#include "util/util_logging.h"
+#include "util/util_map.h"
 #include "util/util_progress.h"
+#include "util/util_task.h"
 
 CCL_NAMESPACE_BEGIN
 
@@ -42,7 +45,12 @@ int BVHStackEntry::encodeIdx() const
 BVH2::BVH2(const BVHParams &params_,
            const vector<Geometry *> &geometry_,
            const vector<Object *> &objects_)
-    : BVH(params_, geometry_, objects_)
+    : BVH(params_, geometry_, objects_),
+      top_level_prims_size(0),
+      top_level_nodes_size(0),
+      top_level_leaf_nodes_size(0),
+      build_sah_cost(0.0f),
+      refit_sah_cost(0.0f)
 {
 }
 
@@ -67,6 +75,13 @@ void BVH2::build(Progress &progress, Stats *)
     return;
   }
 
+  if (params.top_level) {
+    traceable_objects.resize(objects.size());
+    for (size_t i = 0; i < objects.size(); i++) {
+      traceable_objects[i] = objects[i]->is_traceable();
+    }
+  }
+
   /* BVH builder returns tree in a binary mode (with two children per inner
    * node. Need to adopt that for a wider BVH implementations. */
   BVHNode *root = widen_children_nodes(bvh2_root);
@@ -81,6 +96,11 @@ void BVH2::build(Progress &progress, Stats *)
     return;
   }
 
+  /* Remember the build state, to detect when refitting is no longer possible or efficient.
+   * Computed on the widened hierarchy, which is the one refit works on. */
+  build_sah_cost = root->computeSubtreeSAHCost(params);
+  refit_sah_cost = build_sah_cost;
+
   /* pack triangles */
   progress.set_substatus("Packing BVH triangles and strands");
   pack_primitives();
@@ -100,6 +120,20 @@ void BVH2::build(Progress &progress, Stats *)
 
 void BVH2::refit(Progress &progress)
 {
+  if (params.top_level) {
+    /* Objects entering or leaving the BVH change the primitives, which refit can not handle. */
+    for (size_t i = 0; i < objects.size(); i++) {
+      if (i >= traceable_objects.size() || traceable_objects[i] != objects[i]->is_traceable()) {
+        VLOG(1) << "Traceable objects changed, rebuilding BVH.";
+        build(progress, NULL);
+        return;
+      }
+    }
+
+    /* Instances are merged again from their own BVH once the top level is refit. */
+    unpack_instances();
+  }
+
   progress.set_substatus("Packing BVH primitives");
   pack_primitives();
 
@@ -108,6 +142,22 @@ void BVH2::refit(Progress &progress)
 
   progress.set_substatus("Refitting BVH nodes");
   refit_nodes();
+
+  if (refit_need_rebuild()) {
+    VLOG(1) << "BVH SAH cost increased from " << build_sah_cost << " to " << refit_sah_cost
+            << " after refit, rebuilding BVH.";
+    build(progress, NULL);
+    return;
+  }
+
+  if (params.top_level) {
+    pack_instances(top_level_nodes_size, top_level_leaf_nodes_size);
+  }
+}
+
+bool BVH2::refit_need_rebuild() const
+{
+  return refit_sah_cost > build_sah_cost * params.refit_sah_threshold;
 }
 
 BVHNode *BVH2::widen_children_nodes(const BVHNode *root)
@@ -240,6 +290,24 @@ void BVH2::pack_unaligned_node(int idx,
   memcpy(&pack.nodes[idx], data, sizeof(float4) * BVH_UNALIGNED_NODE_SIZE);
 }
 
+void BVH2::resize_nodes(size_t nodes_size, size_t leaf_nodes_size)
+{
+  /* Resize arrays */
+  pack.nodes.clear();
+  pack.leaf_nodes.clear();
+  /* For top level BVH, first merge existing BVH's so we know the offsets. */
+  if (params.top_level) {
+    top_level_prims_size = pack.prim_index.size();
+    top_level_nodes_size = nodes_size;
+    top_level_leaf_nodes_size = leaf_nodes_size;
+    pack_instances(nodes_size, leaf_nodes_size);
+  }
+  else {
+    pack.nodes.resize(nodes_size);
+    pack.leaf_nodes.resize(leaf_nodes_size);
+  }
+}
+
 void BVH2::pack_nodes(const BVHNode *root)
 {
   const size_t num_nodes = root->getSubtreeSize(BVH_STAT_NODE_COUNT);
@@ -255,17 +323,7 @@ void BVH2::pack_nodes(const BVHNode *root)
   else {
     node_size = num_inner_nodes * BVH_NODE_SIZE;
   }
-  /* Resize arrays */
-  pack.nodes.clear();
-  pack.leaf_nodes.clear();
-  /* For top level BVH, first merge existing BVH's so we know the offsets. */
-  if (params.top_level) {
-    pack_instances(node_size, num_leaf_nodes * BVH_NODE_LEAF_SIZE);
-  }
-  else {
-    pack.nodes.resize(node_size);
-    pack.leaf_nodes.resize(num_leaf_nodes * BVH_NODE_LEAF_SIZE);
-  }
+  resize_nodes(node_size, num_leaf_nodes * BVH_NODE_LEAF_SIZE);
 
   int nextNodeIdx = 0, nextLeafNodeIdx = 0;
 
@@ -315,14 +373,68 @@ void BVH2::pack_nodes(const BVHNode *root)
 
 void BVH2::refit_nodes()
 {
-  assert(!params.top_level);
+  /* Split the hierarchy breadth first into independent subtrees. Children always come after
+   * their parent in the resulting list of inner nodes. */
+  const size_t num_subtrees = TaskScheduler::num_threads() * 4;
+  vector<int> inner_nodes;
+  vector<int> subtrees;
+  subtrees.push_back((pack.root_index == -1) ? -1 : 0);
+
+  while (subtrees.size() < num_subtrees) {
+    vector<int> next_subtrees;
+    next_subtrees.reserve(subtrees.size() * BVH_MAX_NODE_CHILDREN);
+
+    foreach (int child, subtrees) {
+      if (child < 0) {
+        next_subtrees.push_back(child);
+      }
+      else {
+        inner_nodes.push_back(child);
+        int children[BVH_MAX_NODE_CHILDREN];
+        const int num_children = get_inner_node_children(child, children);
+        next_subtrees.insert(next_subtrees.end(), children, children + num_children);
+      }
+    }
+
+    if (next_subtrees.size() == subtrees.size()) {
+      break;
+    }
+    subtrees.swap(next_subtrees);
+  }
+
+  /* Refit the subtrees in parallel. */
+  vector<BVHRefitNode> subtree_nodes(subtrees.size());
+  parallel_for(blocked_range<size_t>(0, subtrees.size(), 1), [&](const blocked_range<size_t> &r) {
+    for (size_t i = r.begin(); i != r.end(); i++) {
+      const int child = subtrees[i];
+      refit_node((child < 0) ? -child - 1 : child, (child < 0), subtree_nodes[i]);
+    }
+  });
+
+  /* Refit the nodes above the subtrees bottom-up, nodes are identified by their encoded child
+   * index so leaves and inner nodes do not collide. */
+  unordered_map<int, BVHRefitNode> refit_results;
+  for (size_t i = 0; i < subtrees.size(); i++) {
+    refit_results[subtrees[i]] = subtree_nodes[i];
+  }
 
-  BoundBox bbox = BoundBox::empty;
-  uint visibility = 0;
-  refit_node(0, (pack.root_index == -1) ? true : false, bbox, visibility);
+  for (int i = (int)inner_nodes.size() - 1; i >= 0; i--) {
+    const int idx = inner_nodes[i];
+    int children[BVH_MAX_NODE_CHILDREN];
+    BVHRefitNode child_nodes[BVH_MAX_NODE_CHILDREN];
+    const int num_children = get_inner_node_children(idx, children);
+    for (int j = 0; j < num_children; j++) {
+      child_nodes[j] = refit_results[children[j]];
+    }
+    refit_inner_node(idx, child_nodes, num_children, refit_results[idx]);
+  }
+
+  const BVHRefitNode &root = refit_results[(pack.root_index == -1) ? -1 : 0];
+  const float root_area = root.bounds.safe_area();
+  refit_sah_cost = (root_area > 0.0f) ? root.sah_cost / root_area : 0.0f;
 }
 
-void BVH2::refit_node(int idx, bool leaf, BoundBox &bbox, uint &visibility)
+void BVH2::refit_node(int idx, bool leaf, BVHRefitNode &node)
 {
   if (leaf) {
     /* refit leaf node */
@@ -331,42 +443,92 @@ void BVH2::refit_node(int idx, bool leaf, BoundBox &bbox, uint &visibility)
     const int c0 = data[0].x;
     const int c1 = data[0].y;
 
-    refit_primitives(c0, c1, bbox, visibility);
+    /* Object instances in the top level store their inverted primitive index. */
+    const int start = (c0 < 0) ? ~c0 : c0;
+    const int end = (c0 < 0) ? start + 1 : c1;
+
+    refit_primitives(start, end, node.bounds, node.visibility);
+    node.sah_cost = node.bounds.safe_area() * params.primitive_cost(end - start);
 
     /* TODO(sergey): De-duplicate with pack_leaf(). */
     float4 leaf_data[BVH_NODE_LEAF_SIZE];
     leaf_data[0].x = __int_as_float(c0);
     leaf_data[0].y = __int_as_float(c1);
-    leaf_data[0].z = __uint_as_float(visibility);
+    leaf_data[0].z = __uint_as_float(node.visibility);
     leaf_data[0].w = __uint_as_float(data[0].w);
     memcpy(&pack.leaf_nodes[idx], leaf_data, sizeof(float4) * BVH_NODE_LEAF_SIZE);
   }
   else {
-    assert(idx + BVH_NODE_SIZE <= pack.nodes.size());
-
-    const int4 *data = &pack.nodes[idx];
-    const bool is_unaligned = (data[0].x & PATH_RAY_NODE_UNALIGNED) != 0;
-    const int c0 = data[0].z;
-    const int c1 = data[0].w;
     /* refit inner node, set bbox from children */
-    BoundBox bbox0 = BoundBox::empty, bbox1 = BoundBox::empty;
-    uint visibility0 = 0, visibility1 = 0;
-
-    refit_node((c0 < 0) ? -c0 - 1 : c0, (c0 < 0), bbox0, visibility0);
-    refit_node((c1 < 0) ? -c1 - 1 : c1, (c1 < 0), bbox1, visibility1);
+    int children[BVH_MAX_NODE_CHILDREN];
+    BVHRefitNode child_nodes[BVH_MAX_NODE_CHILDREN];
+    const int num_children = get_inner_node_children(idx, children);
 
-    if (is_unaligned) {
-      Transform aligned_space = transform_identity();
-      pack_unaligned_node(
-          idx, aligned_space, aligned_space, bbox0, bbox1, c0, c1, visibility0, visibility1);
-    }
-    else {
-      pack_aligned_node(idx, bbox0, bbox1, c0, c1, visibility0, visibility1);
+    for (int i = 0; i < num_children; i++) {
+      const int c = children[i];
+      refit_node((c < 0) ? -c - 1 : c, (c < 0), child_nodes[i]);
     }
 
-    bbox.grow(bbox0);
-    bbox.grow(bbox1);
-    visibility = visibility0 | visibility1;
+    refit_inner_node(idx, child_nodes, num_children, node);
+  }
+}
+
+void BVH2::refit_inner_node(int idx,
+                            const BVHRefitNode *children,
+                            int num_children,
+                            BVHRefitNode &node)
+{
+  repack_inner_node(idx, children, num_children);
+
+  node.bounds = BoundBox::empty;
+  node.visibility = 0;
+  node.sah_cost = 0.0f;
+  for (int i = 0; i < num_children; i++) {
+    node.bounds.grow(children[i].bounds);
+    node.visibility |= children[i].visibility;
+    node.sah_cost += children[i].sah_cost;
+  }
+  node.sah_cost += node.bounds.safe_area() * params.node_cost(num_children);
+}
+
+int BVH2::get_inner_node_children(int idx, int children[BVH_MAX_NODE_CHILDREN]) const
+{
+  assert(idx + BVH_NODE_SIZE <= pack.nodes.size());
+  children[0] = pack.nodes[idx].z;
+  children[1] = pack.nodes[idx].w;
+  return 2;
+}
+
+void BVH2::repack_inner_node(int idx, const BVHRefitNode *children, int num_children)
+{
+  assert(num_children == 2);
+  (void)num_children;
+
+  const int4 *data = &pack.nodes[idx];
+  const bool is_unaligned = (data[0].x & PATH_RAY_NODE_UNALIGNED) != 0;
+  const int c0 = data[0].z;
+  const int c1 = data[0].w;
+
+  if (is_unaligned) {
+    Transform aligned_space = transform_identity();
+    pack_unaligned_node(idx,
+                        aligned_space,
+                        aligned_space,
+                        children[0].bounds,
+                        children[1].bounds,
+                        c0,
+                        c1,
+                        children[0].visibility,
+                        children[1].visibility);
+  }
+  else {
+    pack_aligned_node(idx,
+                      children[0].bounds,
+                      children[1].bounds,
+                      c0,
+                      c1,
+                      children[0].visibility,
+                      children[1].visibility);
   }
 }
 
@@ -374,7 +536,8 @@ void BVH2::refit_node(int idx, bool leaf, BoundBox &bbox, uint &visibility)
 
 void BVH2::refit_primitives(int start, int end, BoundBox &bbox, uint &visibility)
 {
-  /* Refit range of primitives. */
+  /* Refit range of primitives, primitive indices are local to their geometry here also for the
+   * top level BVH, see unpack_instances(). */
   for (int prim = start; prim < end; prim++) {
     int pidx = pack.prim_index[prim];
     int tob = pack.prim_object[prim];
@@ -389,8 +552,7 @@ void BVH2::refit_primitives(int start, int end, BoundBox &bbox, uint &visibility
       if (pack.prim_type[prim] & PRIMITIVE_ALL_CURVE) {
         /* Curves. */
         const Hair *hair = static_cast<const Hair *>(ob->get_geometry());
-        int prim_offset = (params.top_level) ? hair->prim_offset : 0;
-        Hair::Curve curve = hair->get_curve(pidx - prim_offset);
+        Hair::Curve curve = hair->get_curve(pidx);
         int k = PRIMITIVE_UNPACK_SEGMENT(pack.prim_type[prim]);
 
         curve.bounds_grow(k, &hair->get_curve_keys()[0], &hair->get_curve_radius()[0], bbox);
@@ -412,8 +574,7 @@ void BVH2::refit_primitives(int start, int end, BoundBox &bbox, uint &visibility
       else {
         /* Triangles. */
         const Mesh *mesh = static_cast<const Mesh *>(ob->get_geometry());
-        int prim_offset = (params.top_level) ? mesh->prim_offset : 0;
-        Mesh::Triangle triangle = mesh->get_triangle(pidx - prim_offset);
+        Mesh::Triangle triangle = mesh->get_triangle(pidx);
         const float3 *vpos = &mesh->verts[0];
 
         triangle.bounds_grow(vpos, bbox);
@@ -501,6 +662,26 @@ void BVH2::pack_primitives()
 
 /* Pack Instances */
 
+void BVH2::unpack_instances()
+{
+  /* Undo pack_instances(), leaving only the top level part of the arrays with primitive indices
+   * local to their geometry, as they are right after the build. */
+  for (size_t i = 0; i < top_level_prims_size; i++) {
+    if (pack.prim_index[i] != -1) {
+      pack.prim_index[i] -= objects[pack.prim_object[i]]->get_geometry()->prim_offset;
+    }
+  }
+
+  pack.prim_index.resize(top_level_prims_size);
+  pack.prim_type.resize(top_level_prims_size);
+  pack.prim_object.resize(top_level_prims_size);
+  if (pack.prim_time.size()) {
+    pack.prim_time.resize(top_level_prims_size);
+  }
+  pack.nodes.resize(top_level_nodes_size);
+  pack.leaf_nodes.resize(top_level_leaf_nodes_size);
+}
+
 void BVH2::pack_instances(size_t nodes_size, size_t leaf_nodes_size)
 {
   /* Adjust primitive index to point to the triangle in the global array, for
@@ -659,38 +840,8 @@ void BVH2::pack_instances(size_t nodes_size, size_t leaf_nodes_size)
     }
 
     if (bvh->pack.nodes.size()) {
-      int4 *bvh_nodes = &bvh->pack.nodes[0];
-      size_t bvh_nodes_size = bvh->pack.nodes.size();
-
-      for (size_t i = 0, j = 0; i < bvh_nodes_size; j++) {
-        size_t nsize, nsize_bbox;
-        if (bvh_nodes[i].x & PATH_RAY_NODE_UNALIGNED) {
-          nsize = BVH_UNALIGNED_NODE_SIZE;
-          nsize_bbox = 0;
-        }
-        else {
-          nsize = BVH_NODE_SIZE;
-          nsize_bbox = 0;
-        }
-
-        memcpy(pack_nodes + pack_nodes_offset, bvh_nodes + i, nsize_bbox * sizeof(int4));
-
-        /* Modify offsets into arrays */
-        int4 data = bvh_nodes[i + nsize_bbox];
-        data.z += (data.z < 0) ? -noffset_leaf : noffset;
-        data.w += (data.w < 0) ? -noffset_leaf : noffset;
-        pack_nodes[pack_nodes_offset + nsize_bbox] = data;
-
-        /* Usually this copies nothing, but we better
-         * be prepared for possible node size extension.
-         */
-        memcpy(&pack_nodes[pack_nodes_offset + nsize_bbox + 1],
-               &bvh_nodes[i + nsize_bbox + 1],
-               sizeof(int4) * (nsize - (nsize_bbox + 1)));
-
-        pack_nodes_offset += nsize;
-        i += nsize;
-      }
+      pack_instance_nodes(bvh, pack_nodes, pack_nodes_offset, noffset, noffset_leaf);
+      pack_nodes_offset += bvh->pack.nodes.size();
     }
 
     nodes_offset += bvh->pack.nodes.size();
@@ -699,4 +850,41 @@ void BVH2::pack_instances(size_t nodes_size, size_t leaf_nodes_size)
   }
 }
 
+void BVH2::pack_instance_nodes(
+    const BVH2 *bvh, int4 *pack_nodes, size_t pack_nodes_offset, int noffset, int noffset_leaf)
+{
+  const int4 *bvh_nodes = &bvh->pack.nodes[0];
+  size_t bvh_nodes_size = bvh->pack.nodes.size();
+
+  for (size_t i = 0, j = 0; i < bvh_nodes_size; j++) {
+    size_t nsize, nsize_bbox;
+    if (bvh_nodes[i].x & PATH_RAY_NODE_UNALIGNED) {
+      nsize = BVH_UNALIGNED_NODE_SIZE;
+      nsize_bbox = 0;
+    }
+    else {
+      nsize = BVH_NODE_SIZE;
+      nsize_bbox = 0;
+    }
+
+    memcpy(pack_nodes + pack_nodes_offset, bvh_nodes + i, nsize_bbox * sizeof(int4));
+
+    /* Modify offsets into arrays */
+    int4 data = bvh_nodes[i + nsize_bbox];
+    data.z += (data.z < 0) ? -noffset_leaf : noffset;
+    data.w += (data.w < 0) ? -noffset_leaf : noffset;
+    pack_nodes[pack_nodes_offset + nsize_bbox] = data;
+
+    /* Usually this copies nothing, but we better
+     * be prepared for possible node size extension.
+     */
+    memcpy(&pack_nodes[pack_nodes_offset + nsize_bbox + 1],
+           &bvh_nodes[i + nsize_bbox + 1],
+           sizeof(int4) * (nsize - (nsize_bbox + 1)));
+
+    pack_nodes_offset += nsize;
+    i += nsize;
+  }
+}
+
 CCL_NAMESPACE_END
@@ -29,6 +29,8 @@ CCL_NAMESPACE_BEGIN
 #define BVH_NODE_SIZE 4
 #define BVH_NODE_LEAF_SIZE 1
 #define BVH_UNALIGNED_NODE_SIZE 7
+/* Maximum number of children of an inner node over all layouts packed by BVH2 and subclasses. */
+#define BVH_MAX_NODE_CHILDREN 4
 
 /* Pack Utility */
 struct BVHStackEntry {
@@ -39,6 +41,18 @@ struct BVHStackEntry {
   int encodeIdx() const;
 };
 
+/* Refit Utility */
+struct BVHRefitNode {
+  BoundBox bounds;
+  uint visibility;
+  /* SAH cost of the subtree, weighted by surface area instead of probability. */
+  float sah_cost;
+
+  BVHRefitNode() : bounds(BoundBox::empty), visibility(0), sah_cost(0.0f)
+  {
+  }
+};
+
 /* BVH2
  *
  * Typical BVH with each node having two children.
@@ -48,6 +62,17 @@ class BVH2 : public BVH {
   void build(Progress &progress, Stats *stats);
   void refit(Progress &progress);
 
+  /* SAH cost of the hierarchy after the last build and the last refit, equal when the last refit
+   * fell back to a rebuild. */
+  float get_build_sah_cost() const
+  {
+    return build_sah_cost;
+  }
+  float get_refit_sah_cost() const
+  {
+    return refit_sah_cost;
+  }
+
   PackedBVH pack;
 
  protected:
@@ -61,7 +86,9 @@ class BVH2 : public BVH {
   virtual BVHNode *widen_children_nodes(const BVHNode *root);
 
   /* pack */
-  void pack_nodes(const BVHNode *root);
+  virtual void pack_nodes(const BVHNode *root);
+  /* Allocate packed node arrays, merging in instance BVH's for the top level. */
+  void resize_nodes(size_t nodes_size, size_t leaf_nodes_size);
 
   void pack_leaf(const BVHStackEntry &e, const LeafNode *leaf);
   void pack_inner(const BVHStackEntry &e, const BVHStackEntry &e0, const BVHStackEntry &e1);
@@ -92,7 +119,17 @@ class BVH2 : public BVH {
 
   /* refit */
   void refit_nodes();
-  void refit_node(int idx, bool leaf, BoundBox &bbox, uint &visibility);
+  void refit_node(int idx, bool leaf, BVHRefitNode &node);
+  void refit_inner_node(int idx,
+                        const BVHRefitNode *children,
+                        int num_children,
+                        BVHRefitNode &node);
+  bool refit_need_rebuild() const;
+
+  /* Encoded child indices of an inner node, returns the number of children. */
+  virtual int get_inner_node_children(int idx, int children[BVH_MAX_NODE_CHILDREN]) const;
+  /* Store refitted bounds and visibility of the children in an inner node. */
+  virtual void repack_inner_node(int idx, const BVHRefitNode *children, int num_children);
 
   /* Refit range of primitives. */
   void refit_primitives(int start, int end, BoundBox &bbox, uint &visibility);
@@ -103,6 +140,25 @@ class BVH2 : public BVH {
 
   /* merge instance BVH's */
   void pack_instances(size_t nodes_size, size_t leaf_nodes_size);
+  void unpack_instances();
+  /* Copy the inner nodes of an instance BVH, offsetting their child indices. */
+  virtual void pack_instance_nodes(const BVH2 *bvh,
+                                   int4 *pack_nodes,
+                                   size_t pack_nodes_offset,
+                                   int noffset,
+                                   int noffset_leaf);
+
+  /* Size of the top level part of the packed arrays, before instances are merged in. */
+  size_t top_level_prims_size;
+  size_t top_level_nodes_size;
+  size_t top_level_leaf_nodes_size;
+
+  /* Objects which were traceable when the top level BVH was built. */
+  vector<bool> traceable_objects;
+
+  /* SAH cost of the hierarchy after the last build and the last refit. */
+  float build_sah_cost;
+  float refit_sah_cost;
 };
 
 CCL_NAMESPACE_END
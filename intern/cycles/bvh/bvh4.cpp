@@ -0,0 +1,299 @@
+/*
+ * Copyright 2021 Blender Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "bvh/bvh4.h"
+
+#include "bvh/bvh_node.h"
+
+#include "util/util_math.h"
+
+CCL_NAMESPACE_BEGIN
+
+namespace {
+
+/* Collapse every binary node with its children, giving nodes with up to four children. */
+BVHNode *bvh_node_merge_children_recursively(const BVHNode *node)
+{
+  if (node->is_leaf()) {
+    return new LeafNode(*reinterpret_cast<const LeafNode *>(node));
+  }
+
+  /* Collect nodes of one layer deeper, allowing us to have more children in an inner layer. */
+  assert(node->num_children() <= 2);
+  const BVHNode *children[BVH4_NUM_CHILDREN];
+  int num_children = 0;
+  for (int i = 0; i < node->num_children(); i++) {
+    const BVHNode *child = node->get_child(i);
+    if (child->is_leaf()) {
+      children[num_children++] = child;
+    }
+    else {
+      children[num_children++] = child->get_child(0);
+      children[num_children++] = child->get_child(1);
+    }
+  }
+
+  /* Merge children in subtrees. */
+  BVHNode *children4[BVH4_NUM_CHILDREN];
+  for (int i = 0; i < num_children; i++) {
+    children4[i] = bvh_node_merge_children_recursively(children[i]);
+  }
+
+  return new InnerNode(node->bounds, children4, num_children);
+}
+
+/* Smallest scale for which the last quantization step reaches the upper bound. */
+float quantize_scale(float lower, float upper)
+{
+  float scale = (upper - lower) / 255.0f;
+  while (lower + 255.0f * scale < upper) {
+    scale = nextafterf(scale, FLT_MAX);
+  }
+  return scale;
+}
+
+/* Quantize bounds rounding outwards, so the decoded bounds always contain the original. */
+uint quantize_lower(float value, float origin, float scale)
+{
+  if (scale == 0.0f) {
+    return 0;
+  }
+  int q = (int)clamp(floorf((value - origin) / scale), 0.0f, 255.0f);
+  while (q > 0 && origin + q * scale > value) {
+    q--;
+  }
+  return q;
+}
+
+uint quantize_upper(float value, float origin, float scale)
+{
+  if (scale == 0.0f) {
+    return 0;
+  }
+  int q = (int)clamp(ceilf((value - origin) / scale), 0.0f, 255.0f);
+  while (q < 255 && origin + q * scale < value) {
+    q++;
+  }
+  return q;
+}
+
+}  // namespace
+
+BVH4::BVH4(const BVHParams &params_,
+           const vector<Geometry *> &geometry_,
+           const vector<Object *> &objects_)
+    : BVH2(params_, geometry_, objects_)
+{
+  /* Quantized nodes only store axis aligned bounds. */
+  params.use_unaligned_nodes = false;
+}
+
+BVHNode *BVH4::widen_children_nodes(const BVHNode *root)
+{
+  if (root == NULL) {
+    return NULL;
+  }
+  if (root->is_leaf()) {
+    return const_cast<BVHNode *>(root);
+  }
+  return bvh_node_merge_children_recursively(root);
+}
+
+void BVH4::pack_inner(const BVHStackEntry &e, const BVHStackEntry *en, int num)
+{
+  BoundBox bounds[BVH4_NUM_CHILDREN];
+  int children[BVH4_NUM_CHILDREN];
+  uint visibility[BVH4_NUM_CHILDREN];
+  for (int i = 0; i < num; i++) {
+    bounds[i] = en[i].node->bounds;
+    children[i] = en[i].encodeIdx();
+    visibility[i] = en[i].node->visibility;
+  }
+  pack_quantized_node(e.idx, bounds, children, visibility, num);
+}
+
+void BVH4::pack_quantized_node(int idx,
+                               const BoundBox *bounds,
+                               const int *children,
+                               const uint *visibility,
+                               int num_children)
+{
+  assert(idx + BVH4_NODE_SIZE <= pack.nodes.size());
+  assert(num_children <= BVH4_NUM_CHILDREN);
+
+  /* Quantize relative to the union of the children, which after a refit may differ from the
+   * bounds the node had when it was built. */
+  BoundBox node_bounds = BoundBox::empty;
+  for (int i = 0; i < num_children; i++) {
+    if (bounds[i].valid()) {
+      node_bounds.grow(bounds[i]);
+    }
+  }
+  if (!node_bounds.valid()) {
+    node_bounds = BoundBox(zero_float3());
+  }
+
+  const float3 origin = node_bounds.min;
+  const float3 scale = make_float3(quantize_scale(origin.x, node_bounds.max.x),
+                                   quantize_scale(origin.y, node_bounds.max.y),
+                                   quantize_scale(origin.z, node_bounds.max.z));
+
+  int child_data[BVH4_NUM_CHILDREN] = {0, 0, 0, 0};
+  int visibility_data[BVH4_NUM_CHILDREN] = {0, 0, 0, 0};
+  uint lower[3] = {0, 0, 0};
+  uint upper[3] = {0, 0, 0};
+
+  for (int i = 0; i < num_children; i++) {
+    assert(children[i] != 0);
+    assert(children[i] < 0 || children[i] < pack.nodes.size());
+    child_data[i] = children[i];
+
+    /* Children without bounds keep zero visibility, so traversal never enters them. */
+    if (!bounds[i].valid()) {
+      continue;
+    }
+    visibility_data[i] = visibility[i];
+
+    for (int axis = 0; axis < 3; axis++) {
+      lower[axis] |= quantize_lower(bounds[i].min[axis], origin[axis], scale[axis]) << (i * 8);
+      upper[axis] |= quantize_upper(bounds[i].max[axis], origin[axis], scale[axis]) << (i * 8);
+    }
+  }
+
+  int4 data[BVH4_NODE_SIZE] = {
+      make_int4(child_data[0], child_data[1], child_data[2], child_data[3]),
+      make_int4(visibility_data[0], visibility_data[1], visibility_data[2], visibility_data[3]),
+      make_int4(__float_as_int(origin.x),
+                __float_as_int(origin.y),
+                __float_as_int(origin.z),
+                (int)upper[1]),
+      make_int4(__float_as_int(scale.x),
+                __float_as_int(scale.y),
+                __float_as_int(scale.z),
+                (int)upper[2]),
+      make_int4((int)lower[0], (int)lower[1], (int)lower[2], (int)upper[0]),
+  };
+
+  memcpy(&pack.nodes[idx], data, sizeof(int4) * BVH4_NODE_SIZE);
+}
+
+void BVH4::pack_nodes(const BVHNode *root)
+{
+  const size_t num_nodes = root->getSubtreeSize(BVH_STAT_NODE_COUNT);
+  const size_t num_leaf_nodes = root->getSubtreeSize(BVH_STAT_LEAF_COUNT);
+  assert(num_leaf_nodes <= num_nodes);
+  const size_t num_inner_nodes = num_nodes - num_leaf_nodes;
+  const size_t node_size = num_inner_nodes * BVH4_NODE_SIZE;
+  resize_nodes(node_size, num_leaf_nodes * BVH_NODE_LEAF_SIZE);
+
+  int nextNodeIdx = 0, nextLeafNodeIdx = 0;
+
+  vector<BVHStackEntry> stack;
+  stack.reserve(BVHParams::MAX_DEPTH * 2);
+  if (root->is_leaf()) {
+    stack.push_back(BVHStackEntry(root, nextLeafNodeIdx++));
+  }
+  else {
+    stack.push_back(BVHStackEntry(root, nextNodeIdx));
+    nextNodeIdx += BVH4_NODE_SIZE;
+  }
+
+  while (stack.size()) {
+    BVHStackEntry e = stack.back();
+    stack.pop_back();
+
+    if (e.node->is_leaf()) {
+      /* leaf node */
+      const LeafNode *leaf = reinterpret_cast<const LeafNode *>(e.node);
+      pack_leaf(e, leaf);
+    }
+    else {
+      /* inner node */
+      const int num_children = e.node->num_children();
+      assert(num_children <= BVH4_NUM_CHILDREN);
+
+      BVHStackEntry children[BVH4_NUM_CHILDREN];
+      for (int i = 0; i < num_children; ++i) {
+        const BVHNode *child = e.node->get_child(i);
+        if (child->is_leaf()) {
+          children[i] = BVHStackEntry(child, nextLeafNodeIdx++);
+        }
+        else {
+          children[i] = BVHStackEntry(child, nextNodeIdx);
+          nextNodeIdx += BVH4_NODE_SIZE;
+        }
+        stack.push_back(children[i]);
+      }
+
+      pack_inner(e, children, num_children);
+    }
+  }
+  assert(node_size == nextNodeIdx);
+  /* root index to start traversal at, to handle case of single leaf node */
+  pack.root_index = (root->is_leaf()) ? -1 : 0;
+}
+
+int BVH4::get_inner_node_children(int idx, int children[BVH_MAX_NODE_CHILDREN]) const
+{
+  assert(idx + BVH4_NODE_SIZE <= pack.nodes.size());
+  const int4 data = pack.nodes[idx];
+  int num_children = 0;
+  for (int i = 0; i < BVH4_NUM_CHILDREN; i++) {
+    /* The root is never a child, index 0 marks an unused slot. */
+    if (data[i] != 0) {
+      children[num_children++] = data[i];
+    }
+  }
+  return num_children;
+}
+
+void BVH4::repack_inner_node(int idx, const BVHRefitNode *children, int num_children)
+{
+  const int4 data = pack.nodes[idx];
+  BoundBox bounds[BVH4_NUM_CHILDREN];
+  int child_indices[BVH4_NUM_CHILDREN];
+  uint visibility[BVH4_NUM_CHILDREN];
+  for (int i = 0; i < num_children; i++) {
+    bounds[i] = children[i].bounds;
+    child_indices[i] = data[i];
+    visibility[i] = children[i].visibility;
+  }
+  pack_quantized_node(idx, bounds, child_indices, visibility, num_children);
+}
+
+void BVH4::pack_instance_nodes(
+    const BVH2 *bvh, int4 *pack_nodes, size_t pack_nodes_offset, int noffset, int noffset_leaf)
+{
+  const int4 *bvh_nodes = &bvh->pack.nodes[0];
+  const size_t bvh_nodes_size = bvh->pack.nodes.size();
+
+  for (size_t i = 0; i < bvh_nodes_size; i += BVH4_NODE_SIZE) {
+    /* Modify offsets into arrays, unused slots stay 0. */
+    int4 data = bvh_nodes[i];
+    for (int j = 0; j < BVH4_NUM_CHILDREN; j++) {
+      if (data[j] != 0) {
+        data[j] += (data[j] < 0) ? -noffset_leaf : noffset;
+      }
+    }
+    pack_nodes[pack_nodes_offset + i] = data;
+
+    memcpy(&pack_nodes[pack_nodes_offset + i + 1],
+           &bvh_nodes[i + 1],
+           sizeof(int4) * (BVH4_NODE_SIZE - 1));
+  }
+}
+
+CCL_NAMESPACE_END
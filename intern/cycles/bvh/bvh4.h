@@ -0,0 +1,79 @@
+/*
+ * Copyright 2021 Blender Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __BVH4_H__
+#define __BVH4_H__
+
+#include "bvh/bvh2.h"
+
+CCL_NAMESPACE_BEGIN
+
+/* Node layout:
+ *
+ *   0: child indices, 0 for unused slots
+ *   1: child visibility, 0 for unused slots
+ *   2: origin.xyz, upper y of the children
+ *   3: scale.xyz, upper z of the children
+ *   4: lower x, lower y, lower z and upper x of the children
+ *
+ * Child bounds are stored as 8 bit integers relative to the node bounds, which decode to
+ * origin + q * scale. Every integer field of the bounds holds one byte per child. */
+#define BVH4_NODE_SIZE 5
+#define BVH4_NUM_CHILDREN 4
+
+/* BVH4
+ *
+ * BVH with each node having up to four children, with child bounds quantized relative to the
+ * bounds of the node. Leaves are stored the same way as in BVH2.
+ *
+ * Only used for traversal on the CPU, and does not support unaligned nodes.
+ */
+class BVH4 : public BVH2 {
+ protected:
+  /* constructor */
+  friend class BVH;
+  BVH4(const BVHParams &params,
+       const vector<Geometry *> &geometry,
+       const vector<Object *> &objects);
+
+  /* Building process. */
+  virtual BVHNode *widen_children_nodes(const BVHNode *root);
+
+  /* pack */
+  virtual void pack_nodes(const BVHNode *root);
+
+  void pack_inner(const BVHStackEntry &e, const BVHStackEntry *en, int num);
+  void pack_quantized_node(int idx,
+                           const BoundBox *bounds,
+                           const int *children,
+                           const uint *visibility,
+                           int num_children);
+
+  /* refit */
+  virtual int get_inner_node_children(int idx, int children[BVH_MAX_NODE_CHILDREN]) const;
+  virtual void repack_inner_node(int idx, const BVHRefitNode *children, int num_children);
+
+  /* merge instance BVH's */
+  virtual void pack_instance_nodes(const BVH2 *bvh,
+                                   int4 *pack_nodes,
+                                   size_t pack_nodes_offset,
+                                   int noffset,
+                                   int noffset_leaf);
+};
+
+CCL_NAMESPACE_END
+
+#endif /* __BVH4_H__ */
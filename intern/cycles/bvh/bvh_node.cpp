@@ -115,10 +115,14 @@ float BVHNode::computeSubtreeSAHCost(const BVHParams &p, float probability) cons
 {
   float SAH = probability * p.cost(num_children(), num_triangles());
 
+  /* Degenerate bounds, for example of triangles collapsed to a line, can not be hit by rays, and
+   * neither can their children. Avoid dividing by a zero area. */
+  const float area = bounds.safe_area();
+
   for (int i = 0; i < num_children(); i++) {
     BVHNode *child = get_child(i);
     SAH += child->computeSubtreeSAHCost(
-        p, probability * child->bounds.safe_area() / bounds.safe_area());
+        p, (area > 0.0f) ? probability * child->bounds.safe_area() / area : 0.0f);
   }
 
   return SAH;
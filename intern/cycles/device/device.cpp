@@ -368,7 +368,7 @@ void Device::draw_pixels(device_memory &rgba,
 
 void Device::build_bvh(BVH *bvh, Progress &progress, bool refit)
 {
-  assert(bvh->params.bvh_layout == BVH_LAYOUT_BVH2);
+  assert(bvh->params.bvh_layout == BVH_LAYOUT_BVH2 || bvh->params.bvh_layout == BVH_LAYOUT_BVH4);
 
   BVH2 *const bvh2 = static_cast<BVH2 *>(bvh);
   if (refit) {
@@ -367,6 +367,9 @@ class CPUDevice : public Device {
   virtual BVHLayoutMask get_bvh_layout_mask() const override
   {
     BVHLayoutMask bvh_layout_mask = BVH_LAYOUT_BVH2;
+#ifdef __BVH4__
+    bvh_layout_mask |= BVH_LAYOUT_BVH4;
+#endif /* __BVH4__ */
 #ifdef WITH_EMBREE
     bvh_layout_mask |= BVH_LAYOUT_EMBREE;
 #endif /* WITH_EMBREE */
@@ -187,6 +187,10 @@ device_texture::device_texture(Device *device,
       data_type = TYPE_UINT16;
       data_elements = 1;
       break;
+    case IMAGE_DATA_TYPE_OIIO:
+      data_type = TYPE_UINT64;
+      data_elements = sizeof(TextureCacheHandle) / sizeof(uint64_t);
+      break;
     case IMAGE_DATA_NUM_TYPES:
       assert(0);
       return;
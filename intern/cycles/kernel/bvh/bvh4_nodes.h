@@ -0,0 +1,131 @@
+/*
+ * Copyright 2021 Blender Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/* Traversal of BVH4 inner nodes, see bvh/bvh4.h for the node layout. */
+
+/* Convert the bytes in the low 64 bits of a to floats, giving the quantized values of the four
+ * children for two of the bounds. */
+ccl_device_forceinline void bvh4_unpack_bounds(const __m128i a, ssef *lo, ssef *hi)
+{
+  const __m128i zero = _mm_setzero_si128();
+  const __m128i a16 = _mm_unpacklo_epi8(a, zero);
+  *lo = ssef(_mm_cvtepi32_ps(_mm_unpacklo_epi16(a16, zero)));
+  *hi = ssef(_mm_cvtepi32_ps(_mm_unpackhi_epi16(a16, zero)));
+}
+
+/* Intersect the ray with all children of an inner node. Continues with the closest child hit
+ * and pushes the other children hit on the stack, farthest first. Returns the next node to
+ * traverse. */
+ccl_device_forceinline int bvh4_node_intersect(KernelGlobals *kg,
+                                               const float3 P,
+                                               const float3 idir,
+                                               const float t,
+                                               const int node_addr,
+                                               const uint visibility,
+                                               int *traversal_stack,
+                                               int *stack_ptr)
+{
+  const float4 cnodes = kernel_tex_fetch(__bvh_nodes, node_addr + 0);
+  const ssef vnodes = load4f(kernel_tex_fetch(__bvh_nodes, node_addr + 1));
+  const ssef origin = load4f(kernel_tex_fetch(__bvh_nodes, node_addr + 2));
+  const ssef scale = load4f(kernel_tex_fetch(__bvh_nodes, node_addr + 3));
+  const ssef qnodes = load4f(kernel_tex_fetch(__bvh_nodes, node_addr + 4));
+
+  /* Bounds are origin + q * scale, so the distance to a slab is q * scale * idir +
+   * (origin - P) * idir. */
+  const ssef idir4 = load4f(idir);
+  const ssef idir_x = shuffle<0>(idir4);
+  const ssef idir_y = shuffle<1>(idir4);
+  const ssef idir_z = shuffle<2>(idir4);
+  const ssef P4 = load4f(P);
+  const ssef scale_x = shuffle<0>(scale) * idir_x;
+  const ssef scale_y = shuffle<1>(scale) * idir_y;
+  const ssef scale_z = shuffle<2>(scale) * idir_z;
+  const ssef offset_x = (shuffle<0>(origin) - shuffle<0>(P4)) * idir_x;
+  const ssef offset_y = (shuffle<1>(origin) - shuffle<1>(P4)) * idir_y;
+  const ssef offset_z = (shuffle<2>(origin) - shuffle<2>(P4)) * idir_z;
+
+  /* Upper y and z are in the last lane of the origin and scale. */
+  ssef lo_x, lo_y, lo_z, hi_x, hi_y, hi_z;
+  const __m128i q = _mm_castps_si128(qnodes);
+  bvh4_unpack_bounds(q, &lo_x, &lo_y);
+  bvh4_unpack_bounds(_mm_unpackhi_epi64(q, q), &lo_z, &hi_x);
+  bvh4_unpack_bounds(
+      _mm_srli_si128(_mm_unpackhi_epi32(_mm_castps_si128(origin), _mm_castps_si128(scale)), 8),
+      &hi_y,
+      &hi_z);
+
+  const ssef t_lo_x = madd(lo_x, scale_x, offset_x);
+  const ssef t_hi_x = madd(hi_x, scale_x, offset_x);
+  const ssef t_lo_y = madd(lo_y, scale_y, offset_y);
+  const ssef t_hi_y = madd(hi_y, scale_y, offset_y);
+  const ssef t_lo_z = madd(lo_z, scale_z, offset_z);
+  const ssef t_hi_z = madd(hi_z, scale_z, offset_z);
+
+  const ssef tnear = max(max(min(t_lo_x, t_hi_x), min(t_lo_y, t_hi_y)),
+                         max(min(t_lo_z, t_hi_z), ssef(0.0f)));
+  const ssef tfar = min(min(max(t_lo_x, t_hi_x), max(t_lo_y, t_hi_y)),
+                        min(max(t_lo_z, t_hi_z), ssef(t)));
+
+  /* Unused child slots have zero visibility. */
+  const ssei child_visibility = cast(vnodes) & ssei((int)visibility);
+  uint mask = movemask((tnear <= tfar) & (child_visibility != 0));
+
+  if (mask == 0) {
+    /* No child was intersected. */
+    const int next_node_addr = traversal_stack[*stack_ptr];
+    --*stack_ptr;
+    return next_node_addr;
+  }
+
+  const int4 children = __float4_as_int4(cnodes);
+  int i = bitscan(mask);
+  mask &= mask - 1;
+  if (mask == 0) {
+    /* One child was intersected. */
+    return children[i];
+  }
+
+  /* Sort the children hit by distance, farthest first. */
+  float dist[4];
+  storeu4f(dist, tnear);
+
+  int hit_addr[4];
+  float hit_dist[4];
+  int num_hits = 0;
+  while (true) {
+    int j = num_hits++;
+    for (; j > 0 && hit_dist[j - 1] < dist[i]; j--) {
+      hit_addr[j] = hit_addr[j - 1];
+      hit_dist[j] = hit_dist[j - 1];
+    }
+    hit_addr[j] = children[i];
+    hit_dist[j] = dist[i];
+
+    if (mask == 0) {
+      break;
+    }
+    i = bitscan(mask);
+    mask &= mask - 1;
+  }
+
+  for (int j = 0; j < num_hits - 1; j++) {
+    ++*stack_ptr;
+    kernel_assert(*stack_ptr < BVH_STACK_SIZE);
+    traversal_stack[*stack_ptr] = hit_addr[j];
+  }
+  return hit_addr[num_hits - 1];
+}
@@ -15,6 +15,7 @@
  */
 
 #include "kernel_light_background.h"
+#include "kernel_light_tree.h"
 
 CCL_NAMESPACE_BEGIN
 
@@ -35,6 +36,76 @@ typedef struct LightSample {
   LightType type; /* type of light */
 } LightSample;
 
+/* Light Selection */
+
+/* Probability of the light distribution or light tree to pick the lamp for a shading point. */
+ccl_device_inline float lamp_light_select_pdf(KernelGlobals *kg, int lamp, float3 P)
+{
+  if (kernel_data.integrator.use_light_tree) {
+    const int distribution_id = kernel_data.integrator.num_distribution -
+                                kernel_data.integrator.num_all_lights + lamp;
+    const uint emitter = kernel_tex_fetch(__light_tree_emitter_index, distribution_id);
+    if (emitter < (uint)kernel_data.integrator.num_light_tree_emitters) {
+      return kernel_data.integrator.pdf_light_tree * light_tree_pdf(kg, P, emitter);
+    }
+    /* Distant lights keep the probability of the distribution. */
+  }
+  return kernel_data.integrator.pdf_lights;
+}
+
+/* Find a mesh light in the light distribution, where they are sorted by object and primitive. */
+ccl_device int light_distribution_find_triangle(KernelGlobals *kg, int object, int prim)
+{
+  const int num_triangles = kernel_data.integrator.num_distribution -
+                            kernel_data.integrator.num_all_lights;
+  int first = 0;
+  int len = num_triangles;
+
+  while (len > 0) {
+    const int half_len = len >> 1;
+    const int middle = first + half_len;
+    const ccl_global KernelLightDistribution *kdistribution = &kernel_tex_fetch(
+        __light_distribution, middle);
+    const int middle_object = kdistribution->mesh_light.object_id;
+
+    if (middle_object < object || (middle_object == object && kdistribution->prim < prim)) {
+      first = middle + 1;
+      len = len - half_len - 1;
+    }
+    else {
+      len = half_len;
+    }
+  }
+
+  if (first < num_triangles) {
+    const ccl_global KernelLightDistribution *kdistribution = &kernel_tex_fetch(
+        __light_distribution, first);
+    if (kdistribution->mesh_light.object_id == object && kdistribution->prim == prim) {
+      return first;
+    }
+  }
+  return -1;
+}
+
+/* Probability per unit area of the light distribution or light tree to pick the triangle for a
+ * shading point. The area is the one of the triangle the distribution was built from. */
+ccl_device_inline float triangle_light_select_pdf(
+    KernelGlobals *kg, int object, int prim, float3 P, float area)
+{
+  if (kernel_data.integrator.use_light_tree) {
+    const int distribution_id = light_distribution_find_triangle(kg, object, prim);
+    if (distribution_id == -1 || area == 0.0f) {
+      return 0.0f;
+    }
+    const uint emitter = kernel_tex_fetch(__light_tree_emitter_index, distribution_id);
+    if (emitter >= (uint)kernel_data.integrator.num_light_tree_emitters) {
+      return 0.0f;
+    }
+    return kernel_data.integrator.pdf_light_tree * light_tree_pdf(kg, P, emitter) / area;
+  }
+  return kernel_data.integrator.pdf_triangles;
+}
+
 /* Regular Light */
 
 ccl_device_inline bool lamp_light_sample(
@@ -153,7 +224,7 @@ ccl_device_inline bool lamp_light_sample(
     }
   }
 
-  ls->pdf *= kernel_data.integrator.pdf_lights;
+  ls->pdf *= lamp_light_select_pdf(kg, lamp, P);
 
   return (ls->pdf > 0.0f);
 }
@@ -291,7 +362,7 @@ ccl_device bool lamp_light_eval(
     return false;
   }
 
-  ls->pdf *= kernel_data.integrator.pdf_lights;
+  ls->pdf *= lamp_light_select_pdf(kg, lamp, P);
 
   return true;
 }
@@ -328,12 +399,12 @@ ccl_device_inline bool triangle_world_space_vertices(
   return has_motion;
 }
 
-ccl_device_inline float triangle_light_pdf_area(KernelGlobals *kg,
+ccl_device_inline float triangle_light_pdf_area(const float select_pdf,
                                                 const float3 Ng,
                                                 const float3 I,
                                                 float t)
 {
-  float pdf = kernel_data.integrator.pdf_triangles;
+  float pdf = select_pdf;
   float cos_pi = fabsf(dot(Ng, I));
 
   if (cos_pi == 0.0f)
@@ -358,10 +429,11 @@ ccl_device_forceinline float triangle_light_pdf(KernelGlobals *kg, ShaderData *s
   const float3 N = cross(e0, e1);
   const float distance_to_plane = fabsf(dot(N, sd->I * t)) / dot(N, N);
 
+  /* sd contains the point on the light source
+   * calculate Px, the point that we're shading */
+  const float3 Px = sd->P + sd->I * t;
+
   if (longest_edge_squared > distance_to_plane * distance_to_plane) {
-    /* sd contains the point on the light source
-     * calculate Px, the point that we're shading */
-    const float3 Px = sd->P + sd->I * t;
     const float3 v0_p = V[0] - Px;
     const float3 v1_p = V[1] - Px;
     const float3 v2_p = V[2] - Px;
@@ -389,22 +461,26 @@ ccl_device_forceinline float triangle_light_pdf(KernelGlobals *kg, ShaderData *s
       else {
         area = 0.5f * len(N);
       }
-      const float pdf = area * kernel_data.integrator.pdf_triangles;
+      const float pdf = area * triangle_light_select_pdf(kg, sd->object, sd->prim, Px, area);
       return pdf / solid_angle;
     }
   }
   else {
-    float pdf = triangle_light_pdf_area(kg, sd->Ng, sd->I, t);
+    const float area = 0.5f * len(N);
+    float area_pre = area;
     if (has_motion) {
-      const float area = 0.5f * len(N);
       if (UNLIKELY(area == 0.0f)) {
         return 0.0f;
       }
+      triangle_world_space_vertices(kg, sd->object, sd->prim, -1.0f, V);
+      area_pre = triangle_area(V[0], V[1], V[2]);
+    }
+    float pdf = triangle_light_pdf_area(
+        triangle_light_select_pdf(kg, sd->object, sd->prim, Px, area_pre), sd->Ng, sd->I, t);
+    if (has_motion) {
       /* scale the PDF.
        * area = the area the sample was taken from
        * area_pre = the are from which pdf_triangles was calculated from */
-      triangle_world_space_vertices(kg, sd->object, sd->prim, -1.0f, V);
-      const float area_pre = triangle_area(V[0], V[1], V[2]);
       pdf = pdf * area_pre / area;
     }
     return pdf;
@@ -542,7 +618,7 @@ ccl_device_forceinline void triangle_light_sample(KernelGlobals *kg,
         triangle_world_space_vertices(kg, object, prim, -1.0f, V);
         area = triangle_area(V[0], V[1], V[2]);
       }
-      const float pdf = area * kernel_data.integrator.pdf_triangles;
+      const float pdf = area * triangle_light_select_pdf(kg, object, prim, P, area);
       ls->pdf = pdf / solid_angle;
     }
   }
@@ -564,13 +640,17 @@ ccl_device_forceinline void triangle_light_sample(KernelGlobals *kg,
     ls->P = u * V[0] + v * V[1] + t * V[2];
     /* compute incoming direction, distance and pdf */
     ls->D = normalize_len(ls->P - P, &ls->t);
-    ls->pdf = triangle_light_pdf_area(kg, ls->Ng, -ls->D, ls->t);
+    float area_pre = area;
+    if (has_motion && area != 0.0f) {
+      triangle_world_space_vertices(kg, object, prim, -1.0f, V);
+      area_pre = triangle_area(V[0], V[1], V[2]);
+    }
+    ls->pdf = triangle_light_pdf_area(
+        triangle_light_select_pdf(kg, object, prim, P, area_pre), ls->Ng, -ls->D, ls->t);
     if (has_motion && area != 0.0f) {
       /* scale the PDF.
        * area = the area the sample was taken from
        * area_pre = the are from which pdf_triangles was calculated from */
-      triangle_world_space_vertices(kg, object, prim, -1.0f, V);
-      const float area_pre = triangle_area(V[0], V[1], V[2]);
       ls->pdf = ls->pdf * area_pre / area;
     }
     ls->u = u;
@@ -634,7 +714,24 @@ ccl_device_noinline bool light_sample(KernelGlobals *kg,
 {
   if (lamp < 0) {
     /* sample index */
-    int index = light_distribution_sample(kg, &randu);
+    int index;
+    if (kernel_data.integrator.use_light_tree) {
+      if (randu < kernel_data.integrator.pdf_light_tree) {
+        randu = randu / kernel_data.integrator.pdf_light_tree;
+        index = light_tree_sample(kg, P, &randu);
+        if (index == -1) {
+          return false;
+        }
+      }
+      else {
+        randu = (randu - kernel_data.integrator.pdf_light_tree) /
+                (1.0f - kernel_data.integrator.pdf_light_tree);
+        index = light_tree_distant_sample(kg, &randu);
+      }
+    }
+    else {
+      index = light_distribution_sample(kg, &randu);
+    }
 
     /* fetch light data */
     const ccl_global KernelLightDistribution *kdistribution = &kernel_tex_fetch(
@@ -0,0 +1,206 @@
+/*
+ * Copyright 2021 Blender Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+CCL_NAMESPACE_BEGIN
+
+/* Light Tree
+ *
+ * Picks emitters by their estimated contribution to the shading point, from their energy,
+ * distance and orientation. See "Importance Sampling of Many Lights with Adaptive Tree
+ * Splitting" by Conty Estevez and Kulla. The receiving surface is not taken into account, so the
+ * same probabilities can be evaluated for BSDF samples that hit an emitter. */
+
+ccl_device float light_tree_importance(const float3 P,
+                                       const float3 bbox_min,
+                                       const float3 bbox_max,
+                                       const float3 axis,
+                                       const float theta_o,
+                                       const float theta_e,
+                                       const float energy)
+{
+  if (energy == 0.0f) {
+    return 0.0f;
+  }
+
+  const float3 centroid = 0.5f * (bbox_min + bbox_max);
+  const float radius_squared = 0.25f * len_squared(bbox_max - bbox_min);
+  const float distance_squared = len_squared(P - centroid);
+
+  float cos_theta_prime = 1.0f;
+  if (theta_o + theta_e < M_PI_F && distance_squared > radius_squared) {
+    /* Smallest angle between the emission bounds and the directions from the bounding box to the
+     * shading point, no light reaches the point when it is outside of the emission cone. */
+    const float distance = sqrtf(distance_squared);
+    const float theta = safe_acosf(dot(axis, P - centroid) / distance);
+    const float theta_u = safe_asinf(sqrtf(radius_squared) / distance);
+    const float theta_prime = max(theta - theta_o - theta_u, 0.0f);
+    if (theta_prime >= theta_e) {
+      return 0.0f;
+    }
+    cos_theta_prime = cosf(theta_prime);
+  }
+
+  /* Clamp the distance to the size of the bounds, the emitters may be anywhere inside. */
+  return energy * cos_theta_prime / max(max(distance_squared, radius_squared), FLT_MIN);
+}
+
+ccl_device_inline float light_tree_node_importance(const ccl_global KernelLightTreeNode *knode,
+                                                   const float3 P)
+{
+  return light_tree_importance(
+      P,
+      make_float3(knode->bbox_min[0], knode->bbox_min[1], knode->bbox_min[2]),
+      make_float3(knode->bbox_max[0], knode->bbox_max[1], knode->bbox_max[2]),
+      make_float3(knode->axis[0], knode->axis[1], knode->axis[2]),
+      knode->theta_o,
+      knode->theta_e,
+      knode->energy);
+}
+
+ccl_device_inline float light_tree_emitter_importance(KernelGlobals *kg,
+                                                      const int emitter,
+                                                      const float3 P)
+{
+  const ccl_global KernelLightTreeEmitter *kemitter = &kernel_tex_fetch(__light_tree_emitters,
+                                                                       emitter);
+  return light_tree_importance(
+      P,
+      make_float3(kemitter->bbox_min[0], kemitter->bbox_min[1], kemitter->bbox_min[2]),
+      make_float3(kemitter->bbox_max[0], kemitter->bbox_max[1], kemitter->bbox_max[2]),
+      make_float3(kemitter->axis[0], kemitter->axis[1], kemitter->axis[2]),
+      kemitter->theta_o,
+      kemitter->theta_e,
+      kemitter->energy);
+}
+
+/* Pick an emitter proportional to its importance for the shading point, by stochastically
+ * traversing the tree. Returns the index of the emitter in the light distribution, or -1 when no
+ * emitter in the tree can light the point. The random number is rescaled for reuse. */
+ccl_device int light_tree_sample(KernelGlobals *kg, const float3 P, float *randu)
+{
+  float r = *randu;
+  int node_index = 0;
+  const ccl_global KernelLightTreeNode *knode = &kernel_tex_fetch(__light_tree_nodes, 0);
+
+  while (knode->right_child != -1) {
+    const ccl_global KernelLightTreeNode *kleft = &kernel_tex_fetch(__light_tree_nodes,
+                                                                    node_index + 1);
+    const ccl_global KernelLightTreeNode *kright = &kernel_tex_fetch(__light_tree_nodes,
+                                                                     knode->right_child);
+    const float left_importance = light_tree_node_importance(kleft, P);
+    const float total_importance = left_importance + light_tree_node_importance(kright, P);
+    if (!(total_importance > 0.0f)) {
+      return -1;
+    }
+
+    const float left_probability = left_importance / total_importance;
+    if (r < left_probability) {
+      r = r / left_probability;
+      node_index = node_index + 1;
+      knode = kleft;
+    }
+    else {
+      r = (r - left_probability) / (1.0f - left_probability);
+      node_index = knode->right_child;
+      knode = kright;
+    }
+    r = min(r, 1.0f - FLT_EPSILON);
+  }
+
+  /* Pick an emitter in the leaf. */
+  const int first_emitter = knode->first_emitter;
+  const int last_emitter = first_emitter + knode->num_emitters - 1;
+  float total_importance = 0.0f;
+  for (int emitter = first_emitter; emitter <= last_emitter; emitter++) {
+    total_importance += light_tree_emitter_importance(kg, emitter, P);
+  }
+  if (!(total_importance > 0.0f)) {
+    return -1;
+  }
+
+  float cdf = 0.0f;
+  for (int emitter = first_emitter; emitter <= last_emitter; emitter++) {
+    const float probability = light_tree_emitter_importance(kg, emitter, P) / total_importance;
+    if (probability == 0.0f) {
+      continue;
+    }
+    if (r < cdf + probability || emitter == last_emitter) {
+      *randu = min((r - cdf) / probability, 1.0f - FLT_EPSILON);
+      return kernel_tex_fetch(__light_tree_emitters, emitter).distribution_id;
+    }
+    cdf += probability;
+  }
+
+  return -1;
+}
+
+/* Probability of light tree sampling to pick the emitter from the shading point. */
+ccl_device float light_tree_pdf(KernelGlobals *kg, const float3 P, const int emitter)
+{
+  float pdf = 1.0f;
+  const ccl_global KernelLightTreeNode *knode = &kernel_tex_fetch(__light_tree_nodes, 0);
+  int node_index = 0;
+
+  while (knode->right_child != -1) {
+    const ccl_global KernelLightTreeNode *kleft = &kernel_tex_fetch(__light_tree_nodes,
+                                                                    node_index + 1);
+    const ccl_global KernelLightTreeNode *kright = &kernel_tex_fetch(__light_tree_nodes,
+                                                                     knode->right_child);
+    const float left_importance = light_tree_node_importance(kleft, P);
+    const float right_importance = light_tree_node_importance(kright, P);
+    const float total_importance = left_importance + right_importance;
+    if (!(total_importance > 0.0f)) {
+      return 0.0f;
+    }
+
+    if (emitter < kright->first_emitter) {
+      pdf *= left_importance / total_importance;
+      node_index = node_index + 1;
+      knode = kleft;
+    }
+    else {
+      pdf *= right_importance / total_importance;
+      node_index = knode->right_child;
+      knode = kright;
+    }
+  }
+
+  float total_importance = 0.0f;
+  const int first_emitter = knode->first_emitter;
+  for (int i = first_emitter; i < first_emitter + knode->num_emitters; i++) {
+    total_importance += light_tree_emitter_importance(kg, i, P);
+  }
+  if (!(total_importance > 0.0f)) {
+    return 0.0f;
+  }
+
+  return pdf * light_tree_emitter_importance(kg, emitter, P) / total_importance;
+}
+
+/* Pick one of the distant lights, which are outside of the tree. They all get the same
+ * probability as in the light distribution. */
+ccl_device int light_tree_distant_sample(KernelGlobals *kg, float *randu)
+{
+  const int num_distant = kernel_data.integrator.num_light_tree_distant;
+  const float r = *randu * num_distant;
+  const int index = min((int)r, num_distant - 1);
+  *randu = min(r - index, 1.0f - FLT_EPSILON);
+
+  const int emitter = kernel_data.integrator.num_light_tree_emitters + index;
+  return kernel_tex_fetch(__light_tree_emitters, emitter).distribution_id;
+}
+
+CCL_NAMESPACE_END
@@ -23,6 +23,8 @@
 #  include <nanovdb/util/SampleFromVoxels.h>
 #endif
 
+#include <OpenImageIO/texture.h>
+
 CCL_NAMESPACE_BEGIN
 
 /* Make template functions private so symbols don't conflict between kernels with different
@@ -584,6 +586,65 @@ template<typename T> struct NanoVDBInterpolator {
 
 #undef SET_CUBIC_SPLINE_WEIGHTS
 
+/* Images that are paged in on demand by the OpenImageIO texture cache. The MIP level is
+ * selected from the derivatives of the texture coordinates, zero derivatives use the full
+ * resolution. */
+ccl_device float4 kernel_tex_image_interp_oiio(
+    const TextureInfo &info, float x, float y, float2 dx, float2 dy)
+{
+  const TextureCacheHandle *cache_handle = (const TextureCacheHandle *)info.data;
+  OIIO::TextureSystem *ts = (OIIO::TextureSystem *)cache_handle->texture_system;
+
+  OIIO::TextureOpt options;
+  switch (info.extension) {
+    case EXTENSION_REPEAT:
+      options.swrap = options.twrap = OIIO::TextureOpt::WrapPeriodic;
+      break;
+    case EXTENSION_EXTEND:
+      options.swrap = options.twrap = OIIO::TextureOpt::WrapClamp;
+      break;
+    default:
+      options.swrap = options.twrap = OIIO::TextureOpt::WrapBlack;
+      break;
+  }
+  switch (info.interpolation) {
+    case INTERPOLATION_CLOSEST:
+      options.interpmode = OIIO::TextureOpt::InterpClosest;
+      break;
+    case INTERPOLATION_CUBIC:
+      options.interpmode = OIIO::TextureOpt::InterpBicubic;
+      break;
+    case INTERPOLATION_SMART:
+      options.interpmode = OIIO::TextureOpt::InterpSmartBicubic;
+      break;
+    default:
+      options.interpmode = OIIO::TextureOpt::InterpBilinear;
+      break;
+  }
+  /* Opaque alpha for images without alpha channel. */
+  options.fill = 1.0f;
+
+  /* Image rows are stored bottom to top in Cycles, and top to bottom in the file. */
+  float result[4];
+  if (!ts->texture((OIIO::TextureSystem::TextureHandle *)cache_handle->handle,
+                   NULL,
+                   options,
+                   x,
+                   1.0f - y,
+                   dx.x,
+                   -dx.y,
+                   dy.x,
+                   -dy.y,
+                   4,
+                   result)) {
+    ts->geterror();
+    return make_float4(
+        TEX_IMAGE_MISSING_R, TEX_IMAGE_MISSING_G, TEX_IMAGE_MISSING_B, TEX_IMAGE_MISSING_A);
+  }
+
+  return make_float4(result[0], result[1], result[2], result[3]);
+}
+
 ccl_device float4 kernel_tex_image_interp(KernelGlobals *kg, int id, float x, float y)
 {
   const TextureInfo &info = kernel_tex_fetch(__texture_info, id);
@@ -605,6 +666,8 @@ ccl_device float4 kernel_tex_image_interp(KernelGlobals *kg, int id, float x, fl
       return TextureInterpolator<ushort4>::interp(info, x, y);
     case IMAGE_DATA_TYPE_FLOAT4:
       return TextureInterpolator<float4>::interp(info, x, y);
+    case IMAGE_DATA_TYPE_OIIO:
+      return kernel_tex_image_interp_oiio(info, x, y, zero_float2(), zero_float2());
     default:
       assert(0);
       return make_float4(
@@ -612,6 +675,20 @@ ccl_device float4 kernel_tex_image_interp(KernelGlobals *kg, int id, float x, fl
   }
 }
 
+/* Lookup with derivatives of the texture coordinates, used for MIP level selection by the
+ * texture cache. Other images ignore the derivatives. */
+ccl_device float4
+kernel_tex_image_interp_deriv(KernelGlobals *kg, int id, float x, float y, float2 dx, float2 dy)
+{
+  const TextureInfo &info = kernel_tex_fetch(__texture_info, id);
+
+  if (info.data_type == IMAGE_DATA_TYPE_OIIO) {
+    return kernel_tex_image_interp_oiio(info, x, y, dx, dy);
+  }
+
+  return kernel_tex_image_interp(kg, id, x, y);
+}
+
 ccl_device float4 kernel_tex_image_interp_3d(KernelGlobals *kg,
                                              int id,
                                              float3 P,
@@ -1232,8 +1232,16 @@ void GeometryManager::device_update_bvh(Device *device,
 
   VLOG(1) << "Using " << bvh_layout_name(bparams.bvh_layout) << " layout.";
 
+  /* The scene BVH is freed in device_update_preprocess() when geometry or objects are added or
+   * removed, or when the topology of geometry changed. If it still exists only vertices and
+   * transforms changed, and the existing hierarchy can be refit. */
+  /* BVH4 is packed by a subclass of BVH2 and shares all of its handling here. */
+  const bool has_bvh2_layout = (bparams.bvh_layout == BVH_LAYOUT_BVH2 ||
+                                bparams.bvh_layout == BVH_LAYOUT_BVH4);
+  /* Packed BVH2 data is handed over to the device below, it must still be there to refit. */
   const bool can_refit = scene->bvh != nullptr &&
-                         (bparams.bvh_layout == BVHLayout::BVH_LAYOUT_OPTIX);
+                         (bparams.bvh_layout == BVHLayout::BVH_LAYOUT_OPTIX ||
+                          (has_bvh2_layout && dscene->bvh_leaf_nodes.size() != 0));
   const bool pack_all = scene->bvh == nullptr;
 
   BVH *bvh = scene->bvh;
@@ -1241,14 +1249,33 @@ void GeometryManager::device_update_bvh(Device *device,
     bvh = scene->bvh = BVH::create(bparams, scene->geometry, scene->objects, device);
   }
 
+  if (can_refit && has_bvh2_layout) {
+    /* Take back the packed arrays moved to the device after the previous build or refit. */
+    PackedBVH &bvh_pack = static_cast<BVH2 *>(bvh)->pack;
+    dscene->bvh_nodes.give_data(bvh_pack.nodes);
+    dscene->bvh_leaf_nodes.give_data(bvh_pack.leaf_nodes);
+    dscene->object_node.give_data(bvh_pack.object_node);
+    dscene->prim_tri_index.give_data(bvh_pack.prim_tri_index);
+    dscene->prim_tri_verts.give_data(bvh_pack.prim_tri_verts);
+    dscene->prim_type.give_data(bvh_pack.prim_type);
+    dscene->prim_visibility.give_data(bvh_pack.prim_visibility);
+    dscene->prim_index.give_data(bvh_pack.prim_index);
+    dscene->prim_object.give_data(bvh_pack.prim_object);
+    dscene->prim_time.give_data(bvh_pack.prim_time);
+  }
+
   device->build_bvh(bvh, progress, can_refit);
 
   if (progress.get_cancel()) {
+    if (has_bvh2_layout) {
+      /* Packed BVH2 data is incomplete after a cancelled build or refit, so it can not be
+       * refit on the next update. */
+      delete scene->bvh;
+      scene->bvh = nullptr;
+    }
     return;
   }
 
-  const bool has_bvh2_layout = (bparams.bvh_layout == BVH_LAYOUT_BVH2);
-
   PackedBVH pack;
   if (has_bvh2_layout) {
     pack = std::move(static_cast<BVH2 *>(bvh)->pack);
@@ -2107,6 +2134,27 @@ void GeometryManager::collect_statistics(const Scene *scene, RenderStats *stats)
     stats->mesh.geometry.add_entry(
         NamedSizeEntry(string(geometry->name.c_str()), geometry->get_total_size_in_bytes()));
   }
+
+  const DeviceScene &dscene = scene->dscene;
+  const BVHLayout bvh_layout = (BVHLayout)dscene.data.bvh.bvh_layout;
+  stats->bvh.layout = bvh_layout_name(bvh_layout);
+
+  /* Other layouts keep their hierarchy in an external library, the packed arrays are empty. */
+  if (!(bvh_layout == BVH_LAYOUT_BVH2 || bvh_layout == BVH_LAYOUT_BVH4)) {
+    return;
+  }
+
+  stats->bvh.nodes.add_entry(
+      NamedSizeEntry("Inner nodes", dscene.bvh_nodes.size() * sizeof(int4)));
+  stats->bvh.nodes.add_entry(
+      NamedSizeEntry("Leaf nodes", dscene.bvh_leaf_nodes.size() * sizeof(int4)));
+  stats->bvh.nodes.add_entry(NamedSizeEntry("Triangle vertices",
+                                            dscene.prim_tri_verts.size() * sizeof(float4)));
+  stats->bvh.nodes.add_entry(NamedSizeEntry(
+      "Primitives",
+      dscene.prim_type.size() * sizeof(int) + dscene.prim_visibility.size() * sizeof(uint) +
+          dscene.prim_index.size() * sizeof(int) + dscene.prim_object.size() * sizeof(int) +
+          dscene.prim_time.size() * sizeof(float2)));
 }
 
 CCL_NAMESPACE_END
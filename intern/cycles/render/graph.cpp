@@ -17,6 +17,7 @@
 #include "render/graph.h"
 #include "render/attribute.h"
 #include "render/constant_fold.h"
+#include "render/image.h"
 #include "render/nodes.h"
 #include "render/scene.h"
 #include "render/shader.h"
@@ -383,6 +384,11 @@ void ShaderGraph::finalize(Scene *scene, bool do_bump, bool do_simplify, bool bu
     if (do_bump)
       bump_from_displacement(bump_in_object_space);
 
+    /* After bump, so that all copies made for bump samples are known. */
+    if (!scene->shader_manager->use_osl() && scene->image_manager->use_texture_cache(scene)) {
+      add_image_texture_derivatives();
+    }
+
     ShaderInput *surface_in = output()->input("Surface");
     ShaderInput *volume_in = output()->input("Volume");
 
@@ -954,6 +960,63 @@ void ShaderGraph::refine_bump_nodes()
   }
 }
 
+void ShaderGraph::add_image_texture_derivatives()
+{
+  /* Images sampled through the texture cache select their MIP level from the
+   * derivatives of the texture coordinate. Like for bump nodes, we copy the
+   * sub-graph defined from the "Vector" input to the inputs "VectorDX" and
+   * "VectorDY", with texture coordinates shifted by the ray differentials.
+   *
+   * Images sampled for bump are skipped: the center and shifted samples must use
+   * the same MIP level for their difference to be meaningful, so they all keep
+   * zero derivatives. */
+
+  vector<ImageTextureNode *> image_nodes;
+  foreach (ShaderNode *node, nodes) {
+    if (node->type == ImageTextureNode::get_node_type() && node->bump == SHADER_BUMP_NONE &&
+        node->input("Vector")->link) {
+      ImageTextureNode *image_node = static_cast<ImageTextureNode *>(node);
+      if (image_node->get_projection() != NODE_IMAGE_PROJ_BOX) {
+        image_nodes.push_back(image_node);
+      }
+    }
+  }
+
+  foreach (ImageTextureNode *node, image_nodes) {
+    ShaderInput *vector_input = node->input("Vector");
+    ShaderNodeSet nodes_vector;
+
+    /* make 2 extra copies of the subgraph defined in Vector input */
+    ShaderNodeMap nodes_dx;
+    ShaderNodeMap nodes_dy;
+
+    find_dependencies(nodes_vector, vector_input);
+
+    copy_nodes(nodes_vector, nodes_dx);
+    copy_nodes(nodes_vector, nodes_dy);
+
+    foreach (NodePair &pair, nodes_dx)
+      pair.second->bump = SHADER_BUMP_DX;
+    foreach (NodePair &pair, nodes_dy)
+      pair.second->bump = SHADER_BUMP_DY;
+
+    ShaderOutput *out = vector_input->link;
+    connect(nodes_dx[out->parent]->output(out->name()), node->input("VectorDX"));
+    connect(nodes_dy[out->parent]->output(out->name()), node->input("VectorDY"));
+
+    /* add generated nodes */
+    foreach (NodePair &pair, nodes_dx)
+      add(pair.second);
+    foreach (NodePair &pair, nodes_dy)
+      add(pair.second);
+  }
+
+  /* Images that share a texture coordinate can also share its copies. */
+  if (!image_nodes.empty()) {
+    deduplicate_nodes();
+  }
+}
+
 void ShaderGraph::bump_from_displacement(bool use_object_space)
 {
   /* generate bump mapping automatically from displacement. bump mapping is
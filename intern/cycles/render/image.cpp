@@ -32,6 +32,8 @@
 #include "util/util_texture.h"
 #include "util/util_unique_ptr.h"
 
+#include <OpenImageIO/texture.h>
+
 #ifdef WITH_OSL
 #  include <OSL/oslexec.h>
 #endif
@@ -77,6 +79,8 @@ const char *name_from_type(ImageDataType type)
       return "nanovdb_float";
     case IMAGE_DATA_TYPE_NANOVDB_FLOAT3:
       return "nanovdb_float3";
+    case IMAGE_DATA_TYPE_OIIO:
+      return "oiio";
     case IMAGE_DATA_NUM_TYPES:
       assert(!"System enumerator type, should never be used");
       return "";
@@ -219,6 +223,7 @@ ImageMetaData::ImageMetaData()
       colorspace(u_colorspace_raw),
       colorspace_file_format(""),
       use_transform_3d(false),
+      is_tiled_mipmap(false),
       compress_as_srgb(false)
 {
 }
@@ -300,16 +305,24 @@ ImageManager::ImageManager(const DeviceInfo &info)
 {
   need_update_ = true;
   osl_texture_system = NULL;
+  texture_cache = NULL;
   animation_frame = 0;
 
   /* Set image limits */
   has_half_images = info.has_half_images;
+  has_texture_cache = (info.type == DEVICE_CPU);
 }
 
 ImageManager::~ImageManager()
 {
   for (size_t slot = 0; slot < images.size(); slot++)
     assert(!images[slot]);
+
+  if (texture_cache) {
+    OIIO::TextureSystem *ts = (OIIO::TextureSystem *)texture_cache;
+    VLOG(2) << "Texture cache stats:\n" << ts->getstats();
+    OIIO::TextureSystem::destroy(ts);
+  }
 }
 
 void ImageManager::set_osl_texture_system(void *texture_system)
@@ -317,6 +330,11 @@ void ImageManager::set_osl_texture_system(void *texture_system)
   osl_texture_system = texture_system;
 }
 
+bool ImageManager::use_texture_cache(const Scene *scene) const
+{
+  return has_texture_cache && scene->params.use_texture_cache;
+}
+
 bool ImageManager::set_animation_frame_update(int frame)
 {
   if (frame != animation_frame) {
@@ -646,6 +664,54 @@ bool ImageManager::file_load_image(Image *img, int texture_limit)
   return true;
 }
 
+bool ImageManager::texture_cache_acquire(const Scene *scene,
+                                         Image *img,
+                                         TextureCacheHandle *r_handle)
+{
+  if (!use_texture_cache(scene)) {
+    return false;
+  }
+
+  /* Only files that store MIP levels in tiles benefit from being paged in on demand. The
+   * texture cache returns the pixels as they are in the file, so images that need a color
+   * space conversion or alpha changes on load are still loaded fully. */
+  const ImageMetaData &metadata = img->metadata;
+  const ustring filepath = img->loader->osl_filepath();
+  if (filepath.empty() || !metadata.is_tiled_mipmap || metadata.depth > 1) {
+    return false;
+  }
+  if (metadata.colorspace != u_colorspace_raw && metadata.colorspace != u_colorspace_srgb) {
+    return false;
+  }
+  if (metadata.channels == 2 || (metadata.channels == 4 && !image_associate_alpha(img))) {
+    return false;
+  }
+
+  OIIO::TextureSystem *ts;
+  {
+    thread_scoped_lock device_lock(device_mutex);
+    if (texture_cache == NULL) {
+      /* A private texture system with its own image cache. The shared one belongs to the OSL
+       * shader manager, and the attributes and destruction here must not affect it. */
+      ts = OIIO::TextureSystem::create(false);
+      ts->attribute("gray_to_rgb", 1);
+      ts->attribute("max_memory_MB", (float)scene->params.texture_cache_size);
+      texture_cache = ts;
+    }
+    ts = (OIIO::TextureSystem *)texture_cache;
+  }
+
+  OIIO::TextureSystem::TextureHandle *handle = ts->get_texture_handle(filepath);
+  if (handle == NULL || !ts->good(handle)) {
+    ts->geterror();
+    return false;
+  }
+
+  r_handle->texture_system = ts;
+  r_handle->handle = handle;
+  return true;
+}
+
 void ImageManager::device_load_image(Device *device, Scene *scene, int slot, Progress *progress)
 {
   if (progress->get_cancel()) {
@@ -659,7 +725,11 @@ void ImageManager::device_load_image(Device *device, Scene *scene, int slot, Pro
   const int texture_limit = scene->params.texture_limit;
 
   load_image_metadata(img);
-  ImageDataType type = img->metadata.type;
+
+  /* Tiled images are paged in on demand while rendering, only their handle is stored. */
+  TextureCacheHandle cache_handle;
+  const bool use_cache = texture_cache_acquire(scene, img, &cache_handle);
+  ImageDataType type = (use_cache) ? IMAGE_DATA_TYPE_OIIO : img->metadata.type;
 
   /* Name for debugging. */
   img->mem_name = string_printf("__tex_image_%s_%03d", name_from_type(type), slot);
@@ -677,7 +747,13 @@ void ImageManager::device_load_image(Device *device, Scene *scene, int slot, Pro
   img->mem->info.transform_3d = img->metadata.transform_3d;
 
   /* Create new texture. */
-  if (type == IMAGE_DATA_TYPE_FLOAT4) {
+  if (type == IMAGE_DATA_TYPE_OIIO) {
+    thread_scoped_lock device_lock(device_mutex);
+    TextureCacheHandle *pixels = (TextureCacheHandle *)img->mem->alloc(1, 1);
+
+    *pixels = cache_handle;
+  }
+  else if (type == IMAGE_DATA_TYPE_FLOAT4) {
     if (!file_load_image<TypeDesc::FLOAT, float>(img, texture_limit)) {
       /* on failure to load, we set a 1x1 pixels pink image */
       thread_scoped_lock device_lock(device_mutex);
@@ -798,6 +874,10 @@ void ImageManager::device_free_image(Device *, int slot)
 #endif
   }
 
+  if (texture_cache && img->mem && img->mem->info.data_type == IMAGE_DATA_TYPE_OIIO) {
+    ((OIIO::TextureSystem *)texture_cache)->invalidate(img->loader->osl_filepath());
+  }
+
   if (img->mem) {
     thread_scoped_lock device_lock(device_mutex);
     delete img->mem;
@@ -88,6 +88,9 @@ class ImageMetaData {
   bool use_transform_3d;
   Transform transform_3d;
 
+  /* Optional, file is stored in tiles with MIP levels. */
+  bool is_tiled_mipmap;
+
   /* Automatically set. */
   bool compress_as_srgb;
 
@@ -187,6 +190,9 @@ class ImageManager {
   void set_osl_texture_system(void *texture_system);
   bool set_animation_frame_update(int frame);
 
+  /* Check whether images may be sampled through the texture cache. */
+  bool use_texture_cache(const Scene *scene) const;
+
   void collect_statistics(RenderStats *stats);
 
   void tag_update();
@@ -213,6 +219,7 @@ class ImageManager {
  private:
   bool need_update_;
   bool has_half_images;
+  bool has_texture_cache;
 
   thread_mutex device_mutex;
   thread_mutex images_mutex;
@@ -220,6 +227,7 @@ class ImageManager {
 
   vector<Image *> images;
   void *osl_texture_system;
+  void *texture_cache;
 
   int add_image_slot(ImageLoader *loader, const ImageParams &params, const bool builtin);
   void add_image_user(int slot);
@@ -230,6 +238,8 @@ class ImageManager {
   template<TypeDesc::BASETYPE FileFormat, typename StorageType>
   bool file_load_image(Image *img, int texture_limit);
 
+  bool texture_cache_acquire(const Scene *scene, Image *img, TextureCacheHandle *r_handle);
+
   void device_load_image(Device *device, Scene *scene, int slot, Progress *progress);
   void device_free_image(Device *device, int slot);
 
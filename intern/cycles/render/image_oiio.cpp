@@ -98,6 +98,10 @@ bool OIIOImageLoader::load_metadata(ImageMetaData &metadata)
 
   metadata.colorspace_file_format = in->format_name();
 
+  /* Tiled files with MIP levels can be paged in on demand by the texture cache. */
+  metadata.is_tiled_mipmap = (spec.tile_width > 0 && spec.tile_height > 0 &&
+                              in->seek_subimage(0, 1));
+
   in->close();
 
   return true;
@@ -211,6 +215,7 @@ bool OIIOImageLoader::load_pixels(const ImageMetaData &metadata,
       break;
     case IMAGE_DATA_TYPE_NANOVDB_FLOAT:
     case IMAGE_DATA_TYPE_NANOVDB_FLOAT3:
+    case IMAGE_DATA_TYPE_OIIO:
     case IMAGE_DATA_NUM_TYPES:
       break;
   }
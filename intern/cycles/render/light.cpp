@@ -15,6 +15,7 @@
  */
 
 #include "render/light.h"
+#include "render/light_tree.h"
 #include "device/device.h"
 #include "render/background.h"
 #include "render/film.h"
@@ -30,6 +31,7 @@
 #include "util/util_foreach.h"
 #include "util/util_hash.h"
 #include "util/util_logging.h"
+#include "util/util_map.h"
 #include "util/util_path.h"
 #include "util/util_progress.h"
 #include "util/util_task.h"
@@ -282,6 +284,126 @@ bool LightManager::object_usable_as_light(Object *object)
   return false;
 }
 
+/* Estimate of the emission strength of a mesh light shader for the light tree, unknown emission
+ * of shaders with varying emission is assumed to have unit strength. */
+static float light_tree_shader_emission(Shader *shader, unordered_map<Shader *, float> &cache)
+{
+  unordered_map<Shader *, float>::const_iterator it = cache.find(shader);
+  if (it != cache.end()) {
+    return it->second;
+  }
+
+  float3 emission;
+  const float estimate = shader->is_constant_emission(&emission) ? average(fabs(emission)) : 1.0f;
+  cache[shader] = estimate;
+  return estimate;
+}
+
+static LightTreePrimitive light_tree_lamp_primitive(Light *light, const int distribution_id)
+{
+  LightTreePrimitive prim;
+  prim.distribution_id = distribution_id;
+  prim.energy = average(fabs(light->get_strength()));
+
+  const float3 co = light->get_co();
+  const LightType type = light->get_light_type();
+
+  if (type == LIGHT_POINT || type == LIGHT_SPOT) {
+    const float radius = light->get_size();
+    prim.bbox = BoundBox(co - make_float3(radius), co + make_float3(radius));
+    if (type == LIGHT_SPOT) {
+      prim.orientation = LightTreeOrientation(
+          safe_normalize(light->get_dir()), 0.0f, light->get_spot_angle() * 0.5f);
+    }
+    else {
+      prim.orientation = LightTreeOrientation(
+          make_float3(0.0f, 0.0f, 1.0f), M_PI_F, M_PI_2_F);
+    }
+  }
+  else if (type == LIGHT_AREA) {
+    const float3 axisu = light->get_axisu() * (light->get_sizeu() * light->get_size() * 0.5f);
+    const float3 axisv = light->get_axisv() * (light->get_sizev() * light->get_size() * 0.5f);
+    prim.bbox = BoundBox(co - axisu - axisv);
+    prim.bbox.grow(co + axisu - axisv);
+    prim.bbox.grow(co - axisu + axisv);
+    prim.bbox.grow(co + axisu + axisv);
+    /* Area lights only emit on their front side. */
+    prim.orientation = LightTreeOrientation(safe_normalize(light->get_dir()), 0.0f, M_PI_2_F);
+  }
+  else {
+    /* Distant and background lights are sampled separately from the tree. */
+    prim.bbox = BoundBox(zero_float3());
+  }
+
+  return prim;
+}
+
+template<typename T>
+static void light_tree_pack_bounds(T *kitem,
+                                   const BoundBox &bbox,
+                                   const LightTreeOrientation &orientation,
+                                   const float energy)
+{
+  kitem->bbox_min[0] = bbox.min.x;
+  kitem->bbox_min[1] = bbox.min.y;
+  kitem->bbox_min[2] = bbox.min.z;
+  kitem->bbox_max[0] = bbox.max.x;
+  kitem->bbox_max[1] = bbox.max.y;
+  kitem->bbox_max[2] = bbox.max.z;
+  kitem->axis[0] = orientation.axis.x;
+  kitem->axis[1] = orientation.axis.y;
+  kitem->axis[2] = orientation.axis.z;
+  kitem->theta_o = orientation.theta_o;
+  kitem->theta_e = orientation.theta_e;
+  kitem->energy = energy;
+}
+
+void LightManager::device_update_light_tree(DeviceScene *dscene,
+                                            vector<LightTreePrimitive> &prims,
+                                            const vector<LightTreePrimitive> &distant_prims,
+                                            const size_t num_distribution)
+{
+  /* Building the tree reorders the primitives to the order of its leaves. */
+  const LightTree light_tree(prims, 8);
+  const vector<LightTreeNode> &nodes = light_tree.get_nodes();
+
+  VLOG(1) << "Light tree with " << nodes.size() << " nodes for " << prims.size()
+          << " emitters, and " << distant_prims.size() << " distant lights.";
+
+  /* Keep the device memory from being empty when there are only distant lights. */
+  KernelLightTreeNode *knodes = dscene->light_tree_nodes.alloc(nodes.empty() ? 1 : nodes.size());
+  memset(knodes, 0, sizeof(KernelLightTreeNode));
+  for (size_t i = 0; i < nodes.size(); i++) {
+    const LightTreeNode &node = nodes[i];
+    light_tree_pack_bounds(&knodes[i], node.bbox, node.orientation, node.energy);
+    knodes[i].first_emitter = node.first_prim;
+    knodes[i].num_emitters = node.num_prims;
+    knodes[i].right_child = node.right_child;
+    knodes[i].pad = 0;
+  }
+
+  /* Distant lights are stored after the emitters of the tree. */
+  const size_t num_emitters = prims.size() + distant_prims.size();
+  KernelLightTreeEmitter *kemitters = dscene->light_tree_emitters.alloc(
+      (num_emitters) ? num_emitters : 1);
+  memset(kemitters, 0, sizeof(KernelLightTreeEmitter));
+  uint *kemitter_index = dscene->light_tree_emitter_index.alloc(num_distribution);
+  std::fill(kemitter_index, kemitter_index + num_distribution, ~0u);
+
+  for (size_t i = 0; i < num_emitters; i++) {
+    const LightTreePrimitive &prim = (i < prims.size()) ? prims[i] :
+                                                          distant_prims[i - prims.size()];
+    light_tree_pack_bounds(&kemitters[i], prim.bbox, prim.orientation, prim.energy);
+    kemitters[i].distribution_id = prim.distribution_id;
+    kemitters[i].pad1 = kemitters[i].pad2 = kemitters[i].pad3 = 0;
+    kemitter_index[prim.distribution_id] = i;
+  }
+
+  dscene->light_tree_nodes.copy_to_device();
+  dscene->light_tree_emitters.copy_to_device();
+  dscene->light_tree_emitter_index.copy_to_device();
+}
+
 void LightManager::device_update_distribution(Device *,
                                               DeviceScene *dscene,
                                               Scene *scene,
@@ -289,6 +411,14 @@ void LightManager::device_update_distribution(Device *,
 {
   progress.set_status("Updating Lights", "Computing distribution");
 
+  /* The light tree replaces the distribution for picking lights in the path tracer. Branched path
+   * tracing samples lamps and mesh lights separately, so it keeps using the distribution. */
+  const bool use_light_tree = scene->integrator->get_use_light_tree() &&
+                              scene->integrator->get_method() == Integrator::PATH;
+  vector<LightTreePrimitive> light_tree_prims;
+  vector<LightTreePrimitive> light_tree_distant_prims;
+  unordered_map<Shader *, float> shader_emission;
+
   /* count */
   size_t num_lights = 0;
   size_t num_portals = 0;
@@ -400,13 +530,29 @@ void LightManager::device_update_distribution(Device *,
           p3 = transform_point(&tfm, p3);
         }
 
-        totarea += triangle_area(p1, p2, p3);
+        const float area = triangle_area(p1, p2, p3);
+        totarea += area;
+
+        if (use_light_tree) {
+          LightTreePrimitive prim;
+          prim.distribution_id = offset - 1;
+          prim.bbox = BoundBox(p1);
+          prim.bbox.grow(p2);
+          prim.bbox.grow(p3);
+          /* Mesh lights emit on both sides. */
+          prim.orientation = LightTreeOrientation(
+              safe_normalize(cross(p2 - p1, p3 - p1)), M_PI_F, M_PI_2_F);
+          prim.energy = area * light_tree_shader_emission(shader, shader_emission);
+          light_tree_prims.push_back(prim);
+        }
       }
     }
 
     j++;
   }
 
+  const size_t num_light_tree_triangles = light_tree_prims.size();
+
   float trianglearea = totarea;
 
   /* point lights */
@@ -424,6 +570,15 @@ void LightManager::device_update_distribution(Device *,
     distribution[offset].lamp.size = light->size;
     totarea += lightarea;
 
+    if (use_light_tree) {
+      if (light->light_type == LIGHT_DISTANT || light->light_type == LIGHT_BACKGROUND) {
+        light_tree_distant_prims.push_back(light_tree_lamp_primitive(light, offset));
+      }
+      else {
+        light_tree_prims.push_back(light_tree_lamp_primitive(light, offset));
+      }
+    }
+
     if (light->light_type == LIGHT_DISTANT) {
       use_lamp_mis |= (light->angle > 0.0f && light->use_mis);
     }
@@ -488,6 +643,45 @@ void LightManager::device_update_distribution(Device *,
 
     kintegrator->use_lamp_mis = use_lamp_mis;
 
+    /* Light tree. The energy of the emitters is normalized so that without taking the distance
+     * and orientation into account, mesh lights and lamps get the same share as in the
+     * distribution. This keeps the probabilities of the distant lights outside of the tree. */
+    kintegrator->use_light_tree = use_light_tree;
+    if (use_light_tree) {
+      const size_t num_local_lights = light_tree_prims.size() - num_light_tree_triangles;
+      float triangle_energy = 0.0f;
+      float local_light_energy = 0.0f;
+      for (size_t i = 0; i < light_tree_prims.size(); i++) {
+        float &energy = (i < num_light_tree_triangles) ? triangle_energy : local_light_energy;
+        energy += light_tree_prims[i].energy;
+      }
+
+      const float local_light_weight = (num_lights) ? (float)num_local_lights / num_lights : 0.0f;
+      const float triangle_scale = (triangle_energy > 0.0f) ? 1.0f / triangle_energy : 0.0f;
+      const float local_light_scale = (local_light_energy > 0.0f) ?
+                                          local_light_weight / local_light_energy :
+                                          0.0f;
+      for (size_t i = 0; i < light_tree_prims.size(); i++) {
+        light_tree_prims[i].energy *= (i < num_light_tree_triangles) ? triangle_scale :
+                                                                        local_light_scale;
+      }
+
+      const float mesh_light_weight = (trianglearea > 0.0f) ? 1.0f : 0.0f;
+      const float lamp_weight = (num_lights) ? 1.0f : 0.0f;
+      kintegrator->pdf_light_tree = (mesh_light_weight + local_light_weight) /
+                                    (mesh_light_weight + lamp_weight);
+      kintegrator->num_light_tree_emitters = light_tree_prims.size();
+      kintegrator->num_light_tree_distant = light_tree_distant_prims.size();
+
+      device_update_light_tree(
+          dscene, light_tree_prims, light_tree_distant_prims, num_distribution);
+    }
+    else {
+      kintegrator->pdf_light_tree = 0.0f;
+      kintegrator->num_light_tree_emitters = 0;
+      kintegrator->num_light_tree_distant = 0;
+    }
+
     /* bit of an ugly hack to compensate for emitting triangles influencing
      * amount of samples we get for this pass */
     kfilm->pass_shadow_scale = 1.0f;
@@ -524,6 +718,10 @@ void LightManager::device_update_distribution(Device *,
     kintegrator->pdf_triangles = 0.0f;
     kintegrator->pdf_lights = 0.0f;
     kintegrator->use_lamp_mis = false;
+    kintegrator->use_light_tree = false;
+    kintegrator->pdf_light_tree = 0.0f;
+    kintegrator->num_light_tree_emitters = 0;
+    kintegrator->num_light_tree_distant = 0;
 
     kbackground->num_portals = 0;
     kbackground->portal_offset = 0;
@@ -1013,6 +1211,9 @@ void LightManager::device_update(Device *device,
 void LightManager::device_free(Device *, DeviceScene *dscene, const bool free_background)
 {
   dscene->light_distribution.free();
+  dscene->light_tree_nodes.free();
+  dscene->light_tree_emitters.free();
+  dscene->light_tree_emitter_index.free();
   dscene->lights.free();
   if (free_background) {
     dscene->light_background_marginal_cdf.free();
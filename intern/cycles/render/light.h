@@ -38,6 +38,7 @@ class Object;
 class Progress;
 class Scene;
 class Shader;
+struct LightTreePrimitive;
 
 class Light : public Node {
  public:
@@ -100,6 +101,7 @@ class LightManager {
     OBJECT_MANAGER = (1 << 5),
     SHADER_COMPILED = (1 << 6),
     SHADER_MODIFIED = (1 << 7),
+    INTEGRATOR_MODIFIED = (1 << 8),
 
     /* tag everything in the manager for an update */
     UPDATE_ALL = ~0u,
@@ -147,6 +149,10 @@ class LightManager {
                                 Scene *scene,
                                 Progress &progress);
   void device_update_ies(DeviceScene *dscene);
+  void device_update_light_tree(DeviceScene *dscene,
+                                vector<LightTreePrimitive> &prims,
+                                const vector<LightTreePrimitive> &distant_prims,
+                                const size_t num_distribution);
 
   /* Check whether light manager can use the object as a light-emissive. */
   bool object_usable_as_light(Object *object);
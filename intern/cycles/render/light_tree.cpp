@@ -0,0 +1,210 @@
+/*
+ * Copyright 2021 Blender Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "render/light_tree.h"
+
+#include "util/util_algorithm.h"
+#include "util/util_math.h"
+
+CCL_NAMESPACE_BEGIN
+
+float LightTreeOrientation::measure() const
+{
+  const float theta_w = min(theta_o + theta_e, M_PI_F);
+  const float cos_theta_o = cosf(theta_o);
+  const float sin_theta_o = sinf(theta_o);
+  return M_2PI_F * (1.0f - cos_theta_o) +
+         M_PI_2_F * (2.0f * theta_w * sin_theta_o - cosf(theta_o - 2.0f * theta_w) -
+                     2.0f * theta_o * sin_theta_o + cos_theta_o);
+}
+
+LightTreeOrientation merge(const LightTreeOrientation &a, const LightTreeOrientation &b)
+{
+  /* Let the first bounds be the wider ones. */
+  if (b.theta_o > a.theta_o) {
+    return merge(b, a);
+  }
+
+  const float theta_d = safe_acosf(dot(a.axis, b.axis));
+  const float theta_e = max(a.theta_e, b.theta_e);
+
+  if (min(theta_d + b.theta_o, M_PI_F) <= a.theta_o) {
+    /* The wider bounds contain the other ones. */
+    return LightTreeOrientation(a.axis, a.theta_o, theta_e);
+  }
+
+  const float theta_o = (a.theta_o + theta_d + b.theta_o) * 0.5f;
+  if (theta_o >= M_PI_F) {
+    return LightTreeOrientation(a.axis, M_PI_F, theta_e);
+  }
+
+  /* Rotate the axis of the wider bounds towards the other axis. */
+  const float3 rotation_axis = cross(a.axis, b.axis);
+  if (len_squared(rotation_axis) < 1e-12f) {
+    return LightTreeOrientation(a.axis, M_PI_F, theta_e);
+  }
+  const float theta_r = theta_o - a.theta_o;
+  const float3 axis = a.axis * cosf(theta_r) +
+                      cross(normalize(rotation_axis), a.axis) * sinf(theta_r);
+  return LightTreeOrientation(normalize(axis), theta_o, theta_e);
+}
+
+LightTree::LightTree(vector<LightTreePrimitive> &prims, const int max_prims_in_leaf)
+    : prims(prims), max_prims_in_leaf(max(max_prims_in_leaf, 1))
+{
+  if (prims.empty()) {
+    return;
+  }
+  nodes.reserve(2 * prims.size() / this->max_prims_in_leaf + 1);
+  recursive_build(0, prims.size());
+}
+
+int LightTree::recursive_build(const int first, const int num)
+{
+  LightTreeNode node;
+  node.bbox = BoundBox::empty;
+  node.orientation = prims[first].orientation;
+  node.energy = 0.0f;
+  node.first_prim = first;
+  node.num_prims = num;
+  node.right_child = -1;
+
+  BoundBox centroid_bbox = BoundBox::empty;
+  for (int i = first; i < first + num; i++) {
+    const LightTreePrimitive &prim = prims[i];
+    node.bbox.grow(prim.bbox);
+    node.orientation = merge(node.orientation, prim.orientation);
+    node.energy += prim.energy;
+    centroid_bbox.grow(prim.bbox.center());
+  }
+
+  const int node_index = nodes.size();
+  nodes.push_back(node);
+
+  if (num <= max_prims_in_leaf) {
+    return node_index;
+  }
+
+  /* Partition the primitives at the best split, or in the middle when all primitives are at the
+   * same place and the heuristic can't tell them apart. */
+  int split_axis;
+  float split_centroid;
+  int middle = first + num / 2;
+  if (find_split(node, centroid_bbox, &split_axis, &split_centroid)) {
+    LightTreePrimitive *split = std::partition(
+        &prims[first], &prims[first] + num, [&](const LightTreePrimitive &prim) {
+          return prim.bbox.center()[split_axis] < split_centroid;
+        });
+    const int split_index = split - &prims[0];
+    if (split_index > first && split_index < first + num) {
+      middle = split_index;
+    }
+  }
+
+  recursive_build(first, middle - first);
+  const int right_child = recursive_build(middle, first + num - middle);
+  nodes[node_index].right_child = right_child;
+
+  return node_index;
+}
+
+bool LightTree::find_split(const LightTreeNode &node,
+                           const BoundBox &centroid_bbox,
+                           int *r_split_axis,
+                           float *r_split_centroid)
+{
+  const int num_buckets = 12;
+
+  struct Bucket {
+    int count = 0;
+    float energy = 0.0f;
+    BoundBox bbox = BoundBox::empty;
+    LightTreeOrientation orientation;
+
+    void add(const Bucket &other)
+    {
+      orientation = (count == 0) ? other.orientation : merge(orientation, other.orientation);
+      count += other.count;
+      energy += other.energy;
+      bbox.grow(other.bbox);
+    }
+  };
+
+  const float3 extent = centroid_bbox.size();
+  const float max_extent = max3(extent);
+  /* Keeps splits of point lights without an area from all having the same cost. */
+  const float area_epsilon = node.bbox.area() * 1e-4f;
+
+  auto cost = [&](const Bucket &bucket) {
+    return bucket.energy * bucket.orientation.measure() * (bucket.bbox.area() + area_epsilon);
+  };
+
+  float min_cost = FLT_MAX;
+  bool found = false;
+
+  for (int axis = 0; axis < 3; axis++) {
+    if (!(extent[axis] > 0.0f)) {
+      continue;
+    }
+
+    Bucket buckets[num_buckets];
+    const float inv_extent = 1.0f / extent[axis];
+    for (int i = node.first_prim; i < node.first_prim + node.num_prims; i++) {
+      const LightTreePrimitive &prim = prims[i];
+      const float offset = (prim.bbox.center()[axis] - centroid_bbox.min[axis]) * inv_extent;
+      const int bucket_index = clamp((int)(offset * num_buckets), 0, num_buckets - 1);
+
+      Bucket prim_bucket;
+      prim_bucket.count = 1;
+      prim_bucket.energy = prim.energy;
+      prim_bucket.bbox = prim.bbox;
+      prim_bucket.orientation = prim.orientation;
+      buckets[bucket_index].add(prim_bucket);
+    }
+
+    /* Elongated nodes are preferably split along their longest axis. */
+    const float regularization = max_extent * inv_extent;
+
+    for (int split = 1; split < num_buckets; split++) {
+      Bucket left, right;
+      for (int i = 0; i < split; i++) {
+        if (buckets[i].count) {
+          left.add(buckets[i]);
+        }
+      }
+      for (int i = split; i < num_buckets; i++) {
+        if (buckets[i].count) {
+          right.add(buckets[i]);
+        }
+      }
+      if (left.count == 0 || right.count == 0) {
+        continue;
+      }
+
+      const float split_cost = (cost(left) + cost(right)) * regularization;
+      if (split_cost < min_cost) {
+        min_cost = split_cost;
+        *r_split_axis = axis;
+        *r_split_centroid = centroid_bbox.min[axis] + extent[axis] * split / num_buckets;
+        found = true;
+      }
+    }
+  }
+
+  return found;
+}
+
+CCL_NAMESPACE_END
@@ -0,0 +1,96 @@
+/*
+ * Copyright 2021 Blender Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __LIGHT_TREE_H__
+#define __LIGHT_TREE_H__
+
+#include "util/util_boundbox.h"
+#include "util/util_types.h"
+#include "util/util_vector.h"
+
+CCL_NAMESPACE_BEGIN
+
+/* Bounds of the directions into which a group of emitters emits light. The normals of the
+ * emitters are within theta_o of the axis, and light leaves within theta_e of the normals. */
+struct LightTreeOrientation {
+  float3 axis;
+  float theta_o;
+  float theta_e;
+
+  LightTreeOrientation() : axis(make_float3(0.0f, 0.0f, 1.0f)), theta_o(0.0f), theta_e(0.0f)
+  {
+  }
+
+  LightTreeOrientation(const float3 &axis, float theta_o, float theta_e)
+      : axis(axis), theta_o(theta_o), theta_e(theta_e)
+  {
+  }
+
+  /* Measure of the solid angle covered by the bounds, as used by the split heuristic. */
+  float measure() const;
+};
+
+LightTreeOrientation merge(const LightTreeOrientation &a, const LightTreeOrientation &b);
+
+/* Emitter in the light tree, either a lamp or an emissive triangle. */
+struct LightTreePrimitive {
+  /* Index in the light distribution. */
+  int distribution_id;
+  BoundBox bbox;
+  LightTreeOrientation orientation;
+  float energy;
+};
+
+struct LightTreeNode {
+  BoundBox bbox;
+  LightTreeOrientation orientation;
+  float energy;
+  int first_prim;
+  int num_prims;
+  /* Index of the second child, -1 for leaves. The first child directly follows the node. */
+  int right_child;
+};
+
+/* Bounding volume hierarchy over the emitters of the scene, with bounds on their energy and
+ * orientation, so the kernel can pick lights by their estimated contribution to a shading point.
+ *
+ * Built top-down with the surface area orientation heuristic from
+ * "Importance Sampling of Many Lights with Adaptive Tree Splitting" by Conty Estevez and Kulla. */
+class LightTree {
+ public:
+  /* Reorders the primitives to the order of the leaves of the tree. */
+  LightTree(vector<LightTreePrimitive> &prims, int max_prims_in_leaf);
+
+  const vector<LightTreeNode> &get_nodes() const
+  {
+    return nodes;
+  }
+
+ protected:
+  int recursive_build(int first, int num);
+  bool find_split(const LightTreeNode &node,
+                  const BoundBox &centroid_bbox,
+                  int *r_split_axis,
+                  float *r_split_centroid);
+
+  vector<LightTreePrimitive> &prims;
+  vector<LightTreeNode> nodes;
+  int max_prims_in_leaf;
+};
+
+CCL_NAMESPACE_END
+
+#endif /* __LIGHT_TREE_H__ */
@@ -252,6 +252,23 @@ string ImageStats::full_report(int indent_level)
   return result;
 }
 
+/* BVH statistics. */
+
+BVHStats::BVHStats()
+{
+}
+
+string BVHStats::full_report(int indent_level)
+{
+  const string indent(indent_level * kIndentNumSpaces, ' ');
+  string result = "";
+  result += indent + "Layout: " + layout + "\n";
+  if (!nodes.entries.empty()) {
+    result += indent + "Nodes:\n" + nodes.full_report(indent_level + 1);
+  }
+  return result;
+}
+
 /* Overall statistics. */
 
 RenderStats::RenderStats()
@@ -334,6 +351,7 @@ string RenderStats::full_report()
   string result = "";
   result += "Mesh statistics:\n" + mesh.full_report(1);
   result += "Image statistics:\n" + image.full_report(1);
+  result += "BVH statistics:\n" + bvh.full_report(1);
   if (has_profiling) {
     result += "Kernel statistics:\n" + kernel.full_report(1);
     result += "Shader statistics:\n" + shaders.full_report(1);
@@ -173,6 +173,22 @@ class ImageStats {
   NamedSizeStats textures;
 };
 
+/* Statistics about the packed BVH of the scene. */
+class BVHStats {
+ public:
+  BVHStats();
+
+  /* Generate full human-readable report. */
+  string full_report(int indent_level = 0);
+
+  /* Name of the BVH layout used for the render. */
+  string layout;
+
+  /* Memory of the packed nodes and primitive arrays, which depends on the layout. Empty for
+   * layouts built by an external library, like Embree. */
+  NamedSizeStats nodes;
+};
+
 /* Render process statistics. */
 class RenderStats {
  public:
@@ -188,6 +204,7 @@ class RenderStats {
 
   MeshStats mesh;
   ImageStats image;
+  BVHStats bvh;
   NamedNestedSampleStats kernel;
   NamedSampleCountStats shaders;
   NamedSampleCountStats objects;
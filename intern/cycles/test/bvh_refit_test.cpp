@@ -0,0 +1,289 @@
+/*
+ * Copyright 2021 Blender Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "testing/testing.h"
+
+#include "bvh/bvh2.h"
+#include "bvh/bvh4.h"
+
+#include "render/mesh.h"
+#include "render/object.h"
+
+#include "util/util_progress.h"
+#include "util/util_task.h"
+
+CCL_NAMESPACE_BEGIN
+
+namespace {
+
+const int GRID_SIZE = 32;
+
+void create_grid(Mesh *mesh)
+{
+  mesh->reserve_mesh(GRID_SIZE * GRID_SIZE, (GRID_SIZE - 1) * (GRID_SIZE - 1) * 2);
+  for (int y = 0; y < GRID_SIZE; y++) {
+    for (int x = 0; x < GRID_SIZE; x++) {
+      mesh->add_vertex(make_float3(x, y, 0.0f));
+    }
+  }
+  for (int y = 0; y < GRID_SIZE - 1; y++) {
+    for (int x = 0; x < GRID_SIZE - 1; x++) {
+      const int v = y * GRID_SIZE + x;
+      mesh->add_triangle(v, v + 1, v + GRID_SIZE + 1, 0, false);
+      mesh->add_triangle(v, v + GRID_SIZE + 1, v + GRID_SIZE, 0, false);
+    }
+  }
+}
+
+BoundBox child_bounds(const PackedBVH &pack, int idx, int child)
+{
+  const int4 *data = &pack.nodes[idx];
+  BoundBox bounds;
+  bounds.min = make_float3(__int_as_float(data[1][child]),
+                           __int_as_float(data[2][child]),
+                           __int_as_float(data[3][child]));
+  bounds.max = make_float3(__int_as_float(data[1][child + 2]),
+                           __int_as_float(data[2][child + 2]),
+                           __int_as_float(data[3][child + 2]));
+  return bounds;
+}
+
+BoundBox bvh4_child_bounds(const PackedBVH &pack, int idx, int child)
+{
+  const int4 *data = &pack.nodes[idx];
+  const float3 origin = make_float3(
+      __int_as_float(data[2].x), __int_as_float(data[2].y), __int_as_float(data[2].z));
+  const float3 scale = make_float3(
+      __int_as_float(data[3].x), __int_as_float(data[3].y), __int_as_float(data[3].z));
+  const int shift = child * 8;
+  const float3 lower = make_float3((data[4].x >> shift) & 0xff,
+                                   (data[4].y >> shift) & 0xff,
+                                   (data[4].z >> shift) & 0xff);
+  const float3 upper = make_float3((data[4].w >> shift) & 0xff,
+                                   (data[2].w >> shift) & 0xff,
+                                   (data[3].w >> shift) & 0xff);
+  return BoundBox(origin + lower * scale, origin + upper * scale);
+}
+
+bool bbox_contains(const BoundBox &bounds, const BoundBox &other)
+{
+  return bounds.min.x <= other.min.x && bounds.min.y <= other.min.y &&
+         bounds.min.z <= other.min.z && bounds.max.x >= other.max.x &&
+         bounds.max.y >= other.max.y && bounds.max.z >= other.max.z;
+}
+
+/* Check that the bounds stored for every child contain all triangles below it. */
+bool check_subtree(
+    const PackedBVH &pack, BVHLayout layout, const Mesh *mesh, int child, const BoundBox &bounds)
+{
+  if (child < 0) {
+    const int4 leaf = pack.leaf_nodes[-child - 1];
+    for (int prim = leaf.x; prim < leaf.y; prim++) {
+      BoundBox prim_bounds = BoundBox::empty;
+      mesh->get_triangle(pack.prim_index[prim]).bounds_grow(&mesh->get_verts()[0], prim_bounds);
+      if (!bbox_contains(bounds, prim_bounds)) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  const int4 data = pack.nodes[child];
+  if (layout == BVH_LAYOUT_BVH4) {
+    for (int i = 0; i < BVH4_NUM_CHILDREN; i++) {
+      /* Unused slots are only skipped by traversal when they have no visibility. */
+      if (data[i] == 0) {
+        if (pack.nodes[child + 1][i] != 0) {
+          return false;
+        }
+      }
+      else if (!check_subtree(pack, layout, mesh, data[i], bvh4_child_bounds(pack, child, i))) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  return check_subtree(pack, layout, mesh, data.z, child_bounds(pack, child, 0)) &&
+         check_subtree(pack, layout, mesh, data.w, child_bounds(pack, child, 1));
+}
+
+bool check_bvh(const PackedBVH &pack, BVHLayout layout, const Mesh *mesh)
+{
+  BoundBox bounds = BoundBox::empty;
+  for (const float3 &P : mesh->get_verts()) {
+    bounds.grow(P);
+  }
+  return check_subtree(pack, layout, mesh, (pack.root_index == -1) ? -1 : 0, bounds);
+}
+
+void deform_wave(array<float3> &verts)
+{
+  for (float3 &P : verts) {
+    P.z = sinf(P.x * 0.5f) * 0.25f;
+  }
+}
+
+void test_refit(BVHLayout layout)
+{
+  TaskScheduler::init(0);
+
+  Mesh *mesh = new Mesh();
+  create_grid(mesh);
+
+  Object object;
+  object.set_geometry(mesh);
+
+  vector<Geometry *> geometry(1, mesh);
+  vector<Object *> objects(1, &object);
+
+  BVHParams params;
+  params.bvh_layout = layout;
+  params.use_spatial_split = false;
+  BVH2 *bvh = static_cast<BVH2 *>(BVH::create(params, geometry, objects, NULL));
+  mesh->bvh = bvh;
+
+  Progress progress;
+  bvh->build(progress, NULL);
+  ASSERT_EQ(bvh->pack.root_index, 0);
+  EXPECT_TRUE(check_bvh(bvh->pack, layout, mesh));
+  const size_t num_nodes = bvh->pack.nodes.size();
+  const float build_sah_cost = bvh->get_build_sah_cost();
+
+  /* Deform the grid into a shallow wave, refit keeps the hierarchy. */
+  array<float3> verts = mesh->get_verts();
+  deform_wave(verts);
+  mesh->set_verts(verts);
+
+  bvh->refit(progress);
+  EXPECT_EQ(bvh->pack.nodes.size(), num_nodes);
+  EXPECT_EQ(bvh->get_build_sah_cost(), build_sah_cost);
+  EXPECT_LE(bvh->get_refit_sah_cost(), build_sah_cost * params.refit_sah_threshold);
+  EXPECT_TRUE(check_bvh(bvh->pack, layout, mesh));
+
+  /* Swap vertices of opposite corners, which degrades the SAH cost enough to fall back to a
+   * rebuild. A rebuild resets the reference cost to that of the new hierarchy. */
+  verts = mesh->get_verts();
+  for (int i = 0; i < GRID_SIZE * GRID_SIZE / 2; i += 2) {
+    std::swap(verts[i], verts[GRID_SIZE * GRID_SIZE - 1 - i]);
+  }
+  mesh->set_verts(verts);
+
+  bvh->refit(progress);
+  EXPECT_NE(bvh->get_build_sah_cost(), build_sah_cost);
+  EXPECT_EQ(bvh->get_refit_sah_cost(), bvh->get_build_sah_cost());
+  EXPECT_TRUE(check_bvh(bvh->pack, layout, mesh));
+
+  delete mesh;
+  TaskScheduler::exit();
+}
+
+}  // namespace
+
+TEST(bvh2, refit)
+{
+  test_refit(BVH_LAYOUT_BVH2);
+}
+
+TEST(bvh4, refit)
+{
+  test_refit(BVH_LAYOUT_BVH4);
+}
+
+TEST(bvh2, refit_top_level)
+{
+  TaskScheduler::init(0);
+
+  Mesh *mesh_a = new Mesh();
+  Mesh *mesh_b = new Mesh();
+  create_grid(mesh_a);
+  create_grid(mesh_b);
+
+  Object object_a;
+  Object object_b;
+  object_a.set_geometry(mesh_a);
+  object_b.set_geometry(mesh_b);
+  object_b.set_tfm(transform_translate(0.0f, 0.0f, 10.0f));
+
+  vector<Geometry *> geometry;
+  geometry.push_back(mesh_a);
+  geometry.push_back(mesh_b);
+  vector<Object *> objects;
+  objects.push_back(&object_a);
+  objects.push_back(&object_b);
+
+  BVHParams params;
+  params.bvh_layout = BVH_LAYOUT_BVH2;
+  params.use_spatial_split = false;
+
+  /* Both meshes are instanced, build their own BVH first as the geometry manager does. Primitive
+   * offsets stay zero, so merged instance primitives can be checked against each mesh directly. */
+  Progress progress;
+  for (size_t i = 0; i < objects.size(); i++) {
+    Geometry *geom = geometry[i];
+    geom->compute_bounds();
+    objects[i]->compute_bounds(false);
+
+    BVH2 *geom_bvh = static_cast<BVH2 *>(BVH::create(
+        params, vector<Geometry *>(1, geom), vector<Object *>(1, objects[i]), NULL));
+    geom_bvh->build(progress, NULL);
+    geom->bvh = geom_bvh;
+  }
+
+  params.top_level = true;
+  BVH2 *bvh = static_cast<BVH2 *>(BVH::create(params, geometry, objects, NULL));
+  bvh->build(progress, NULL);
+  ASSERT_EQ(bvh->pack.root_index, 0);
+  ASSERT_EQ(bvh->pack.object_node.size(), 2u);
+  EXPECT_TRUE(check_subtree(
+      bvh->pack, params.bvh_layout, mesh_b, bvh->pack.object_node[1], mesh_b->bounds));
+
+  const size_t num_nodes = bvh->pack.nodes.size();
+  const size_t num_leaf_nodes = bvh->pack.leaf_nodes.size();
+  const size_t num_prims = bvh->pack.prim_index.size();
+  const int object_node_b = bvh->pack.object_node[1];
+
+  /* Deform the second mesh and refit its own BVH, then the top level. */
+  array<float3> verts = mesh_b->get_verts();
+  deform_wave(verts);
+  mesh_b->set_verts(verts);
+  mesh_b->compute_bounds();
+  object_b.compute_bounds(false);
+  static_cast<BVH2 *>(mesh_b->bvh)->refit(progress);
+
+  bvh->refit(progress);
+
+  /* Instances are merged back at the same offsets, with the refit nodes of the second mesh. */
+  EXPECT_EQ(bvh->pack.nodes.size(), num_nodes);
+  EXPECT_EQ(bvh->pack.leaf_nodes.size(), num_leaf_nodes);
+  EXPECT_EQ(bvh->pack.prim_index.size(), num_prims);
+  ASSERT_EQ(bvh->pack.object_node.size(), 2u);
+  EXPECT_EQ(bvh->pack.object_node[1], object_node_b);
+  EXPECT_TRUE(check_subtree(bvh->pack, params.bvh_layout, mesh_b, object_node_b, mesh_b->bounds));
+
+  /* The top level bounds follow the moved object. */
+  BoundBox root_bounds = child_bounds(bvh->pack, 0, 0);
+  root_bounds.grow(child_bounds(bvh->pack, 0, 1));
+  EXPECT_TRUE(bbox_contains(root_bounds, object_a.bounds));
+  EXPECT_TRUE(bbox_contains(root_bounds, object_b.bounds));
+
+  delete bvh;
+  delete mesh_a;
+  delete mesh_b;
+  TaskScheduler::exit();
+}
+
+CCL_NAMESPACE_END
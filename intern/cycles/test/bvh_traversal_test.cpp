@@ -0,0 +1,313 @@
+/*
+ * Copyright 2021 Blender Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "testing/testing.h"
+
+/* Kernel headers come first, so the kernel types are declared with the CPU device features. */
+#include "kernel/kernel_compat_cpu.h"
+#include "kernel/kernel_math.h"
+#include "kernel/kernel_types.h"
+#include "kernel/split/kernel_split_data.h"
+#include "kernel/kernel_globals.h"
+
+#include "kernel/bvh/bvh_types.h"
+#include "kernel/geom/geom_object.h"
+
+#include "bvh/bvh2.h"
+#include "bvh/bvh4.h"
+
+#include "render/mesh.h"
+#include "render/object.h"
+
+#include "util/util_algorithm.h"
+#include "util/util_progress.h"
+#include "util/util_task.h"
+
+CCL_NAMESPACE_BEGIN
+
+#ifdef __BVH4__
+
+/* Node intersection functions are declared inside the namespace, as in kernel/bvh/bvh.h. */
+#  include "kernel/bvh/bvh_nodes.h"
+#  include "kernel/bvh/bvh4_nodes.h"
+
+namespace {
+
+/* Build a BVH of the given layout for a single mesh. */
+BVH2 *build_bvh(BVHLayout layout, Mesh *mesh, Object *object, int max_leaf_size = 8)
+{
+  BVHParams params;
+  params.bvh_layout = layout;
+  params.use_spatial_split = false;
+  params.max_triangle_leaf_size = max_leaf_size;
+  BVH2 *bvh = static_cast<BVH2 *>(
+      BVH::create(params, vector<Geometry *>(1, mesh), vector<Object *>(1, object), NULL));
+
+  Progress progress;
+  bvh->build(progress, NULL);
+  return bvh;
+}
+
+/* Kernel globals holding only the packed nodes of the BVH, which is all node intersection
+ * reads. */
+void kernel_globals_init(KernelGlobals *kg, BVH2 *bvh)
+{
+  kg->__bvh_nodes.data = reinterpret_cast<float4 *>(bvh->pack.nodes.data());
+  kg->__bvh_nodes.width = bvh->pack.nodes.size();
+}
+
+/* Triangle of the mesh referenced by a leaf node. */
+int leaf_triangle(const BVH2 *bvh, int node_addr)
+{
+  const int4 leaf = bvh->pack.leaf_nodes[-node_addr - 1];
+  EXPECT_EQ(leaf.y - leaf.x, 1);
+  return bvh->pack.prim_index[leaf.x];
+}
+
+bool triangle_hit(const Mesh *mesh, int prim, const float3 P, const float3 dir, const float t)
+{
+  const Mesh::Triangle triangle = mesh->get_triangle(prim);
+  const float3 *verts = mesh->get_verts().data();
+  float isect_u, isect_v, isect_t;
+  return ray_triangle_intersect(P,
+                                dir,
+                                t,
+                                verts[triangle.v[0]],
+                                verts[triangle.v[1]],
+                                verts[triangle.v[2]],
+                                &isect_u,
+                                &isect_v,
+                                &isect_t);
+}
+
+/* Collect all triangles hit by the ray, following the same loop as the kernel traversal.
+ * Returns the number of inner nodes visited. */
+int traverse(KernelGlobals *kg,
+             const BVH2 *bvh,
+             const Mesh *mesh,
+             const float3 P,
+             const float3 dir,
+             vector<int> &hits)
+{
+  const bool use_bvh4 = (bvh->params.bvh_layout == BVH_LAYOUT_BVH4);
+  const float3 idir = bvh_inverse_direction(bvh_clamp_direction(dir));
+  const float t = FLT_MAX;
+
+  int traversal_stack[BVH_STACK_SIZE];
+  traversal_stack[0] = ENTRYPOINT_SENTINEL;
+  int stack_ptr = 0;
+  int node_addr = bvh->pack.root_index;
+  int num_nodes = 0;
+
+  do {
+    while (node_addr >= 0 && node_addr != ENTRYPOINT_SENTINEL) {
+      num_nodes++;
+      if (use_bvh4) {
+        node_addr = bvh4_node_intersect(
+            kg, P, idir, t, node_addr, PATH_RAY_ALL_VISIBILITY, traversal_stack, &stack_ptr);
+        continue;
+      }
+
+      float dist[2];
+      const int4 cnodes = bvh->pack.nodes[node_addr];
+      const int traverse_mask = bvh_aligned_node_intersect(
+          kg, P, idir, t, node_addr, PATH_RAY_ALL_VISIBILITY, dist);
+      if (traverse_mask == 3) {
+        const bool is_closest_child1 = (dist[1] < dist[0]);
+        node_addr = is_closest_child1 ? cnodes.w : cnodes.z;
+        traversal_stack[++stack_ptr] = is_closest_child1 ? cnodes.z : cnodes.w;
+      }
+      else if (traverse_mask == 2) {
+        node_addr = cnodes.w;
+      }
+      else if (traverse_mask == 1) {
+        node_addr = cnodes.z;
+      }
+      else {
+        node_addr = traversal_stack[stack_ptr--];
+      }
+    }
+
+    if (node_addr < 0) {
+      const int4 leaf = bvh->pack.leaf_nodes[-node_addr - 1];
+      for (int prim_addr = leaf.x; prim_addr < leaf.y; prim_addr++) {
+        const int prim = bvh->pack.prim_index[prim_addr];
+        if (triangle_hit(mesh, prim, P, dir, t)) {
+          hits.push_back(prim);
+        }
+      }
+      node_addr = traversal_stack[stack_ptr--];
+    }
+  } while (node_addr != ENTRYPOINT_SENTINEL);
+
+  sort(hits.begin(), hits.end());
+  return num_nodes;
+}
+
+}  // namespace
+
+TEST(bvh4, node_intersect)
+{
+  TaskScheduler::init(0);
+
+  /* Four triangles spread along the X axis, with one triangle per leaf the root has one leaf
+   * child for each. */
+  Mesh *mesh = new Mesh();
+  mesh->reserve_mesh(12, 4);
+  for (int i = 0; i < 4; i++) {
+    const float x = i * 10.0f;
+    mesh->add_vertex(make_float3(x, 0.0f, 0.0f));
+    mesh->add_vertex(make_float3(x + 1.0f, 1.0f, 0.0f));
+    mesh->add_vertex(make_float3(x, 0.0f, 1.0f));
+    mesh->add_triangle(i * 3, i * 3 + 1, i * 3 + 2, 0, false);
+  }
+
+  Object object;
+  object.set_geometry(mesh);
+  BVH2 *bvh = build_bvh(BVH_LAYOUT_BVH4, mesh, &object, 1);
+  ASSERT_EQ(bvh->pack.root_index, 0);
+
+  KernelGlobals kg;
+  kernel_globals_init(&kg, bvh);
+
+  int traversal_stack[BVH_STACK_SIZE];
+  traversal_stack[0] = ENTRYPOINT_SENTINEL;
+
+  /* A ray hitting a single child continues with its leaf, leaving the stack untouched. */
+  const float3 down = make_float3(0.001f, 0.001f, -1.0f);
+  for (int i = 0; i < 4; i++) {
+    int stack_ptr = 0;
+    const float3 P = make_float3(i * 10.0f + 0.5f, 0.25f, 2.0f);
+    const int node_addr = bvh4_node_intersect(
+        &kg, P, rcp(down), FLT_MAX, 0, PATH_RAY_ALL_VISIBILITY, traversal_stack, &stack_ptr);
+    ASSERT_LT(node_addr, 0);
+    EXPECT_EQ(leaf_triangle(bvh, node_addr), i);
+    EXPECT_EQ(stack_ptr, 0);
+  }
+
+  /* A ray missing all children pops the stack. */
+  {
+    int stack_ptr = 0;
+    const float3 P = make_float3(5.0f, 5.0f, 2.0f);
+    const int node_addr = bvh4_node_intersect(
+        &kg, P, rcp(down), FLT_MAX, 0, PATH_RAY_ALL_VISIBILITY, traversal_stack, &stack_ptr);
+    EXPECT_EQ(node_addr, ENTRYPOINT_SENTINEL);
+    EXPECT_EQ(stack_ptr, -1);
+  }
+
+  /* A ray through all children continues with the nearest and pushes the others farthest first,
+   * so they are popped front to back. */
+  {
+    int stack_ptr = 0;
+    const float3 P = make_float3(-5.0f, 0.25f, 0.25f);
+    const float3 dir = make_float3(1.0f, 0.001f, 0.001f);
+    const int node_addr = bvh4_node_intersect(
+        &kg, P, rcp(dir), FLT_MAX, 0, PATH_RAY_ALL_VISIBILITY, traversal_stack, &stack_ptr);
+    ASSERT_LT(node_addr, 0);
+    EXPECT_EQ(leaf_triangle(bvh, node_addr), 0);
+    ASSERT_EQ(stack_ptr, 3);
+    EXPECT_EQ(leaf_triangle(bvh, traversal_stack[1]), 3);
+    EXPECT_EQ(leaf_triangle(bvh, traversal_stack[2]), 2);
+    EXPECT_EQ(leaf_triangle(bvh, traversal_stack[3]), 1);
+  }
+
+  /* The ray length limits the children hit. */
+  {
+    int stack_ptr = 0;
+    const float3 P = make_float3(-5.0f, 0.25f, 0.25f);
+    const float3 dir = make_float3(1.0f, 0.001f, 0.001f);
+    const int node_addr = bvh4_node_intersect(
+        &kg, P, rcp(dir), 10.0f, 0, PATH_RAY_ALL_VISIBILITY, traversal_stack, &stack_ptr);
+    ASSERT_LT(node_addr, 0);
+    EXPECT_EQ(leaf_triangle(bvh, node_addr), 0);
+    EXPECT_EQ(stack_ptr, 0);
+  }
+
+  delete bvh;
+  delete mesh;
+  TaskScheduler::exit();
+}
+
+TEST(bvh4, traversal_matches_bvh2)
+{
+  TaskScheduler::init(0);
+
+  /* A wavy grid, so rays from above and grazing rays both hit several triangles. */
+  const int grid_size = 32;
+  Mesh *mesh = new Mesh();
+  mesh->reserve_mesh(grid_size * grid_size, (grid_size - 1) * (grid_size - 1) * 2);
+  for (int y = 0; y < grid_size; y++) {
+    for (int x = 0; x < grid_size; x++) {
+      mesh->add_vertex(make_float3(x, y, sinf(x * 0.5f) * 2.0f + cosf(y * 0.3f)));
+    }
+  }
+  for (int y = 0; y < grid_size - 1; y++) {
+    for (int x = 0; x < grid_size - 1; x++) {
+      const int v = y * grid_size + x;
+      mesh->add_triangle(v, v + 1, v + grid_size + 1, 0, false);
+      mesh->add_triangle(v, v + grid_size + 1, v + grid_size, 0, false);
+    }
+  }
+
+  Object object;
+  object.set_geometry(mesh);
+  BVH2 *bvh2 = build_bvh(BVH_LAYOUT_BVH2, mesh, &object);
+  BVH2 *bvh4 = build_bvh(BVH_LAYOUT_BVH4, mesh, &object);
+
+  KernelGlobals kg2, kg4;
+  kernel_globals_init(&kg2, bvh2);
+  kernel_globals_init(&kg4, bvh4);
+
+  vector<float3> ray_P, ray_dir;
+  for (int y = 0; y < grid_size - 2; y++) {
+    for (int x = 0; x < grid_size - 2; x++) {
+      ray_P.push_back(make_float3(x + 0.3f, y + 0.7f, 5.0f));
+      ray_dir.push_back(normalize(make_float3(0.05f, 0.03f, -1.0f)));
+    }
+  }
+  for (int y = 0; y < grid_size - 1; y++) {
+    ray_P.push_back(make_float3(-1.0f, y + 0.4f, 0.5f));
+    ray_dir.push_back(normalize(make_float3(1.0f, 0.01f, 0.02f)));
+  }
+
+  /* Both layouts find the same triangles as testing each of them, while BVH4 visits fewer
+   * inner nodes. */
+  int num_nodes2 = 0, num_nodes4 = 0;
+  for (size_t i = 0; i < ray_P.size(); i++) {
+    vector<int> hits2, hits4, expected;
+    num_nodes2 += traverse(&kg2, bvh2, mesh, ray_P[i], ray_dir[i], hits2);
+    num_nodes4 += traverse(&kg4, bvh4, mesh, ray_P[i], ray_dir[i], hits4);
+    for (int prim = 0; prim < mesh->num_triangles(); prim++) {
+      if (triangle_hit(mesh, prim, ray_P[i], ray_dir[i], FLT_MAX)) {
+        expected.push_back(prim);
+      }
+    }
+
+    EXPECT_FALSE(expected.empty());
+    EXPECT_EQ(hits2, expected);
+    EXPECT_EQ(hits4, expected);
+  }
+  EXPECT_LT(num_nodes4, num_nodes2);
+
+  delete bvh2;
+  delete bvh4;
+  delete mesh;
+  TaskScheduler::exit();
+}
+
+#endif /* __BVH4__ */
+
+CCL_NAMESPACE_END
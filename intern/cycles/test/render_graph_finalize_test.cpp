@@ -1536,4 +1536,75 @@ TEST_F(RenderGraph, constant_fold_convert_color_float_color)
   graph.finalize(scene);
 }
 
+/*
+ * Tests:
+ *  - Texture coordinate shifted by ray differentials for images in the texture cache.
+ *  - Images with the same texture coordinate share the shifted copies.
+ */
+TEST_F(RenderGraph, image_texture_derivatives)
+{
+  EXPECT_ANY_MESSAGE(log);
+
+  scene->params.use_texture_cache = true;
+
+  builder.add_node(ShaderNodeBuilder<TextureCoordinateNode>(graph, "TexCoord"))
+      .add_node(ShaderNodeBuilder<ImageTextureNode>(graph, "Image1"))
+      .add_node(ShaderNodeBuilder<ImageTextureNode>(graph, "Image2")
+                    .set_param("extension", EXTENSION_EXTEND))
+      .add_node(ShaderNodeBuilder<MixNode>(graph, "Mix")
+                    .set_param("mix_type", NODE_MIX_BLEND)
+                    .set("Fac", 0.5f))
+      .add_connection("TexCoord::UV", "Image1::Vector")
+      .add_connection("TexCoord::UV", "Image2::Vector")
+      .add_connection("Image1::Color", "Mix::Color1")
+      .add_connection("Image2::Color", "Mix::Color2")
+      .output_color("Mix::Color");
+
+  graph.finalize(scene);
+
+  ShaderNode *image1 = builder.find_node("Image1");
+  ShaderNode *image2 = builder.find_node("Image2");
+  ShaderOutput *vector_dx = image1->input("VectorDX")->link;
+  ShaderOutput *vector_dy = image1->input("VectorDY")->link;
+
+  ASSERT_NE(vector_dx, (void *)NULL);
+  ASSERT_NE(vector_dy, (void *)NULL);
+  EXPECT_EQ(vector_dx->name(), "UV");
+  EXPECT_EQ(vector_dx->parent->bump, SHADER_BUMP_DX);
+  EXPECT_EQ(vector_dy->parent->bump, SHADER_BUMP_DY);
+
+  EXPECT_EQ(image2->input("VectorDX")->link, vector_dx);
+  EXPECT_EQ(image2->input("VectorDY")->link, vector_dy);
+}
+
+/*
+ * Tests:
+ *  - Images sampled for bump keep zero derivatives, in the center and shifted samples.
+ */
+TEST_F(RenderGraph, image_texture_derivatives_bump)
+{
+  EXPECT_ANY_MESSAGE(log);
+
+  scene->params.use_texture_cache = true;
+
+  builder.add_node(ShaderNodeBuilder<TextureCoordinateNode>(graph, "TexCoord"))
+      .add_node(ShaderNodeBuilder<ImageTextureNode>(graph, "Image"))
+      .add_node(ShaderNodeBuilder<BumpNode>(graph, "Bump"))
+      .add_connection("TexCoord::UV", "Image::Vector")
+      .add_connection("Image::Alpha", "Bump::Height")
+      .output_color("Bump::Normal");
+
+  graph.finalize(scene);
+
+  int num_images = 0;
+  for (ShaderNode *node : graph.nodes) {
+    if (node->type == ImageTextureNode::get_node_type()) {
+      EXPECT_EQ(node->input("VectorDX")->link, (void *)NULL);
+      EXPECT_EQ(node->input("VectorDY")->link, (void *)NULL);
+      num_images++;
+    }
+  }
+  EXPECT_EQ(num_images, 3);
+}
+
 CCL_NAMESPACE_END
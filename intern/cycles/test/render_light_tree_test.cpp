@@ -0,0 +1,132 @@
+/*
+ * Copyright 2021 Blender Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "testing/testing.h"
+
+#include "render/light_tree.h"
+
+CCL_NAMESPACE_BEGIN
+
+static bool bbox_contains(const BoundBox &bounds, const BoundBox &other)
+{
+  return bounds.min.x <= other.min.x && bounds.min.y <= other.min.y &&
+         bounds.min.z <= other.min.z && bounds.max.x >= other.max.x &&
+         bounds.max.y >= other.max.y && bounds.max.z >= other.max.z;
+}
+
+static bool orientation_contains(const LightTreeOrientation &bounds,
+                                 const LightTreeOrientation &other)
+{
+  const float theta_d = safe_acosf(dot(bounds.axis, other.axis));
+  return theta_d + other.theta_o <= bounds.theta_o + 1e-4f && other.theta_e <= bounds.theta_e;
+}
+
+TEST(light_tree_orientation, Merge)
+{
+  const LightTreeOrientation a(make_float3(1.0f, 0.0f, 0.0f), 0.0f, M_PI_2_F);
+  const LightTreeOrientation b(make_float3(0.0f, 1.0f, 0.0f), 0.2f, 0.1f);
+
+  const LightTreeOrientation merged = merge(a, b);
+  EXPECT_TRUE(orientation_contains(merged, a));
+  EXPECT_TRUE(orientation_contains(merged, b));
+  EXPECT_NEAR(merged.theta_o, (M_PI_2_F + 0.2f) * 0.5f, 1e-5f);
+  EXPECT_EQ(merged.theta_e, M_PI_2_F);
+
+  /* Opposite directions need the whole sphere. */
+  const LightTreeOrientation c(make_float3(-1.0f, 0.0f, 0.0f), 0.0f, M_PI_2_F);
+  EXPECT_EQ(merge(a, c).theta_o, M_PI_F);
+
+  /* Bounds that contain the other ones are kept. */
+  const LightTreeOrientation wide(make_float3(0.0f, 0.0f, 1.0f), M_PI_F, M_PI_2_F);
+  EXPECT_EQ(merge(b, wide).theta_o, M_PI_F);
+}
+
+TEST(light_tree, Build)
+{
+  vector<LightTreePrimitive> prims;
+  for (int i = 0; i < 100; i++) {
+    const float3 co = make_float3((i % 10) * 2.0f, (i / 10) * 3.0f, (i % 7) * 0.5f);
+    LightTreePrimitive prim;
+    prim.distribution_id = i;
+    prim.bbox = BoundBox(co - make_float3(0.1f), co + make_float3(0.1f));
+    prim.orientation = LightTreeOrientation(
+        normalize(make_float3(1.0f, (float)(i % 3), 0.0f)), 0.0f, M_PI_2_F);
+    prim.energy = 1.0f + (i % 5);
+    prims.push_back(prim);
+  }
+
+  const int max_prims_in_leaf = 4;
+  LightTree light_tree(prims, max_prims_in_leaf);
+  const vector<LightTreeNode> &nodes = light_tree.get_nodes();
+  ASSERT_FALSE(nodes.empty());
+  EXPECT_EQ(nodes[0].first_prim, 0);
+  EXPECT_EQ(nodes[0].num_prims, 100);
+
+  /* The primitives are reordered, but all of them are still there. */
+  vector<bool> found(prims.size(), false);
+  for (const LightTreePrimitive &prim : prims) {
+    found[prim.distribution_id] = true;
+  }
+  for (const bool prim_found : found) {
+    EXPECT_TRUE(prim_found);
+  }
+
+  for (size_t i = 0; i < nodes.size(); i++) {
+    const LightTreeNode &node = nodes[i];
+    float energy = 0.0f;
+    for (int prim = node.first_prim; prim < node.first_prim + node.num_prims; prim++) {
+      energy += prims[prim].energy;
+      EXPECT_TRUE(bbox_contains(node.bbox, prims[prim].bbox));
+      EXPECT_TRUE(orientation_contains(node.orientation, prims[prim].orientation));
+    }
+    EXPECT_NEAR(node.energy, energy, 1e-3f);
+
+    if (node.right_child == -1) {
+      EXPECT_LE(node.num_prims, max_prims_in_leaf);
+      continue;
+    }
+
+    /* Children cover consecutive ranges of the primitives of their parent. */
+    const LightTreeNode &left = nodes[i + 1];
+    const LightTreeNode &right = nodes[node.right_child];
+    EXPECT_EQ(left.first_prim, node.first_prim);
+    EXPECT_EQ(right.first_prim, left.first_prim + left.num_prims);
+    EXPECT_EQ(left.num_prims + right.num_prims, node.num_prims);
+  }
+}
+
+TEST(light_tree, CoincidentPrimitives)
+{
+  /* Primitives at the same place can't be split by position, but leaves still stay small. */
+  vector<LightTreePrimitive> prims(20);
+  for (int i = 0; i < prims.size(); i++) {
+    prims[i].distribution_id = i;
+    prims[i].bbox = BoundBox(zero_float3());
+    prims[i].orientation = LightTreeOrientation(make_float3(0.0f, 0.0f, 1.0f), M_PI_F, M_PI_2_F);
+    prims[i].energy = 1.0f;
+  }
+
+  LightTree light_tree(prims, 1);
+  const vector<LightTreeNode> &nodes = light_tree.get_nodes();
+  EXPECT_EQ(nodes.size(), 39);
+  for (const LightTreeNode &node : nodes) {
+    if (node.right_child == -1) {
+      EXPECT_EQ(node.num_prims, 1);
+    }
+  }
+}
+
+CCL_NAMESPACE_END
@@ -59,6 +59,7 @@ typedef enum ImageDataType {
   IMAGE_DATA_TYPE_USHORT = 7,
   IMAGE_DATA_TYPE_NANOVDB_FLOAT = 8,
   IMAGE_DATA_TYPE_NANOVDB_FLOAT3 = 9,
+  IMAGE_DATA_TYPE_OIIO = 10,
 
   IMAGE_DATA_NUM_TYPES
 } ImageDataType;
@@ -108,6 +109,17 @@ typedef struct TextureInfo {
   Transform transform_3d;
 } TextureInfo;
 
+#ifndef __KERNEL_GPU__
+/* Images of type IMAGE_DATA_TYPE_OIIO are sampled on demand through the
+ * OpenImageIO texture cache, on the CPU only. This is stored in place of
+ * their pixels. */
+typedef struct TextureCacheHandle {
+  /* OIIO::TextureSystem and OIIO::TextureSystem::TextureHandle. */
+  void *texture_system;
+  void *handle;
+} TextureCacheHandle;
+#endif
+
 CCL_NAMESPACE_END
 
 #endif /* __UTIL_TEXTURE_H__ */
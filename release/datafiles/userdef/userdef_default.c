@@ -112,6 +112,7 @@ const UserDef U_default = {
     .gp_euclideandist = 2,
     .gp_eraser = 25,
     .gp_settings = 0,
+    .geometry_nodes_cache_limit = 512,
 
     /** Initialized by: #BKE_studiolight_default . */
     .light_param = {{0}},
@@ -132,6 +133,7 @@ const UserDef U_default = {
 
     .prefetchframes = 0,
     .pad_rot_angle = 15,
+    .compositor_cache_limit = 1024,
     .rvisize = 25,
     .rvibright = 8,
     .recent_files = 10,
@@ -645,6 +645,8 @@ class USERPREF_PT_system_video_sequencer(SystemPanel, CenterAlignMixIn, Panel):
         # edit = prefs.edit
 
         layout.prop(system, "memory_cache_limit")
+        layout.prop(system, "compositor_cache_limit")
+        layout.prop(system, "geometry_nodes_cache_limit")
 
         layout.separator()
 
@@ -2256,6 +2258,7 @@ class USERPREF_PT_experimental_prototypes(ExperimentalPanel, Panel):
             context, (
                 ({"property": "use_new_hair_type"}, "T68981"),
                 ({"property": "use_new_point_cloud_type"}, "T75717"),
+                ({"property": "use_undo_skip_unchanged"}, None),
             ),
         )
 
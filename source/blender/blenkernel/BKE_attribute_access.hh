@@ -26,6 +26,7 @@
 #include "BLI_color.hh"
 #include "BLI_float2.hh"
 #include "BLI_float3.hh"
+#include "BLI_index_mask.hh"
 
 namespace blender::bke {
 
@@ -108,11 +109,36 @@ class ReadAttribute {
     return this->get_span().typed<T>();
   }
 
+  /**
+   * Copy the values at the indices in the mask to the same indices in r_values, which has to be
+   * as large as the attribute. Interpolated and converted values are only computed for the
+   * indices in the mask, so this is much cheaper than #get_span when only some values are used.
+   */
+  void materialize(IndexMask mask, fn::GMutableSpan r_values) const;
+  void materialize_to_uninitialized(IndexMask mask, fn::GMutableSpan r_values) const;
+
+  /**
+   * Like #materialize, but the values are written to the start of r_values, which only has to be
+   * as large as the mask.
+   */
+  void materialize_compressed(IndexMask mask, fn::GMutableSpan r_values) const;
+  void materialize_compressed_to_uninitialized(IndexMask mask, fn::GMutableSpan r_values) const;
+
  protected:
   /* r_value is expected to be uninitialized. */
   virtual void get_internal(const int64_t index, void *r_value) const = 0;
 
   virtual void initialize_span() const;
+
+  /* The default implementations call #get_internal for every index. Attributes that can compute
+   * many values at once more efficiently should override them. */
+  virtual void materialize_to_uninitialized_internal(IndexMask mask, void *r_values) const;
+  virtual void materialize_compressed_to_uninitialized_internal(IndexMask mask,
+                                                                void *r_values) const;
+
+  /* Implements #materialize_to_uninitialized_internal for attributes that compute values in
+   * chunks with #materialize_compressed_to_uninitialized_internal. */
+  void materialize_in_compressed_chunks(IndexMask mask, void *r_values) const;
 };
 
 /**
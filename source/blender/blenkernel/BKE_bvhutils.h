@@ -274,6 +274,9 @@ bool bvhcache_has_tree(const struct BVHCache *bvh_cache, const BVHTree *tree);
 struct BVHCache *bvhcache_init(void);
 void bvhcache_free(struct BVHCache *bvh_cache);
 
+/* Free all trees in the content keyed cache of `BKE_geometry_set_bvh_cache.hh`. */
+void BKE_geometry_set_bvh_cache_free(void);
+
 #ifdef __cplusplus
 }
 #endif
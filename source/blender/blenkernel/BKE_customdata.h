@@ -70,7 +70,13 @@ typedef enum eCDAllocType {
   CD_CALLOC = 1,
   /** Allocate and set to default. */
   CD_DEFAULT = 2,
-  /** Use data pointers, set layer flag NOFREE. */
+  /**
+   * Use data pointers. Layers that own their data share it with the new layers, the data is
+   * freed by its last user. Layers that reference data themselves (flag NOFREE) are copied as
+   * references with the same flag.
+   * Shared and referenced layers must not be modified before they are made unique, see
+   * #CustomData_duplicate_referenced_layer.
+   */
   CD_REFERENCE = 3,
   /** Do a full copy of all layers, only allowed if source has same number of elements. */
   CD_DUPLICATE = 4,
@@ -218,8 +224,8 @@ bool CustomData_has_layer(const struct CustomData *data, int type);
 int CustomData_number_of_layers(const struct CustomData *data, int type);
 int CustomData_number_of_layers_typemask(const struct CustomData *data, CustomDataMask mask);
 
-/* duplicate data of a layer with flag NOFREE, and remove that flag.
- * returns the layer data */
+/* duplicate data of a layer with flag NOFREE or data shared with other layers, so that it can be
+ * modified. returns the layer data */
 void *CustomData_duplicate_referenced_layer(struct CustomData *data,
                                             const int type,
                                             const int totelem);
@@ -231,6 +237,9 @@ void *CustomData_duplicate_referenced_layer_named(struct CustomData *data,
                                                   const int type,
                                                   const char *name,
                                                   const int totelem);
+/* duplicate data of all layers shared with other custom data, so that the arrays can be written
+ * to directly. layers with flag NOFREE are kept as they are */
+void CustomData_duplicate_shared_layers(struct CustomData *data, const int totelem);
 bool CustomData_is_referenced_layer(struct CustomData *data, int type);
 
 /* set the CD_FLAG_NOCOPY flag in custom data layers where the mask is
@@ -382,6 +391,8 @@ void CustomData_bmesh_set_layer_n(struct CustomData *data, void *block, int n, c
 
 /* set the pointer of to the first layer of type. the old data is not freed.
  * returns the value of ptr if the layer is found, NULL otherwise
+ * NOTE: the layer stops sharing its old data, callers that take over the old data must make
+ * it unique first with #CustomData_duplicate_referenced_layer.
  */
 void *CustomData_set_layer(const struct CustomData *data, int type, void *ptr);
 void *CustomData_set_layer_n(const struct CustomData *data, int type, int n, void *ptr);
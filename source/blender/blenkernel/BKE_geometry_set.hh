@@ -184,6 +184,13 @@ class GeometryComponent {
 
   virtual bool is_empty() const;
 
+  /* Returns false when the component references data that someone else is responsible for
+   * freeing, see #GeometryOwnershipType. */
+  virtual bool owns_direct_data() const;
+  /* Replace referenced data that is not owned with an owned copy. Can only be used when the
+   * component is mutable. */
+  virtual void ensure_owns_direct_data();
+
   /* Get a read-only attribute for the given domain and data type.
    * Returns null when it does not exist. */
   blender::bke::ReadAttributePtr attribute_try_get_for_read(
@@ -307,6 +314,8 @@ struct GeometrySet {
 
   blender::Vector<const GeometryComponent *> get_components_for_read() const;
 
+  void ensure_owns_direct_data();
+
   void compute_boundbox_without_instances(blender::float3 *r_min, blender::float3 *r_max) const;
 
   friend std::ostream &operator<<(std::ostream &stream, const GeometrySet &geometry_set);
@@ -372,6 +381,9 @@ class MeshComponent : public GeometryComponent {
 
   bool is_empty() const final;
 
+  bool owns_direct_data() const final;
+  void ensure_owns_direct_data() final;
+
   static constexpr inline GeometryComponentType static_type = GEO_COMPONENT_TYPE_MESH;
 
  private:
@@ -402,6 +414,9 @@ class PointCloudComponent : public GeometryComponent {
 
   bool is_empty() const final;
 
+  bool owns_direct_data() const final;
+  void ensure_owns_direct_data() final;
+
   static constexpr inline GeometryComponentType static_type = GEO_COMPONENT_TYPE_POINT_CLOUD;
 
  private:
@@ -464,5 +479,8 @@ class VolumeComponent : public GeometryComponent {
   const Volume *get_for_read() const;
   Volume *get_for_write();
 
+  bool owns_direct_data() const final;
+  void ensure_owns_direct_data() final;
+
   static constexpr inline GeometryComponentType static_type = GEO_COMPONENT_TYPE_VOLUME;
 };
@@ -0,0 +1,67 @@
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+#pragma once
+
+/** \file
+ * \ingroup bke
+ *
+ * A cache for BVH trees of geometry, keyed by the content of the geometry instead of its memory.
+ *
+ * Geometry nodes create new meshes and point clouds on every evaluation, for example when
+ * instances are realized. The BVH cache in the runtime data of a mesh is freed together with
+ * the mesh, so it can not be reused in the next evaluation even when the geometry did not change.
+ * With this cache, looking up the tree for unchanged geometry only requires hashing its data.
+ */
+
+#include <memory>
+
+#include "BKE_bvhutils.h"
+
+struct Mesh;
+struct PointCloud;
+
+namespace blender::bke {
+
+struct CachedBVHTree;
+
+/**
+ * Shares the ownership of a cached tree. The tree stays valid as long as a user exists, even when
+ * it has been removed from the cache in the meantime.
+ */
+using CachedBVHTreeUser = std::shared_ptr<const CachedBVHTree>;
+
+/**
+ * Get a BVH tree for the mesh, building it when no mesh with the same content has been cached.
+ * `r_data` references the arrays of the given mesh, so it is only valid as long as both the
+ * returned user and the mesh exist. It must not be passed to #free_bvhtree_from_mesh.
+ *
+ * \return Null when no tree could be built, for example when the mesh is empty.
+ */
+CachedBVHTreeUser bvh_cache_get_for_mesh(const Mesh &mesh,
+                                         BVHCacheType bvh_cache_type,
+                                         BVHTreeFromMesh &r_data);
+
+/**
+ * Same as #bvh_cache_get_for_mesh, but for the points of a point cloud. `r_data` must not be
+ * passed to #free_bvhtree_from_pointcloud.
+ */
+CachedBVHTreeUser bvh_cache_get_for_pointcloud(const PointCloud &pointcloud,
+                                               BVHTreeFromPointCloud &r_data);
+
+/** Memory used by the trees kept in the cache in bytes, including trees that are not used. */
+int64_t bvh_cache_size();
+
+}  // namespace blender::bke
@@ -133,6 +133,12 @@ typedef struct Main {
    * instead do a complete full re-read/update from stored memfile.
    */
   char use_memfile_full_barrier;
+  /**
+   * IDs were read from a memfile, so their addresses may differ from the ones stored in the last
+   * memfile undo step. The next memfile undo step has to write all IDs again instead of reusing
+   * the data of unchanged ones, which still points to the old addresses.
+   */
+  char use_memfile_full_write;
 
   /**
    * When linking, disallow creation of new data-blocks.
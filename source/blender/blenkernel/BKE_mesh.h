@@ -124,6 +124,9 @@ void BKE_mesh_eval_delete(struct Mesh *mesh_eval);
  * optional referencing original arrays to reduce memory. */
 struct Mesh *BKE_mesh_copy_for_eval(struct Mesh *source, bool reference);
 
+/* Free the meshes cached by #blender::bke::mesh_primitive_cache_get. */
+void BKE_mesh_primitive_cache_free(void);
+
 /* These functions construct a new Mesh,
  * contrary to BKE_mesh_from_nurbs which modifies ob itself. */
 struct Mesh *BKE_mesh_new_nomain_from_curve(struct Object *ob);
@@ -0,0 +1,67 @@
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+#pragma once
+
+/** \file
+ * \ingroup bke
+ *
+ * A cache for the topology of procedurally generated meshes like the primitives created by
+ * geometry nodes. Such meshes are often generated many times with the same resolution, where
+ * only their transform differs. Generated meshes are copied from the cached mesh, so only the
+ * vertex positions have to be computed again.
+ */
+
+#include "BLI_float4x4.hh"
+#include "BLI_function_ref.hh"
+
+struct Mesh;
+
+namespace blender::bke {
+
+/**
+ * Identifies the topology of a generated mesh. `type` tells apart the different generators
+ * (for example by using their node type), the meaning of the resolution values depends on it.
+ */
+struct MeshPrimitiveCacheKey {
+  int type;
+  int resolution[2];
+
+  uint64_t hash() const
+  {
+    return (uint64_t)type ^ ((uint64_t)resolution[0] * 33) ^ ((uint64_t)resolution[1] * 97);
+  }
+
+  friend bool operator==(const MeshPrimitiveCacheKey &a, const MeshPrimitiveCacheKey &b)
+  {
+    return a.type == b.type && a.resolution[0] == b.resolution[0] &&
+           a.resolution[1] == b.resolution[1];
+  }
+};
+
+/**
+ * Get a mesh with the topology and custom data of the mesh created by \a create_fn for the same
+ * key, and vertex positions transformed by \a transform. The mesh is only created when it is not
+ * in the cache already. It has to be generated in a way that positions depend linearly on the
+ * transform, i.e. as if it was created with an identity transform.
+ *
+ * The returned mesh is a full copy that doesn't share data with the cached mesh, as a lot of code
+ * writes to mesh arrays directly.
+ */
+Mesh *mesh_primitive_cache_get(const MeshPrimitiveCacheKey &key,
+                               FunctionRef<Mesh *()> create_fn,
+                               const float4x4 &transform);
+
+}  // namespace blender::bke
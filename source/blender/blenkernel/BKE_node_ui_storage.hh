@@ -127,3 +127,12 @@ void BKE_nodetree_attribute_hint_add(bNodeTree &ntree,
                                      const blender::StringRef attribute_name,
                                      const AttributeDomain domain,
                                      const CustomDataType data_type);
+
+NodeUIStorage BKE_nodetree_ui_storage_copy_for_node(bNodeTree &ntree,
+                                                    const NodeTreeEvaluationContext &context,
+                                                    const bNode &node);
+
+void BKE_nodetree_ui_storage_add_for_node(bNodeTree &ntree,
+                                          const NodeTreeEvaluationContext &context,
+                                          const bNode &node,
+                                          const NodeUIStorage &storage);
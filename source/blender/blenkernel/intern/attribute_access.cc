@@ -79,11 +79,105 @@ fn::GSpan ReadAttribute::get_span() const
 void ReadAttribute::initialize_span() const
 {
   const int element_size = cpp_type_.size();
-  array_buffer_ = MEM_mallocN_aligned(size_ * element_size, cpp_type_.alignment(), __func__);
+  void *buffer = MEM_mallocN_aligned(size_ * element_size, cpp_type_.alignment(), __func__);
+  this->materialize_compressed_to_uninitialized_internal(IndexRange(size_), buffer);
   array_is_temporary_ = true;
-  for (const int i : IndexRange(size_)) {
-    this->get_internal(i, POINTER_OFFSET(array_buffer_, i * element_size));
+  array_buffer_ = buffer;
+}
+
+/* Number of values computed at once by attributes that interpolate or convert values, small
+ * enough for the temporary buffers to stay in the CPU cache. */
+static constexpr int64_t materialize_chunk_size = 1024;
+
+void ReadAttribute::materialize(IndexMask mask, fn::GMutableSpan r_values) const
+{
+  BLI_assert(r_values.type() == cpp_type_);
+  BLI_assert(mask.min_array_size() <= r_values.size());
+  cpp_type_.destruct_indices(r_values.data(), mask);
+  this->materialize_to_uninitialized(mask, r_values);
+}
+
+void ReadAttribute::materialize_to_uninitialized(IndexMask mask, fn::GMutableSpan r_values) const
+{
+  BLI_assert(r_values.type() == cpp_type_);
+  BLI_assert(mask.min_array_size() <= r_values.size());
+  BLI_assert(mask.min_array_size() <= size_);
+  if (array_buffer_ != nullptr) {
+    /* All values have been computed already. */
+    cpp_type_.copy_to_uninitialized_indices(array_buffer_, r_values.data(), mask);
+    return;
+  }
+  this->materialize_to_uninitialized_internal(mask, r_values.data());
+}
+
+void ReadAttribute::materialize_compressed(IndexMask mask, fn::GMutableSpan r_values) const
+{
+  BLI_assert(r_values.type() == cpp_type_);
+  BLI_assert(mask.size() <= r_values.size());
+  cpp_type_.destruct_n(r_values.data(), mask.size());
+  this->materialize_compressed_to_uninitialized(mask, r_values);
+}
+
+void ReadAttribute::materialize_compressed_to_uninitialized(IndexMask mask,
+                                                            fn::GMutableSpan r_values) const
+{
+  BLI_assert(r_values.type() == cpp_type_);
+  BLI_assert(mask.size() <= r_values.size());
+  BLI_assert(mask.min_array_size() <= size_);
+  if (array_buffer_ != nullptr) {
+    /* All values have been computed already. */
+    const int element_size = cpp_type_.size();
+    for (const int64_t i : mask.index_range()) {
+      cpp_type_.copy_to_uninitialized(POINTER_OFFSET(array_buffer_, mask[i] * element_size),
+                                      r_values[i]);
+    }
+    return;
   }
+  this->materialize_compressed_to_uninitialized_internal(mask, r_values.data());
+}
+
+void ReadAttribute::materialize_to_uninitialized_internal(IndexMask mask, void *r_values) const
+{
+  const int element_size = cpp_type_.size();
+  mask.foreach_index(
+      [&](const int64_t i) { this->get_internal(i, POINTER_OFFSET(r_values, i * element_size)); });
+}
+
+void ReadAttribute::materialize_compressed_to_uninitialized_internal(IndexMask mask,
+                                                                     void *r_values) const
+{
+  const int element_size = cpp_type_.size();
+  for (const int64_t i : mask.index_range()) {
+    this->get_internal(mask[i], POINTER_OFFSET(r_values, i * element_size));
+  }
+}
+
+void ReadAttribute::materialize_in_compressed_chunks(IndexMask mask, void *r_values) const
+{
+  if (mask.size() == 0) {
+    return;
+  }
+  if (mask.is_range()) {
+    /* Write directly into the destination. */
+    const IndexRange range = mask.as_range();
+    this->materialize_compressed_to_uninitialized_internal(
+        mask, POINTER_OFFSET(r_values, range.start() * cpp_type_.size()));
+    return;
+  }
+
+  const int element_size = cpp_type_.size();
+  const int64_t chunk_size = std::min(mask.size(), materialize_chunk_size);
+  void *buffer = MEM_mallocN_aligned(chunk_size * element_size, cpp_type_.alignment(), __func__);
+  for (int64_t start = 0; start < mask.size(); start += chunk_size) {
+    const int64_t size = std::min(chunk_size, mask.size() - start);
+    const IndexMask chunk_mask = mask.indices().slice(start, size);
+    this->materialize_compressed_to_uninitialized_internal(chunk_mask, buffer);
+    for (const int64_t i : chunk_mask.index_range()) {
+      cpp_type_.relocate_to_uninitialized(POINTER_OFFSET(buffer, i * element_size),
+                                          POINTER_OFFSET(r_values, chunk_mask[i] * element_size));
+    }
+  }
+  MEM_freeN(buffer);
 }
 
 WriteAttribute::~WriteAttribute()
@@ -211,6 +305,7 @@ class ConvertedReadAttribute final : public ReadAttribute {
   const CPPType &to_type_;
   ReadAttributePtr base_attribute_;
   const nodes::DataTypeConversions &conversions_;
+  const fn::MultiFunction &conversion_fn_;
 
  public:
   ConvertedReadAttribute(ReadAttributePtr base_attribute, const CPPType &to_type)
@@ -218,7 +313,9 @@ class ConvertedReadAttribute final : public ReadAttribute {
         from_type_(base_attribute->cpp_type()),
         to_type_(to_type),
         base_attribute_(std::move(base_attribute)),
-        conversions_(nodes::get_implicit_type_conversions())
+        conversions_(nodes::get_implicit_type_conversions()),
+        conversion_fn_(*conversions_.get_conversion(fn::MFDataType::ForSingle(from_type_),
+                                                    fn::MFDataType::ForSingle(to_type_)))
   {
   }
 
@@ -227,6 +324,40 @@ class ConvertedReadAttribute final : public ReadAttribute {
     BUFFER_FOR_CPP_TYPE_VALUE(from_type_, buffer);
     base_attribute_->get(index, buffer);
     conversions_.convert(from_type_, to_type_, buffer, r_value);
+    from_type_.destruct(buffer);
+  }
+
+  void materialize_to_uninitialized_internal(IndexMask mask, void *r_values) const override
+  {
+    this->materialize_in_compressed_chunks(mask, r_values);
+  }
+
+  /* Convert chunks of values at once, instead of converting every value separately or the
+   * entire base attribute up front. */
+  void materialize_compressed_to_uninitialized_internal(IndexMask mask,
+                                                        void *r_values) const override
+  {
+    if (mask.size() == 0) {
+      return;
+    }
+    const int64_t chunk_size = std::min(mask.size(), materialize_chunk_size);
+    void *buffer = MEM_mallocN_aligned(
+        chunk_size * from_type_.size(), from_type_.alignment(), __func__);
+    fn::MFContextBuilder context;
+    for (int64_t start = 0; start < mask.size(); start += chunk_size) {
+      const int64_t size = std::min(chunk_size, mask.size() - start);
+      base_attribute_->materialize_compressed_to_uninitialized(
+          mask.indices().slice(start, size), fn::GMutableSpan(from_type_, buffer, size));
+
+      fn::MFParamsBuilder params{conversion_fn_, size};
+      params.add_readonly_single_input(fn::GSpan(from_type_, buffer, size));
+      params.add_uninitialized_single_output(fn::GMutableSpan(
+          to_type_, POINTER_OFFSET(r_values, start * to_type_.size()), size));
+      conversion_fn_.call(IndexRange(size), params, context);
+
+      from_type_.destruct_n(buffer, size);
+    }
+    MEM_freeN(buffer);
   }
 };
 
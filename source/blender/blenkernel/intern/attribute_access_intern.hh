@@ -57,8 +57,39 @@ class ConstantReadAttribute final : public ReadAttribute {
     array_is_temporary_ = true;
     cpp_type_.fill_uninitialized(value_, array_buffer_, size_);
   }
+
+  void materialize_to_uninitialized_internal(IndexMask mask, void *r_values) const override
+  {
+    cpp_type_.fill_uninitialized_indices(value_, r_values, mask);
+  }
+
+  void materialize_compressed_to_uninitialized_internal(IndexMask mask,
+                                                        void *r_values) const override
+  {
+    cpp_type_.fill_uninitialized(value_, r_values, mask.size());
+  }
 };
 
+template<typename T>
+static void materialize_array_to_uninitialized(Span<T> data, IndexMask mask, T *r_values)
+{
+  mask.foreach_index([&](const int64_t i) { new (r_values + i) T(data[i]); });
+}
+
+template<typename T>
+static void materialize_array_compressed_to_uninitialized(Span<T> data,
+                                                          IndexMask mask,
+                                                          T *r_values)
+{
+  if (mask.is_range()) {
+    uninitialized_copy_n(data.data() + mask.as_range().start(), mask.size(), r_values);
+    return;
+  }
+  for (const int64_t i : mask.index_range()) {
+    new (r_values + i) T(data[mask[i]]);
+  }
+}
+
 template<typename T> class ArrayReadAttribute final : public ReadAttribute {
  private:
   Span<T> data_;
@@ -80,6 +111,17 @@ template<typename T> class ArrayReadAttribute final : public ReadAttribute {
     array_buffer_ = const_cast<T *>(data_.data());
     array_is_temporary_ = false;
   }
+
+  void materialize_to_uninitialized_internal(IndexMask mask, void *r_values) const override
+  {
+    materialize_array_to_uninitialized<T>(data_, mask, (T *)r_values);
+  }
+
+  void materialize_compressed_to_uninitialized_internal(IndexMask mask,
+                                                        void *r_values) const override
+  {
+    materialize_array_compressed_to_uninitialized<T>(data_, mask, (T *)r_values);
+  }
 };
 
 template<typename T> class OwnedArrayReadAttribute final : public ReadAttribute {
@@ -103,6 +145,17 @@ template<typename T> class OwnedArrayReadAttribute final : public ReadAttribute
     array_buffer_ = const_cast<T *>(data_.data());
     array_is_temporary_ = false;
   }
+
+  void materialize_to_uninitialized_internal(IndexMask mask, void *r_values) const override
+  {
+    materialize_array_to_uninitialized<T>(data_, mask, (T *)r_values);
+  }
+
+  void materialize_compressed_to_uninitialized_internal(IndexMask mask,
+                                                        void *r_values) const override
+  {
+    materialize_array_compressed_to_uninitialized<T>(data_, mask, (T *)r_values);
+  }
 };
 
 template<typename StructT, typename ElemT, ElemT (*GetFunc)(const StructT &)>
@@ -122,6 +175,21 @@ class DerivedArrayReadAttribute final : public ReadAttribute {
     const ElemT value = GetFunc(struct_value);
     new (r_value) ElemT(value);
   }
+
+  void materialize_to_uninitialized_internal(IndexMask mask, void *r_values) const override
+  {
+    ElemT *dst = (ElemT *)r_values;
+    mask.foreach_index([&](const int64_t i) { new (dst + i) ElemT(GetFunc(data_[i])); });
+  }
+
+  void materialize_compressed_to_uninitialized_internal(IndexMask mask,
+                                                        void *r_values) const override
+  {
+    ElemT *dst = (ElemT *)r_values;
+    for (const int64_t i : mask.index_range()) {
+      new (dst + i) ElemT(GetFunc(data_[mask[i]]));
+    }
+  }
 };
 
 template<typename T> class ArrayWriteAttribute final : public WriteAttribute {
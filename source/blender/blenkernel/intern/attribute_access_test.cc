@@ -0,0 +1,145 @@
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ * Copyright 2021, Blender Foundation.
+ */
+#include "testing/testing.h"
+
+#include "MEM_guardedalloc.h"
+
+#include "BKE_attribute_access.hh"
+#include "BKE_geometry_set.hh"
+#include "BKE_mesh.h"
+
+#include "DNA_mesh_types.h"
+#include "DNA_meshdata_types.h"
+
+namespace blender::bke::tests {
+
+/* Two quads sharing an edge, with an attribute on the points. */
+static Mesh *create_test_mesh()
+{
+  Mesh *mesh = BKE_mesh_new_nomain(6, 0, 0, 8, 2);
+  const int loop_verts[8] = {0, 1, 4, 3, 1, 2, 5, 4};
+  for (const int i : IndexRange(8)) {
+    mesh->mloop[i].v = loop_verts[i];
+  }
+  for (const int i : IndexRange(2)) {
+    mesh->mpoly[i].loopstart = i * 4;
+    mesh->mpoly[i].totloop = 4;
+  }
+  return mesh;
+}
+
+static void fill_test_attribute(MeshComponent &component)
+{
+  component.attribute_try_create("test", ATTR_DOMAIN_POINT, CD_PROP_FLOAT);
+  WriteAttributePtr attribute = component.attribute_try_get_for_write("test");
+  MutableSpan<float> values = attribute->get_span_for_write_only<float>();
+  for (const int i : values.index_range()) {
+    values[i] = i * 2.0f + 1.0f;
+  }
+  attribute->apply_span();
+}
+
+static void expect_materialized_values_equal(const ReadAttribute &attribute)
+{
+  const CPPType &type = attribute.cpp_type();
+  const int64_t size = attribute.size();
+  Vector<int64_t> indices;
+  for (int64_t i = 1; i < size; i += 2) {
+    indices.append(i);
+  }
+  const IndexMask mask = indices.as_span();
+
+  Array<float3> expected(size);
+  for (const int64_t i : IndexRange(size)) {
+    attribute.get(i, &expected[i]);
+  }
+
+  Array<float3> values(size, float3(-1.0f));
+  attribute.materialize(mask, fn::GMutableSpan(type, values.data(), size));
+  for (const int64_t i : IndexRange(size)) {
+    if (mask.indices().contains(i)) {
+      EXPECT_EQ(values[i], expected[i]);
+    }
+    else {
+      /* Values that are not in the mask are not changed. */
+      EXPECT_EQ(values[i], float3(-1.0f));
+    }
+  }
+
+  Array<float3> compressed_values(mask.size());
+  attribute.materialize_compressed(mask,
+                                   fn::GMutableSpan(type, compressed_values.data(), mask.size()));
+  for (const int64_t i : mask.index_range()) {
+    EXPECT_EQ(compressed_values[i], expected[mask[i]]);
+  }
+
+  /* Nothing is materialized for empty masks. */
+  attribute.materialize_compressed(IndexMask(Span<int64_t>()),
+                                   fn::GMutableSpan(type, compressed_values.data(), 0));
+  attribute.materialize(IndexMask(Span<int64_t>()), fn::GMutableSpan(type, values.data(), size));
+  EXPECT_EQ(values[0], float3(-1.0f));
+
+  Span<float3> span = attribute.get_span<float3>();
+  for (const int64_t i : IndexRange(size)) {
+    EXPECT_EQ(span[i], expected[i]);
+  }
+}
+
+TEST(attribute_access, MaterializeAdaptedDomain)
+{
+  MeshComponent component;
+  component.replace(create_test_mesh());
+  fill_test_attribute(component);
+
+  ReadAttributePtr corner_attribute = component.attribute_try_get_for_read(
+      "test", ATTR_DOMAIN_CORNER, CD_PROP_FLOAT3);
+  ASSERT_TRUE(corner_attribute);
+  EXPECT_EQ(corner_attribute->domain(), ATTR_DOMAIN_CORNER);
+  EXPECT_EQ(corner_attribute->size(), 8);
+  float3 value;
+  corner_attribute->get(6, &value);
+  EXPECT_EQ(value, float3(11.0f));
+  expect_materialized_values_equal(*corner_attribute);
+
+  ReadAttributePtr polygon_attribute = component.attribute_try_get_for_read(
+      "test", ATTR_DOMAIN_POLYGON, CD_PROP_FLOAT3);
+  ASSERT_TRUE(polygon_attribute);
+  EXPECT_EQ(polygon_attribute->domain(), ATTR_DOMAIN_POLYGON);
+  EXPECT_EQ(polygon_attribute->size(), 2);
+  polygon_attribute->get(1, &value);
+  EXPECT_EQ(value, float3(7.0f));
+  expect_materialized_values_equal(*polygon_attribute);
+}
+
+TEST(attribute_access, MaterializeConvertedLarge)
+{
+  /* More points than are converted at once, to test the chunks. */
+  MeshComponent component;
+  component.replace(BKE_mesh_new_nomain(5000, 0, 0, 0, 0));
+  fill_test_attribute(component);
+
+  ReadAttributePtr attribute = component.attribute_try_get_for_read(
+      "test", ATTR_DOMAIN_POINT, CD_PROP_FLOAT3);
+  ASSERT_TRUE(attribute);
+  float3 value;
+  attribute->get(4321, &value);
+  EXPECT_EQ(value, float3(8643.0f));
+  expect_materialized_values_equal(*attribute);
+}
+
+}  // namespace blender::bke::tests
@@ -42,13 +42,16 @@
 #include "BKE_blender_version.h" /* own include */
 #include "BKE_blendfile.h"
 #include "BKE_brush.h"
+#include "BKE_bvhutils.h"
 #include "BKE_cachefile.h"
 #include "BKE_callbacks.h"
+#include "BKE_customdata.h"
 #include "BKE_global.h"
 #include "BKE_idprop.h"
 #include "BKE_image.h"
 #include "BKE_layer.h"
 #include "BKE_main.h"
+#include "BKE_mesh.h"
 #include "BKE_node.h"
 #include "BKE_report.h"
 #include "BKE_scene.h"
@@ -100,6 +103,8 @@ void BKE_blender_free(void)
 
   IMB_moviecache_destruct();
 
+  BKE_geometry_set_bvh_cache_free();
+  BKE_mesh_primitive_cache_free();
   BKE_node_system_exit();
 }
 
@@ -44,6 +44,7 @@
 #include "BKE_blender_version.h"
 #include "BKE_blendfile.h"
 #include "BKE_bpath.h"
+#include "BKE_bvhutils.h"
 #include "BKE_colorband.h"
 #include "BKE_context.h"
 #include "BKE_global.h"
@@ -53,6 +54,7 @@
 #include "BKE_lib_id.h"
 #include "BKE_lib_override.h"
 #include "BKE_main.h"
+#include "BKE_mesh.h"
 #include "BKE_preferences.h"
 #include "BKE_report.h"
 #include "BKE_scene.h"
@@ -276,6 +278,12 @@ static void setup_app_data(bContext *C,
     }
   }
 
+  if (mode != LOAD_UNDO) {
+    /* Caches of generated geometry, which isn't used by the new file. */
+    BKE_geometry_set_bvh_cache_free();
+    BKE_mesh_primitive_cache_free();
+  }
+
   /* free G_MAIN Main database */
   //  CTX_wm_manager_set(C, NULL);
   BKE_blender_globals_clear();
@@ -26,6 +26,8 @@
 
 #include "MEM_guardedalloc.h"
 
+#include "atomic_ops.h"
+
 /* Since we have versioning code here (CustomData_verify_versions()). */
 #define DNA_DEPRECATED_ALLOW
 
@@ -2061,6 +2063,56 @@ void customData_mask_layers__print(const CustomData_MeshMasks *mask)
 /********************* CustomData functions *********************/
 static void customData_update_offsets(CustomData *data);
 
+/**
+ * Stored in #CustomDataLayer.sharing_info when the layer data is shared between multiple
+ * layers with #CD_REFERENCE. The data is freed when the last of them is freed.
+ */
+typedef struct CustomDataLayerSharing {
+  int32_t users;
+} CustomDataLayerSharing;
+
+/**
+ * Start sharing the data of the layer if it isn't yet. This may be called from multiple threads
+ * for the same source layer, e.g. when different users copy the same mesh.
+ */
+static CustomDataLayerSharing *customData_layer_sharing_ensure(CustomDataLayer *layer)
+{
+  if (layer->sharing_info == NULL) {
+    CustomDataLayerSharing *sharing = MEM_mallocN(sizeof(*sharing), __func__);
+    sharing->users = 1;
+    if (atomic_cas_ptr(&layer->sharing_info, NULL, sharing) != NULL) {
+      /* Another thread started sharing the data in the meantime. */
+      MEM_freeN(sharing);
+    }
+  }
+  return layer->sharing_info;
+}
+
+/**
+ * Remove the layer from the users of its shared data.
+ * \return True if it was the last user, the caller is then responsible for freeing the data.
+ */
+static bool customData_layer_sharing_release(CustomDataLayer *layer)
+{
+  CustomDataLayerSharing *sharing = layer->sharing_info;
+  layer->sharing_info = NULL;
+  if (atomic_sub_and_fetch_int32(&sharing->users, 1) == 0) {
+    MEM_freeN(sharing);
+    return true;
+  }
+  return false;
+}
+
+/** Whether the layer data may not be modified, because it is referenced or shared. */
+static bool customData_layer_is_referenced(const CustomDataLayer *layer)
+{
+  if (layer->flag & CD_FLAG_NOFREE) {
+    return true;
+  }
+  const CustomDataLayerSharing *sharing = layer->sharing_info;
+  return sharing != NULL && sharing->users > 1;
+}
+
 static CustomDataLayer *customData_add_layer__internal(CustomData *data,
                                                        int type,
                                                        eCDAllocType alloctype,
@@ -2156,8 +2208,24 @@ bool CustomData_merge(const struct CustomData *source,
       newlayer = customData_add_layer__internal(
           dest, type, CD_REFERENCE, data, totelem, layer->name);
     }
+    else if ((alloctype == CD_REFERENCE) && !(flag & CD_FLAG_NOFREE) && data != NULL) {
+      /* Share the data instead of referencing it, so that it stays valid for the new layer even
+       * when the source layer is freed. */
+      newlayer = customData_add_layer__internal(dest, type, CD_ASSIGN, data, totelem, layer->name);
+      if (newlayer && newlayer->data == data && newlayer->sharing_info == NULL) {
+        CustomDataLayerSharing *sharing = customData_layer_sharing_ensure(
+            (CustomDataLayer *)layer);
+        atomic_add_and_fetch_int32(&sharing->users, 1);
+        newlayer->sharing_info = sharing;
+      }
+    }
     else {
       newlayer = customData_add_layer__internal(dest, type, alloctype, data, totelem, layer->name);
+      if (newlayer && (alloctype == CD_ASSIGN) && newlayer->data == data) {
+        /* The new layer takes over the place of the source layer among the users. */
+        newlayer->sharing_info = layer->sharing_info;
+        ((CustomDataLayer *)layer)->sharing_info = NULL;
+      }
     }
 
     if (newlayer) {
@@ -2176,6 +2244,10 @@ bool CustomData_merge(const struct CustomData *source,
   return changed;
 }
 
+static void *customData_duplicate_referenced_layer_index(CustomData *data,
+                                                         const int layer_index,
+                                                         const int totelem);
+
 /* NOTE: Take care of referenced layers by yourself! */
 void CustomData_realloc(CustomData *data, int totelem)
 {
@@ -2186,6 +2258,11 @@ void CustomData_realloc(CustomData *data, int totelem)
       continue;
     }
     typeInfo = layerType_getInfo(layer->type);
+    if (layer->sharing_info != NULL) {
+      /* Shared data can't be reallocated in place, the other users still need it. */
+      const int old_totelem = (int)(MEM_allocN_len(layer->data) / typeInfo->size);
+      customData_duplicate_referenced_layer_index(data, i, old_totelem);
+    }
     layer->data = MEM_reallocN(layer->data, (size_t)totelem * typeInfo->size);
   }
 }
@@ -2205,20 +2282,26 @@ void CustomData_copy(const struct CustomData *source,
   CustomData_merge(source, dest, mask, alloctype, totelem);
 }
 
-static void customData_free_layer__internal(CustomDataLayer *layer, int totelem)
+static void customData_free_layer_data(int type, void *data, int totelem)
 {
-  const LayerTypeInfo *typeInfo;
+  const LayerTypeInfo *typeInfo = layerType_getInfo(type);
 
-  if (!(layer->flag & CD_FLAG_NOFREE) && layer->data) {
-    typeInfo = layerType_getInfo(layer->type);
+  if (typeInfo->free) {
+    typeInfo->free(data, totelem, typeInfo->size);
+  }
 
-    if (typeInfo->free) {
-      typeInfo->free(layer->data, totelem, typeInfo->size);
-    }
+  MEM_freeN(data);
+}
 
-    if (layer->data) {
-      MEM_freeN(layer->data);
-    }
+static void customData_free_layer__internal(CustomDataLayer *layer, int totelem)
+{
+  if (layer->sharing_info != NULL && !customData_layer_sharing_release(layer)) {
+    /* The data is still used by other layers. */
+    return;
+  }
+
+  if (!(layer->flag & CD_FLAG_NOFREE) && layer->data) {
+    customData_free_layer_data(layer->type, layer->data, totelem);
   }
 }
 
@@ -2583,6 +2666,7 @@ static CustomDataLayer *customData_add_layer__internal(CustomData *data,
   data->layers[index].type = type;
   data->layers[index].flag = flag;
   data->layers[index].data = newlayerdata;
+  data->layers[index].sharing_info = NULL;
 
   /* Set default name if none exists. Note we only call DATA_()  once
    * we know there is a default name, to avoid overhead of locale lookups
@@ -2752,6 +2836,22 @@ int CustomData_number_of_layers_typemask(const CustomData *data, CustomDataMask
   return number;
 }
 
+static void *customData_duplicate_layer_data(const CustomDataLayer *layer, const int totelem)
+{
+  /* MEM_dupallocN won't work in case of complex layers, like e.g.
+   * CD_MDEFORMVERT, which has pointers to allocated data...
+   * So in case a custom copy function is defined, use it!
+   */
+  const LayerTypeInfo *typeInfo = layerType_getInfo(layer->type);
+
+  if (typeInfo->copy) {
+    void *dst_data = MEM_malloc_arrayN((size_t)totelem, typeInfo->size, "CD duplicate ref layer");
+    typeInfo->copy(layer->data, dst_data, totelem);
+    return dst_data;
+  }
+  return MEM_dupallocN(layer->data);
+}
+
 static void *customData_duplicate_referenced_layer_index(CustomData *data,
                                                          const int layer_index,
                                                          const int totelem)
@@ -2763,28 +2863,32 @@ static void *customData_duplicate_referenced_layer_index(CustomData *data,
   CustomDataLayer *layer = &data->layers[layer_index];
 
   if (layer->flag & CD_FLAG_NOFREE) {
-    /* MEM_dupallocN won't work in case of complex layers, like e.g.
-     * CD_MDEFORMVERT, which has pointers to allocated data...
-     * So in case a custom copy function is defined, use it!
-     */
-    const LayerTypeInfo *typeInfo = layerType_getInfo(layer->type);
-
-    if (typeInfo->copy) {
-      void *dst_data = MEM_malloc_arrayN(
-          (size_t)totelem, typeInfo->size, "CD duplicate ref layer");
-      typeInfo->copy(layer->data, dst_data, totelem);
-      layer->data = dst_data;
+    layer->data = customData_duplicate_layer_data(layer, totelem);
+    layer->flag &= ~CD_FLAG_NOFREE;
+  }
+  else if (layer->sharing_info != NULL) {
+    void *old_data = layer->data;
+    if (customData_layer_is_referenced(layer)) {
+      layer->data = customData_duplicate_layer_data(layer, totelem);
     }
-    else {
-      layer->data = MEM_dupallocN(layer->data);
+    if (customData_layer_sharing_release(layer) && layer->data != old_data) {
+      /* The other users have been freed while the data was copied. */
+      customData_free_layer_data(layer->type, old_data, totelem);
     }
-
-    layer->flag &= ~CD_FLAG_NOFREE;
   }
 
   return layer->data;
 }
 
+void CustomData_duplicate_shared_layers(CustomData *data, const int totelem)
+{
+  for (int i = 0; i < data->totlayer; i++) {
+    if (data->layers[i].sharing_info != NULL) {
+      customData_duplicate_referenced_layer_index(data, i, totelem);
+    }
+  }
+}
+
 void *CustomData_duplicate_referenced_layer(CustomData *data, const int type, const int totelem)
 {
   /* get the layer index of the first layer of type */
@@ -2825,7 +2929,7 @@ bool CustomData_is_referenced_layer(struct CustomData *data, int type)
 
   CustomDataLayer *layer = &data->layers[layer_index];
 
-  return (layer->flag & CD_FLAG_NOFREE) != 0;
+  return customData_layer_is_referenced(layer);
 }
 
 void CustomData_free_temporary(CustomData *data, int totelem)
@@ -2996,7 +3100,7 @@ void CustomData_copy_layer_type_data(const CustomData *source,
 void CustomData_free_elem(CustomData *data, int index, int count)
 {
   for (int i = 0; i < data->totlayer; i++) {
-    if (!(data->layers[i].flag & CD_FLAG_NOFREE)) {
+    if (!customData_layer_is_referenced(&data->layers[i])) {
       const LayerTypeInfo *typeInfo = layerType_getInfo(data->layers[i].type);
 
       if (typeInfo->free) {
@@ -3259,6 +3363,19 @@ const char *CustomData_get_layer_name(const CustomData *data, int type, int n)
   return (layer_index == -1) ? NULL : data->layers[layer_index].name;
 }
 
+/**
+ * Replace the data of the layer, the previous data is not freed. When it was shared with other
+ * layers it stays with them, callers that take over the previous data have to make it unique
+ * first, see #CustomData_duplicate_referenced_layer.
+ */
+static void customData_set_layer_data(CustomDataLayer *layer, void *ptr)
+{
+  if (layer->sharing_info != NULL) {
+    customData_layer_sharing_release(layer);
+  }
+  layer->data = ptr;
+}
+
 void *CustomData_set_layer(const CustomData *data, int type, void *ptr)
 {
   /* get the layer index of the first layer of type */
@@ -3268,7 +3385,7 @@ void *CustomData_set_layer(const CustomData *data, int type, void *ptr)
     return NULL;
   }
 
-  data->layers[layer_index].data = ptr;
+  customData_set_layer_data(&data->layers[layer_index], ptr);
 
   return ptr;
 }
@@ -3281,7 +3398,7 @@ void *CustomData_set_layer_n(const struct CustomData *data, int type, int n, voi
     return NULL;
   }
 
-  data->layers[layer_index].data = ptr;
+  customData_set_layer_data(&data->layers[layer_index], ptr);
 
   return ptr;
 }
@@ -3602,7 +3719,7 @@ void CustomData_bmesh_free_block(CustomData *data, void **block)
   }
 
   for (int i = 0; i < data->totlayer; i++) {
-    if (!(data->layers[i].flag & CD_FLAG_NOFREE)) {
+    if (!customData_layer_is_referenced(&data->layers[i])) {
       const LayerTypeInfo *typeInfo = layerType_getInfo(data->layers[i].type);
 
       if (typeInfo->free) {
@@ -3628,7 +3745,7 @@ void CustomData_bmesh_free_block_data(CustomData *data, void *block)
     return;
   }
   for (int i = 0; i < data->totlayer; i++) {
-    if (!(data->layers[i].flag & CD_FLAG_NOFREE)) {
+    if (!customData_layer_is_referenced(&data->layers[i])) {
       const LayerTypeInfo *typeInfo = layerType_getInfo(data->layers[i].type);
       if (typeInfo->free) {
         const size_t offset = data->layers[i].offset;
@@ -3669,7 +3786,7 @@ void CustomData_bmesh_free_block_data_exclude_by_type(CustomData *data,
     if ((CD_TYPE_AS_MASK(data->layers[i].type) & mask_exclude) == 0) {
       const LayerTypeInfo *typeInfo = layerType_getInfo(data->layers[i].type);
       const size_t offset = data->layers[i].offset;
-      if (!(data->layers[i].flag & CD_FLAG_NOFREE)) {
+      if (!customData_layer_is_referenced(&data->layers[i])) {
         if (typeInfo->free) {
           typeInfo->free(POINTER_OFFSET(block, offset), 1, typeInfo->size);
         }
@@ -3848,7 +3965,7 @@ bool CustomData_has_math(const struct CustomData *data)
 bool CustomData_bmesh_has_free(const struct CustomData *data)
 {
   for (int i = 0; i < data->totlayer; i++) {
-    if (!(data->layers[i].flag & CD_FLAG_NOFREE)) {
+    if (!customData_layer_is_referenced(&data->layers[i])) {
       const LayerTypeInfo *typeInfo = layerType_getInfo(data->layers[i].type);
       if (typeInfo->free) {
         return true;
@@ -3873,7 +3990,7 @@ bool CustomData_has_interp(const struct CustomData *data)
 bool CustomData_has_referenced(const struct CustomData *data)
 {
   for (int i = 0; i < data->totlayer; i++) {
-    if (data->layers[i].flag & CD_FLAG_NOFREE) {
+    if (customData_layer_is_referenced(&data->layers[i])) {
       return true;
     }
   }
@@ -5191,6 +5308,7 @@ void CustomData_blend_read(BlendDataReader *reader, CustomData *data, int count)
     }
 
     layer->flag &= ~CD_FLAG_NOFREE;
+    layer->sharing_info = NULL;
 
     if (CustomData_verify_versions(data, i)) {
       BLO_read_data_address(reader, &layer->data);
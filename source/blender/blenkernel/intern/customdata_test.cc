@@ -0,0 +1,147 @@
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ * Copyright 2021, Blender Foundation.
+ */
+#include "testing/testing.h"
+
+#include "MEM_guardedalloc.h"
+
+#include "BLI_index_range.hh"
+
+#include "BKE_customdata.h"
+
+#include "DNA_customdata_types.h"
+
+namespace blender::bke::tests {
+
+static void fill_float_layer(CustomData &data, const int totelem)
+{
+  CustomData_add_layer(&data, CD_PROP_FLOAT, CD_CALLOC, nullptr, totelem);
+  float *values = (float *)CustomData_get_layer(&data, CD_PROP_FLOAT);
+  for (const int i : IndexRange(totelem)) {
+    values[i] = (float)i;
+  }
+}
+
+TEST(customdata, ReferenceSharesData)
+{
+  CustomData source;
+  CustomData_reset(&source);
+  fill_float_layer(source, 4);
+
+  CustomData copy;
+  CustomData_copy(&source, &copy, CD_MASK_PROP_FLOAT, CD_REFERENCE, 4);
+  EXPECT_EQ(CustomData_get_layer(&copy, CD_PROP_FLOAT),
+            CustomData_get_layer(&source, CD_PROP_FLOAT));
+  EXPECT_TRUE(CustomData_is_referenced_layer(&source, CD_PROP_FLOAT));
+  EXPECT_TRUE(CustomData_is_referenced_layer(&copy, CD_PROP_FLOAT));
+
+  /* The data stays valid for the copy when the source is freed. */
+  CustomData_free(&source, 4);
+  EXPECT_FALSE(CustomData_is_referenced_layer(&copy, CD_PROP_FLOAT));
+  const float *values = (const float *)CustomData_get_layer(&copy, CD_PROP_FLOAT);
+  EXPECT_EQ(values[3], 3.0f);
+
+  /* The last user doesn't have to copy the data to modify it. */
+  EXPECT_EQ(CustomData_duplicate_referenced_layer(&copy, CD_PROP_FLOAT, 4), values);
+  CustomData_free(&copy, 4);
+}
+
+TEST(customdata, DuplicateSharedLayer)
+{
+  CustomData source;
+  CustomData_reset(&source);
+  fill_float_layer(source, 4);
+
+  CustomData copy;
+  CustomData_copy(&source, &copy, CD_MASK_PROP_FLOAT, CD_REFERENCE, 4);
+  const float *source_values = (const float *)CustomData_get_layer(&source, CD_PROP_FLOAT);
+  float *copy_values = (float *)CustomData_duplicate_referenced_layer(&copy, CD_PROP_FLOAT, 4);
+  EXPECT_NE(copy_values, source_values);
+  EXPECT_FALSE(CustomData_is_referenced_layer(&source, CD_PROP_FLOAT));
+  EXPECT_FALSE(CustomData_is_referenced_layer(&copy, CD_PROP_FLOAT));
+
+  copy_values[0] = 10.0f;
+  EXPECT_EQ(source_values[0], 0.0f);
+  EXPECT_EQ(copy_values[3], 3.0f);
+
+  CustomData_free(&source, 4);
+  CustomData_free(&copy, 4);
+}
+
+TEST(customdata, ReferenceOfSharedLayer)
+{
+  CustomData source;
+  CustomData_reset(&source);
+  fill_float_layer(source, 4);
+
+  CustomData copy_a;
+  CustomData copy_b;
+  CustomData_copy(&source, &copy_a, CD_MASK_PROP_FLOAT, CD_REFERENCE, 4);
+  CustomData_copy(&copy_a, &copy_b, CD_MASK_PROP_FLOAT, CD_REFERENCE, 4);
+  CustomData_free(&source, 4);
+  CustomData_free(&copy_a, 4);
+
+  const float *values = (const float *)CustomData_get_layer(&copy_b, CD_PROP_FLOAT);
+  EXPECT_EQ(values[2], 2.0f);
+  EXPECT_FALSE(CustomData_is_referenced_layer(&copy_b, CD_PROP_FLOAT));
+  CustomData_free(&copy_b, 4);
+}
+
+TEST(customdata, SetLayerOfSharedLayer)
+{
+  CustomData source;
+  CustomData_reset(&source);
+  fill_float_layer(source, 4);
+
+  CustomData copy;
+  CustomData_copy(&source, &copy, CD_MASK_PROP_FLOAT, CD_REFERENCE, 4);
+  float *new_values = (float *)MEM_calloc_arrayN(4, sizeof(float), __func__);
+  CustomData_set_layer(&copy, CD_PROP_FLOAT, new_values);
+
+  /* Replacing the data stops sharing, both layers free their own data. */
+  EXPECT_FALSE(CustomData_is_referenced_layer(&source, CD_PROP_FLOAT));
+  EXPECT_FALSE(CustomData_is_referenced_layer(&copy, CD_PROP_FLOAT));
+  const float *source_values = (const float *)CustomData_get_layer(&source, CD_PROP_FLOAT);
+  EXPECT_EQ(source_values[3], 3.0f);
+
+  CustomData_free(&source, 4);
+  CustomData_free(&copy, 4);
+}
+
+TEST(customdata, DuplicateSharedLayers)
+{
+  CustomData source;
+  CustomData_reset(&source);
+  fill_float_layer(source, 4);
+
+  CustomData copy;
+  CustomData_copy(&source, &copy, CD_MASK_PROP_FLOAT, CD_REFERENCE, 4);
+  CustomData_duplicate_shared_layers(&copy, 4);
+
+  /* Writing to the copy directly doesn't change the source anymore. */
+  EXPECT_FALSE(CustomData_is_referenced_layer(&source, CD_PROP_FLOAT));
+  EXPECT_FALSE(CustomData_is_referenced_layer(&copy, CD_PROP_FLOAT));
+  float *copy_values = (float *)CustomData_get_layer(&copy, CD_PROP_FLOAT);
+  copy_values[3] = 10.0f;
+  const float *source_values = (const float *)CustomData_get_layer(&source, CD_PROP_FLOAT);
+  EXPECT_EQ(source_values[3], 3.0f);
+
+  CustomData_free(&source, 4);
+  CustomData_free(&copy, 4);
+}
+
+}  // namespace blender::bke::tests
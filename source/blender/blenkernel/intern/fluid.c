@@ -1024,8 +1024,7 @@ static void obstacles_from_mesh(Object *coll_ob,
 
     /* Duplicate vertices to modify. */
     if (me->mvert) {
-      me->mvert = MEM_dupallocN(me->mvert);
-      CustomData_set_layer(&me->vdata, CD_MVERT, me->mvert);
+      me->mvert = CustomData_duplicate_referenced_layer(&me->vdata, CD_MVERT, me->totvert);
     }
 
     BKE_mesh_ensure_normals(me);
@@ -2110,8 +2109,7 @@ static void emit_from_mesh(
 
     /* Duplicate vertices to modify. */
     if (me->mvert) {
-      me->mvert = MEM_dupallocN(me->mvert);
-      CustomData_set_layer(&me->vdata, CD_MVERT, me->mvert);
+      me->mvert = CustomData_duplicate_referenced_layer(&me->vdata, CD_MVERT, me->totvert);
     }
 
     BKE_mesh_ensure_normals(me);
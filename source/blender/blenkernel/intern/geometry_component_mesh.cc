@@ -22,6 +22,7 @@
 
 #include "BKE_attribute_access.hh"
 #include "BKE_attribute_math.hh"
+#include "BKE_customdata.h"
 #include "BKE_deform.h"
 #include "BKE_geometry_set.hh"
 #include "BKE_lib_id.h"
@@ -51,7 +52,10 @@ GeometryComponent *MeshComponent::copy() const
 {
   MeshComponent *new_component = new MeshComponent();
   if (mesh_ != nullptr) {
-    new_component->mesh_ = BKE_mesh_copy_for_eval(mesh_, false);
+    /* The custom data layers of owned meshes are shared with the copy. They are only copied
+     * when they are accessed for writing. Other meshes can be changed or freed by their owner,
+     * so they are copied fully. */
+    new_component->mesh_ = BKE_mesh_copy_for_eval(mesh_, this->owns_direct_data());
     new_component->ownership_ = GeometryOwnershipType::Owned;
     new_component->vertex_group_names_ = blender::Map(vertex_group_names_);
   }
@@ -108,6 +112,16 @@ Mesh *MeshComponent::release()
   BLI_assert(this->is_mutable());
   Mesh *mesh = mesh_;
   mesh_ = nullptr;
+  if (mesh != nullptr) {
+    /* Layers can be shared with other meshes, e.g. ones kept in a cache of the nodes modifier.
+     * The caller can write to the arrays of the mesh directly, so it must not share them. */
+    CustomData_duplicate_shared_layers(&mesh->vdata, mesh->totvert);
+    CustomData_duplicate_shared_layers(&mesh->edata, mesh->totedge);
+    CustomData_duplicate_shared_layers(&mesh->fdata, mesh->totface);
+    CustomData_duplicate_shared_layers(&mesh->ldata, mesh->totloop);
+    CustomData_duplicate_shared_layers(&mesh->pdata, mesh->totpoly);
+    BKE_mesh_update_customdata_pointers(mesh, false);
+  }
   return mesh;
 }
 
@@ -146,12 +160,26 @@ Mesh *MeshComponent::get_for_write()
 {
   BLI_assert(this->is_mutable());
   if (ownership_ == GeometryOwnershipType::ReadOnly) {
-    mesh_ = BKE_mesh_copy_for_eval(mesh_, false);
+    mesh_ = BKE_mesh_copy_for_eval(mesh_, true);
     ownership_ = GeometryOwnershipType::Owned;
   }
   return mesh_;
 }
 
+bool MeshComponent::owns_direct_data() const
+{
+  return mesh_ == nullptr || ownership_ == GeometryOwnershipType::Owned;
+}
+
+void MeshComponent::ensure_owns_direct_data()
+{
+  BLI_assert(this->is_mutable());
+  if (!this->owns_direct_data()) {
+    mesh_ = BKE_mesh_copy_for_eval(mesh_, false);
+    ownership_ = GeometryOwnershipType::Owned;
+  }
+}
+
 bool MeshComponent::is_empty() const
 {
   return mesh_ == nullptr;
@@ -187,6 +215,51 @@ int MeshComponent::attribute_domain_size(const AttributeDomain domain) const
 
 namespace blender::bke {
 
+/**
+ * Interpolates the values of an attribute on another domain when they are accessed, instead of
+ * computing the values for the entire new domain up front. When a node only uses some of the
+ * values, no array as large as the new domain has to be allocated. The old values are read from
+ * a span, which doesn't need a copy when the attribute is stored in an array.
+ * `AdaptFn` computes the values at the indices in the mask, written compressed to the output.
+ */
+template<typename T, void (*AdaptFn)(const Mesh &mesh, Span<T>, IndexMask, MutableSpan<T>)>
+class MeshAdaptedDomainReadAttribute final : public ReadAttribute {
+ private:
+  const Mesh &mesh_;
+  ReadAttributePtr old_attribute_;
+  Span<T> old_values_;
+
+ public:
+  MeshAdaptedDomainReadAttribute(const AttributeDomain domain,
+                                 const int64_t size,
+                                 const Mesh &mesh,
+                                 ReadAttributePtr old_attribute)
+      : ReadAttribute(domain, CPPType::get<T>(), size),
+        mesh_(mesh),
+        old_attribute_(std::move(old_attribute)),
+        old_values_(old_attribute_->get_span<T>())
+  {
+  }
+
+  void get_internal(const int64_t index, void *r_value) const override
+  {
+    this->materialize_compressed_to_uninitialized_internal(Span<int64_t>(&index, 1), r_value);
+  }
+
+  void materialize_to_uninitialized_internal(IndexMask mask, void *r_values) const override
+  {
+    this->materialize_in_compressed_chunks(mask, r_values);
+  }
+
+  void materialize_compressed_to_uninitialized_internal(IndexMask mask,
+                                                        void *r_values) const override
+  {
+    MutableSpan<T> values{(T *)r_values, mask.size()};
+    default_construct_n(values.data(), values.size());
+    AdaptFn(mesh_, old_values_, mask, values);
+  }
+};
+
 template<typename T>
 static void adapt_mesh_domain_corner_to_point_impl(const Mesh &mesh,
                                                    const TypedReadAttribute<T> &attribute,
@@ -225,14 +298,13 @@ static ReadAttributePtr adapt_mesh_domain_corner_to_point(const Mesh &mesh,
 
 template<typename T>
 static void adapt_mesh_domain_point_to_corner_impl(const Mesh &mesh,
-                                                   const TypedReadAttribute<T> &attribute,
+                                                   const Span<T> old_values,
+                                                   const IndexMask mask,
                                                    MutableSpan<T> r_values)
 {
-  BLI_assert(r_values.size() == mesh.totloop);
-
-  for (const int loop_index : IndexRange(mesh.totloop)) {
-    const int vertex_index = mesh.mloop[loop_index].v;
-    r_values[loop_index] = attribute[vertex_index];
+  for (const int64_t i : mask.index_range()) {
+    const int vertex_index = mesh.mloop[mask[i]].v;
+    r_values[i] = old_values[vertex_index];
   }
 }
 
@@ -243,36 +315,26 @@ static ReadAttributePtr adapt_mesh_domain_point_to_corner(const Mesh &mesh,
   const CustomDataType data_type = attribute->custom_data_type();
   attribute_math::convert_to_static_type(data_type, [&](auto dummy) {
     using T = decltype(dummy);
-    /* It is not strictly necessary to compute the value for all corners here. Instead one could
-     * lazily lookup the mesh topology when a specific index accessed. This can be more efficient
-     * when an algorithm only accesses very few of the corner values. However, for the algorithms
-     * we currently have, precomputing the array is fine. Also, it is easier to implement. */
-    Array<T> values(mesh.totloop);
-    adapt_mesh_domain_point_to_corner_impl<T>(mesh, *attribute, values);
-    new_attribute = std::make_unique<OwnedArrayReadAttribute<T>>(ATTR_DOMAIN_CORNER,
-                                                                 std::move(values));
+    new_attribute = std::make_unique<
+        MeshAdaptedDomainReadAttribute<T, adapt_mesh_domain_point_to_corner_impl<T>>>(
+        ATTR_DOMAIN_CORNER, mesh.totloop, mesh, std::move(attribute));
   });
   return new_attribute;
 }
 
-/**
- * \note Theoretically this interpolation does not need to compute all values at once.
- * However, doing that makes the implementation simpler, and this can be optimized in the future if
- * only some values are required.
- */
 template<typename T>
 static void adapt_mesh_domain_corner_to_polygon_impl(const Mesh &mesh,
-                                                     Span<T> old_values,
+                                                     const Span<T> old_values,
+                                                     const IndexMask mask,
                                                      MutableSpan<T> r_values)
 {
-  BLI_assert(r_values.size() == mesh.totpoly);
   attribute_math::DefaultMixer<T> mixer(r_values);
 
-  for (const int poly_index : IndexRange(mesh.totpoly)) {
-    const MPoly &poly = mesh.mpoly[poly_index];
+  for (const int64_t i : mask.index_range()) {
+    const MPoly &poly = mesh.mpoly[mask[i]];
     for (const int loop_index : IndexRange(poly.loopstart, poly.totloop)) {
       const T value = old_values[loop_index];
-      mixer.mix_in(poly_index, value);
+      mixer.mix_in(i, value);
     }
   }
 
@@ -287,10 +349,9 @@ static ReadAttributePtr adapt_mesh_domain_corner_to_polygon(const Mesh &mesh,
   attribute_math::convert_to_static_type(data_type, [&](auto dummy) {
     using T = decltype(dummy);
     if constexpr (!std::is_void_v<attribute_math::DefaultMixer<T>>) {
-      Array<T> values(mesh.totpoly);
-      adapt_mesh_domain_corner_to_polygon_impl<T>(mesh, attribute->get_span<T>(), values);
-      new_attribute = std::make_unique<OwnedArrayReadAttribute<T>>(ATTR_DOMAIN_POINT,
-                                                                   std::move(values));
+      new_attribute = std::make_unique<
+          MeshAdaptedDomainReadAttribute<T, adapt_mesh_domain_corner_to_polygon_impl<T>>>(
+          ATTR_DOMAIN_POLYGON, mesh.totpoly, mesh, std::move(attribute));
     }
   });
   return new_attribute;
@@ -358,32 +419,27 @@ static ReadAttributePtr adapt_mesh_domain_polygon_to_corner(const Mesh &mesh,
     if constexpr (!std::is_void_v<attribute_math::DefaultMixer<T>>) {
       Array<T> values(mesh.totloop);
       adapt_mesh_domain_polygon_to_corner_impl<T>(mesh, attribute->get_span<T>(), values);
-      new_attribute = std::make_unique<OwnedArrayReadAttribute<T>>(ATTR_DOMAIN_POINT,
+      new_attribute = std::make_unique<OwnedArrayReadAttribute<T>>(ATTR_DOMAIN_CORNER,
                                                                    std::move(values));
     }
   });
   return new_attribute;
 }
 
-/**
- * \note Theoretically this interpolation does not need to compute all values at once.
- * However, doing that makes the implementation simpler, and this can be optimized in the future if
- * only some values are required.
- */
 template<typename T>
 static void adapt_mesh_domain_point_to_polygon_impl(const Mesh &mesh,
                                                     const Span<T> old_values,
+                                                    const IndexMask mask,
                                                     MutableSpan<T> r_values)
 {
-  BLI_assert(r_values.size() == mesh.totpoly);
   attribute_math::DefaultMixer<T> mixer(r_values);
 
-  for (const int poly_index : IndexRange(mesh.totpoly)) {
-    const MPoly &poly = mesh.mpoly[poly_index];
+  for (const int64_t i : mask.index_range()) {
+    const MPoly &poly = mesh.mpoly[mask[i]];
     for (const int loop_index : IndexRange(poly.loopstart, poly.totloop)) {
-      MLoop &loop = mesh.mloop[loop_index];
+      const MLoop &loop = mesh.mloop[loop_index];
       const int point_index = loop.v;
-      mixer.mix_in(poly_index, old_values[point_index]);
+      mixer.mix_in(i, old_values[point_index]);
     }
   }
   mixer.finalize();
@@ -397,10 +453,9 @@ static ReadAttributePtr adapt_mesh_domain_point_to_polygon(const Mesh &mesh,
   attribute_math::convert_to_static_type(data_type, [&](auto dummy) {
     using T = decltype(dummy);
     if constexpr (!std::is_void_v<attribute_math::DefaultMixer<T>>) {
-      Array<T> values(mesh.totpoly);
-      adapt_mesh_domain_point_to_polygon_impl<T>(mesh, attribute->get_span<T>(), values);
-      new_attribute = std::make_unique<OwnedArrayReadAttribute<T>>(ATTR_DOMAIN_POINT,
-                                                                   std::move(values));
+      new_attribute = std::make_unique<
+          MeshAdaptedDomainReadAttribute<T, adapt_mesh_domain_point_to_polygon_impl<T>>>(
+          ATTR_DOMAIN_POLYGON, mesh.totpoly, mesh, std::move(attribute));
     }
   });
   return new_attribute;
@@ -757,6 +812,8 @@ class VertexGroupsAttributeProvider final : public DynamicAttributesProvider {
     if (mesh->dvert == nullptr) {
       return true;
     }
+    mesh->dvert = (MDeformVert *)CustomData_duplicate_referenced_layer(
+        &mesh->vdata, CD_MDEFORMVERT, mesh->totvert);
     for (MDeformVert &dvert : MutableSpan(mesh->dvert, mesh->totvert)) {
       MDeformWeight *weight = BKE_defvert_find_index(&dvert, vertex_group_index);
       BKE_defvert_remove_group(&dvert, weight);
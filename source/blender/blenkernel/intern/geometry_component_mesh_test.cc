@@ -0,0 +1,52 @@
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ * Copyright 2021, Blender Foundation.
+ */
+#include "testing/testing.h"
+
+#include "BKE_geometry_set.hh"
+#include "BKE_lib_id.h"
+#include "BKE_mesh.h"
+
+#include "DNA_mesh_types.h"
+#include "DNA_meshdata_types.h"
+
+namespace blender::bke::tests {
+
+TEST(mesh_component, ReleaseDoesNotShareLayers)
+{
+  Mesh *mesh = BKE_mesh_new_nomain(2, 1, 0, 0, 0);
+  mesh->medge[0].v1 = 0;
+  mesh->medge[0].v2 = 1;
+
+  /* A geometry set that isn't changed anymore, like the results cached by the nodes modifier. */
+  const GeometrySet cached_geometry_set = GeometrySet::create_with_mesh(mesh);
+
+  /* Copying the component for writing shares the layers of the cached mesh. */
+  GeometrySet geometry_set = cached_geometry_set;
+  Mesh *released_mesh = geometry_set.get_component_for_write<MeshComponent>().release();
+  ASSERT_NE(released_mesh, mesh);
+
+  /* Modifiers like Normal Edit write to the arrays of the released mesh directly. */
+  EXPECT_NE(released_mesh->medge, mesh->medge);
+  released_mesh->medge[0].flag |= ME_SHARP;
+  EXPECT_EQ(mesh->medge[0].flag & ME_SHARP, 0);
+  EXPECT_EQ(released_mesh->medge[0].v2, 1);
+
+  BKE_id_free(nullptr, released_mesh);
+}
+
+}  // namespace blender::bke::tests
@@ -102,6 +102,20 @@ PointCloud *PointCloudComponent::get_for_write()
   return pointcloud_;
 }
 
+bool PointCloudComponent::owns_direct_data() const
+{
+  return pointcloud_ == nullptr || ownership_ == GeometryOwnershipType::Owned;
+}
+
+void PointCloudComponent::ensure_owns_direct_data()
+{
+  BLI_assert(this->is_mutable());
+  if (!this->owns_direct_data()) {
+    pointcloud_ = BKE_pointcloud_copy_for_eval(pointcloud_, false);
+    ownership_ = GeometryOwnershipType::Owned;
+  }
+}
+
 bool PointCloudComponent::is_empty() const
 {
   return pointcloud_ == nullptr;
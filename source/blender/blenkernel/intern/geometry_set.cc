@@ -99,6 +99,15 @@ bool GeometryComponent::is_empty() const
   return false;
 }
 
+bool GeometryComponent::owns_direct_data() const
+{
+  return true;
+}
+
+void GeometryComponent::ensure_owns_direct_data()
+{
+}
+
 /** \} */
 
 /* -------------------------------------------------------------------- */
@@ -172,6 +181,24 @@ Vector<const GeometryComponent *> GeometrySet::get_components_for_read() const
   return components;
 }
 
+/**
+ * Make sure the geometry set can be kept after the data referenced by its components has been
+ * freed by its owner, e.g. to cache it. Shared components are copied when they don't own their
+ * data.
+ */
+void GeometrySet::ensure_owns_direct_data()
+{
+  Vector<GeometryComponentType> types;
+  for (const GeometryComponent *component : this->get_components_for_read()) {
+    if (!component->owns_direct_data()) {
+      types.append(component->type());
+    }
+  }
+  for (const GeometryComponentType type : types) {
+    this->get_component_for_write(type).ensure_owns_direct_data();
+  }
+}
+
 void GeometrySet::compute_boundbox_without_instances(float3 *r_min, float3 *r_max) const
 {
   const PointCloud *pointcloud = this->get_pointcloud_for_read();
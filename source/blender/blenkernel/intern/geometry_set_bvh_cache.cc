@@ -0,0 +1,319 @@
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+/** \file
+ * \ingroup bke
+ */
+
+#include <mutex>
+
+#include "BLI_hash_mm2a.h"
+#include "BLI_map.hh"
+
+#include "DNA_mesh_types.h"
+#include "DNA_meshdata_types.h"
+#include "DNA_pointcloud_types.h"
+
+#include "BKE_geometry_set_bvh_cache.hh"
+#include "BKE_mesh_runtime.h"
+
+/* The tree type and axis that are used for all cached trees. */
+#define CACHED_TREE_TYPE 2
+#define CACHED_TREE_AXIS 6
+
+namespace blender::bke {
+
+/* The number of trees and their memory in bytes that are kept when they are not used anymore. */
+static constexpr int max_cached_trees = 16;
+static constexpr int64_t max_cached_bytes = 256 * 1024 * 1024;
+
+struct CachedBVHTree {
+  BVHTree *tree = nullptr;
+  /* Memory used by the tree in bytes, computed once it is built. */
+  int64_t size = 0;
+  /* The callbacks for the tree. The data arrays are set separately for every user, because they
+   * belong to the geometry the tree is requested for. */
+  BVHTreeFromMesh mesh_data = {nullptr};
+  BVHTreeFromPointCloud pointcloud_data = {nullptr};
+
+  ~CachedBVHTree()
+  {
+    BLI_bvhtree_free(tree);
+  }
+};
+
+namespace {
+
+struct BVHCacheKey {
+  /* Point clouds use #BVHTREE_MAX_ITEM, since they only have one kind of tree. */
+  BVHCacheType type;
+  int elements_num;
+  uint64_t content_hash;
+
+  uint64_t hash() const
+  {
+    return content_hash ^ ((uint64_t)type * 33) ^ ((uint64_t)elements_num * 97);
+  }
+
+  friend bool operator==(const BVHCacheKey &a, const BVHCacheKey &b)
+  {
+    return a.type == b.type && a.elements_num == b.elements_num &&
+           a.content_hash == b.content_hash;
+  }
+};
+
+struct BVHCacheEntry {
+  CachedBVHTreeUser tree;
+  uint64_t last_used;
+};
+
+struct GeometryBVHCache {
+  std::mutex mutex;
+  Map<BVHCacheKey, BVHCacheEntry> entries;
+  int64_t size = 0;
+  uint64_t usage_counter = 0;
+};
+
+}  // namespace
+
+static GeometryBVHCache &get_geometry_bvh_cache()
+{
+  static GeometryBVHCache cache;
+  return cache;
+}
+
+/**
+ * Two 32 bit hashes with different seeds are combined, to make collisions between the few cached
+ * trees practically impossible.
+ */
+static uint64_t hash_array(const void *data, const size_t size, const uint64_t hash)
+{
+  const uint32_t low = BLI_hash_mm2((const unsigned char *)data, size, (uint32_t)hash);
+  const uint32_t high = BLI_hash_mm2(
+      (const unsigned char *)data, size, (uint32_t)(hash >> 32) ^ 0x9e3779b9);
+  return ((uint64_t)high << 32) | low;
+}
+
+static bool mesh_cache_key(const Mesh &mesh, const BVHCacheType type, BVHCacheKey &r_key)
+{
+  r_key.type = type;
+  r_key.content_hash = hash_array(mesh.mvert, sizeof(MVert) * mesh.totvert, 0);
+  switch (type) {
+    case BVHTREE_FROM_VERTS:
+      r_key.elements_num = mesh.totvert;
+      return true;
+    case BVHTREE_FROM_EDGES:
+      r_key.elements_num = mesh.totedge;
+      r_key.content_hash = hash_array(
+          mesh.medge, sizeof(MEdge) * mesh.totedge, r_key.content_hash);
+      return true;
+    case BVHTREE_FROM_LOOPTRI:
+      r_key.elements_num = BKE_mesh_runtime_looptri_len(&mesh);
+      r_key.content_hash = hash_array(
+          mesh.mloop, sizeof(MLoop) * mesh.totloop, r_key.content_hash);
+      r_key.content_hash = hash_array(
+          mesh.mpoly, sizeof(MPoly) * mesh.totpoly, r_key.content_hash);
+      return true;
+    default:
+      /* Other trees depend on more data, like hidden or loose elements. */
+      BLI_assert(false);
+      return false;
+  }
+}
+
+static CachedBVHTreeUser cache_lookup(const BVHCacheKey &key)
+{
+  GeometryBVHCache &cache = get_geometry_bvh_cache();
+  std::lock_guard lock{cache.mutex};
+  BVHCacheEntry *entry = cache.entries.lookup_ptr(key);
+  if (entry == nullptr) {
+    return {};
+  }
+  entry->last_used = ++cache.usage_counter;
+  return entry->tree;
+}
+
+static void cache_add(const BVHCacheKey &key, std::shared_ptr<CachedBVHTree> tree)
+{
+  tree->size = sizeof(CachedBVHTree) + (int64_t)BLI_bvhtree_get_memory_size(tree->tree);
+  if (tree->size > max_cached_bytes) {
+    return;
+  }
+
+  GeometryBVHCache &cache = get_geometry_bvh_cache();
+  std::lock_guard lock{cache.mutex};
+  if (cache.entries.contains(key)) {
+    /* Another thread has built the same tree in the meantime. */
+    return;
+  }
+  cache.size += tree->size;
+  cache.entries.add_new(key, {std::move(tree), ++cache.usage_counter});
+
+  /* Remove the least recently used trees. Users keep them alive until they are done. */
+  while (cache.entries.size() > max_cached_trees || cache.size > max_cached_bytes) {
+    BVHCacheKey oldest_key;
+    uint64_t oldest_usage = UINT64_MAX;
+    for (Map<BVHCacheKey, BVHCacheEntry>::Item item : cache.entries.items()) {
+      if (item.value.last_used < oldest_usage) {
+        oldest_usage = item.value.last_used;
+        oldest_key = item.key;
+      }
+    }
+    cache.size -= cache.entries.pop(oldest_key).tree->size;
+  }
+}
+
+static BVHTree *build_mesh_tree(const Mesh &mesh,
+                                const BVHCacheType type,
+                                BVHTreeFromMesh &r_data)
+{
+  switch (type) {
+    case BVHTREE_FROM_VERTS:
+      return bvhtree_from_mesh_verts_ex(&r_data,
+                                        mesh.mvert,
+                                        mesh.totvert,
+                                        false,
+                                        nullptr,
+                                        -1,
+                                        0.0f,
+                                        CACHED_TREE_TYPE,
+                                        CACHED_TREE_AXIS,
+                                        type,
+                                        nullptr,
+                                        nullptr);
+    case BVHTREE_FROM_EDGES:
+      return bvhtree_from_mesh_edges_ex(&r_data,
+                                        mesh.mvert,
+                                        false,
+                                        mesh.medge,
+                                        mesh.totedge,
+                                        false,
+                                        nullptr,
+                                        -1,
+                                        0.0f,
+                                        CACHED_TREE_TYPE,
+                                        CACHED_TREE_AXIS,
+                                        type,
+                                        nullptr,
+                                        nullptr);
+    case BVHTREE_FROM_LOOPTRI: {
+      /* This only updates a cache and can be considered to be logically const. */
+      const MLoopTri *looptris = BKE_mesh_runtime_looptri_ensure(const_cast<Mesh *>(&mesh));
+      return bvhtree_from_mesh_looptri_ex(&r_data,
+                                          mesh.mvert,
+                                          false,
+                                          mesh.mloop,
+                                          false,
+                                          looptris,
+                                          BKE_mesh_runtime_looptri_len(&mesh),
+                                          false,
+                                          nullptr,
+                                          -1,
+                                          0.0f,
+                                          CACHED_TREE_TYPE,
+                                          CACHED_TREE_AXIS,
+                                          type,
+                                          nullptr,
+                                          nullptr);
+    }
+    default:
+      BLI_assert(false);
+      return nullptr;
+  }
+}
+
+CachedBVHTreeUser bvh_cache_get_for_mesh(const Mesh &mesh,
+                                         const BVHCacheType bvh_cache_type,
+                                         BVHTreeFromMesh &r_data)
+{
+  memset(&r_data, 0, sizeof(r_data));
+
+  BVHCacheKey key;
+  if (!mesh_cache_key(mesh, bvh_cache_type, key) || key.elements_num == 0) {
+    return {};
+  }
+
+  CachedBVHTreeUser cached_tree = cache_lookup(key);
+  if (!cached_tree) {
+    std::shared_ptr<CachedBVHTree> new_tree = std::make_shared<CachedBVHTree>();
+    new_tree->tree = build_mesh_tree(mesh, bvh_cache_type, new_tree->mesh_data);
+    if (new_tree->tree == nullptr) {
+      return {};
+    }
+    cached_tree = new_tree;
+    cache_add(key, std::move(new_tree));
+  }
+
+  r_data = cached_tree->mesh_data;
+  r_data.tree = cached_tree->tree;
+  r_data.vert = mesh.mvert;
+  r_data.edge = mesh.medge;
+  r_data.face = mesh.mface;
+  r_data.loop = mesh.mloop;
+  r_data.looptri = (bvh_cache_type == BVHTREE_FROM_LOOPTRI) ?
+                       BKE_mesh_runtime_looptri_ensure(const_cast<Mesh *>(&mesh)) :
+                       nullptr;
+  /* The tree is owned by the cache. */
+  r_data.cached = true;
+  return cached_tree;
+}
+
+CachedBVHTreeUser bvh_cache_get_for_pointcloud(const PointCloud &pointcloud,
+                                               BVHTreeFromPointCloud &r_data)
+{
+  memset(&r_data, 0, sizeof(r_data));
+  if (pointcloud.totpoint == 0) {
+    return {};
+  }
+
+  BVHCacheKey key;
+  key.type = BVHTREE_MAX_ITEM;
+  key.elements_num = pointcloud.totpoint;
+  key.content_hash = hash_array(pointcloud.co, sizeof(float[3]) * pointcloud.totpoint, 0);
+
+  CachedBVHTreeUser cached_tree = cache_lookup(key);
+  if (!cached_tree) {
+    std::shared_ptr<CachedBVHTree> new_tree = std::make_shared<CachedBVHTree>();
+    new_tree->tree = BKE_bvhtree_from_pointcloud_get(
+        &new_tree->pointcloud_data, &pointcloud, CACHED_TREE_TYPE);
+    if (new_tree->tree == nullptr) {
+      return {};
+    }
+    cached_tree = new_tree;
+    cache_add(key, std::move(new_tree));
+  }
+
+  r_data = cached_tree->pointcloud_data;
+  r_data.tree = cached_tree->tree;
+  r_data.coords = pointcloud.co;
+  return cached_tree;
+}
+
+int64_t bvh_cache_size()
+{
+  GeometryBVHCache &cache = get_geometry_bvh_cache();
+  std::lock_guard lock{cache.mutex};
+  return cache.size;
+}
+
+}  // namespace blender::bke
+
+void BKE_geometry_set_bvh_cache_free()
+{
+  blender::bke::GeometryBVHCache &cache = blender::bke::get_geometry_bvh_cache();
+  std::lock_guard lock{cache.mutex};
+  cache.entries.clear();
+  cache.size = 0;
+}
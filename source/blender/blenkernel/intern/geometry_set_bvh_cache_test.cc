@@ -0,0 +1,98 @@
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ * Copyright 2021, Blender Foundation.
+ */
+#include "testing/testing.h"
+
+#include "BLI_index_range.hh"
+
+#include "BKE_bvhutils.h"
+#include "BKE_geometry_set_bvh_cache.hh"
+#include "BKE_lib_id.h"
+#include "BKE_pointcloud.h"
+
+#include "DNA_pointcloud_types.h"
+
+namespace blender::bke::tests {
+
+static PointCloud *create_test_pointcloud(const int size, const float offset)
+{
+  PointCloud *pointcloud = BKE_pointcloud_new_nomain(size);
+  for (const int i : IndexRange(size)) {
+    pointcloud->co[i][0] = (float)i;
+    pointcloud->co[i][1] = offset;
+    pointcloud->co[i][2] = 0.0f;
+  }
+  return pointcloud;
+}
+
+TEST(geometry_set_bvh_cache, LookupByContent)
+{
+  BKE_geometry_set_bvh_cache_free();
+  PointCloud *pointcloud_a = create_test_pointcloud(100, 0.0f);
+  PointCloud *pointcloud_b = create_test_pointcloud(100, 0.0f);
+  PointCloud *pointcloud_c = create_test_pointcloud(100, 1.0f);
+
+  BVHTreeFromPointCloud data_a;
+  BVHTreeFromPointCloud data_b;
+  BVHTreeFromPointCloud data_c;
+  CachedBVHTreeUser tree_a = bvh_cache_get_for_pointcloud(*pointcloud_a, data_a);
+  CachedBVHTreeUser tree_b = bvh_cache_get_for_pointcloud(*pointcloud_b, data_b);
+  CachedBVHTreeUser tree_c = bvh_cache_get_for_pointcloud(*pointcloud_c, data_c);
+
+  /* Point clouds with the same positions use the same tree, but their own positions. */
+  ASSERT_TRUE(tree_a);
+  EXPECT_EQ(tree_a, tree_b);
+  EXPECT_EQ(data_a.tree, data_b.tree);
+  EXPECT_EQ(data_b.coords, pointcloud_b->co);
+  EXPECT_NE(tree_a, tree_c);
+  EXPECT_GT(bvh_cache_size(), 0);
+
+  BKE_geometry_set_bvh_cache_free();
+  EXPECT_EQ(bvh_cache_size(), 0);
+
+  BKE_id_free(nullptr, pointcloud_a);
+  BKE_id_free(nullptr, pointcloud_b);
+  BKE_id_free(nullptr, pointcloud_c);
+}
+
+TEST(geometry_set_bvh_cache, RemoveLeastRecentlyUsed)
+{
+  BKE_geometry_set_bvh_cache_free();
+  PointCloud *first_pointcloud = create_test_pointcloud(10, 0.0f);
+  BVHTreeFromPointCloud data;
+  CachedBVHTreeUser first_tree = bvh_cache_get_for_pointcloud(*first_pointcloud, data);
+
+  /* Add more trees than the cache keeps. */
+  for (const int i : IndexRange(1, 32)) {
+    PointCloud *pointcloud = create_test_pointcloud(10, (float)i);
+    EXPECT_TRUE(bvh_cache_get_for_pointcloud(*pointcloud, data));
+    BKE_id_free(nullptr, pointcloud);
+  }
+
+  /* The first tree has been removed from the cache, so it is built again. The old tree is still
+   * kept alive by its user. */
+  CachedBVHTreeUser new_first_tree = bvh_cache_get_for_pointcloud(*first_pointcloud, data);
+  EXPECT_NE(new_first_tree, first_tree);
+
+  /* The most recently used tree is found in the cache. */
+  EXPECT_EQ(bvh_cache_get_for_pointcloud(*first_pointcloud, data), new_first_tree);
+
+  BKE_geometry_set_bvh_cache_free();
+  BKE_id_free(nullptr, first_pointcloud);
+}
+
+}  // namespace blender::bke::tests
@@ -20,6 +20,8 @@
 #include "BKE_modifier.h"
 #include "BKE_pointcloud.h"
 
+#include "BLI_task.hh"
+
 #include "DNA_collection_types.h"
 #include "DNA_mesh_types.h"
 #include "DNA_meshdata_types.h"
@@ -28,13 +30,59 @@
 
 namespace blender::bke {
 
+namespace {
+
+/**
+ * Identifies the data of a geometry set that is realized when joining instances. Geometry sets
+ * that reference the same data are gathered in the same group, even when they are different
+ * geometry set objects, like the ones created for every instance of an object without a
+ * geometry nodes modifier.
+ */
+struct GeometryDataKey {
+  const Mesh *mesh;
+  const PointCloud *pointcloud;
+  const Volume *volume;
+
+  static GeometryDataKey from_geometry_set(const GeometrySet &geometry_set)
+  {
+    return {geometry_set.get_mesh_for_read(),
+            geometry_set.get_pointcloud_for_read(),
+            geometry_set.get_volume_for_read()};
+  }
+
+  bool is_empty() const
+  {
+    return mesh == nullptr && pointcloud == nullptr && volume == nullptr;
+  }
+
+  uint64_t hash() const
+  {
+    const uint64_t hash1 = DefaultHash<const Mesh *>{}(mesh);
+    const uint64_t hash2 = DefaultHash<const PointCloud *>{}(pointcloud);
+    const uint64_t hash3 = DefaultHash<const Volume *>{}(volume);
+    return hash1 ^ (hash2 * 33) ^ (hash3 * 97);
+  }
+
+  friend bool operator==(const GeometryDataKey &a, const GeometryDataKey &b)
+  {
+    return a.mesh == b.mesh && a.pointcloud == b.pointcloud && a.volume == b.volume;
+  }
+};
+
+struct GatherInstancesData {
+  Vector<GeometryInstanceGroup> &r_sets;
+  Map<GeometryDataKey, int> group_by_data;
+};
+
+}  // namespace
+
 static void geometry_set_collect_recursive(const GeometrySet &geometry_set,
                                            const float4x4 &transform,
-                                           Vector<GeometryInstanceGroup> &r_sets);
+                                           GatherInstancesData &gather_data);
 
 static void geometry_set_collect_recursive_collection(const Collection &collection,
                                                       const float4x4 &transform,
-                                                      Vector<GeometryInstanceGroup> &r_sets);
+                                                      GatherInstancesData &gather_data);
 
 /**
  * \note This doesn't extract instances from the "dupli" system for non-geometry-nodes instances.
@@ -71,53 +119,71 @@ static GeometrySet object_get_geometry_set_for_read(const Object &object)
   return new_geometry_set;
 }
 
-static void geometry_set_collect_recursive_collection_instance(
-    const Collection &collection, const float4x4 &transform, Vector<GeometryInstanceGroup> &r_sets)
+static void geometry_set_collect_recursive_collection_instance(const Collection &collection,
+                                                               const float4x4 &transform,
+                                                               GatherInstancesData &gather_data)
 {
   float4x4 offset_matrix;
   unit_m4(offset_matrix.values);
   sub_v3_v3(offset_matrix.values[3], collection.instance_offset);
   const float4x4 instance_transform = transform * offset_matrix;
-  geometry_set_collect_recursive_collection(collection, instance_transform, r_sets);
+  geometry_set_collect_recursive_collection(collection, instance_transform, gather_data);
 }
 
 static void geometry_set_collect_recursive_object(const Object &object,
                                                   const float4x4 &transform,
-                                                  Vector<GeometryInstanceGroup> &r_sets)
+                                                  GatherInstancesData &gather_data)
 {
   GeometrySet instance_geometry_set = object_get_geometry_set_for_read(object);
-  geometry_set_collect_recursive(instance_geometry_set, transform, r_sets);
+  geometry_set_collect_recursive(instance_geometry_set, transform, gather_data);
 
   if (object.type == OB_EMPTY) {
     const Collection *collection_instance = object.instance_collection;
     if (collection_instance != nullptr) {
-      geometry_set_collect_recursive_collection_instance(*collection_instance, transform, r_sets);
+      geometry_set_collect_recursive_collection_instance(
+          *collection_instance, transform, gather_data);
     }
   }
 }
 
 static void geometry_set_collect_recursive_collection(const Collection &collection,
                                                       const float4x4 &transform,
-                                                      Vector<GeometryInstanceGroup> &r_sets)
+                                                      GatherInstancesData &gather_data)
 {
   LISTBASE_FOREACH (const CollectionObject *, collection_object, &collection.gobject) {
     BLI_assert(collection_object->ob != nullptr);
     const Object &object = *collection_object->ob;
     const float4x4 object_transform = transform * object.obmat;
-    geometry_set_collect_recursive_object(object, object_transform, r_sets);
+    geometry_set_collect_recursive_object(object, object_transform, gather_data);
   }
   LISTBASE_FOREACH (const CollectionChild *, collection_child, &collection.children) {
     BLI_assert(collection_child->collection != nullptr);
     const Collection &collection = *collection_child->collection;
-    geometry_set_collect_recursive_collection(collection, transform, r_sets);
+    geometry_set_collect_recursive_collection(collection, transform, gather_data);
   }
 }
 
 static void geometry_set_collect_recursive(const GeometrySet &geometry_set,
                                            const float4x4 &transform,
-                                           Vector<GeometryInstanceGroup> &r_sets)
+                                           GatherInstancesData &gather_data)
 {
-  r_sets.append({geometry_set, {transform}});
+  const GeometryDataKey key = GeometryDataKey::from_geometry_set(geometry_set);
+  if (gather_data.r_sets.is_empty()) {
+    /* The argument geometry set is always the first group. */
+    gather_data.r_sets.append({geometry_set, {transform}});
+    if (!key.is_empty()) {
+      gather_data.group_by_data.add_new(key, 0);
+    }
+  }
+  else if (!key.is_empty()) {
+    /* Only store the transform when the data has been gathered before, so that realizing many
+     * instances of the same geometry does not require a copy of it for every instance. */
+    const int group_index = gather_data.group_by_data.lookup_or_add_cb(key, [&]() {
+      gather_data.r_sets.append({geometry_set, {}});
+      return (int)gather_data.r_sets.size() - 1;
+    });
+    gather_data.r_sets[group_index].transforms.append(transform);
+  }
 
   if (geometry_set.has_instances()) {
     const InstancesComponent &instances_component =
@@ -132,12 +198,13 @@ static void geometry_set_collect_recursive(const GeometrySet &geometry_set,
       if (data.type == INSTANCE_DATA_TYPE_OBJECT) {
         BLI_assert(data.data.object != nullptr);
         const Object &object = *data.data.object;
-        geometry_set_collect_recursive_object(object, instance_transform, r_sets);
+        geometry_set_collect_recursive_object(object, instance_transform, gather_data);
       }
       else if (data.type == INSTANCE_DATA_TYPE_COLLECTION) {
         BLI_assert(data.data.collection != nullptr);
         const Collection &collection = *data.data.collection;
-        geometry_set_collect_recursive_collection_instance(collection, instance_transform, r_sets);
+        geometry_set_collect_recursive_collection_instance(
+            collection, instance_transform, gather_data);
       }
     }
   }
@@ -151,6 +218,11 @@ static void geometry_set_collect_recursive(const GeometrySet &geometry_set,
  * \note For convenience (to avoid duplication in the caller), the returned vector also contains
  * the argument geometry set.
  *
+ * \note Instances of the same data are combined into a single group with multiple transforms, so
+ * the data itself is never duplicated for every instance. Groups are ordered by the first instance
+ * of their data, so realized instances of the same data are next to each other rather than in the
+ * order of the instances.
+ *
  * \note This doesn't extract instances from the "dupli" system for non-geometry-nodes instances.
  */
 Vector<GeometryInstanceGroup> geometry_set_gather_instances(const GeometrySet &geometry_set)
@@ -160,7 +232,8 @@ Vector<GeometryInstanceGroup> geometry_set_gather_instances(const GeometrySet &g
   float4x4 unit_transform;
   unit_m4(unit_transform.values);
 
-  geometry_set_collect_recursive(geometry_set, unit_transform, result_vector);
+  GatherInstancesData gather_data = {result_vector};
+  geometry_set_collect_recursive(geometry_set, unit_transform, gather_data);
 
   return result_vector;
 }
@@ -199,6 +272,22 @@ void gather_attribute_info(Map<std::string, AttributeKind> &attributes,
   }
 }
 
+/** The location of the data of one instance in the joined mesh. */
+struct RealizedMeshInstance {
+  const Mesh *mesh;
+  const float4x4 *transform;
+  int vert_offset;
+  int edge_offset;
+  int loop_offset;
+  int poly_offset;
+};
+
+struct RealizedPointCloudInstance {
+  const PointCloud *pointcloud;
+  const float4x4 *transform;
+  int vert_offset;
+};
+
 static Mesh *join_mesh_topology_and_builtin_attributes(Span<GeometryInstanceGroup> set_groups,
                                                        const bool convert_points_to_vertices)
 {
@@ -245,6 +334,10 @@ static Mesh *join_mesh_topology_and_builtin_attributes(Span<GeometryInstanceGrou
   new_mesh->runtime.cd_dirty_edge = cd_dirty_edge;
   new_mesh->runtime.cd_dirty_loop = cd_dirty_loop;
 
+  /* Compute the offsets of every instance first, so that the instances can be copied in
+   * parallel without creating intermediate meshes. */
+  Vector<RealizedMeshInstance> mesh_instances;
+  Vector<RealizedPointCloudInstance> pointcloud_instances;
   int vert_offset = 0;
   int loop_offset = 0;
   int edge_offset = 0;
@@ -254,36 +347,8 @@ static Mesh *join_mesh_topology_and_builtin_attributes(Span<GeometryInstanceGrou
     if (set.has_mesh()) {
       const Mesh &mesh = *set.get_mesh_for_read();
       for (const float4x4 &transform : set_group.transforms) {
-        for (const int i : IndexRange(mesh.totvert)) {
-          const MVert &old_vert = mesh.mvert[i];
-          MVert &new_vert = new_mesh->mvert[vert_offset + i];
-
-          new_vert = old_vert;
-
-          const float3 new_position = transform * float3(old_vert.co);
-          copy_v3_v3(new_vert.co, new_position);
-        }
-        for (const int i : IndexRange(mesh.totedge)) {
-          const MEdge &old_edge = mesh.medge[i];
-          MEdge &new_edge = new_mesh->medge[edge_offset + i];
-          new_edge = old_edge;
-          new_edge.v1 += vert_offset;
-          new_edge.v2 += vert_offset;
-        }
-        for (const int i : IndexRange(mesh.totloop)) {
-          const MLoop &old_loop = mesh.mloop[i];
-          MLoop &new_loop = new_mesh->mloop[loop_offset + i];
-          new_loop = old_loop;
-          new_loop.v += vert_offset;
-          new_loop.e += edge_offset;
-        }
-        for (const int i : IndexRange(mesh.totpoly)) {
-          const MPoly &old_poly = mesh.mpoly[i];
-          MPoly &new_poly = new_mesh->mpoly[poly_offset + i];
-          new_poly = old_poly;
-          new_poly.loopstart += loop_offset;
-        }
-
+        mesh_instances.append(
+            {&mesh, &transform, vert_offset, edge_offset, loop_offset, poly_offset});
         vert_offset += mesh.totvert;
         loop_offset += mesh.totloop;
         edge_offset += mesh.totedge;
@@ -293,17 +358,63 @@ static Mesh *join_mesh_topology_and_builtin_attributes(Span<GeometryInstanceGrou
     if (convert_points_to_vertices && set.has_pointcloud()) {
       const PointCloud &pointcloud = *set.get_pointcloud_for_read();
       for (const float4x4 &transform : set_group.transforms) {
-        for (const int i : IndexRange(pointcloud.totpoint)) {
-          MVert &new_vert = new_mesh->mvert[vert_offset + i];
-          const float3 old_position = pointcloud.co[i];
-          const float3 new_position = transform * old_position;
-          copy_v3_v3(new_vert.co, new_position);
-        }
+        pointcloud_instances.append({&pointcloud, &transform, vert_offset});
         vert_offset += pointcloud.totpoint;
       }
     }
   }
 
+  parallel_for(mesh_instances.index_range(), 32, [&](IndexRange range) {
+    for (const int instance_index : range) {
+      const RealizedMeshInstance &instance = mesh_instances[instance_index];
+      const Mesh &mesh = *instance.mesh;
+      const float4x4 &transform = *instance.transform;
+      for (const int i : IndexRange(mesh.totvert)) {
+        const MVert &old_vert = mesh.mvert[i];
+        MVert &new_vert = new_mesh->mvert[instance.vert_offset + i];
+
+        new_vert = old_vert;
+
+        const float3 new_position = transform * float3(old_vert.co);
+        copy_v3_v3(new_vert.co, new_position);
+      }
+      for (const int i : IndexRange(mesh.totedge)) {
+        const MEdge &old_edge = mesh.medge[i];
+        MEdge &new_edge = new_mesh->medge[instance.edge_offset + i];
+        new_edge = old_edge;
+        new_edge.v1 += instance.vert_offset;
+        new_edge.v2 += instance.vert_offset;
+      }
+      for (const int i : IndexRange(mesh.totloop)) {
+        const MLoop &old_loop = mesh.mloop[i];
+        MLoop &new_loop = new_mesh->mloop[instance.loop_offset + i];
+        new_loop = old_loop;
+        new_loop.v += instance.vert_offset;
+        new_loop.e += instance.edge_offset;
+      }
+      for (const int i : IndexRange(mesh.totpoly)) {
+        const MPoly &old_poly = mesh.mpoly[i];
+        MPoly &new_poly = new_mesh->mpoly[instance.poly_offset + i];
+        new_poly = old_poly;
+        new_poly.loopstart += instance.loop_offset;
+      }
+    }
+  });
+
+  parallel_for(pointcloud_instances.index_range(), 32, [&](IndexRange range) {
+    for (const int instance_index : range) {
+      const RealizedPointCloudInstance &instance = pointcloud_instances[instance_index];
+      const PointCloud &pointcloud = *instance.pointcloud;
+      const float4x4 &transform = *instance.transform;
+      for (const int i : IndexRange(pointcloud.totpoint)) {
+        MVert &new_vert = new_mesh->mvert[instance.vert_offset + i];
+        const float3 old_position = pointcloud.co[i];
+        const float3 new_position = transform * old_position;
+        copy_v3_v3(new_vert.co, new_position);
+      }
+    }
+  });
+
   return new_mesh;
 }
 
@@ -341,17 +452,18 @@ static void join_attributes(Span<GeometryInstanceGroup> set_groups,
               name, domain_output, data_type_output);
 
           if (source_attribute) {
+            /* The source span is only retrieved once for all instances of the group. */
             fn::GSpan src_span = source_attribute->get_span();
             const void *src_buffer = src_span.data();
-            for (const int UNUSED(i) : set_group.transforms.index_range()) {
-              void *dst_buffer = dst_span[offset];
-              cpp_type->copy_to_initialized_n(src_buffer, dst_buffer, domain_size);
-              offset += domain_size;
-            }
-          }
-          else {
-            offset += domain_size * set_group.transforms.size();
+            const int group_offset = offset;
+            parallel_for(set_group.transforms.index_range(), 32, [&](IndexRange range) {
+              for (const int i : range) {
+                void *dst_buffer = dst_span[group_offset + domain_size * i];
+                cpp_type->copy_to_initialized_n(src_buffer, dst_buffer, domain_size);
+              }
+            });
           }
+          offset += domain_size * set_group.transforms.size();
         }
       }
     }
@@ -394,7 +506,8 @@ static void join_instance_groups_pointcloud(Span<GeometryInstanceGroup> set_grou
     const GeometrySet &set = set_group.geometry_set;
     if (set.has<PointCloudComponent>()) {
       const PointCloudComponent &component = *set.get_component_for_read<PointCloudComponent>();
-      totpoint += component.attribute_domain_size(ATTR_DOMAIN_POINT);
+      totpoint += component.attribute_domain_size(ATTR_DOMAIN_POINT) *
+                  set_group.transforms.size();
     }
   }
 
@@ -0,0 +1,81 @@
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ * Copyright 2021, Blender Foundation.
+ */
+#include "testing/testing.h"
+
+#include "BLI_math_matrix.h"
+
+#include "BKE_attribute_access.hh"
+#include "BKE_geometry_set.hh"
+#include "BKE_geometry_set_instances.hh"
+#include "BKE_pointcloud.h"
+
+#include "DNA_object_types.h"
+#include "DNA_pointcloud_types.h"
+
+namespace blender::bke::tests {
+
+static float4x4 translation_matrix(const float3 translation)
+{
+  float4x4 matrix;
+  unit_m4(matrix.values);
+  copy_v3_v3(matrix.values[3], translation);
+  return matrix;
+}
+
+TEST(geometry_set_instances, RealizePointCloudInstances)
+{
+  PointCloud *pointcloud = BKE_pointcloud_new_nomain(3);
+  GeometrySet instance_geometry_set = GeometrySet::create_with_pointcloud(pointcloud);
+  PointCloudComponent &pointcloud_component =
+      instance_geometry_set.get_component_for_write<PointCloudComponent>();
+  pointcloud_component.attribute_try_create("test", ATTR_DOMAIN_POINT, CD_PROP_FLOAT);
+  WriteAttributePtr attribute = pointcloud_component.attribute_try_get_for_write("test");
+  MutableSpan<float> values = attribute->get_span_for_write_only<float>();
+  for (const int i : values.index_range()) {
+    values[i] = i + 1.0f;
+  }
+  attribute->apply_span();
+  attribute.reset();
+
+  Object object = {{nullptr}};
+  object.type = OB_POINTCLOUD;
+  object.runtime.geometry_set_eval = &instance_geometry_set;
+
+  /* Every instance references the same point cloud. */
+  GeometrySet geometry_set;
+  InstancesComponent &instances = geometry_set.get_component_for_write<InstancesComponent>();
+  for (const int i : IndexRange(3)) {
+    instances.add_instance(&object, translation_matrix(float3(i, 0.0f, 0.0f)));
+  }
+
+  GeometrySet realized_geometry_set = geometry_set_realize_instances(geometry_set);
+  const PointCloudComponent *realized_component =
+      realized_geometry_set.get_component_for_read<PointCloudComponent>();
+  ASSERT_NE(realized_component, nullptr);
+  EXPECT_EQ(realized_component->attribute_domain_size(ATTR_DOMAIN_POINT), 9);
+
+  ReadAttributePtr realized_attribute = realized_component->attribute_try_get_for_read(
+      "test", ATTR_DOMAIN_POINT, CD_PROP_FLOAT);
+  ASSERT_TRUE(realized_attribute);
+  Span<float> realized_values = realized_attribute->get_span<float>();
+  for (const int i : realized_values.index_range()) {
+    EXPECT_EQ(realized_values[i], i % 3 + 1.0f);
+  }
+}
+
+}  // namespace blender::bke::tests
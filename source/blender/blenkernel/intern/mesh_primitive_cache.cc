@@ -0,0 +1,158 @@
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+/** \file
+ * \ingroup bke
+ */
+
+#include <memory>
+#include <mutex>
+
+#include "BLI_array.hh"
+#include "BLI_map.hh"
+
+#include "DNA_mesh_types.h"
+#include "DNA_meshdata_types.h"
+
+#include "BKE_lib_id.h"
+#include "BKE_mesh.h"
+#include "BKE_mesh_primitive_cache.hh"
+
+namespace blender::bke {
+
+/* The number of meshes and the number of their corners that are kept at most. The generated
+ * meshes share the layers of the cached meshes, which stay alive as long as they are used. */
+static constexpr int max_cached_meshes = 64;
+static constexpr int64_t max_cached_corners = 1 << 22;
+
+namespace {
+
+struct CachedMeshPrimitive {
+  Mesh *mesh;
+  /* The positions of the cached mesh, which are transformed for every generated mesh. */
+  Array<float3> positions;
+
+  CachedMeshPrimitive(Mesh *mesh) : mesh(mesh), positions(mesh->totvert)
+  {
+    for (const int i : positions.index_range()) {
+      positions[i] = mesh->mvert[i].co;
+    }
+  }
+
+  ~CachedMeshPrimitive()
+  {
+    BKE_id_free(nullptr, mesh);
+  }
+};
+
+struct MeshPrimitiveCacheEntry {
+  std::shared_ptr<const CachedMeshPrimitive> primitive;
+  uint64_t last_used;
+};
+
+struct MeshPrimitiveCache {
+  std::mutex mutex;
+  Map<MeshPrimitiveCacheKey, MeshPrimitiveCacheEntry> entries;
+  int64_t corners_num = 0;
+  uint64_t usage_counter = 0;
+};
+
+}  // namespace
+
+static MeshPrimitiveCache &get_mesh_primitive_cache()
+{
+  static MeshPrimitiveCache cache;
+  return cache;
+}
+
+static std::shared_ptr<const CachedMeshPrimitive> lookup_cached_primitive(
+    const MeshPrimitiveCacheKey &key)
+{
+  MeshPrimitiveCache &cache = get_mesh_primitive_cache();
+  std::lock_guard lock{cache.mutex};
+  MeshPrimitiveCacheEntry *entry = cache.entries.lookup_ptr(key);
+  if (entry == nullptr) {
+    return {};
+  }
+  entry->last_used = cache.usage_counter++;
+  return entry->primitive;
+}
+
+static void remove_least_recently_used(MeshPrimitiveCache &cache)
+{
+  MeshPrimitiveCacheKey oldest_key;
+  uint64_t oldest_usage = UINT64_MAX;
+  for (Map<MeshPrimitiveCacheKey, MeshPrimitiveCacheEntry>::Item item : cache.entries.items()) {
+    if (item.value.last_used < oldest_usage) {
+      oldest_usage = item.value.last_used;
+      oldest_key = item.key;
+    }
+  }
+  cache.corners_num -= cache.entries.lookup(oldest_key).primitive->mesh->totloop;
+  cache.entries.remove(oldest_key);
+}
+
+static std::shared_ptr<const CachedMeshPrimitive> add_cached_primitive(
+    const MeshPrimitiveCacheKey &key, Mesh *mesh)
+{
+  std::shared_ptr<const CachedMeshPrimitive> primitive = std::make_shared<CachedMeshPrimitive>(
+      mesh);
+  if (mesh->totloop > max_cached_corners) {
+    return primitive;
+  }
+  MeshPrimitiveCache &cache = get_mesh_primitive_cache();
+  std::lock_guard lock{cache.mutex};
+  if (cache.entries.contains(key)) {
+    /* Another thread has created the same mesh in the meantime. */
+    return primitive;
+  }
+  while (!cache.entries.is_empty() &&
+         (cache.entries.size() >= max_cached_meshes ||
+          cache.corners_num + mesh->totloop > max_cached_corners)) {
+    remove_least_recently_used(cache);
+  }
+  cache.corners_num += mesh->totloop;
+  cache.entries.add_new(key, {primitive, cache.usage_counter++});
+  return primitive;
+}
+
+Mesh *mesh_primitive_cache_get(const MeshPrimitiveCacheKey &key,
+                               FunctionRef<Mesh *()> create_fn,
+                               const float4x4 &transform)
+{
+  std::shared_ptr<const CachedMeshPrimitive> primitive = lookup_cached_primitive(key);
+  if (!primitive) {
+    primitive = add_cached_primitive(key, create_fn());
+  }
+
+  /* Share the topology of the cached mesh, only the positions are copied when they are
+   * transformed. Code writing to the other arrays directly has to make them unique first, meshes
+   * passed to the modifier stack do that when they are released from their geometry set. */
+  Mesh *mesh = BKE_mesh_copy_for_eval(primitive->mesh, true);
+  BKE_mesh_vert_coords_apply_with_mat4(
+      mesh, reinterpret_cast<const float(*)[3]>(primitive->positions.data()), transform.values);
+  return mesh;
+}
+
+}  // namespace blender::bke
+
+void BKE_mesh_primitive_cache_free()
+{
+  blender::bke::MeshPrimitiveCache &cache = blender::bke::get_mesh_primitive_cache();
+  std::lock_guard lock{cache.mutex};
+  cache.entries.clear();
+  cache.corners_num = 0;
+}
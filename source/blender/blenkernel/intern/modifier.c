@@ -51,6 +51,7 @@
 #include "BLI_linklist.h"
 #include "BLI_listbase.h"
 #include "BLI_path_util.h"
+#include "BLI_profile.h"
 #include "BLI_session_uuid.h"
 #include "BLI_string.h"
 #include "BLI_string_utils.h"
@@ -1052,7 +1053,10 @@ struct Mesh *BKE_modifier_modify_mesh(ModifierData *md,
   if (mti->dependsOnNormals && mti->dependsOnNormals(md)) {
     modwrap_dependsOnNormals(me);
   }
-  return mti->modifyMesh(md, ctx, me);
+  const double profile_start_time = BLI_profile_event_begin();
+  struct Mesh *result = mti->modifyMesh(md, ctx, me);
+  BLI_profile_event_end(profile_start_time, "modifier", md->name);
+  return result;
 }
 
 void BKE_modifier_deform_verts(ModifierData *md,
@@ -1067,7 +1071,9 @@ void BKE_modifier_deform_verts(ModifierData *md,
   if (me && mti->dependsOnNormals && mti->dependsOnNormals(md)) {
     modwrap_dependsOnNormals(me);
   }
+  const double profile_start_time = BLI_profile_event_begin();
   mti->deformVerts(md, ctx, me, vertexCos, numVerts);
+  BLI_profile_event_end(profile_start_time, "modifier", md->name);
 }
 
 void BKE_modifier_deform_vertsEM(ModifierData *md,
@@ -1083,7 +1089,9 @@ void BKE_modifier_deform_vertsEM(ModifierData *md,
   if (me && mti->dependsOnNormals && mti->dependsOnNormals(md)) {
     BKE_mesh_calc_normals(me);
   }
+  const double profile_start_time = BLI_profile_event_begin();
   mti->deformVertsEM(md, ctx, em, me, vertexCos, numVerts);
+  BLI_profile_event_end(profile_start_time, "modifier", md->name);
 }
 
 /* end modifier callback wrappers */
@@ -126,14 +126,14 @@ static void node_error_message_log(bNodeTree &ntree,
   }
 }
 
-static NodeUIStorage &node_ui_storage_ensure(bNodeTree &ntree,
+/**
+ * The caller must hold the lock on the context map mutex while using the returned storage,
+ * since nodes can be executed on multiple threads and adding to the maps can reallocate them.
+ */
+static NodeUIStorage &node_ui_storage_ensure(NodeTreeUIStorage &ui_storage,
                                              const NodeTreeEvaluationContext &context,
                                              const bNode &node)
 {
-  ui_storage_ensure(ntree);
-  NodeTreeUIStorage &ui_storage = *ntree.ui_storage;
-
-  std::lock_guard<std::mutex> lock(ui_storage.context_map_mutex);
   Map<std::string, NodeUIStorage> &node_tree_ui_storage =
       ui_storage.context_map.lookup_or_add_default(context);
 
@@ -151,7 +151,11 @@ void BKE_nodetree_error_message_add(bNodeTree &ntree,
 {
   node_error_message_log(ntree, node, message, type);
 
-  NodeUIStorage &node_ui_storage = node_ui_storage_ensure(ntree, context, node);
+  ui_storage_ensure(ntree);
+  NodeTreeUIStorage &ui_storage = *ntree.ui_storage;
+
+  std::lock_guard<std::mutex> lock(ui_storage.context_map_mutex);
+  NodeUIStorage &node_ui_storage = node_ui_storage_ensure(ui_storage, context, node);
   node_ui_storage.warnings.append({type, std::move(message)});
 }
 
@@ -162,7 +166,54 @@ void BKE_nodetree_attribute_hint_add(bNodeTree &ntree,
                                      const AttributeDomain domain,
                                      const CustomDataType data_type)
 {
-  NodeUIStorage &node_ui_storage = node_ui_storage_ensure(ntree, context, node);
+  ui_storage_ensure(ntree);
+  NodeTreeUIStorage &ui_storage = *ntree.ui_storage;
+
+  std::lock_guard<std::mutex> lock(ui_storage.context_map_mutex);
+  NodeUIStorage &node_ui_storage = node_ui_storage_ensure(ui_storage, context, node);
   node_ui_storage.attribute_hints.add_as(attribute_name,
                                          AvailableAttributeInfo{domain, data_type});
 }
+
+/**
+ * Get a copy of the UI data added for a node in the current evaluation, so that it can be added
+ * again when the results of the node are reused in later evaluations without executing it.
+ */
+NodeUIStorage BKE_nodetree_ui_storage_copy_for_node(bNodeTree &ntree,
+                                                    const NodeTreeEvaluationContext &context,
+                                                    const bNode &node)
+{
+  NodeTreeUIStorage *ui_storage = ntree.ui_storage;
+  if (ui_storage == nullptr) {
+    return {};
+  }
+
+  std::lock_guard<std::mutex> lock(ui_storage->context_map_mutex);
+  const Map<std::string, NodeUIStorage> *storage = ui_storage->context_map.lookup_ptr(context);
+  if (storage == nullptr) {
+    return {};
+  }
+  const NodeUIStorage *node_ui_storage = storage->lookup_ptr_as(StringRef(node.name));
+  if (node_ui_storage == nullptr) {
+    return {};
+  }
+  return *node_ui_storage;
+}
+
+void BKE_nodetree_ui_storage_add_for_node(bNodeTree &ntree,
+                                          const NodeTreeEvaluationContext &context,
+                                          const bNode &node,
+                                          const NodeUIStorage &storage)
+{
+  ui_storage_ensure(ntree);
+  NodeTreeUIStorage &ui_storage = *ntree.ui_storage;
+
+  std::lock_guard<std::mutex> lock(ui_storage.context_map_mutex);
+  NodeUIStorage &node_ui_storage = node_ui_storage_ensure(ui_storage, context, node);
+  node_ui_storage.warnings.extend(storage.warnings);
+  for (auto item : storage.attribute_hints.items()) {
+    for (const AvailableAttributeInfo &info : item.value) {
+      node_ui_storage.attribute_hints.add(item.key, info);
+    }
+  }
+}
@@ -43,6 +43,8 @@ uint32_t BLI_hash_mm2a_end(BLI_HashMurmur2A *mm2);
 
 uint32_t BLI_hash_mm2(const unsigned char *data, size_t len, uint32_t seed);
 
+uint64_t BLI_hash_mm64a(const unsigned char *data, size_t len, uint64_t seed);
+
 #ifdef __cplusplus
 }
 #endif
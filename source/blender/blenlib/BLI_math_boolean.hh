@@ -49,6 +49,12 @@ int incircle_fast(const double2 &a, const double2 &b, const double2 &c, const do
 int orient3d(const double3 &a, const double3 &b, const double3 &c, const double3 &d);
 int orient3d_fast(const double3 &a, const double3 &b, const double3 &c, const double3 &d);
 
+/* #filter_orient3d is for inputs that are only approximations of exact coordinates
+ * (e.g. the double coordinates of a vertex whose exact coordinates are rational).
+ * It returns the sign #orient3d would give for the exact coordinates when that can be
+ * decided with double arithmetic and a bound on the error, and 0 when it cannot. */
+int filter_orient3d(const double3 &a, const double3 &b, const double3 &c, const double3 &d);
+
 int insphere(
     const double3 &a, const double3 &b, const double3 &c, const double3 &d, const double3 &e);
 int insphere_fast(
@@ -0,0 +1,44 @@
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+#pragma once
+
+/** \file
+ * \ingroup bli
+ *
+ * Poisson disk elimination removes points that are closer to each other than a minimum distance,
+ * turning a random point distribution into one with blue noise characteristics.
+ */
+
+#include "BLI_float3.hh"
+#include "BLI_span.hh"
+
+namespace blender {
+
+/**
+ * Mark points that are within `minimum_distance` of a point that is kept. Points that are
+ * already marked in `elimination_mask` are ignored.
+ *
+ * The points are sorted into a uniform grid with cells as large as the minimum distance. Rows of
+ * cells along the x axis are processed in four passes with alternating y and z coordinates, so
+ * that the rows in one pass can not affect each other and are processed in parallel. Within a row
+ * the points are processed cell by cell, in index order. Therefore the result does not depend on
+ * the number of threads.
+ */
+void poisson_disk_eliminate_close_points(Span<float3> positions,
+                                         float minimum_distance,
+                                         MutableSpan<bool> elimination_mask);
+
+}  // namespace blender
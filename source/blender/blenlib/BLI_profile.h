@@ -0,0 +1,64 @@
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#pragma once
+
+/** \file
+ * \ingroup bli
+ *
+ * Low overhead profiling of scoped events, written as a Chrome trace (JSON) which can be opened
+ * in `chrome://tracing` or https://ui.perfetto.dev to see all recorded events on one timeline.
+ *
+ * Events are recorded in a ring buffer per thread, so recording does not need any locking. When
+ * the buffer of a thread is full its oldest events are overwritten. When profiling is disabled
+ * recording an event costs a single check.
+ *
+ * Use `--profile-trace <filename>` on the command line to record a trace of the whole session.
+ */
+
+#include "BLI_sys_types.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Start recording events, they are written to the given file by #BLI_profile_exit. */
+void BLI_profile_init(const char *filepath);
+/* Write the recorded events when profiling was started and free all the buffers.
+ * No other thread is to record events while this is running. */
+void BLI_profile_exit(void);
+
+bool BLI_profile_is_enabled(void);
+
+/* Start time of an event, zero when profiling is disabled. */
+double BLI_profile_event_begin(void);
+/* Record an event started by #BLI_profile_event_begin which ends now.
+ * The category is expected to be a static string, the name is copied. */
+void BLI_profile_event_end(double start_time, const char *category, const char *name);
+/* Record an event with the times from #PIL_check_seconds_timer, for code which is timing
+ * itself already. */
+void BLI_profile_event_add(double start_time,
+                           double end_time,
+                           const char *category,
+                           const char *name);
+
+/* Write all recorded events, returns false when the file could not be written.
+ * No other thread is to record events while this is running. */
+bool BLI_profile_write(const char *filepath);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,90 @@
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#pragma once
+
+/** \file
+ * \ingroup bli
+ */
+
+#include <cstdio>
+
+#include "BLI_profile.h"
+#include "BLI_string_ref.hh"
+#include "BLI_utility_mixins.hh"
+
+namespace blender::profile {
+
+/* Records an event for the lifetime of the object. */
+class ScopedEvent : NonCopyable, NonMovable {
+ private:
+  const char *category_;
+  const char *name_;
+  double start_time_;
+
+ public:
+  ScopedEvent(const char *category, const char *name)
+      : category_(category), name_(name), start_time_(BLI_profile_event_begin())
+  {
+  }
+
+  ~ScopedEvent()
+  {
+    if (start_time_ != 0.0) {
+      BLI_profile_event_end(start_time_, category_, name_);
+    }
+  }
+};
+
+/**
+ * Writes events in the Chrome trace event format, for the recorded profile and for other
+ * exports of timings. The trace is finished when the writer is destructed.
+ *
+ * Times are in seconds, they are written in microseconds as the format expects.
+ */
+class TraceWriter : NonCopyable, NonMovable {
+ private:
+  FILE *file_;
+  bool is_first_event_ = true;
+  bool event_has_args_ = false;
+
+ public:
+  TraceWriter(FILE *file);
+  ~TraceWriter();
+
+  void process_name(StringRef name);
+  void thread_name(int thread, StringRef name);
+
+  /* Arguments can be added between the begin and end of an event. */
+  void event_begin(StringRef name,
+                   StringRef category,
+                   int thread,
+                   double start_time,
+                   double duration);
+  void event_arg(StringRef key, StringRef value);
+  void event_arg(StringRef key, double value);
+  void event_end();
+
+ private:
+  void event_separator();
+  void arg_separator();
+  void write_escaped(StringRef str);
+};
+
+}  // namespace blender::profile
+
+#define BLI_PROFILE_SCOPE(category, name) \
+  blender::profile::ScopedEvent profile_scoped_event(category, name)
@@ -1076,6 +1076,15 @@ float BLI_bvhtree_get_epsilon(const BVHTree *tree)
   return tree->epsilon;
 }
 
+/**
+ * Number of bytes allocated for the tree, which is reserved for the maximum number of elements.
+ */
+size_t BLI_bvhtree_get_memory_size(const BVHTree *tree)
+{
+  return sizeof(BVHTree) + MEM_allocN_len(tree->nodes) + MEM_allocN_len(tree->nodearray) +
+         MEM_allocN_len(tree->nodechild) + MEM_allocN_len(tree->nodebv);
+}
+
 /**
  * This function returns the bounding box of the BVH tree.
  */
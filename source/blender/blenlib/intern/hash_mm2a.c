@@ -21,6 +21,7 @@
  *  Functions to compute Murmur2A hash key.
  *
  * A very fast hash generating int32 result, with few collisions and good repartition.
+ * MurmurHash64A generates int64 result, faster on large data as it mixes 8 bytes at a time.
  *
  * See also:
  * reference implementation:
@@ -31,6 +32,8 @@
  * so you should only use it for temporary data.
  */
 
+#include <string.h>
+
 #include "BLI_compiler_attrs.h"
 
 #include "BLI_hash_mm2a.h" /* own include */
@@ -55,6 +58,19 @@
   } \
   (void)0
 
+#define MM64A_M 0xc6a4a7935bd1e995ull
+#define MM64A_R 47
+
+#define MM64A_MIX(h, k) \
+  { \
+    (k) *= MM64A_M; \
+    (k) ^= (k) >> MM64A_R; \
+    (k) *= MM64A_M; \
+    (h) ^= (k); \
+    (h) *= MM64A_M; \
+  } \
+  (void)0
+
 static void mm2a_mix_tail(BLI_HashMurmur2A *mm2, const unsigned char **data, size_t *len)
 {
   while (*len && ((*len < 4) || mm2->count)) {
@@ -141,3 +157,47 @@ uint32_t BLI_hash_mm2(const unsigned char *data, size_t len, uint32_t seed)
 
   return h;
 }
+
+/* Non-incremental 64 bits version, chain calls by passing the previous hash as seed. */
+uint64_t BLI_hash_mm64a(const unsigned char *data, size_t len, uint64_t seed)
+{
+  uint64_t h = seed ^ (len * MM64A_M);
+
+  /* Mix 8 bytes at a time into the hash, data may not be aligned. */
+  for (; len >= 8; data += 8, len -= 8) {
+    uint64_t k;
+    memcpy(&k, data, sizeof(k));
+
+    MM64A_MIX(h, k);
+  }
+
+  switch (len) {
+    case 7:
+      h ^= (uint64_t)data[6] << 48;
+      ATTR_FALLTHROUGH;
+    case 6:
+      h ^= (uint64_t)data[5] << 40;
+      ATTR_FALLTHROUGH;
+    case 5:
+      h ^= (uint64_t)data[4] << 32;
+      ATTR_FALLTHROUGH;
+    case 4:
+      h ^= (uint64_t)data[3] << 24;
+      ATTR_FALLTHROUGH;
+    case 3:
+      h ^= (uint64_t)data[2] << 16;
+      ATTR_FALLTHROUGH;
+    case 2:
+      h ^= (uint64_t)data[1] << 8;
+      ATTR_FALLTHROUGH;
+    case 1:
+      h ^= (uint64_t)data[0];
+      h *= MM64A_M;
+  }
+
+  h ^= h >> MM64A_R;
+  h *= MM64A_M;
+  h ^= h >> MM64A_R;
+
+  return h;
+}
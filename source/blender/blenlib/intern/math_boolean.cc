@@ -2518,6 +2518,38 @@ int orient3d_fast(const double3 &a, const double3 &b, const double3 &c, const do
   return sgn(robust_pred::orient3dfast(a, b, c, d));
 }
 
+/**
+ * Uses the supremum and index error bounds of Burnikel, Funke and Seel
+ * ("Exact Geometric Computation Using Cascading"), treating every input coordinate
+ * as inexact (index 1). The determinant expression then has index 11.
+ */
+int filter_orient3d(const double3 &a, const double3 &b, const double3 &c, const double3 &d)
+{
+  constexpr int index_orient3d = 11;
+  double3 abs_d = double3::abs(d);
+  double3 ad = a - d;
+  double3 bd = b - d;
+  double3 cd = c - d;
+  double3 abs_ad = double3::abs(a) + abs_d;
+  double3 abs_bd = double3::abs(b) + abs_d;
+  double3 abs_cd = double3::abs(c) + abs_d;
+
+  double det = ad[2] * (bd[0] * cd[1] - cd[0] * bd[1]) +
+               bd[2] * (cd[0] * ad[1] - ad[0] * cd[1]) +
+               cd[2] * (ad[0] * bd[1] - bd[0] * ad[1]);
+  if (det == 0.0) {
+    return 0;
+  }
+  double supremum = abs_ad[2] * (abs_bd[0] * abs_cd[1] + abs_cd[0] * abs_bd[1]) +
+                    abs_bd[2] * (abs_cd[0] * abs_ad[1] + abs_ad[0] * abs_cd[1]) +
+                    abs_cd[2] * (abs_ad[0] * abs_bd[1] + abs_bd[0] * abs_ad[1]);
+  double err_bound = supremum * index_orient3d * DBL_EPSILON;
+  if (fabs(det) > err_bound) {
+    return det > 0 ? 1 : -1;
+  }
+  return 0;
+}
+
 int insphere(
     const double3 &a, const double3 &b, const double3 &c, const double3 &d, const double3 &e)
 {
@@ -0,0 +1,259 @@
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+/** \file
+ * \ingroup bli
+ */
+
+#include <algorithm>
+#include <atomic>
+
+#include "BLI_array.hh"
+#include "BLI_map.hh"
+#include "BLI_poisson_disk.hh"
+#include "BLI_task.hh"
+#include "BLI_vector.hh"
+
+namespace blender {
+
+namespace {
+
+struct GridCell {
+  int x, y, z;
+};
+
+/**
+ * All cells with the same y and z coordinate. Rows are the unit of work, because the points in a
+ * row can be sorted along x once, after which finding the neighbors of a cell only requires
+ * advancing a cursor in each of the neighboring rows instead of looking up every cell.
+ */
+struct GridRow {
+  int y, z;
+
+  uint64_t hash() const
+  {
+    return (uint64_t)y * 19349663 + (uint64_t)z * 83492791;
+  }
+
+  /* Rows with the same color are at least one row apart on one axis. */
+  int color() const
+  {
+    return (y & 1) | ((z & 1) << 1);
+  }
+
+  friend bool operator==(const GridRow &a, const GridRow &b)
+  {
+    return a.y == b.y && a.z == b.z;
+  }
+};
+
+struct PointGrid {
+  Array<GridCell> point_cells;
+  Map<GridRow, int> row_indices;
+  Vector<GridRow> rows;
+  Array<int> row_offsets;
+  /* The points of every row, sorted by their cell's x coordinate and then by index. */
+  Array<int> row_points;
+
+  Span<int> points_in_row(const int row_index) const
+  {
+    const int start = row_offsets[row_index];
+    return row_points.as_span().slice(start, row_offsets[row_index + 1] - start);
+  }
+};
+
+}  // namespace
+
+/* Limit the coordinates, so that far away points do not overflow. Clamping only merges cells at
+ * the border of the grid, which does not break the neighborhood of close points. Eliminated
+ * points are not part of the minimum and can be below it, their cells are clamped to zero. */
+static constexpr float max_grid_coordinate = (float)(1 << 30);
+
+static int grid_coordinate(const float value, const float min, const float cell_size)
+{
+  /* Zero as first argument also maps NaN to zero. */
+  const float coordinate = std::max(0.0f, (value - min) / cell_size);
+  return (int)std::min(coordinate, max_grid_coordinate);
+}
+
+static void build_point_grid(Span<float3> positions,
+                             const float cell_size,
+                             Span<bool> elimination_mask,
+                             PointGrid &grid)
+{
+  float3 min(FLT_MAX);
+  for (const int i : positions.index_range()) {
+    if (!elimination_mask[i]) {
+      min = float3(std::min(min.x, positions[i].x),
+                   std::min(min.y, positions[i].y),
+                   std::min(min.z, positions[i].z));
+    }
+  }
+
+  grid.point_cells.reinitialize(positions.size());
+  parallel_for(positions.index_range(), 4096, [&](IndexRange range) {
+    for (const int i : range) {
+      const float3 &position = positions[i];
+      grid.point_cells[i] = {grid_coordinate(position.x, min.x, cell_size),
+                             grid_coordinate(position.y, min.y, cell_size),
+                             grid_coordinate(position.z, min.z, cell_size)};
+    }
+  });
+
+  /* Counting sort of the points by row, which keeps the points in a row in index order. */
+  Vector<int> row_sizes;
+  Array<int> point_row_indices(positions.size());
+  for (const int i : positions.index_range()) {
+    if (elimination_mask[i]) {
+      continue;
+    }
+    const GridRow row = {grid.point_cells[i].y, grid.point_cells[i].z};
+    const int row_index = grid.row_indices.lookup_or_add_cb(row, [&]() {
+      grid.rows.append(row);
+      row_sizes.append(0);
+      return (int)row_sizes.size() - 1;
+    });
+    row_sizes[row_index]++;
+    point_row_indices[i] = row_index;
+  }
+
+  grid.row_offsets.reinitialize(row_sizes.size() + 1);
+  int offset = 0;
+  for (const int row_index : row_sizes.index_range()) {
+    grid.row_offsets[row_index] = offset;
+    offset += row_sizes[row_index];
+  }
+  grid.row_offsets.last() = offset;
+
+  grid.row_points.reinitialize(offset);
+  row_sizes.fill(0);
+  for (const int i : positions.index_range()) {
+    if (elimination_mask[i]) {
+      continue;
+    }
+    const int row_index = point_row_indices[i];
+    grid.row_points[grid.row_offsets[row_index] + row_sizes[row_index]] = i;
+    row_sizes[row_index]++;
+  }
+
+  /* A stable sort keeps the points within a cell in index order. */
+  parallel_for(grid.rows.index_range(), 256, [&](IndexRange range) {
+    for (const int row_index : range) {
+      const int start = grid.row_offsets[row_index];
+      MutableSpan<int> points = grid.row_points.as_mutable_span().slice(
+          start, grid.row_offsets[row_index + 1] - start);
+      std::stable_sort(points.begin(), points.end(), [&](const int a, const int b) {
+        return grid.point_cells[a].x < grid.point_cells[b].x;
+      });
+    }
+  });
+}
+
+static void eliminate_points_in_row(Span<float3> positions,
+                                    const float minimum_distance_squared,
+                                    const PointGrid &grid,
+                                    const int row_index,
+                                    MutableSpan<std::atomic<bool>> eliminated)
+{
+  const GridRow &row = grid.rows[row_index];
+
+  struct NeighborRow {
+    Span<int> points;
+    /* The points in the cells next to the current cell. */
+    int64_t begin = 0;
+    int64_t end = 0;
+  };
+
+  Vector<NeighborRow, 9> neighbor_rows;
+  for (int z = row.z - 1; z <= row.z + 1; z++) {
+    for (int y = row.y - 1; y <= row.y + 1; y++) {
+      const int neighbor_index = grid.row_indices.lookup_default({y, z}, -1);
+      if (neighbor_index != -1) {
+        neighbor_rows.append({grid.points_in_row(neighbor_index)});
+      }
+    }
+  }
+
+  for (const int point : grid.points_in_row(row_index)) {
+    if (eliminated[point].load(std::memory_order_relaxed)) {
+      continue;
+    }
+    const int x = grid.point_cells[point].x;
+    const float3 &position = positions[point];
+    for (NeighborRow &neighbor_row : neighbor_rows) {
+      Span<int> points = neighbor_row.points;
+      while (neighbor_row.begin < points.size() &&
+             grid.point_cells[points[neighbor_row.begin]].x < x - 1) {
+        neighbor_row.begin++;
+      }
+      neighbor_row.end = std::max(neighbor_row.end, neighbor_row.begin);
+      while (neighbor_row.end < points.size() &&
+             grid.point_cells[points[neighbor_row.end]].x <= x + 1) {
+        neighbor_row.end++;
+      }
+      for (const int other_point : points.slice(neighbor_row.begin,
+                                                neighbor_row.end - neighbor_row.begin)) {
+        if (other_point == point) {
+          continue;
+        }
+        if (float3::distance_squared(position, positions[other_point]) <=
+            minimum_distance_squared) {
+          eliminated[other_point].store(true, std::memory_order_relaxed);
+        }
+      }
+    }
+  }
+}
+
+void poisson_disk_eliminate_close_points(Span<float3> positions,
+                                         const float minimum_distance,
+                                         MutableSpan<bool> elimination_mask)
+{
+  BLI_assert(positions.size() == elimination_mask.size());
+  if (minimum_distance <= 0.0f || positions.is_empty()) {
+    return;
+  }
+
+  PointGrid grid;
+  build_point_grid(positions, minimum_distance, elimination_mask, grid);
+
+  Array<Vector<int>> rows_by_color(4);
+  for (const int row_index : grid.rows.index_range()) {
+    rows_by_color[grid.rows[row_index].color()].append(row_index);
+  }
+
+  /* Points in neighboring rows can be eliminated by different threads at the same time, so the
+   * mask has to be atomic. Since points are only ever marked, the order of the writes does not
+   * matter. */
+  Array<std::atomic<bool>> eliminated(positions.size());
+  for (const int i : positions.index_range()) {
+    eliminated[i].store(elimination_mask[i], std::memory_order_relaxed);
+  }
+
+  const float minimum_distance_squared = minimum_distance * minimum_distance;
+  for (Span<int> rows : rows_by_color) {
+    parallel_for(rows.index_range(), 8, [&](IndexRange range) {
+      for (const int i : range) {
+        eliminate_points_in_row(positions, minimum_distance_squared, grid, rows[i], eliminated);
+      }
+    });
+  }
+
+  for (const int i : positions.index_range()) {
+    elimination_mask[i] = eliminated[i].load(std::memory_order_relaxed);
+  }
+}
+
+}  // namespace blender
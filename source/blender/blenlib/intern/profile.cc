@@ -0,0 +1,307 @@
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+/** \file
+ * \ingroup bli
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <mutex>
+#include <string>
+
+#include "MEM_guardedalloc.h"
+
+#include "BLI_fileops.h"
+#include "BLI_profile.hh"
+#include "BLI_string.h"
+#include "BLI_threads.h"
+#include "BLI_utildefines.h"
+#include "BLI_vector.hh"
+
+#include "PIL_time.h"
+
+namespace blender::profile {
+
+/* Number of events kept per thread, older events are overwritten. */
+static constexpr int64_t THREAD_EVENTS_NUM = 1 << 16;
+
+struct ProfileEvent {
+  double start_time;
+  double end_time;
+  const char *category;
+  char name[64];
+};
+
+struct ThreadBuffer {
+  int thread_index;
+  bool is_main_thread;
+  /* Total number of recorded events, including the overwritten ones. */
+  int64_t events_num = 0;
+  ProfileEvent *events;
+
+  ThreadBuffer(const int thread_index)
+      : thread_index(thread_index), is_main_thread(BLI_thread_is_main())
+  {
+    events = (ProfileEvent *)MEM_mallocN(sizeof(ProfileEvent) * THREAD_EVENTS_NUM, __func__);
+  }
+
+  ~ThreadBuffer()
+  {
+    MEM_freeN(events);
+  }
+
+  MEM_CXX_CLASS_ALLOC_FUNCS("profile:ThreadBuffer")
+};
+
+static std::atomic<bool> profile_enabled = false;
+static std::mutex profile_mutex;
+static std::string profile_filepath;
+static double profile_start_time = 0.0;
+static Vector<ThreadBuffer *> thread_buffers;
+/* Changed on every (re)initialization, so threads know their buffer is gone. */
+static int profile_session = 0;
+
+static thread_local ThreadBuffer *thread_buffer = nullptr;
+static thread_local int thread_buffer_session = -1;
+
+static ThreadBuffer &thread_buffer_ensure()
+{
+  if (thread_buffer == nullptr || thread_buffer_session != profile_session) {
+    std::lock_guard lock{profile_mutex};
+    thread_buffer = new ThreadBuffer(thread_buffers.size());
+    thread_buffer_session = profile_session;
+    thread_buffers.append(thread_buffer);
+  }
+  return *thread_buffer;
+}
+
+TraceWriter::TraceWriter(FILE *file) : file_(file)
+{
+  fprintf(file_, "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [");
+}
+
+TraceWriter::~TraceWriter()
+{
+  fprintf(file_, "\n]}\n");
+}
+
+void TraceWriter::process_name(StringRef name)
+{
+  this->event_separator();
+  fprintf(file_,
+          "{\"name\": \"process_name\", \"ph\": \"M\", \"pid\": 0, "
+          "\"args\": {\"name\": \"");
+  this->write_escaped(name);
+  fprintf(file_, "\"}}");
+}
+
+void TraceWriter::thread_name(const int thread, StringRef name)
+{
+  this->event_separator();
+  fprintf(file_,
+          "{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 0, \"tid\": %d, "
+          "\"args\": {\"name\": \"",
+          thread);
+  this->write_escaped(name);
+  fprintf(file_, "\"}}");
+}
+
+void TraceWriter::event_begin(StringRef name,
+                              StringRef category,
+                              const int thread,
+                              const double start_time,
+                              const double duration)
+{
+  this->event_separator();
+  fprintf(file_, "{\"name\": \"");
+  this->write_escaped(name);
+  fprintf(file_, "\", \"cat\": \"");
+  this->write_escaped(category);
+  fprintf(file_,
+          "\", \"ph\": \"X\", \"pid\": 0, \"tid\": %d, \"ts\": %.3f, \"dur\": %.3f",
+          thread,
+          start_time * 1e6,
+          duration * 1e6);
+  event_has_args_ = false;
+}
+
+void TraceWriter::event_arg(StringRef key, StringRef value)
+{
+  this->arg_separator();
+  fputc('"', file_);
+  this->write_escaped(key);
+  fprintf(file_, "\": \"");
+  this->write_escaped(value);
+  fputc('"', file_);
+}
+
+void TraceWriter::event_arg(StringRef key, const double value)
+{
+  this->arg_separator();
+  fputc('"', file_);
+  this->write_escaped(key);
+  fprintf(file_, "\": %.3f", value);
+}
+
+void TraceWriter::event_end()
+{
+  fprintf(file_, event_has_args_ ? "}}" : "}");
+}
+
+void TraceWriter::event_separator()
+{
+  fprintf(file_, is_first_event_ ? "\n" : ",\n");
+  is_first_event_ = false;
+}
+
+void TraceWriter::arg_separator()
+{
+  fprintf(file_, event_has_args_ ? ", " : ", \"args\": {");
+  event_has_args_ = true;
+}
+
+void TraceWriter::write_escaped(StringRef str)
+{
+  for (const char c : str) {
+    if (ELEM(c, '"', '\\')) {
+      fputc('\\', file_);
+      fputc(c, file_);
+    }
+    else if ((unsigned char)c < 0x20) {
+      fprintf(file_, "\\u%04x", (unsigned char)c);
+    }
+    else {
+      fputc(c, file_);
+    }
+  }
+}
+
+static void write_trace(FILE *file)
+{
+  TraceWriter writer{file};
+  writer.process_name("Blender");
+  for (const ThreadBuffer *buffer : thread_buffers) {
+    if (buffer->is_main_thread) {
+      writer.thread_name(buffer->thread_index, "Main");
+    }
+    else {
+      writer.thread_name(buffer->thread_index, "Worker " + std::to_string(buffer->thread_index));
+    }
+
+    const int64_t first_event = std::max<int64_t>(0, buffer->events_num - THREAD_EVENTS_NUM);
+    for (int64_t i = first_event; i < buffer->events_num; i++) {
+      const ProfileEvent &event = buffer->events[i % THREAD_EVENTS_NUM];
+      writer.event_begin(event.name,
+                         event.category,
+                         buffer->thread_index,
+                         event.start_time - profile_start_time,
+                         event.end_time - event.start_time);
+      writer.event_end();
+    }
+  }
+}
+
+}  // namespace blender::profile
+
+using namespace blender::profile;
+
+void BLI_profile_init(const char *filepath)
+{
+  std::lock_guard lock{profile_mutex};
+  profile_filepath = filepath;
+  profile_start_time = PIL_check_seconds_timer();
+  profile_session++;
+  profile_enabled = true;
+}
+
+void BLI_profile_exit(void)
+{
+  if (!profile_enabled) {
+    return;
+  }
+  if (!profile_filepath.empty()) {
+    if (BLI_profile_write(profile_filepath.c_str())) {
+      printf("Profile trace written to '%s'\n", profile_filepath.c_str());
+    }
+    else {
+      printf("Unable to write profile trace to '%s'\n", profile_filepath.c_str());
+    }
+  }
+
+  std::lock_guard lock{profile_mutex};
+  profile_enabled = false;
+  profile_session++;
+  for (ThreadBuffer *buffer : thread_buffers) {
+    delete buffer;
+  }
+  thread_buffers.clear_and_make_inline();
+  profile_filepath.clear();
+}
+
+bool BLI_profile_is_enabled(void)
+{
+  return profile_enabled.load(std::memory_order_relaxed);
+}
+
+double BLI_profile_event_begin(void)
+{
+  if (!BLI_profile_is_enabled()) {
+    return 0.0;
+  }
+  return PIL_check_seconds_timer();
+}
+
+void BLI_profile_event_end(const double start_time, const char *category, const char *name)
+{
+  if (start_time == 0.0) {
+    return;
+  }
+  BLI_profile_event_add(start_time, PIL_check_seconds_timer(), category, name);
+}
+
+void BLI_profile_event_add(const double start_time,
+                           const double end_time,
+                           const char *category,
+                           const char *name)
+{
+  if (!BLI_profile_is_enabled()) {
+    return;
+  }
+  ThreadBuffer &buffer = thread_buffer_ensure();
+  ProfileEvent &event = buffer.events[buffer.events_num % THREAD_EVENTS_NUM];
+  event.start_time = start_time;
+  event.end_time = end_time;
+  event.category = category;
+  BLI_strncpy(event.name, name, sizeof(event.name));
+  buffer.events_num++;
+}
+
+bool BLI_profile_write(const char *filepath)
+{
+  FILE *file = BLI_fopen(filepath, "w");
+  if (file == nullptr) {
+    return false;
+  }
+  {
+    std::lock_guard lock{profile_mutex};
+    write_trace(file);
+  }
+  const bool success = ferror(file) == 0;
+  fclose(file);
+  return success;
+}
@@ -72,3 +72,22 @@ TEST(hash_mm2a, MM2AIntegers)
 #endif
   EXPECT_EQ(BLI_hash_mm2a_end(&mm2), hash);
 }
+
+/* Reference results are taken from reference implementation
+ * (cpp code, MurmurHash64A variant). */
+TEST(hash_mm2a, MM64ABasic)
+{
+  const char *data = "Blender";
+  const char *data_long = "Blender Foundation";
+
+  /* Shorter than 8 bytes, only the tail is mixed. */
+  EXPECT_EQ(BLI_hash_mm64a((const unsigned char *)data, strlen(data), 0), 9643588805810197421ull);
+  EXPECT_EQ(BLI_hash_mm64a((const unsigned char *)data, strlen(data), 42), 8138913553056819997ull);
+#ifdef __LITTLE_ENDIAN__
+  EXPECT_EQ(BLI_hash_mm64a((const unsigned char *)data_long, strlen(data_long), 0),
+            16311822771394860664ull);
+#else
+  EXPECT_EQ(BLI_hash_mm64a((const unsigned char *)data_long, strlen(data_long), 0),
+            4817684787657581093ull);
+#endif
+}
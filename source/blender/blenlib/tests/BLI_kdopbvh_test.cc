@@ -47,6 +47,19 @@ TEST(kdopbvh, Single)
   BLI_bvhtree_free(tree);
 }
 
+TEST(kdopbvh, MemorySize)
+{
+  BVHTree *small_tree = BLI_bvhtree_new(10, 0.0, 2, 6);
+  BVHTree *large_tree = BLI_bvhtree_new(1000, 0.0, 2, 6);
+
+  /* The memory is reserved for the maximum number of elements when the tree is created. */
+  EXPECT_GT(BLI_bvhtree_get_memory_size(small_tree), 10 * sizeof(float[6]));
+  EXPECT_GT(BLI_bvhtree_get_memory_size(large_tree), 1000 * sizeof(float[6]));
+
+  BLI_bvhtree_free(small_tree);
+  BLI_bvhtree_free(large_tree);
+}
+
 static void optimal_check_callback(void *userdata,
                                    int index,
                                    const float co[3],
@@ -0,0 +1,107 @@
+/* Apache License, Version 2.0 */
+
+#include "testing/testing.h"
+
+#include "BLI_array.hh"
+#include "BLI_poisson_disk.hh"
+#include "BLI_rand.hh"
+
+namespace blender::tests {
+
+static Array<float3> random_positions(const int amount, const uint32_t seed)
+{
+  RandomNumberGenerator rng(seed);
+  Array<float3> positions(amount);
+  for (float3 &position : positions) {
+    position = float3(rng.get_float(), rng.get_float(), rng.get_float() * 0.1f);
+  }
+  return positions;
+}
+
+TEST(poisson_disk, KeptPointsAreFarApart)
+{
+  const float minimum_distance = 0.05f;
+  Array<float3> positions = random_positions(2000, 0);
+  Array<bool> elimination_mask(positions.size(), false);
+  poisson_disk_eliminate_close_points(positions, minimum_distance, elimination_mask);
+
+  int kept_amount = 0;
+  for (const int i : positions.index_range()) {
+    if (elimination_mask[i]) {
+      /* Every eliminated point has to be close to a kept point. */
+      bool has_close_kept_point = false;
+      for (const int j : positions.index_range()) {
+        if (!elimination_mask[j] &&
+            float3::distance(positions[i], positions[j]) <= minimum_distance) {
+          has_close_kept_point = true;
+          break;
+        }
+      }
+      EXPECT_TRUE(has_close_kept_point);
+      continue;
+    }
+    kept_amount++;
+    for (const int j : positions.index_range()) {
+      if (i != j && !elimination_mask[j]) {
+        EXPECT_GT(float3::distance(positions[i], positions[j]), minimum_distance);
+      }
+    }
+  }
+  EXPECT_GT(kept_amount, 0);
+  EXPECT_LT(kept_amount, positions.size());
+}
+
+TEST(poisson_disk, Deterministic)
+{
+  Array<float3> positions = random_positions(10000, 1);
+  Array<bool> mask_a(positions.size(), false);
+  Array<bool> mask_b(positions.size(), false);
+  poisson_disk_eliminate_close_points(positions, 0.02f, mask_a);
+  poisson_disk_eliminate_close_points(positions, 0.02f, mask_b);
+  for (const int i : positions.index_range()) {
+    EXPECT_EQ(mask_a[i], mask_b[i]);
+  }
+}
+
+TEST(poisson_disk, IgnoreEliminatedPoints)
+{
+  Array<float3> positions = {float3(0.0f), float3(0.5f, 0.0f, 0.0f), float3(1.0f, 0.0f, 0.0f)};
+
+  Array<bool> elimination_mask = {false, false, false};
+  poisson_disk_eliminate_close_points(positions, 0.6f, elimination_mask);
+  EXPECT_FALSE(elimination_mask[0]);
+  EXPECT_TRUE(elimination_mask[1]);
+  EXPECT_FALSE(elimination_mask[2]);
+
+  elimination_mask = {true, false, false};
+  poisson_disk_eliminate_close_points(positions, 0.6f, elimination_mask);
+  EXPECT_TRUE(elimination_mask[0]);
+  EXPECT_FALSE(elimination_mask[1]);
+  EXPECT_TRUE(elimination_mask[2]);
+
+  elimination_mask = {false, false, false};
+  poisson_disk_eliminate_close_points(positions, 0.0f, elimination_mask);
+  EXPECT_FALSE(elimination_mask[0]);
+  EXPECT_FALSE(elimination_mask[1]);
+  EXPECT_FALSE(elimination_mask[2]);
+}
+
+TEST(poisson_disk, EliminatedPointsBelowMinimum)
+{
+  /* Eliminated points are not part of the grid bounds, far away ones must not overflow. */
+  Array<float3> positions = {float3(-1e30f),
+                             float3(0.0f),
+                             float3(0.5f, 0.0f, 0.0f),
+                             float3(1.0f, 0.0f, 0.0f),
+                             float3(-1.0f, -1.0f, -1.0f)};
+
+  Array<bool> elimination_mask = {true, false, false, false, true};
+  poisson_disk_eliminate_close_points(positions, 0.6f, elimination_mask);
+  EXPECT_TRUE(elimination_mask[0]);
+  EXPECT_FALSE(elimination_mask[1]);
+  EXPECT_TRUE(elimination_mask[2]);
+  EXPECT_FALSE(elimination_mask[3]);
+  EXPECT_TRUE(elimination_mask[4]);
+}
+
+}  // namespace blender::tests
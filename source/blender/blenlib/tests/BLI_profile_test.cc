@@ -0,0 +1,96 @@
+/* Apache License, Version 2.0 */
+
+#include "testing/testing.h"
+
+#include <fstream>
+#include <sstream>
+
+#include "BLI_fileops.h"
+#include "BLI_profile.hh"
+#include "BLI_task.h"
+
+namespace blender::profile::tests {
+
+static std::string read_file(const std::string &filepath)
+{
+  std::ifstream stream(filepath);
+  std::stringstream buffer;
+  buffer << stream.rdbuf();
+  return buffer.str();
+}
+
+TEST(profile, Disabled)
+{
+  EXPECT_FALSE(BLI_profile_is_enabled());
+  EXPECT_EQ(BLI_profile_event_begin(), 0.0);
+  /* Must not crash or allocate anything. */
+  BLI_profile_event_end(0.0, "test", "Nothing");
+  BLI_profile_event_add(1.0, 2.0, "test", "Nothing");
+}
+
+static void profile_parallel_fn(void *__restrict UNUSED(userdata),
+                                const int UNUSED(index),
+                                const TaskParallelTLS *__restrict UNUSED(tls))
+{
+  BLI_PROFILE_SCOPE("test", "Parallel \"Event\"");
+}
+
+TEST(profile, WriteTrace)
+{
+  const std::string filepath = ::testing::TempDir() + "BLI_profile_test.json";
+  BLI_profile_init(filepath.c_str());
+  EXPECT_TRUE(BLI_profile_is_enabled());
+  {
+    BLI_PROFILE_SCOPE("test", "Main Event");
+  }
+  BLI_profile_event_add(BLI_profile_event_begin(), BLI_profile_event_begin(), "test", "Added");
+
+  TaskParallelSettings settings;
+  BLI_parallel_range_settings_defaults(&settings);
+  settings.min_iter_per_thread = 1;
+  BLI_task_parallel_range(0, 100, nullptr, profile_parallel_fn, &settings);
+
+  BLI_profile_exit();
+  EXPECT_FALSE(BLI_profile_is_enabled());
+
+  const std::string trace = read_file(filepath);
+  EXPECT_EQ(trace.rfind("{\"displayTimeUnit\"", 0), 0);
+  EXPECT_NE(trace.find("\"name\": \"Main Event\", \"cat\": \"test\", \"ph\": \"X\""),
+            std::string::npos);
+  EXPECT_NE(trace.find("\"name\": \"Added\""), std::string::npos);
+  /* Quotes are escaped. */
+  EXPECT_NE(trace.find("\"name\": \"Parallel \\\"Event\\\"\""), std::string::npos);
+  EXPECT_EQ(trace.substr(trace.size() - 4), "\n]}\n");
+
+  BLI_delete(filepath.c_str(), false, false);
+}
+
+TEST(profile, TraceWriterArgs)
+{
+  const std::string filepath = ::testing::TempDir() + "BLI_profile_writer_test.json";
+  FILE *file = BLI_fopen(filepath.c_str(), "w");
+  ASSERT_NE(file, nullptr);
+  {
+    TraceWriter writer{file};
+    writer.event_begin("Line\nBreak", "test", 1, 0.5, 0.25);
+    writer.event_end();
+    writer.event_begin("Args", "test", 2, 1.0, 0.0);
+    writer.event_arg("id", "OB\"Cube\"");
+    writer.event_arg("value", 2.0);
+    writer.event_end();
+  }
+  fclose(file);
+
+  const std::string trace = read_file(filepath);
+  EXPECT_EQ(trace.rfind("{\"displayTimeUnit\"", 0), 0);
+  /* Control characters are escaped, times are in microseconds. */
+  EXPECT_NE(trace.find("\"name\": \"Line\\u000aBreak\""), std::string::npos);
+  EXPECT_NE(trace.find("\"ts\": 500000.000, \"dur\": 250000.000}"), std::string::npos);
+  EXPECT_NE(trace.find("\"args\": {\"id\": \"OB\\\"Cube\\\"\", \"value\": 2.000}}"),
+            std::string::npos);
+  EXPECT_EQ(trace.substr(trace.size() - 4), "\n]}\n");
+
+  BLI_delete(filepath.c_str(), false, false);
+}
+
+}  // namespace blender::profile::tests
@@ -0,0 +1,97 @@
+/* Apache License, Version 2.0 */
+
+#include "testing/testing.h"
+
+#include "BLI_array.hh"
+#include "BLI_kdtree.h"
+#include "BLI_poisson_disk.hh"
+#include "BLI_rand.hh"
+#include "BLI_timeit.hh"
+
+namespace blender::tests {
+
+/* Points scattered on a wavy terrain, similar to what the Point Distribute node generates. */
+static Array<float3> terrain_positions(const int amount)
+{
+  RandomNumberGenerator rng(0);
+  Array<float3> positions(amount);
+  for (float3 &position : positions) {
+    const float x = rng.get_float() * 100.0f;
+    const float y = rng.get_float() * 100.0f;
+    position = float3(x, y, sinf(x * 0.3f) * cosf(y * 0.2f) * 4.0f);
+  }
+  return positions;
+}
+
+/* The single threaded elimination the Point Distribute node used before, for comparison. */
+static void eliminate_close_points_kdtree(Span<float3> positions,
+                                          const float minimum_distance,
+                                          MutableSpan<bool> elimination_mask)
+{
+  KDTree_3d *kdtree = BLI_kdtree_3d_new(positions.size());
+  for (const int i : positions.index_range()) {
+    BLI_kdtree_3d_insert(kdtree, i, positions[i]);
+  }
+  BLI_kdtree_3d_balance(kdtree);
+
+  for (const int i : positions.index_range()) {
+    if (elimination_mask[i]) {
+      continue;
+    }
+    struct CallbackData {
+      int index;
+      MutableSpan<bool> elimination_mask;
+    } callback_data = {i, elimination_mask};
+
+    BLI_kdtree_3d_range_search_cb(
+        kdtree,
+        positions[i],
+        minimum_distance,
+        [](void *user_data, int index, const float *UNUSED(co), float UNUSED(dist_sq)) {
+          CallbackData &callback_data = *static_cast<CallbackData *>(user_data);
+          if (index != callback_data.index) {
+            callback_data.elimination_mask[index] = true;
+          }
+          return true;
+        },
+        &callback_data);
+  }
+  BLI_kdtree_3d_free(kdtree);
+}
+
+static void run_poisson_disk_performance(const int amount, const float minimum_distance)
+{
+  Array<float3> positions = terrain_positions(amount);
+  std::cout << amount << " points, minimum distance " << minimum_distance << "\n";
+
+  Array<bool> kdtree_mask(amount, false);
+  {
+    SCOPED_TIMER("kdtree");
+    eliminate_close_points_kdtree(positions, minimum_distance, kdtree_mask);
+  }
+
+  Array<bool> grid_mask(amount, false);
+  {
+    SCOPED_TIMER("grid");
+    poisson_disk_eliminate_close_points(positions, minimum_distance, grid_mask);
+  }
+
+  int kdtree_kept = 0;
+  int grid_kept = 0;
+  for (const int i : positions.index_range()) {
+    kdtree_kept += !kdtree_mask[i];
+    grid_kept += !grid_mask[i];
+  }
+  std::cout << "  kept points: kdtree " << kdtree_kept << ", grid " << grid_kept << "\n";
+
+  /* The elimination order differs, but the density of the result should be very similar. */
+  EXPECT_NEAR((float)grid_kept / (float)kdtree_kept, 1.0f, 0.1f);
+}
+
+TEST(poisson_disk, Performance)
+{
+  run_poisson_disk_performance(100000, 0.5f);
+  run_poisson_disk_performance(1000000, 0.2f);
+}
+
+}  // namespace blender::tests
@@ -456,6 +456,12 @@ BlendFileData *BLO_read_from_memfile(Main *oldmain,
 
     bfd = blo_read_file_internal(fd, filename);
 
+    /* Re-read IDs get new addresses, data of unchanged IDs in the memfile can't be re-used for
+     * the next undo step anymore. */
+    if (bfd != NULL) {
+      bfd->main->use_memfile_full_write = true;
+    }
+
     /* Ensure relinked caches are not freed together with their old IDs. */
     blo_cache_storage_old_bmain_clear(fd, oldmain);
 
@@ -69,6 +69,8 @@
 #include "BLI_memarena.h"
 #include "BLI_mempool.h"
 #include "BLI_mmap.h"
+#include "BLI_profile.h"
+#include "BLI_task.h"
 #include "BLI_threads.h"
 
 #include "BLT_translation.h"
@@ -178,6 +180,17 @@
  */
 #define USE_BHEAD_READ_ON_DEMAND
 
+/**
+ * Read the data-blocks belonging to an ID on multiple threads when reading from a
+ * memory-mapped file, see #read_data_into_datamap.
+ *
+ * \note Memory-mapped reading is stateless (unlike the #FileData read callbacks which advance
+ * #FileData.file_offset), so blocks can be copied, endian switched and reconstructed in parallel.
+ */
+#ifdef USE_BHEAD_READ_ON_DEMAND
+#  define USE_BHEAD_READ_PARALLEL
+#endif
+
 /* use GHash for BHead name-based lookups (speeds up linking) */
 #define USE_GHASH_BHEAD
 
@@ -1247,6 +1260,264 @@ static off64_t fd_seek_from_mmap(FileData *filedata, off64_t offset, int whence)
   return filedata->file_offset;
 }
 
+/* Seekable gzip reading.
+ * Files written with an index (see #BlendFrameIndexFooter) support seeking, decompression starts
+ * at the nearest seek point at or before the offset that is read. */
+
+typedef struct FileDataFrames {
+  BLI_mmap_file *mmap_file;
+  int points_len;
+  /** Start of each seek point in the compressed file and in the uncompressed data,
+   * `points_len + 1` items so the size of a point is the difference with the next one. */
+  size_t *compressed_offsets;
+  size_t *uncompressed_offsets;
+  /** Bytes to skip before the raw deflate data of each seek point. */
+  uint32_t *header_sizes;
+
+  z_stream strm;
+  char *compressed_buffer;
+
+  /** Small cache of decompressed seek points. Reading data on demand jumps back and forth
+   * between the data containing the block headers and the data of the blocks. */
+  int cache_point[2];
+  char *cache_buffer[2];
+  int cache_next;
+} FileDataFrames;
+
+static void blo_frames_free(FileDataFrames *frames)
+{
+  if (frames->strm.state != NULL) {
+    inflateEnd(&frames->strm);
+  }
+  MEM_SAFE_FREE(frames->compressed_offsets);
+  MEM_SAFE_FREE(frames->uncompressed_offsets);
+  MEM_SAFE_FREE(frames->header_sizes);
+  MEM_SAFE_FREE(frames->compressed_buffer);
+  for (int i = 0; i < ARRAY_SIZE(frames->cache_buffer); i++) {
+    MEM_SAFE_FREE(frames->cache_buffer[i]);
+  }
+  if (frames->mmap_file) {
+    BLI_mmap_free(frames->mmap_file);
+  }
+  MEM_freeN(frames);
+}
+
+/**
+ * Inflate data into a buffer of the exact uncompressed size.
+ *
+ * \param window_bits: As passed to `inflateInit2`, raw deflate data for seek points
+ * (the stream only ends at the last point of a frame), gzip for the index.
+ */
+static bool blo_frames_inflate(z_stream *strm,
+                               int window_bits,
+                               const char *src,
+                               size_t src_len,
+                               char *dst,
+                               size_t dst_len)
+{
+  if (inflateReset2(strm, window_bits) != Z_OK) {
+    return false;
+  }
+  strm->next_in = (Bytef *)src;
+  strm->avail_in = (uInt)src_len;
+  strm->next_out = (Bytef *)dst;
+  strm->avail_out = (uInt)dst_len;
+
+  const int ret = inflate(strm, Z_FINISH);
+  if (window_bits < 0) {
+    /* Data up to a full flush doesn't end the stream, #Z_BUF_ERROR then only means that. */
+    return ELEM(ret, Z_STREAM_END, Z_BUF_ERROR, Z_OK) && (strm->total_out == dst_len);
+  }
+  return (ret == Z_STREAM_END) && (strm->total_out == dst_len);
+}
+
+/**
+ * Read the index from the end of the file.
+ * \return NULL when the file isn't a seekable gzip file, or the index is invalid.
+ */
+static FileDataFrames *blo_frames_open(int file)
+{
+  BlendFrameIndexFooter footer;
+  const off64_t file_size = BLI_lseek(file, 0, SEEK_END);
+  const off64_t footer_offset = file_size - BLEND_FRAME_GZIP_TRAILER_SIZE - sizeof(footer);
+  if (footer_offset <= 0) {
+    return NULL;
+  }
+
+  BLI_mmap_file *mmap_file = BLI_mmap_open(file);
+  if (mmap_file == NULL) {
+    return NULL;
+  }
+
+  FileDataFrames *frames = MEM_callocN(sizeof(*frames), __func__);
+  frames->mmap_file = mmap_file;
+  frames->cache_point[0] = frames->cache_point[1] = -1;
+
+  if (!BLI_mmap_read(mmap_file, &footer, (size_t)footer_offset, sizeof(footer)) ||
+      memcmp(footer.magic, BLEND_FRAME_INDEX_MAGIC, sizeof(footer.magic)) != 0) {
+    blo_frames_free(frames);
+    return NULL;
+  }
+  if (ENDIAN_ORDER == B_ENDIAN) {
+    BLI_endian_switch_uint32(&footer.entries_len);
+    BLI_endian_switch_uint32(&footer.index_size);
+  }
+
+  const size_t index_len = sizeof(BlendFrameIndexEntry) * footer.entries_len + sizeof(footer);
+  if (footer.entries_len == 0 || footer.index_size > (size_t)file_size ||
+      index_len > footer.index_size) {
+    blo_frames_free(frames);
+    return NULL;
+  }
+
+  if (inflateInit2(&frames->strm, MAX_WBITS + 16) != Z_OK) {
+    blo_frames_free(frames);
+    return NULL;
+  }
+
+  const size_t index_offset = (size_t)file_size - footer.index_size;
+  char *index_compressed = MEM_mallocN(footer.index_size, __func__);
+  BlendFrameIndexEntry *index = MEM_mallocN(index_len, __func__);
+  bool ok = BLI_mmap_read(mmap_file, index_compressed, index_offset, footer.index_size) &&
+            blo_frames_inflate(&frames->strm,
+                               MAX_WBITS + 16,
+                               index_compressed,
+                               footer.index_size,
+                               (char *)index,
+                               index_len);
+  MEM_freeN(index_compressed);
+
+  if (ok) {
+    frames->points_len = (int)footer.entries_len;
+    frames->compressed_offsets = MEM_malloc_arrayN(
+        (size_t)frames->points_len + 1, sizeof(size_t), __func__);
+    frames->uncompressed_offsets = MEM_malloc_arrayN(
+        (size_t)frames->points_len + 1, sizeof(size_t), __func__);
+    frames->header_sizes = MEM_malloc_arrayN(
+        (size_t)frames->points_len, sizeof(uint32_t), __func__);
+
+    size_t compressed_size_max = 0, uncompressed_size_max = 0;
+    frames->compressed_offsets[0] = frames->uncompressed_offsets[0] = 0;
+    for (int i = 0; i < frames->points_len && ok; i++) {
+      BlendFrameIndexEntry entry = index[i];
+      if (ENDIAN_ORDER == B_ENDIAN) {
+        BLI_endian_switch_uint32(&entry.compressed_size);
+        BLI_endian_switch_uint32(&entry.uncompressed_size);
+        BLI_endian_switch_uint32(&entry.header_size);
+      }
+      frames->compressed_offsets[i + 1] = frames->compressed_offsets[i] + entry.compressed_size;
+      frames->uncompressed_offsets[i + 1] = frames->uncompressed_offsets[i] +
+                                            entry.uncompressed_size;
+      frames->header_sizes[i] = entry.header_size;
+      compressed_size_max = MAX2(compressed_size_max, entry.compressed_size);
+      uncompressed_size_max = MAX2(uncompressed_size_max, entry.uncompressed_size);
+      ok = (entry.header_size < entry.compressed_size);
+    }
+
+    /* The seek points must exactly cover the file up to the index. */
+    ok = ok && (frames->compressed_offsets[frames->points_len] == index_offset);
+    if (ok) {
+      frames->compressed_buffer = MEM_mallocN(compressed_size_max, __func__);
+      for (int i = 0; i < ARRAY_SIZE(frames->cache_buffer); i++) {
+        frames->cache_buffer[i] = MEM_mallocN(uncompressed_size_max, __func__);
+      }
+    }
+  }
+  MEM_freeN(index);
+
+  if (!ok) {
+    blo_frames_free(frames);
+    return NULL;
+  }
+  return frames;
+}
+
+/** \return The decompressed data starting at the seek point, or NULL on error. */
+static const char *blo_frames_decompress(FileDataFrames *frames, int point)
+{
+  for (int i = 0; i < ARRAY_SIZE(frames->cache_point); i++) {
+    if (frames->cache_point[i] == point) {
+      /* Evict the other slot next. */
+      frames->cache_next = !i;
+      return frames->cache_buffer[i];
+    }
+  }
+
+  const int slot = frames->cache_next;
+  const size_t compressed_offset = frames->compressed_offsets[point];
+  const size_t compressed_size = frames->compressed_offsets[point + 1] - compressed_offset;
+  const size_t uncompressed_size = frames->uncompressed_offsets[point + 1] -
+                                   frames->uncompressed_offsets[point];
+  const size_t header_size = frames->header_sizes[point];
+
+  frames->cache_point[slot] = -1;
+  if (!BLI_mmap_read(
+          frames->mmap_file, frames->compressed_buffer, compressed_offset, compressed_size) ||
+      !blo_frames_inflate(&frames->strm,
+                          -MAX_WBITS,
+                          frames->compressed_buffer + header_size,
+                          compressed_size - header_size,
+                          frames->cache_buffer[slot],
+                          uncompressed_size)) {
+    return NULL;
+  }
+
+  frames->cache_point[slot] = point;
+  frames->cache_next = !slot;
+  return frames->cache_buffer[slot];
+}
+
+/** \return The last seek point at or before the offset. */
+static int blo_frames_find(const FileDataFrames *frames, size_t offset)
+{
+  for (int i = 0; i < ARRAY_SIZE(frames->cache_point); i++) {
+    const int point = frames->cache_point[i];
+    if (point != -1 && offset >= frames->uncompressed_offsets[point] &&
+        offset < frames->uncompressed_offsets[point + 1]) {
+      return point;
+    }
+  }
+
+  int low = 0, high = frames->points_len - 1;
+  while (low < high) {
+    const int mid = (low + high + 1) / 2;
+    if (frames->uncompressed_offsets[mid] <= offset) {
+      low = mid;
+    }
+    else {
+      high = mid - 1;
+    }
+  }
+  return low;
+}
+
+static ssize_t fd_read_from_frames(FileData *filedata,
+                                   void *buffer,
+                                   size_t size,
+                                   bool *UNUSED(r_is_memchunck_identical))
+{
+  FileDataFrames *frames = filedata->frames;
+  size_t totread = 0;
+
+  while (totread < size && (size_t)filedata->file_offset < filedata->buffersize) {
+    const size_t offset = (size_t)filedata->file_offset;
+    const int point = blo_frames_find(frames, offset);
+    const char *data = blo_frames_decompress(frames, point);
+    if (data == NULL) {
+      break;
+    }
+
+    const size_t point_offset = offset - frames->uncompressed_offsets[point];
+    const size_t readsize = MIN2(size - totread,
+                                 frames->uncompressed_offsets[point + 1] - offset);
+    memcpy(POINTER_OFFSET(buffer, totread), data + point_offset, readsize);
+    totread += readsize;
+    filedata->file_offset += readsize;
+  }
+
+  return (ssize_t)totread;
+}
+
 /* MemFile reading. */
 
 static ssize_t fd_read_from_memfile(FileData *filedata,
@@ -1376,6 +1647,7 @@ static FileData *blo_filedata_from_file_descriptor(const char *filepath,
   FileDataSeekFn *seek_fn = NULL; /* Optional. */
   size_t buffersize = 0;
   BLI_mmap_file *mmap_file = NULL;
+  FileDataFrames *frames = NULL;
 
   gzFile gzfile = (gzFile)Z_NULL;
 
@@ -1412,6 +1684,16 @@ static FileData *blo_filedata_from_file_descriptor(const char *filepath,
   if ((read_fn == NULL) &&
       /* Check header magic. */
       (header[0] == 0x1f && header[1] == 0x8b)) {
+    frames = blo_frames_open(file);
+    BLI_lseek(file, 0, SEEK_SET);
+  }
+  if (frames != NULL) {
+    read_fn = fd_read_from_frames;
+    /* Only depends on #FileData.buffersize. */
+    seek_fn = fd_seek_from_mmap;
+    buffersize = frames->uncompressed_offsets[frames->points_len];
+  }
+  else if ((read_fn == NULL) && (header[0] == 0x1f && header[1] == 0x8b)) {
     gzfile = BLI_gzopen(filepath, "rb");
     if (gzfile == (gzFile)Z_NULL) {
       BKE_reportf(reports,
@@ -1441,6 +1723,7 @@ static FileData *blo_filedata_from_file_descriptor(const char *filepath,
   fd->read = read_fn;
   fd->seek = seek_fn;
   fd->mmap_file = mmap_file;
+  fd->frames = frames;
   fd->buffersize = buffersize;
 
   return fd;
@@ -1615,6 +1898,11 @@ void blo_filedata_free(FileData *fd)
       fd->mmap_file = NULL;
     }
 
+    if (fd->frames) {
+      blo_frames_free(fd->frames);
+      fd->frames = NULL;
+    }
+
     /* Free all BHeadN data blocks */
 #ifndef NDEBUG
     BLI_freelistN(&fd->bhead_list);
@@ -3344,11 +3632,161 @@ static bool direct_link_id(FileData *fd, Main *main, const int tag, ID *id, ID *
   return success;
 }
 
+#ifdef USE_BHEAD_READ_PARALLEL
+
+/* Avoid the threading overhead for small data-blocks (most ID types only have a few). */
+#  define BHEAD_READ_PARALLEL_MIN_BLOCKS 8
+#  define BHEAD_READ_PARALLEL_MIN_SIZE (256 * 1024)
+
+typedef struct BHeadReadParallelData {
+  FileData *fd;
+  BHead **bheads;
+  void **results;
+  const char *allocname;
+  bool is_error;
+} BHeadReadParallelData;
+
+/**
+ * Thread-safe version of #read_struct for blocks that have not been read yet,
+ * the data is read directly from the memory-mapped file.
+ */
+static void *read_struct_from_mmap(FileData *fd, BHead *bh, const char *blockname, bool *r_error)
+{
+  BHeadN *new_bhead = BHEADN_FROM_BHEAD(bh);
+  BLI_assert(fd->mmap_file != NULL && new_bhead->has_data == false);
+
+  if (bh->len == 0 || fd->compflags[bh->SDNAnr] == SDNA_CMP_REMOVED) {
+    return NULL;
+  }
+
+  const bool do_endian_switch = bh->SDNAnr && (fd->flags & FD_FLAGS_SWITCH_ENDIAN);
+  const bool do_reconstruct = fd->compflags[bh->SDNAnr] == SDNA_CMP_NOT_EQUAL;
+
+  char *data = MEM_mallocN((size_t)bh->len, do_reconstruct ? __func__ : blockname);
+  if (UNLIKELY(!BLI_mmap_read(fd->mmap_file, data, new_bhead->file_offset, (size_t)bh->len))) {
+    *r_error = true;
+    MEM_freeN(data);
+    return NULL;
+  }
+
+  if (do_endian_switch) {
+    const int blocksize = fd->filesdna->types_size[fd->filesdna->structs[bh->SDNAnr]->type];
+    for (int i = 0; i < bh->nr; i++) {
+      DNA_struct_switch_endian(fd->filesdna, bh->SDNAnr, data + (size_t)i * blocksize);
+    }
+  }
+
+  if (do_reconstruct) {
+    void *temp = DNA_struct_reconstruct(fd->reconstruct_info, bh->SDNAnr, bh->nr, data);
+    MEM_freeN(data);
+    return temp;
+  }
+
+  return data;
+}
+
+static void read_data_parallel_fn(void *__restrict userdata,
+                                  const int i,
+                                  const TaskParallelTLS *__restrict UNUSED(tls))
+{
+  BHeadReadParallelData *data = userdata;
+  BHead *bhead = data->bheads[i];
+
+  if (BHEADN_FROM_BHEAD(bhead)->has_data) {
+    /* Already in memory, handled by #read_struct on the main thread. */
+    return;
+  }
+
+  bool is_error = false;
+  data->results[i] = read_struct_from_mmap(data->fd, bhead, data->allocname, &is_error);
+  if (is_error) {
+    data->is_error = true;
+  }
+}
+
+/**
+ * Parallel version of #read_data_into_datamap.
+ *
+ * \return The #BHead following the data of the ID, or NULL when there are too few blocks for
+ * threading to be worthwhile (in which case nothing has been read).
+ */
+static BHead *read_data_into_datamap_parallel(FileData *fd,
+                                              BHead *bhead_first,
+                                              const char *allocname,
+                                              bool *r_is_done)
+{
+  *r_is_done = false;
+
+  /* Collect the run of DATA blocks, only headers are read here. */
+  int blocks_len = 0;
+  size_t blocks_size = 0;
+  BHead *bhead;
+  for (bhead = bhead_first; bhead && bhead->code == DATA; bhead = blo_bhead_next(fd, bhead)) {
+    blocks_len++;
+    blocks_size += (size_t)bhead->len;
+  }
+  BHead *bhead_end = bhead;
+
+  if (blocks_len < BHEAD_READ_PARALLEL_MIN_BLOCKS && blocks_size < BHEAD_READ_PARALLEL_MIN_SIZE) {
+    return NULL;
+  }
+
+  BHeadReadParallelData data = {
+      .fd = fd,
+      .bheads = MEM_malloc_arrayN((size_t)blocks_len, sizeof(BHead *), __func__),
+      .results = MEM_calloc_arrayN((size_t)blocks_len, sizeof(void *), __func__),
+      .allocname = allocname,
+      .is_error = false,
+  };
+
+  int i = 0;
+  for (bhead = bhead_first; bhead != bhead_end; bhead = blo_bhead_next(fd, bhead)) {
+    data.bheads[i++] = bhead;
+  }
+
+  TaskParallelSettings settings;
+  BLI_parallel_range_settings_defaults(&settings);
+  settings.min_iter_per_thread = 1;
+  BLI_task_parallel_range(0, blocks_len, &data, read_data_parallel_fn, &settings);
+
+  /* The #OldNewMap is not thread-safe, insert in file order on the calling thread. */
+  for (i = 0; i < blocks_len; i++) {
+    bhead = data.bheads[i];
+    void *result = BHEADN_FROM_BHEAD(bhead)->has_data ? read_struct(fd, bhead, allocname) :
+                                                         data.results[i];
+    if (result) {
+      oldnewmap_insert(fd->datamap, bhead->old, result, 0);
+    }
+  }
+
+  if (data.is_error) {
+    fd->flags &= ~FD_FLAGS_FILE_OK;
+  }
+
+  MEM_freeN(data.bheads);
+  MEM_freeN(data.results);
+
+  *r_is_done = true;
+  return bhead_end;
+}
+
+#endif /* USE_BHEAD_READ_PARALLEL */
+
 /* Read all data associated with a datablock into datamap. */
 static BHead *read_data_into_datamap(FileData *fd, BHead *bhead, const char *allocname)
 {
   bhead = blo_bhead_next(fd, bhead);
 
+#ifdef USE_BHEAD_READ_PARALLEL
+  if (fd->mmap_file != NULL) {
+    bool is_done;
+    BHead *bhead_end = read_data_into_datamap_parallel(fd, bhead, allocname, &is_done);
+    if (is_done) {
+      return bhead_end;
+    }
+  }
+#endif
+
   while (bhead && bhead->code == DATA) {
     /* The code below is useful for debugging leaks in data read from the blend file.
      * Without this the messages only tell us what ID-type the memory came from,
@@ -4092,6 +4530,8 @@ BlendFileData *blo_read_file_internal(FileData *fd, const char *filepath)
   BlendFileData *bfd;
   ListBase mainlist = {NULL, NULL};
 
+  const double profile_start_time = BLI_profile_event_begin();
+
   if (fd->memfile != NULL) {
     DEBUG_PRINTF("\nUNDO: read step\n");
   }
@@ -4198,8 +4638,10 @@ BlendFileData *blo_read_file_internal(FileData *fd, const char *filepath)
 
     blo_join_main(&mainlist);
 
+    const double profile_link_start_time = BLI_profile_event_begin();
     lib_link_all(fd, bfd->main);
     after_liblink_merged_bmain_process(bfd->main);
+    BLI_profile_event_end(profile_link_start_time, "blendfile", "Link Data");
 
     /* Skip in undo case. */
     if (fd->memfile == NULL) {
@@ -4251,6 +4693,9 @@ BlendFileData *blo_read_file_internal(FileData *fd, const char *filepath)
 
   fd->mainlist = NULL; /* Safety, this is local variable, shall not be used afterward. */
 
+  BLI_profile_event_end(
+      profile_start_time, "blendfile", fd->memfile ? "Read Undo Step" : "Read Blend File");
+
   return bfd;
 }
 
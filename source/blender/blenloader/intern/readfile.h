@@ -35,6 +35,7 @@
 
 struct BLI_mmap_file;
 struct BLOCacheStorage;
+struct FileDataFrames;
 struct IDNameLib_Map;
 struct Key;
 struct MemFile;
@@ -95,6 +96,8 @@ typedef struct FileData {
 
   /** Variables needed for reading from file. */
   gzFile gzfiledes;
+  /** Seekable gzip reading, see #BlendFrameIndexFooter. */
+  struct FileDataFrames *frames;
   /** Gzip stream for memory decompression. */
   z_stream strm;
 
@@ -154,6 +157,49 @@ typedef struct FileData {
 
 #define SIZEOFBLENDERHEADER 12
 
+/**
+ * Seekable compressed files.
+ *
+ * Compressed files are written as a sequence of independent gzip members (frames), each holding
+ * #BLEND_FRAME_SIZE bytes of uncompressed data, so they remain regular gzip files.
+ * Within a frame the compressor state is reset every #BLEND_FRAME_SEEK_SIZE bytes with a full
+ * flush, so decompression can start at any of these seek points without decoding the data before
+ * it in the frame.
+ *
+ * The last gzip member only uses stored (uncompressed) deflate blocks and contains the index:
+ * a #BlendFrameIndexEntry per seek point followed by a #BlendFrameIndexFooter in its own final
+ * block, right before the 8 byte gzip trailer. This allows finding the index from the end of the
+ * file, and to decompress only the data around the offsets that are actually read.
+ *
+ * All values are stored little endian. The index is placed after #ENDB in the uncompressed
+ * stream, so readers that don't know about it ignore it.
+ */
+#define BLEND_FRAME_SIZE (1 << 20)
+#define BLEND_FRAME_SEEK_SIZE (1 << 16)
+#define BLEND_FRAME_INDEX_MAGIC "BLENDIDX"
+
+typedef struct BlendFrameIndexEntry {
+  /** Size of the compressed data up to the next seek point, including gzip headers and
+   * trailers of the frame. */
+  uint32_t compressed_size;
+  uint32_t uncompressed_size;
+  /** Bytes before the raw deflate data: the gzip header for the first seek point of a frame,
+   * zero otherwise. */
+  uint32_t header_size;
+} BlendFrameIndexEntry;
+
+typedef struct BlendFrameIndexFooter {
+  uint32_t entries_len;
+  /** Size of the gzip member containing the index (including gzip header and trailer). */
+  uint32_t index_size;
+  char magic[8];
+} BlendFrameIndexFooter;
+
+/** Size of the gzip header written by zlib (without optional fields). */
+#define BLEND_FRAME_GZIP_HEADER_SIZE 10
+/** Size of the gzip trailer (CRC32 and uncompressed size). */
+#define BLEND_FRAME_GZIP_TRAILER_SIZE 8
+
 /***/
 struct Main;
 void blo_join_main(ListBase *mainlist);
@@ -864,6 +864,12 @@ void blo_do_versions_userdef(UserDef *userdef)
    */
   {
     /* Keep this block, even when empty. */
+    if (userdef->compositor_cache_limit == 0) {
+      userdef->compositor_cache_limit = 1024;
+    }
+    if (userdef->geometry_nodes_cache_limit == 0) {
+      userdef->geometry_nodes_cache_limit = 512;
+    }
   }
 
   LISTBASE_FOREACH (bTheme *, btheme, &userdef->themes) {
@@ -100,7 +100,11 @@
 
 #include "BLI_bitmap.h"
 #include "BLI_blenlib.h"
+#include "BLI_endian_switch.h"
+#include "BLI_math_base.h"
 #include "BLI_mempool.h"
+#include "BLI_profile.h"
+#include "BLI_task.h"
 #include "MEM_guardedalloc.h" /* MEM_freeN */
 
 #include "BKE_blender_version.h"
@@ -162,7 +166,7 @@ struct WriteWrap {
   /* internal */
   union {
     int file_handle;
-    gzFile gz_handle;
+    struct WriteWrapFrames *frames;
   } _user_data;
 };
 
@@ -192,31 +196,301 @@ static size_t ww_write_none(WriteWrap *ww, const char *buf, size_t buf_len)
 }
 #undef FILE_HANDLE
 
-/* zlib */
-#define FILE_HANDLE(ww) (ww)->_user_data.gz_handle
+/* zlib
+ *
+ * Data is split in frames of #BLEND_FRAME_SIZE which are compressed as independent gzip members
+ * on multiple threads, with seek points every #BLEND_FRAME_SEEK_SIZE. They are followed by an
+ * index of the seek points, see #BlendFrameIndexFooter. */
+
+/* Compression level, favor speed as files are typically saved often. */
+#define WW_ZLIB_LEVEL 1
+
+typedef struct WriteWrapFrame {
+  struct WriteWrapFrame *next, *prev;
+  /** Uncompressed data. */
+  char *data;
+  size_t data_len;
+  /** Compressed data (a complete gzip member), set by #ww_zlib_frame_compress_task. */
+  char *result;
+  size_t result_len;
+  /** Seek points in the compressed data, in native byte order. */
+  BlendFrameIndexEntry *points;
+  int points_len;
+} WriteWrapFrame;
+
+typedef struct WriteWrapFrames {
+  int file_handle;
+  TaskPool *task_pool;
+  /** #WriteWrapFrame, in file order, compressed by the task pool but not yet written. */
+  ListBase frames_pending;
+  int frames_pending_len;
+  /** Flush pending frames once this many are waiting, limits memory usage. */
+  int frames_pending_max;
+
+  /** The frame currently being filled. */
+  char *buf;
+  size_t buf_used_len;
 
-static bool ww_open_zlib(WriteWrap *ww, const char *filepath)
+  /** Index of all seek points written so far. */
+  BlendFrameIndexEntry *index;
+  int index_len;
+  int index_alloc_len;
+
+  bool error;
+} WriteWrapFrames;
+
+#define FILE_FRAMES(ww) (ww)->_user_data.frames
+
+static void ww_zlib_frame_compress_task(TaskPool *__restrict UNUSED(pool), void *taskdata)
 {
-  gzFile file;
+  WriteWrapFrame *frame = taskdata;
+  z_stream strm = {NULL};
 
-  file = BLI_gzopen(filepath, "wb1");
+  /* A window size over 15 makes zlib write a gzip header and trailer. */
+  if (deflateInit2(&strm, WW_ZLIB_LEVEL, Z_DEFLATED, MAX_WBITS + 16, 8, Z_DEFAULT_STRATEGY) !=
+      Z_OK) {
+    return;
+  }
 
-  if (file != Z_NULL) {
-    FILE_HANDLE(ww) = file;
-    return true;
+  const int points_len = (int)((frame->data_len + BLEND_FRAME_SEEK_SIZE - 1) /
+                               BLEND_FRAME_SEEK_SIZE);
+  BlendFrameIndexEntry *points = MEM_malloc_arrayN(
+      (size_t)points_len, sizeof(*points), __func__);
+
+  /* #deflateBound doesn't account for flushes, each adds at most an empty stored block and
+   * the pending bits of the previous block. */
+  const size_t result_len_max = deflateBound(&strm, (uLong)frame->data_len) +
+                                (size_t)points_len * 16;
+  char *result = MEM_mallocN(result_len_max, __func__);
+
+  strm.next_out = (Bytef *)result;
+  strm.avail_out = (uInt)result_len_max;
+
+  bool ok = true;
+  size_t compressed_prev = 0;
+  for (int i = 0; i < points_len && ok; i++) {
+    const size_t offset = (size_t)i * BLEND_FRAME_SEEK_SIZE;
+    const size_t len = MIN2(BLEND_FRAME_SEEK_SIZE, frame->data_len - offset);
+    const bool is_last = (i == points_len - 1);
+
+    strm.next_in = (Bytef *)(frame->data + offset);
+    strm.avail_in = (uInt)len;
+    /* A full flush resets the compression state, so decompression can start here. */
+    const int ret = deflate(&strm, is_last ? Z_FINISH : Z_FULL_FLUSH);
+    ok = is_last ? (ret == Z_STREAM_END) : (ret == Z_OK && strm.avail_in == 0);
+
+    points[i].compressed_size = (uint32_t)(strm.total_out - compressed_prev);
+    points[i].uncompressed_size = (uint32_t)len;
+    points[i].header_size = (i == 0) ? BLEND_FRAME_GZIP_HEADER_SIZE : 0;
+    compressed_prev = strm.total_out;
   }
 
-  return false;
+  if (ok) {
+    frame->result = result;
+    frame->result_len = (size_t)strm.total_out;
+    frame->points = points;
+    frame->points_len = points_len;
+  }
+  else {
+    MEM_freeN(result);
+    MEM_freeN(points);
+  }
+
+  deflateEnd(&strm);
+
+  MEM_freeN(frame->data);
+  frame->data = NULL;
+}
+
+static void ww_zlib_file_write(WriteWrapFrames *frames, const void *buf, size_t buf_len)
+{
+  if (!frames->error && write(frames->file_handle, buf, buf_len) != (ssize_t)buf_len) {
+    frames->error = true;
+  }
+}
+
+static void ww_zlib_index_add(WriteWrapFrames *frames, const BlendFrameIndexEntry *point)
+{
+  if (frames->index_len == frames->index_alloc_len) {
+    frames->index_alloc_len = max_ii(64, frames->index_alloc_len * 2);
+    frames->index = MEM_reallocN(frames->index,
+                                 sizeof(*frames->index) * (size_t)frames->index_alloc_len);
+  }
+  BlendFrameIndexEntry *entry = &frames->index[frames->index_len++];
+  *entry = *point;
+  if (ENDIAN_ORDER == B_ENDIAN) {
+    BLI_endian_switch_uint32(&entry->compressed_size);
+    BLI_endian_switch_uint32(&entry->uncompressed_size);
+    BLI_endian_switch_uint32(&entry->header_size);
+  }
+}
+
+/** Wait for all pending frames to be compressed and write them out in order. */
+static void ww_zlib_frames_flush(WriteWrapFrames *frames)
+{
+  BLI_task_pool_work_and_wait(frames->task_pool);
+
+  LISTBASE_FOREACH_MUTABLE (WriteWrapFrame *, frame, &frames->frames_pending) {
+    if (frame->result == NULL) {
+      frames->error = true;
+    }
+    else {
+      ww_zlib_file_write(frames, frame->result, frame->result_len);
+      for (int i = 0; i < frame->points_len; i++) {
+        ww_zlib_index_add(frames, &frame->points[i]);
+      }
+      MEM_freeN(frame->result);
+      MEM_freeN(frame->points);
+    }
+    MEM_SAFE_FREE(frame->data);
+    MEM_freeN(frame);
+  }
+  BLI_listbase_clear(&frames->frames_pending);
+  frames->frames_pending_len = 0;
+}
+
+static void ww_zlib_frame_submit(WriteWrapFrames *frames)
+{
+  if (frames->buf_used_len == 0) {
+    return;
+  }
+
+  WriteWrapFrame *frame = MEM_callocN(sizeof(*frame), __func__);
+  frame->data = frames->buf;
+  frame->data_len = frames->buf_used_len;
+  BLI_addtail(&frames->frames_pending, frame);
+  frames->frames_pending_len++;
+
+  frames->buf = MEM_mallocN(BLEND_FRAME_SIZE, __func__);
+  frames->buf_used_len = 0;
+
+  BLI_task_pool_push(frames->task_pool, ww_zlib_frame_compress_task, frame, false, NULL);
+
+  if (frames->frames_pending_len >= frames->frames_pending_max) {
+    ww_zlib_frames_flush(frames);
+  }
+}
+
+/**
+ * Write the frame index as a gzip member made of stored deflate blocks,
+ * the footer gets its own block so it's always at a fixed offset from the end of the file.
+ */
+static void ww_zlib_index_write(WriteWrapFrames *frames)
+{
+  BlendFrameIndexFooter footer;
+  footer.entries_len = (uint32_t)frames->index_len;
+  memcpy(footer.magic, BLEND_FRAME_INDEX_MAGIC, sizeof(footer.magic));
+
+  const size_t index_data_len = sizeof(*frames->index) * (size_t)frames->index_len;
+  const size_t block_len_max = 0xffff;
+  const int blocks_len = (int)((index_data_len + block_len_max - 1) / block_len_max);
+  const uchar gzip_header[10] = {0x1f, 0x8b, Z_DEFLATED, 0, 0, 0, 0, 0, 0, 0xff};
+  const size_t block_header_size = 5;
+
+  footer.index_size = (uint32_t)(sizeof(gzip_header) +
+                                 (size_t)(blocks_len + 1) * block_header_size + index_data_len +
+                                 sizeof(footer) + BLEND_FRAME_GZIP_TRAILER_SIZE);
+  if (ENDIAN_ORDER == B_ENDIAN) {
+    BLI_endian_switch_uint32(&footer.entries_len);
+    BLI_endian_switch_uint32(&footer.index_size);
+  }
+
+  ww_zlib_file_write(frames, gzip_header, sizeof(gzip_header));
+
+  uLong crc = crc32(0, NULL, 0);
+  const char *data = (const char *)frames->index;
+  for (int i = 0; i <= blocks_len; i++) {
+    const bool is_footer = (i == blocks_len);
+    const size_t offset = (size_t)i * block_len_max;
+    const void *block = is_footer ? (const void *)&footer : (const void *)(data + offset);
+    const size_t block_len = is_footer ? sizeof(footer) :
+                                         MIN2(block_len_max, index_data_len - offset);
+
+    /* Stored block: BFINAL bit and BTYPE 00, followed by LEN and its ones complement NLEN. */
+    const uchar block_header[5] = {
+        is_footer ? 1 : 0,
+        (uchar)(block_len & 0xff),
+        (uchar)(block_len >> 8),
+        (uchar)(~block_len & 0xff),
+        (uchar)((~block_len >> 8) & 0xff),
+    };
+    ww_zlib_file_write(frames, block_header, sizeof(block_header));
+    ww_zlib_file_write(frames, block, block_len);
+    crc = crc32(crc, block, (uInt)block_len);
+  }
+
+  const uint32_t isize = (uint32_t)(index_data_len + sizeof(footer));
+  const uchar gzip_trailer[BLEND_FRAME_GZIP_TRAILER_SIZE] = {
+      (uchar)(crc & 0xff),
+      (uchar)((crc >> 8) & 0xff),
+      (uchar)((crc >> 16) & 0xff),
+      (uchar)((crc >> 24) & 0xff),
+      (uchar)(isize & 0xff),
+      (uchar)((isize >> 8) & 0xff),
+      (uchar)((isize >> 16) & 0xff),
+      (uchar)((isize >> 24) & 0xff),
+  };
+  ww_zlib_file_write(frames, gzip_trailer, sizeof(gzip_trailer));
+}
+
+static bool ww_open_zlib(WriteWrap *ww, const char *filepath)
+{
+  int file = BLI_open(filepath, O_BINARY + O_WRONLY + O_CREAT + O_TRUNC, 0666);
+
+  if (file == -1) {
+    return false;
+  }
+
+  WriteWrapFrames *frames = MEM_callocN(sizeof(*frames), __func__);
+  frames->file_handle = file;
+  frames->task_pool = BLI_task_pool_create(NULL, TASK_PRIORITY_HIGH);
+  frames->frames_pending_max = max_ii(2, BLI_task_scheduler_num_threads() * 2);
+  frames->buf = MEM_mallocN(BLEND_FRAME_SIZE, __func__);
+
+  FILE_FRAMES(ww) = frames;
+  return true;
 }
 static bool ww_close_zlib(WriteWrap *ww)
 {
-  return (gzclose(FILE_HANDLE(ww)) == Z_OK);
+  WriteWrapFrames *frames = FILE_FRAMES(ww);
+
+  ww_zlib_frame_submit(frames);
+  ww_zlib_frames_flush(frames);
+  ww_zlib_index_write(frames);
+
+  bool ok = !frames->error;
+  if (close(frames->file_handle) == -1) {
+    ok = false;
+  }
+
+  BLI_task_pool_free(frames->task_pool);
+  MEM_freeN(frames->buf);
+  MEM_SAFE_FREE(frames->index);
+  MEM_freeN(frames);
+  FILE_FRAMES(ww) = NULL;
+
+  return ok;
 }
 static size_t ww_write_zlib(WriteWrap *ww, const char *buf, size_t buf_len)
 {
-  return gzwrite(FILE_HANDLE(ww), buf, buf_len);
+  WriteWrapFrames *frames = FILE_FRAMES(ww);
+  size_t remaining = buf_len;
+
+  while (remaining > 0) {
+    const size_t len = MIN2(remaining, BLEND_FRAME_SIZE - frames->buf_used_len);
+    memcpy(frames->buf + frames->buf_used_len, buf, len);
+    frames->buf_used_len += len;
+    buf += len;
+    remaining -= len;
+
+    if (frames->buf_used_len == BLEND_FRAME_SIZE) {
+      ww_zlib_frame_submit(frames);
+    }
+  }
+
+  return frames->error ? 0 : buf_len;
 }
-#undef FILE_HANDLE
+#undef FILE_FRAMES
 
 /* --- end compression types --- */
 
@@ -444,6 +718,49 @@ static bool mywrite_end(WriteData *wd)
   return err;
 }
 
+/**
+ * Whether the ID can be assumed to be unchanged since the previous undo step, based on the
+ * depsgraph update tags accumulated up to this undo push (see #ID.recalc_up_to_undo_push).
+ *
+ * Only ID types which are reliably tagged when edited are considered. UI data (window-manager,
+ * screens, work-spaces, scenes' tool settings...) typically changes without any tagging.
+ */
+static bool mywrite_id_is_unchanged(ID *id)
+{
+  switch ((ID_Type)GS(id->name)) {
+    case ID_OB:
+    case ID_ME:
+    case ID_CU:
+    case ID_MB:
+    case ID_LT:
+    case ID_AR:
+    case ID_LA:
+    case ID_CA:
+    case ID_MA:
+    case ID_WO:
+    case ID_NT:
+    case ID_GR:
+    case ID_HA:
+    case ID_PT:
+    case ID_VO:
+      break;
+    default:
+      return false;
+  }
+
+  if (id->recalc_up_to_undo_push != 0) {
+    return false;
+  }
+
+  /* Embedded IDs are written as part of their owner. */
+  bNodeTree *nodetree = ntreeFromID(id);
+  if (nodetree != NULL && nodetree->id.recalc_up_to_undo_push != 0) {
+    return false;
+  }
+
+  return true;
+}
+
 /**
  * Start writing of data related to a single ID.
  *
@@ -926,6 +1243,8 @@ static bool write_file_handle(Main *mainvar,
   char buf[16];
   WriteData *wd;
 
+  const double profile_start_time = BLI_profile_event_begin();
+
   blo_split_main(&mainlist, mainvar);
 
   wd = mywrite_begin(ww, compare, current);
@@ -951,6 +1270,18 @@ static bool write_file_handle(Main *mainvar,
                                                  NULL :
                                                  BKE_lib_override_library_operations_store_init();
 
+  /* Re-use the previous undo step's data of IDs that were not tagged for update since then,
+   * instead of writing and comparing them again. Not done after operations that request a full
+   * undo barrier, since they may change data without tagging, nor after reading a memfile, since
+   * then the previous step's data may point to old addresses of re-read IDs. */
+  const bool use_undo_skip_unchanged = wd->use_memfile &&
+                                       USER_EXPERIMENTAL_TEST(&U, use_undo_skip_unchanged) &&
+                                       !mainvar->use_memfile_full_barrier &&
+                                       !mainvar->use_memfile_full_write;
+  if (wd->use_memfile) {
+    mainvar->use_memfile_full_write = false;
+  }
+
 #define ID_BUFFER_STATIC_SIZE 8192
   /* This outer loop allows to save first data-blocks from real mainvar,
    * then the temp ones from override process,
@@ -1007,6 +1338,11 @@ static bool write_file_handle(Main *mainvar,
               scene->master_collection->id.recalc_after_undo_push = 0;
             }
           }
+
+          if (use_undo_skip_unchanged && mywrite_id_is_unchanged(id) &&
+              BLO_memfile_chunk_reuse_id(&wd->mem, id->session_uuid)) {
+            continue;
+          }
         }
 
         mywrite_id_begin(wd, id);
@@ -1068,7 +1404,12 @@ static bool write_file_handle(Main *mainvar,
 
   blo_join_main(&mainlist);
 
-  return mywrite_end(wd);
+  const bool err = mywrite_end(wd);
+
+  BLI_profile_event_end(
+      profile_start_time, "blendfile", current ? "Write Undo Step" : "Write Blend File");
+
+  return err;
 }
 
 /* do reverse file history: .blend1 -> .blend2, .blend -> .blend1 */
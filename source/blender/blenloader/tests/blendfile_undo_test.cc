@@ -0,0 +1,98 @@
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ * The Original Code is Copyright (C) 2021 by Blender Foundation.
+ */
+#include "blendfile_loading_base_test.h"
+
+#include "BKE_lib_id.h"
+#include "BKE_main.h"
+#include "BKE_mesh.h"
+#include "BKE_object.h"
+#include "BKE_undo_system.h"
+
+#include "BLO_readfile.h"
+#include "BLO_undofile.h"
+#include "BLO_writefile.h"
+
+#include "DNA_ID.h"
+#include "DNA_mesh_types.h"
+#include "DNA_object_types.h"
+#include "DNA_userdef_types.h"
+
+class BlendfileUndoTest : public BlendfileLoadingBaseTest {
+};
+
+static BlendFileData *undo_read(Main *bmain, MemFile *memfile)
+{
+  BlendFileReadParams params = {0};
+  params.skip_flags = BLO_READ_SKIP_UNDO_OLD_MAIN;
+  params.undo_direction = STEP_UNDO;
+  return BLO_read_from_memfile(bmain, "", memfile, &params, nullptr);
+}
+
+/* Undo, edit and undo again with "Undo Skip Unchanged". Data of unchanged IDs from the step
+ * before the first undo must not be re-used, since it points to addresses from before the
+ * re-read. */
+TEST_F(BlendfileUndoTest, SkipUnchangedAfterUndo)
+{
+  const int flag_prev = U.flag;
+  const char use_undo_skip_unchanged_prev = U.experimental.use_undo_skip_unchanged;
+  U.flag |= USER_DEVELOPER_UI;
+  U.experimental.use_undo_skip_unchanged = true;
+
+  Main *bmain = BKE_main_new();
+  Mesh *mesh = BKE_mesh_add(bmain, "Mesh");
+  Object *object = BKE_object_add_only_object(bmain, OB_MESH, "Object");
+  object->data = mesh;
+  id_us_plus(&mesh->id);
+
+  MemFile memfile_a = {{nullptr}};
+  BLO_write_file_mem(bmain, nullptr, &memfile_a, 0);
+
+  /* Undo, all IDs are re-read at new addresses. */
+  BlendFileData *bfd_a = undo_read(bmain, &memfile_a);
+  ASSERT_NE(bfd_a, nullptr);
+  EXPECT_TRUE(bfd_a->main->use_memfile_full_write);
+
+  /* Edit only the mesh, the object stays unchanged. */
+  Object *object_a = static_cast<Object *>(bfd_a->main->objects.first);
+  Mesh *mesh_a = static_cast<Mesh *>(bfd_a->main->meshes.first);
+  ASSERT_NE(object_a, nullptr);
+  ASSERT_NE(mesh_a, nullptr);
+  object_a->id.recalc_after_undo_push = 0;
+  mesh_a->id.recalc_after_undo_push = ID_RECALC_GEOMETRY;
+
+  MemFile memfile_b = {{nullptr}};
+  BLO_write_file_mem(bfd_a->main, &memfile_a, &memfile_b, 0);
+  EXPECT_FALSE(bfd_a->main->use_memfile_full_write);
+
+  /* Undo again, the object must still use the mesh. */
+  BlendFileData *bfd_b = undo_read(bfd_a->main, &memfile_b);
+  ASSERT_NE(bfd_b, nullptr);
+  Object *object_b = static_cast<Object *>(bfd_b->main->objects.first);
+  ASSERT_NE(object_b, nullptr);
+  EXPECT_NE(object_b->data, nullptr);
+  EXPECT_EQ(object_b->data, bfd_b->main->meshes.first);
+
+  BLO_blendfiledata_free(bfd_b);
+  BLO_blendfiledata_free(bfd_a);
+  BKE_main_free(bmain);
+  BLO_memfile_free(&memfile_b);
+  BLO_memfile_free(&memfile_a);
+
+  U.flag = flag_prev;
+  U.experimental.use_undo_skip_unchanged = use_undo_skip_unchanged_prev;
+}
@@ -58,6 +58,18 @@ typedef enum CompositorPriority {
   COM_PRIORITY_LOW = 0,
 } CompositorPriority;
 
+/**
+ * \brief Possible execution models
+ * \see CompositorContext.execution_model
+ * \ingroup Execution
+ */
+typedef enum ExecutionModel {
+  /** \brief Operations are executed per pixel, in chunks scheduled by #ExecutionGroup's. */
+  COM_EM_TILED = 0,
+  /** \brief Operations are executed one after another on whole frame buffers. */
+  COM_EM_FULL_FRAME = 1,
+} ExecutionModel;
+
 // configurable items
 
 // chunk size determination
@@ -25,6 +25,8 @@ CompositorContext::CompositorContext()
   this->m_scene = nullptr;
   this->m_rd = nullptr;
   this->m_quality = COM_QUALITY_HIGH;
+  this->m_execution_model = COM_EM_TILED;
+  this->m_buffer_cache = nullptr;
   this->m_hasActiveOpenCLDevices = false;
   this->m_fastCalculation = false;
   this->m_viewSettings = nullptr;
@@ -26,6 +26,8 @@
 #include <string>
 #include <vector>
 
+class MemoryBufferCache;
+
 /**
  * \brief Overall context of the compositor
  */
@@ -45,6 +47,19 @@ class CompositorContext {
    */
   CompositorQuality m_quality;
 
+  /**
+   * \brief The execution model, tiled or full frame.
+   * This field is initialized in ExecutionSystem and must only be read from that point on.
+   * \see ExecutionSystem
+   */
+  ExecutionModel m_execution_model;
+
+  /**
+   * \brief Results kept across executions, only used by the full frame execution model.
+   * Can be nullptr.
+   */
+  MemoryBufferCache *m_buffer_cache;
+
   Scene *m_scene;
 
   /**
@@ -213,6 +228,26 @@ class CompositorContext {
     return this->m_quality;
   }
 
+  void set_execution_model(ExecutionModel execution_model)
+  {
+    this->m_execution_model = execution_model;
+  }
+
+  ExecutionModel get_execution_model() const
+  {
+    return this->m_execution_model;
+  }
+
+  void set_buffer_cache(MemoryBufferCache *buffer_cache)
+  {
+    this->m_buffer_cache = buffer_cache;
+  }
+
+  MemoryBufferCache *get_buffer_cache() const
+  {
+    return this->m_buffer_cache;
+  }
+
   /**
    * \brief get the current frame-number of the scene in this context
    */
@@ -28,6 +28,7 @@
 #include "COM_Converter.h"
 #include "COM_Debug.h"
 #include "COM_ExecutionGroup.h"
+#include "COM_FullFrameExecutionModel.h"
 #include "COM_NodeOperation.h"
 #include "COM_NodeOperationBuilder.h"
 #include "COM_ReadBufferOperation.h"
@@ -44,7 +45,8 @@ ExecutionSystem::ExecutionSystem(RenderData *rd,
                                  bool fastcalculation,
                                  const ColorManagedViewSettings *viewSettings,
                                  const ColorManagedDisplaySettings *displaySettings,
-                                 const char *viewName)
+                                 const char *viewName,
+                                 MemoryBufferCache *buffer_cache)
 {
   this->m_context.setViewName(viewName);
   this->m_context.setScene(scene);
@@ -59,6 +61,8 @@ ExecutionSystem::ExecutionSystem(RenderData *rd,
     this->m_context.setQuality((CompositorQuality)editingtree->edit_quality);
   }
   this->m_context.setRendering(rendering);
+  this->m_context.set_execution_model((ExecutionModel)editingtree->execution_mode);
+  this->m_context.set_buffer_cache(buffer_cache);
   this->m_context.setHasActiveOpenCLDevices(WorkScheduler::has_gpu_devices() &&
                                             (editingtree->flag & NTREE_COM_OPENCL));
 
@@ -131,6 +135,12 @@ void ExecutionSystem::set_operations(const blender::Vector<NodeOperation *> &ope
 void ExecutionSystem::execute()
 {
   const bNodeTree *editingtree = this->m_context.getbNodeTree();
+  if (m_context.get_execution_model() == COM_EM_FULL_FRAME) {
+    FullFrameExecutionModel execution_model(m_context, m_operations);
+    execution_model.execute();
+    return;
+  }
+
   editingtree->stats_draw(editingtree->sdh, TIP_("Compositing | Initializing execution"));
 
   DebugInfo::execute_started(this);
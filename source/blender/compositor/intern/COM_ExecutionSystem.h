@@ -148,6 +148,7 @@ class ExecutionSystem {
    *
    * \param editingtree: [bNodeTree *]
    * \param rendering: [true false]
+   * \param buffer_cache: results kept across executions, can be nullptr.
    */
   ExecutionSystem(RenderData *rd,
                   Scene *scene,
@@ -156,7 +157,8 @@ class ExecutionSystem {
                   bool fastcalculation,
                   const ColorManagedViewSettings *viewSettings,
                   const ColorManagedDisplaySettings *displaySettings,
-                  const char *viewName);
+                  const char *viewName,
+                  MemoryBufferCache *buffer_cache);
 
   /**
    * Destructor
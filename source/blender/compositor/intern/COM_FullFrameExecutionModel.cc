@@ -0,0 +1,496 @@
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ * Copyright 2021, Blender Foundation.
+ */
+
+#include <typeinfo>
+
+#include "COM_FullFrameExecutionModel.h"
+#include "COM_BufferOperation.h"
+#include "COM_MemoryBufferCache.h"
+#include "COM_OperationHash.h"
+#include "COM_ReadBufferOperation.h"
+#include "COM_WriteBufferOperation.h"
+
+#include "BLI_math_base.h"
+#include "BLI_rect.h"
+#include "BLI_string.h"
+#include "BLI_task.hh"
+
+#include "BLT_translation.h"
+
+#ifdef WITH_CXX_GUARDEDALLOC
+#  include "MEM_guardedalloc.h"
+#endif
+
+using blender::IndexRange;
+using blender::Span;
+using blender::Vector;
+
+/**
+ * Number of rows rendered by a task. Areas are split in bands of rows so each task writes a
+ * contiguous part of the output buffer.
+ */
+static constexpr int ROWS_PER_TASK = 16;
+
+/**
+ * Get the operation which renders the result read by an input, skipping the read/write buffer
+ * operations of the tiled execution model.
+ */
+static NodeOperation *get_input_operation(NodeOperation *operation, int input_index)
+{
+  NodeOperationOutput *link = operation->getInputSocket(input_index)->getLink();
+  BLI_assert(link != nullptr);
+  NodeOperation *input = &link->getOperation();
+  while (input->isReadBufferOperation()) {
+    WriteBufferOperation *write_operation =
+        ((ReadBufferOperation *)input)->getMemoryProxy()->getWriteBufferOperation();
+    input = &write_operation->getInputSocket(0)->getLink()->getOperation();
+  }
+  return input;
+}
+
+static bool has_area(NodeOperation *operation)
+{
+  return operation->getWidth() > 0 && operation->getHeight() > 0;
+}
+
+static rcti get_operation_area(NodeOperation *operation)
+{
+  rcti area;
+  BLI_rcti_init(&area, 0, operation->getWidth(), 0, operation->getHeight());
+  return area;
+}
+
+/**
+ * Split an area in bands of rows and call the given function for each of them, in parallel when
+ * the area is big enough.
+ */
+template<typename Func>
+static void execute_area_in_bands(const rcti &area, const bool single_threaded, const Func &func)
+{
+  const int height = BLI_rcti_size_y(&area);
+  if (single_threaded || height <= ROWS_PER_TASK) {
+    func(area);
+    return;
+  }
+  const int bands_num = divide_ceil_u(height, ROWS_PER_TASK);
+  blender::parallel_for(IndexRange(bands_num), 1, [&](const IndexRange range) {
+    for (const int64_t band : range) {
+      rcti band_area;
+      BLI_rcti_init(&band_area,
+                    area.xmin,
+                    area.xmax,
+                    area.ymin + band * ROWS_PER_TASK,
+                    min_ii(area.ymin + (band + 1) * ROWS_PER_TASK, area.ymax));
+      func(band_area);
+    }
+  });
+}
+
+/** Execute an operation per pixel, the same way #WriteBufferOperation does for a tile. */
+static void execute_pixels(NodeOperation *operation, MemoryBuffer *output, const rcti &area)
+{
+  const int num_channels = output->get_num_channels();
+  rcti tile_area = area;
+  void *data = operation->isComplex() ? operation->initializeTileData(&tile_area) : nullptr;
+
+  float color[4];
+  for (int y = area.ymin; y < area.ymax; y++) {
+    float *out = output->get_elem(area.xmin, y);
+    for (int x = area.xmin; x < area.xmax; x++) {
+      if (data) {
+        operation->read(color, x, y, data);
+      }
+      else {
+        operation->readSampled(color, x, y, COM_PS_NEAREST);
+      }
+      memcpy(out, color, sizeof(float) * num_channels);
+      out += num_channels;
+    }
+  }
+
+  if (data) {
+    operation->deinitializeTileData(&tile_area, data);
+  }
+}
+
+/** Create a full buffer of the operation size filled with the element of a single one. */
+static MemoryBuffer *expand_single_elem(MemoryBuffer *single_elem,
+                                        NodeOperation *operation,
+                                        DataType data_type)
+{
+  rcti area = get_operation_area(operation);
+  MemoryBuffer *buffer = new MemoryBuffer(data_type, &area);
+  const int num_channels = buffer->get_num_channels();
+  const float *elem = single_elem->getBuffer();
+  float *out = buffer->getBuffer();
+  const int64_t elems_len = (int64_t)buffer->getWidth() * buffer->getHeight();
+  for (int64_t i = 0; i < elems_len; i++) {
+    memcpy(out, elem, sizeof(float) * num_channels);
+    out += num_channels;
+  }
+  return buffer;
+}
+
+FullFrameExecutionModel::FullFrameExecutionModel(const CompositorContext &context,
+                                                 Span<NodeOperation *> operations)
+    : m_context(context),
+      m_operations(operations),
+      m_buffer_cache(context.get_buffer_cache()),
+      m_operations_num(0),
+      m_operations_finished(0)
+{
+}
+
+FullFrameExecutionModel::~FullFrameExecutionModel()
+{
+  for (auto item : m_buffers.items()) {
+    free_result(item.key, item.value);
+  }
+}
+
+void FullFrameExecutionModel::execute()
+{
+  const bNodeTree *node_tree = m_context.getbNodeTree();
+  node_tree->stats_draw(node_tree->sdh, TIP_("Compositing | Initializing execution"));
+
+  Vector<NodeOperation *> outputs = get_output_operations();
+  for (NodeOperation *output : outputs) {
+    count_readers(output);
+  }
+
+  for (NodeOperation *output : outputs) {
+    render_operation(output);
+  }
+}
+
+/**
+ * Output operations sorted by priority. When doing fast calculations only the high priority ones
+ * are rendered, as the tiled execution model does.
+ */
+Vector<NodeOperation *> FullFrameExecutionModel::get_output_operations() const
+{
+  const bool rendering = m_context.isRendering();
+  Vector<NodeOperation *> outputs;
+  for (const CompositorPriority priority :
+       {COM_PRIORITY_HIGH, COM_PRIORITY_MEDIUM, COM_PRIORITY_LOW}) {
+    if (priority != COM_PRIORITY_HIGH && m_context.isFastCalculation()) {
+      break;
+    }
+    for (NodeOperation *operation : m_operations) {
+      if (operation->isOutputOperation(rendering) &&
+          operation->getRenderPriority() == priority) {
+        outputs.append(operation);
+      }
+    }
+  }
+  return outputs;
+}
+
+void FullFrameExecutionModel::count_readers(NodeOperation *operation)
+{
+  if (!m_readers_num.add(operation, 0)) {
+    /* Already counted. */
+    return;
+  }
+  m_operations_num++;
+
+  const std::optional<uint64_t> hash = get_operation_hash(operation);
+  MemoryBuffer *cached = hash ? m_buffer_cache->acquire(*hash) : nullptr;
+  if (cached) {
+    /* Rendered by a previous execution, its inputs aren't needed. */
+    m_buffers.add_new(operation, cached);
+    m_cached_operations.add_new(operation);
+    m_operations_finished++;
+    return;
+  }
+
+  for (int i = 0; i < operation->getNumberOfInputSockets(); i++) {
+    NodeOperation *input = get_input_operation(operation, i);
+    count_readers(input);
+    m_readers_num.lookup(input)++;
+  }
+}
+
+/**
+ * Hash the type, resolution, parameters and inputs of an operation. Operations without a buffer
+ * cache, output operations and operations depending on an operation which can't be hashed have no
+ * hash.
+ */
+std::optional<uint64_t> FullFrameExecutionModel::get_operation_hash(NodeOperation *operation)
+{
+  const std::optional<uint64_t> *cached_hash = m_hashes.lookup_ptr(operation);
+  if (cached_hash) {
+    return *cached_hash;
+  }
+
+  std::optional<uint64_t> result;
+  OperationHash hash;
+  if (m_buffer_cache && operation->getNumberOfOutputSockets() > 0 &&
+      operation->hash_output_params(hash)) {
+    hash.add_string(typeid(*operation).name());
+    hash.add(operation->getOutputSocket()->getDataType());
+    hash.add(operation->getWidth());
+    hash.add(operation->getHeight());
+    hash.add(m_context.getQuality());
+    hash.add(m_context.isFastCalculation());
+    hash.add(m_context.isRendering());
+
+    result = hash.value();
+    for (int i = 0; i < operation->getNumberOfInputSockets(); i++) {
+      const std::optional<uint64_t> input_hash = get_operation_hash(
+          get_input_operation(operation, i));
+      if (!input_hash) {
+        result.reset();
+        break;
+      }
+      hash.add(*input_hash);
+      result = hash.value();
+    }
+  }
+
+  m_hashes.add_new(operation, result);
+  return result;
+}
+
+/**
+ * Keep a result in the cache for later executions. Single elements are cheap to render again so
+ * they're not cached.
+ */
+void FullFrameExecutionModel::cache_result(NodeOperation *operation, MemoryBuffer *result)
+{
+  const std::optional<uint64_t> hash = get_operation_hash(operation);
+  if (hash && result && !result->is_a_single_elem() && !is_breaked() &&
+      m_buffer_cache->add(*hash, result)) {
+    m_cached_operations.add_new(operation);
+  }
+}
+
+MemoryBuffer *FullFrameExecutionModel::render_operation(NodeOperation *operation)
+{
+  MemoryBuffer **rendered = m_buffers.lookup_ptr(operation);
+  if (rendered) {
+    return *rendered;
+  }
+
+  Vector<MemoryBuffer *> inputs;
+  for (int i = 0; i < operation->getNumberOfInputSockets(); i++) {
+    inputs.append(render_operation(get_input_operation(operation, i)));
+  }
+
+  MemoryBuffer *output = create_output_buffer(operation, inputs);
+  if (is_breaked()) {
+    if (output) {
+      output->clear();
+    }
+  }
+  else {
+    operation->setbNodeTree(m_context.getbNodeTree());
+
+    bool inputs_match_area = true;
+    for (MemoryBuffer *input : inputs) {
+      if (!input->is_a_single_elem() && (input->getWidth() != operation->getWidth() ||
+                                         input->getHeight() != operation->getHeight())) {
+        inputs_match_area = false;
+      }
+    }
+    if (output && operation->is_full_frame_operation() && inputs_match_area) {
+      render_full_frame(operation, output, inputs);
+    }
+    else {
+      render_fallback(operation, output, inputs);
+    }
+    cache_result(operation, output);
+  }
+  m_buffers.add_new(operation, output);
+
+  for (int i = 0; i < operation->getNumberOfInputSockets(); i++) {
+    release_input(get_input_operation(operation, i));
+  }
+
+  m_operations_finished++;
+  update_progress_bar();
+  return output;
+}
+
+/**
+ * Operations without area, set operations and full frame operations which only read single
+ * elements result in a single element, reading it is the same for any pixel.
+ */
+MemoryBuffer *FullFrameExecutionModel::create_output_buffer(NodeOperation *operation,
+                                                            Span<MemoryBuffer *> inputs)
+{
+  if (operation->getNumberOfOutputSockets() == 0) {
+    return nullptr;
+  }
+
+  const DataType data_type = operation->getOutputSocket()->getDataType();
+  bool is_a_single_elem = operation->isSetOperation() || !has_area(operation);
+  if (!is_a_single_elem && operation->is_full_frame_operation() && !operation->isComplex() &&
+      !inputs.is_empty()) {
+    is_a_single_elem = true;
+    for (MemoryBuffer *input : inputs) {
+      is_a_single_elem &= input->is_a_single_elem();
+    }
+  }
+
+  if (is_a_single_elem) {
+    return new MemoryBuffer(data_type, true);
+  }
+  rcti area = get_operation_area(operation);
+  return new MemoryBuffer(data_type, &area);
+}
+
+void FullFrameExecutionModel::render_full_frame(NodeOperation *operation,
+                                                MemoryBuffer *output,
+                                                Span<MemoryBuffer *> inputs)
+{
+  operation->initExecution();
+  if (output->is_a_single_elem()) {
+    rcti area;
+    BLI_rcti_init(&area, 0, 1, 0, 1);
+    operation->update_memory_buffer_partial(output, area, inputs);
+  }
+  else {
+    execute_area_in_bands(get_operation_area(operation), false, [&](const rcti &area) {
+      if (!is_breaked()) {
+        operation->update_memory_buffer_partial(output, area, inputs);
+      }
+    });
+  }
+  operation->deinitExecution();
+}
+
+/**
+ * Execute an operation not implementing #NodeOperation.update_memory_buffer_partial. Its inputs
+ * are temporarily linked to #BufferOperation's reading the rendered buffers.
+ */
+void FullFrameExecutionModel::render_fallback(NodeOperation *operation,
+                                              MemoryBuffer *output,
+                                              Span<MemoryBuffer *> inputs)
+{
+  Vector<NodeOperationOutput *> links;
+  Vector<BufferOperation *> buffer_operations;
+  Vector<MemoryBuffer *> expanded_buffers;
+  for (int i = 0; i < inputs.size(); i++) {
+    NodeOperationInput *socket = operation->getInputSocket(i);
+    NodeOperation *input_operation = get_input_operation(operation, i);
+    const DataType data_type = socket->getLink()->getDataType();
+    MemoryBuffer *buffer = inputs[i];
+    if (buffer->is_a_single_elem() && operation->isComplex() && has_area(input_operation)) {
+      /* Complex operations may access the buffers of their inputs directly. */
+      buffer = expand_single_elem(buffer, input_operation, data_type);
+      expanded_buffers.append(buffer);
+    }
+
+    BufferOperation *buffer_operation = new BufferOperation(buffer, input_operation, data_type);
+    buffer_operation->setbNodeTree(m_context.getbNodeTree());
+    buffer_operations.append(buffer_operation);
+    links.append(socket->getLink());
+    socket->setLink(buffer_operation->getOutputSocket());
+  }
+
+  operation->initExecution();
+  if (output == nullptr) {
+    execute_area_in_bands(
+        get_operation_area(operation), operation->isSingleThreaded(), [&](const rcti &area) {
+          if (!is_breaked()) {
+            rcti region = area;
+            operation->executeRegion(&region, 0);
+          }
+        });
+  }
+  else if (output->is_a_single_elem()) {
+    if (has_area(operation)) {
+      float color[4];
+      operation->readSampled(color, 0.0f, 0.0f, COM_PS_NEAREST);
+      memcpy(output->getBuffer(), color, sizeof(float) * output->get_num_channels());
+    }
+    else {
+      output->clear();
+    }
+  }
+  else {
+    execute_area_in_bands(
+        get_operation_area(operation), operation->isSingleThreaded(), [&](const rcti &area) {
+          if (!is_breaked()) {
+            execute_pixels(operation, output, area);
+          }
+        });
+  }
+  operation->deinitExecution();
+
+  for (int i = 0; i < links.size(); i++) {
+    operation->getInputSocket(i)->setLink(links[i]);
+  }
+  for (BufferOperation *buffer_operation : buffer_operations) {
+    delete buffer_operation;
+  }
+  for (MemoryBuffer *buffer : expanded_buffers) {
+    delete buffer;
+  }
+}
+
+/** Free the result of an input once all operations reading it are rendered. */
+void FullFrameExecutionModel::release_input(NodeOperation *input)
+{
+  int &readers = m_readers_num.lookup(input);
+  BLI_assert(readers > 0);
+  readers--;
+  if (readers == 0) {
+    /* Keep the entry so the operation is known to be rendered. */
+    MemoryBuffer *&buffer = m_buffers.lookup(input);
+    free_result(input, buffer);
+    buffer = nullptr;
+  }
+}
+
+void FullFrameExecutionModel::free_result(NodeOperation *operation, MemoryBuffer *result)
+{
+  if (result == nullptr) {
+    return;
+  }
+  if (m_cached_operations.contains(operation)) {
+    m_buffer_cache->release(*m_hashes.lookup(operation));
+  }
+  else {
+    delete result;
+  }
+}
+
+bool FullFrameExecutionModel::is_breaked() const
+{
+  const bNodeTree *node_tree = m_context.getbNodeTree();
+  return node_tree->test_break(node_tree->tbh);
+}
+
+void FullFrameExecutionModel::update_progress_bar()
+{
+  const bNodeTree *node_tree = m_context.getbNodeTree();
+  if (node_tree) {
+    const float progress = m_operations_finished / (float)m_operations_num;
+    node_tree->progress(node_tree->prh, progress);
+
+    char buf[128];
+    BLI_snprintf(buf,
+                 sizeof(buf),
+                 TIP_("Compositing | Operation %i-%i"),
+                 m_operations_finished,
+                 m_operations_num);
+    node_tree->stats_draw(node_tree->sdh, buf);
+  }
+}
@@ -0,0 +1,100 @@
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ * Copyright 2021, Blender Foundation.
+ */
+
+#pragma once
+
+#include <optional>
+
+#include "BLI_map.hh"
+#include "BLI_set.hh"
+#include "BLI_span.hh"
+#include "BLI_vector.hh"
+
+#include "COM_CompositorContext.h"
+#include "COM_NodeOperation.h"
+
+/**
+ * \brief execute operations one after another on whole frame buffers.
+ *
+ * The operations needed by the outputs are rendered depth first, so the inputs of an operation
+ * are rendered before it. The result of an operation is kept in a #MemoryBuffer until all
+ * operations reading it are rendered.
+ *
+ * Operations implementing #NodeOperation.update_memory_buffer_partial render areas of their
+ * output buffer at once. Other operations are executed per pixel, reading their inputs from the
+ * rendered buffers through #BufferOperation's.
+ *
+ * Read/write buffer operations and execution groups of the tiled model are not used, reading
+ * through a #ReadBufferOperation reads the result of the operation linked to its
+ * #WriteBufferOperation.
+ *
+ * Results of operations which can be hashed are kept in the #MemoryBufferCache of the context.
+ * Operations found in the cache are not rendered again, nor their inputs.
+ * \ingroup Execution
+ */
+class FullFrameExecutionModel {
+ private:
+  const CompositorContext &m_context;
+  blender::Span<NodeOperation *> m_operations;
+
+  /** Rendered results, kept until all operations reading them are rendered. */
+  blender::Map<NodeOperation *, MemoryBuffer *> m_buffers;
+  /** Number of inputs reading the result of an operation which are not rendered yet. */
+  blender::Map<NodeOperation *, int> m_readers_num;
+
+  MemoryBufferCache *m_buffer_cache;
+  /** Hashes identifying the results of operations, none for operations which can't be hashed. */
+  blender::Map<NodeOperation *, std::optional<uint64_t>> m_hashes;
+  /** Operations whose result is owned by the cache, it's released instead of freed. */
+  blender::Set<NodeOperation *> m_cached_operations;
+
+  int m_operations_num;
+  int m_operations_finished;
+
+ public:
+  FullFrameExecutionModel(const CompositorContext &context,
+                          blender::Span<NodeOperation *> operations);
+  ~FullFrameExecutionModel();
+
+  void execute();
+
+ private:
+  blender::Vector<NodeOperation *> get_output_operations() const;
+  void count_readers(NodeOperation *operation);
+  std::optional<uint64_t> get_operation_hash(NodeOperation *operation);
+  void cache_result(NodeOperation *operation, MemoryBuffer *result);
+
+  MemoryBuffer *render_operation(NodeOperation *operation);
+  MemoryBuffer *create_output_buffer(NodeOperation *operation,
+                                     blender::Span<MemoryBuffer *> inputs);
+  void render_full_frame(NodeOperation *operation,
+                         MemoryBuffer *output,
+                         blender::Span<MemoryBuffer *> inputs);
+  void render_fallback(NodeOperation *operation,
+                       MemoryBuffer *output,
+                       blender::Span<MemoryBuffer *> inputs);
+  void release_input(NodeOperation *input);
+  void free_result(NodeOperation *operation, MemoryBuffer *result);
+
+  bool is_breaked() const;
+  void update_progress_bar();
+
+#ifdef WITH_CXX_GUARDEDALLOC
+  MEM_CXX_CLASS_ALLOC_FUNCS("COM:FullFrameExecutionModel")
+#endif
+};
@@ -58,6 +58,7 @@ MemoryBuffer::MemoryBuffer(MemoryProxy *memoryProxy, unsigned int chunkNumber, r
   this->m_buffer = (float *)MEM_mallocN_aligned(
       sizeof(float) * determineBufferSize() * this->m_num_channels, 16, "COM_MemoryBuffer");
   this->m_state = COM_MB_ALLOCATED;
+  this->m_is_a_single_elem = false;
   this->m_datatype = memoryProxy->getDataType();
 }
 
@@ -72,6 +73,7 @@ MemoryBuffer::MemoryBuffer(MemoryProxy *memoryProxy, rcti *rect)
   this->m_buffer = (float *)MEM_mallocN_aligned(
       sizeof(float) * determineBufferSize() * this->m_num_channels, 16, "COM_MemoryBuffer");
   this->m_state = COM_MB_TEMPORARILY;
+  this->m_is_a_single_elem = false;
   this->m_datatype = memoryProxy->getDataType();
 }
 MemoryBuffer::MemoryBuffer(DataType dataType, rcti *rect)
@@ -86,8 +88,24 @@ MemoryBuffer::MemoryBuffer(DataType dataType, rcti *rect)
   this->m_buffer = (float *)MEM_mallocN_aligned(
       sizeof(float) * determineBufferSize() * this->m_num_channels, 16, "COM_MemoryBuffer");
   this->m_state = COM_MB_TEMPORARILY;
+  this->m_is_a_single_elem = false;
   this->m_datatype = dataType;
 }
+MemoryBuffer::MemoryBuffer(DataType datatype, bool is_a_single_elem)
+{
+  BLI_rcti_init(&this->m_rect, 0, 1, 0, 1);
+  this->m_width = 1;
+  this->m_height = 1;
+  this->m_memoryProxy = nullptr;
+  this->m_chunkNumber = -1;
+  this->m_num_channels = determine_num_channels(datatype);
+  this->m_buffer = (float *)MEM_mallocN_aligned(
+      sizeof(float) * this->m_num_channels, 16, "COM_MemoryBuffer");
+  this->m_state = COM_MB_TEMPORARILY;
+  this->m_datatype = datatype;
+  this->m_is_a_single_elem = is_a_single_elem;
+}
+
 MemoryBuffer *MemoryBuffer::duplicate()
 {
   MemoryBuffer *result = new MemoryBuffer(this->m_memoryProxy, &this->m_rect);
@@ -94,6 +94,12 @@ class MemoryBuffer {
   int m_width;
   int m_height;
 
+  /**
+   * \brief the buffer stores a single element used for every pixel of its area.
+   * Used by the full frame execution model for constant results.
+   */
+  bool m_is_a_single_elem;
+
  public:
   /**
    * \brief construct new MemoryBuffer for a chunk
@@ -110,6 +116,11 @@ class MemoryBuffer {
    */
   MemoryBuffer(DataType datatype, rcti *rect);
 
+  /**
+   * \brief construct a buffer holding a single element, see #is_a_single_elem
+   */
+  MemoryBuffer(DataType datatype, bool is_a_single_elem);
+
   /**
    * \brief destructor
    */
@@ -137,6 +148,35 @@ class MemoryBuffer {
     return this->m_buffer;
   }
 
+  bool is_a_single_elem() const
+  {
+    return this->m_is_a_single_elem;
+  }
+
+  /**
+   * \brief number of floats between two horizontally adjacent elements,
+   * zero for single element buffers so they can be iterated like full ones.
+   */
+  int elem_stride() const
+  {
+    return this->m_is_a_single_elem ? 0 : this->m_num_channels;
+  }
+
+  /**
+   * \brief get the element at the given coordinates, the single element for single element
+   * buffers.
+   */
+  float *get_elem(int x, int y)
+  {
+    if (this->m_is_a_single_elem) {
+      return this->m_buffer;
+    }
+    BLI_assert(x >= m_rect.xmin && x < m_rect.xmax && y >= m_rect.ymin && y < m_rect.ymax);
+    const int offset = (this->m_width * (y - m_rect.ymin) + (x - m_rect.xmin)) *
+                       this->m_num_channels;
+    return &this->m_buffer[offset];
+  }
+
   /**
    * \brief after execution the state will be set to available by calling this method
    */
@@ -0,0 +1,124 @@
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ * Copyright 2021, Blender Foundation.
+ */
+
+#include <algorithm>
+
+#include "COM_MemoryBufferCache.h"
+
+#include "BLI_vector.hh"
+
+MemoryBufferCache::MemoryBufferCache() : m_size(0), m_max_size(0), m_clock(0)
+{
+}
+
+MemoryBufferCache::~MemoryBufferCache()
+{
+  clear();
+}
+
+void MemoryBufferCache::set_max_size(size_t max_size)
+{
+  m_max_size = max_size;
+  free_unused(0);
+}
+
+MemoryBuffer *MemoryBufferCache::acquire(uint64_t hash)
+{
+  Entry *entry = m_entries.lookup_ptr(hash);
+  if (entry == nullptr) {
+    return nullptr;
+  }
+  entry->users++;
+  entry->last_used = ++m_clock;
+  return entry->buffer;
+}
+
+bool MemoryBufferCache::add(uint64_t hash, MemoryBuffer *buffer)
+{
+  if (m_entries.contains(hash)) {
+    /* Rendered by another operation of the same execution. */
+    return false;
+  }
+  const size_t size = sizeof(float) * buffer->get_num_channels() * buffer->getWidth() *
+                      buffer->getHeight();
+  if (!free_unused(size)) {
+    return false;
+  }
+
+  Entry entry;
+  entry.buffer = buffer;
+  entry.size = size;
+  entry.users = 1;
+  entry.last_used = ++m_clock;
+  m_entries.add_new(hash, entry);
+  m_size += size;
+  return true;
+}
+
+void MemoryBufferCache::release(uint64_t hash)
+{
+  Entry &entry = m_entries.lookup(hash);
+  BLI_assert(entry.users > 0);
+  entry.users--;
+}
+
+void MemoryBufferCache::clear()
+{
+  for (Entry &entry : m_entries.values()) {
+    BLI_assert(entry.users == 0);
+    delete entry.buffer;
+  }
+  m_entries.clear();
+  m_size = 0;
+}
+
+/**
+ * Free the least recently used results until \a required_size fits in the cache.
+ * Returns false when it doesn't fit, in which case nothing is freed.
+ */
+bool MemoryBufferCache::free_unused(size_t required_size)
+{
+  if (required_size > m_max_size) {
+    return false;
+  }
+
+  size_t unused_size = 0;
+  blender::Vector<uint64_t> unused;
+  for (auto item : m_entries.items()) {
+    if (item.value.users == 0) {
+      unused.append(item.key);
+      unused_size += item.value.size;
+    }
+  }
+  if (m_size - unused_size + required_size > m_max_size) {
+    return false;
+  }
+
+  std::sort(unused.begin(), unused.end(), [&](const uint64_t a, const uint64_t b) {
+    return m_entries.lookup(a).last_used < m_entries.lookup(b).last_used;
+  });
+  for (const uint64_t hash : unused) {
+    if (m_size + required_size <= m_max_size) {
+      break;
+    }
+    Entry entry = m_entries.pop(hash);
+    delete entry.buffer;
+    m_size -= entry.size;
+  }
+  return true;
+}
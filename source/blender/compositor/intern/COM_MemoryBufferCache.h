@@ -0,0 +1,74 @@
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ * Copyright 2021, Blender Foundation.
+ */
+
+#pragma once
+
+#include "BLI_map.hh"
+
+#include "COM_MemoryBuffer.h"
+
+/**
+ * \brief results of operations kept across executions of the compositor.
+ *
+ * Results are identified by the #OperationHash of the operation which rendered them, so editing
+ * a node only renders the operations depending on it again. Results used by the current
+ * execution are acquired, the least recently used of the others are freed to stay within the
+ * maximum size.
+ * \ingroup Memory
+ */
+class MemoryBufferCache {
+ private:
+  struct Entry {
+    MemoryBuffer *buffer;
+    size_t size;
+    /** Number of executions using the buffer, it can't be freed while used. */
+    int users;
+    uint64_t last_used;
+  };
+
+  blender::Map<uint64_t, Entry> m_entries;
+  size_t m_size;
+  size_t m_max_size;
+  uint64_t m_clock;
+
+ public:
+  MemoryBufferCache();
+  ~MemoryBufferCache();
+
+  /** Set the maximum size in bytes, freeing unused results exceeding it. */
+  void set_max_size(size_t max_size);
+
+  /** Get a result and mark it as used until #release, nullptr when it is not cached. */
+  MemoryBuffer *acquire(uint64_t hash);
+  /**
+   * Add a result used until #release. The cache owns the buffer when it returns true, it
+   * returns false when the buffer doesn't fit or the hash is already cached.
+   */
+  bool add(uint64_t hash, MemoryBuffer *buffer);
+  void release(uint64_t hash);
+
+  /** Free all results, none may be used. */
+  void clear();
+
+ private:
+  bool free_unused(size_t required_size);
+
+#ifdef WITH_CXX_GUARDEDALLOC
+  MEM_CXX_CLASS_ALLOC_FUNCS("COM:MemoryBufferCache")
+#endif
+};
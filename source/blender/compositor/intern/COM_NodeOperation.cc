@@ -36,6 +36,7 @@ NodeOperation::NodeOperation()
   this->m_height = 0;
   this->m_isResolutionSet = false;
   this->m_openCL = false;
+  this->m_full_frame = false;
   this->m_btree = nullptr;
 }
 
@@ -24,6 +24,7 @@
 
 #include "BLI_math_color.h"
 #include "BLI_math_vector.h"
+#include "BLI_span.hh"
 #include "BLI_threads.h"
 
 #include "COM_MemoryBuffer.h"
@@ -34,6 +35,7 @@
 #include "clew.h"
 
 class OpenCLDevice;
+class OperationHash;
 class ReadBufferOperation;
 class WriteBufferOperation;
 
@@ -98,6 +100,12 @@ class NodeOperation : public SocketReader {
    */
   bool m_openCL;
 
+  /**
+   * \brief can this operation render whole areas in the full frame execution model.
+   * \see update_memory_buffer_partial
+   */
+  bool m_full_frame;
+
   /**
    * \brief mutex reference for very special node initializations
    * \note only use when you really know what you are doing.
@@ -241,6 +249,45 @@ class NodeOperation : public SocketReader {
   }
   virtual void deinitExecution();
 
+  /**
+   * \brief render an area of the output buffer in the full frame execution model.
+   *
+   * Inputs are the rendered results of the input operations, with the resolution of their
+   * operation or a single element (see #MemoryBuffer.is_a_single_elem). When all inputs of an
+   * operation which is not complex are single elements, the output is a single element too and
+   * the area is the single element at (0, 0).
+   *
+   * Called from multiple threads at once for different areas, only used when
+   * #is_full_frame_operation is true.
+   * \ingroup execution
+   */
+  virtual void update_memory_buffer_partial(MemoryBuffer * /*output*/,
+                                            const rcti & /*area*/,
+                                            blender::Span<MemoryBuffer *> /*inputs*/)
+  {
+  }
+
+  /**
+   * \brief does this operation implement #update_memory_buffer_partial.
+   * Other operations are executed per pixel from buffers in the full frame execution model.
+   */
+  bool is_full_frame_operation() const
+  {
+    return this->m_full_frame;
+  }
+
+  /**
+   * \brief hash the parameters affecting the output of this operation.
+   *
+   * The type, resolution and inputs of the operation are hashed by the caller. Results of
+   * operations returning false are not cached, nor the results depending on them.
+   * \see MemoryBufferCache
+   */
+  virtual bool hash_output_params(OperationHash & /*hash*/)
+  {
+    return false;
+  }
+
   bool isResolutionSet()
   {
     return this->m_isResolutionSet;
@@ -416,6 +463,14 @@ class NodeOperation : public SocketReader {
     this->m_openCL = openCL;
   }
 
+  /**
+   * \brief set if this NodeOperation implements #update_memory_buffer_partial
+   */
+  void set_full_frame(bool full_frame)
+  {
+    this->m_full_frame = full_frame;
+  }
+
   /* allow the DebugInfo class to look at internals */
   friend class DebugInfo;
 
@@ -0,0 +1,95 @@
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ * Copyright 2021, Blender Foundation.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+
+#include "BLI_hash_mm2a.h"
+#include "BLI_math_base.h"
+#include "BLI_utildefines.h"
+
+#ifdef WITH_CXX_GUARDEDALLOC
+#  include "MEM_guardedalloc.h"
+#endif
+
+/**
+ * \brief accumulates everything affecting the result of an operation.
+ *
+ * Used to identify results of previous executions in the #MemoryBufferCache, see
+ * #NodeOperation.hash_output_params.
+ * \ingroup Model
+ */
+class OperationHash {
+ private:
+  static constexpr int IMAGE_SAMPLE_ROWS = 64;
+
+  uint64_t m_value;
+
+ public:
+  OperationHash() : m_value(0)
+  {
+  }
+
+  /** Hash raw memory, in 64 bits words (MurmurHash64A). */
+  void add_data(const void *data, size_t size)
+  {
+    m_value = BLI_hash_mm64a((const unsigned char *)data, size, m_value);
+  }
+
+  /**
+   * Hash a sparse sample of image pixels: at most #IMAGE_SAMPLE_ROWS evenly spaced rows,
+   * including the last one. A new render or a reloaded image changes most of the pixels, so it
+   * is detected without reading the whole buffer.
+   */
+  void add_image_sampled(const void *pixels, size_t row_size, int height)
+  {
+    add(height);
+    if (height <= 0) {
+      return;
+    }
+    const int step = max_ii(1, height / IMAGE_SAMPLE_ROWS);
+    for (int y = 0; y < height; y += step) {
+      add_data((const char *)pixels + row_size * y, row_size);
+    }
+    if ((height - 1) % step != 0) {
+      add_data((const char *)pixels + row_size * (height - 1), row_size);
+    }
+  }
+
+  /** Hash the bytes of a value, structs must not contain uninitialized padding. */
+  template<typename T> void add(const T &value)
+  {
+    add_data(&value, sizeof(T));
+  }
+
+  void add_string(const char *str)
+  {
+    add_data(str, strlen(str));
+  }
+
+  uint64_t value() const
+  {
+    return m_value;
+  }
+
+#ifdef WITH_CXX_GUARDEDALLOC
+  MEM_CXX_CLASS_ALLOC_FUNCS("COM:OperationHash")
+#endif
+};
@@ -29,6 +29,7 @@
 
 #include "MEM_guardedalloc.h"
 
+#include "BLI_task.h"
 #include "BLI_threads.h"
 #include "PIL_time.h"
 
@@ -390,5 +391,9 @@ void WorkScheduler::deinitialize()
 int WorkScheduler::current_thread_id()
 {
   CPUDevice *device = (CPUDevice *)BLI_thread_local_get(g_thread_device);
+  if (device == nullptr) {
+    /* Not executed by a compositor device, as done by the full frame execution model. */
+    return BLI_task_parallel_thread_id(nullptr);
+  }
   return device->thread_id();
 }
@@ -23,7 +23,10 @@
 #include "BKE_node.h"
 #include "BKE_scene.h"
 
+#include "DNA_userdef_types.h"
+
 #include "COM_ExecutionSystem.h"
+#include "COM_MemoryBufferCache.h"
 #include "COM_MovieDistortionOperation.h"
 #include "COM_WorkScheduler.h"
 #include "COM_compositor.h"
@@ -32,6 +35,8 @@
 static struct {
   bool is_initialized = false;
   ThreadMutex mutex;
+  /** Results kept across executions of the full frame execution model. */
+  MemoryBufferCache *buffer_cache = nullptr;
 } g_compositor;
 
 /* Make sure node tree has previews.
@@ -56,6 +61,22 @@ static void compositor_init_node_previews(const RenderData *render_data, bNodeTr
   BKE_node_preview_init_tree(node_tree, preview_width, preview_height, false);
 }
 
+static MemoryBufferCache *compositor_get_buffer_cache(const bNodeTree *node_tree)
+{
+  if (node_tree->execution_mode != NTREE_EXECUTION_MODE_FULL_FRAME) {
+    /* Only used by the full frame execution model, free the memory otherwise. */
+    delete g_compositor.buffer_cache;
+    g_compositor.buffer_cache = nullptr;
+    return nullptr;
+  }
+
+  if (g_compositor.buffer_cache == nullptr) {
+    g_compositor.buffer_cache = new MemoryBufferCache();
+  }
+  g_compositor.buffer_cache->set_max_size((size_t)U.compositor_cache_limit * 1024 * 1024);
+  return g_compositor.buffer_cache;
+}
+
 static void compositor_reset_node_tree_status(bNodeTree *node_tree)
 {
   node_tree->progress(node_tree->prh, 0.0);
@@ -94,11 +115,20 @@ void COM_execute(RenderData *render_data,
   const bool use_opencl = (node_tree->flag & NTREE_COM_OPENCL) != 0;
   WorkScheduler::initialize(use_opencl, BKE_render_num_threads(render_data));
 
+  MemoryBufferCache *buffer_cache = compositor_get_buffer_cache(node_tree);
+
   /* Execute. */
   const bool twopass = (node_tree->flag & NTREE_TWO_PASS) && !rendering;
   if (twopass) {
-    ExecutionSystem fast_pass(
-        render_data, scene, node_tree, rendering, true, viewSettings, displaySettings, viewName);
+    ExecutionSystem fast_pass(render_data,
+                              scene,
+                              node_tree,
+                              rendering,
+                              true,
+                              viewSettings,
+                              displaySettings,
+                              viewName,
+                              buffer_cache);
     fast_pass.execute();
 
     if (node_tree->test_break(node_tree->tbh)) {
@@ -107,8 +137,15 @@ void COM_execute(RenderData *render_data,
     }
   }
 
-  ExecutionSystem system(
-      render_data, scene, node_tree, rendering, false, viewSettings, displaySettings, viewName);
+  ExecutionSystem system(render_data,
+                         scene,
+                         node_tree,
+                         rendering,
+                         false,
+                         viewSettings,
+                         displaySettings,
+                         viewName,
+                         buffer_cache);
   system.execute();
 
   BLI_mutex_unlock(&g_compositor.mutex);
@@ -119,6 +156,8 @@ void COM_deinitialize()
   if (g_compositor.is_initialized) {
     BLI_mutex_lock(&g_compositor.mutex);
     WorkScheduler::deinitialize();
+    delete g_compositor.buffer_cache;
+    g_compositor.buffer_cache = nullptr;
     g_compositor.is_initialized = false;
     BLI_mutex_unlock(&g_compositor.mutex);
     BLI_mutex_end(&g_compositor.mutex);
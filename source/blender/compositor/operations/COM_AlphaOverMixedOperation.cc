@@ -17,6 +17,7 @@
  */
 
 #include "COM_AlphaOverMixedOperation.h"
+#include "COM_OperationHash.h"
 
 AlphaOverMixedOperation::AlphaOverMixedOperation()
 {
@@ -53,3 +54,10 @@ void AlphaOverMixedOperation::executePixelSampled(float output[4],
     output[3] = (mul * inputColor1[3]) + value[0] * inputOverColor[3];
   }
 }
+
+bool AlphaOverMixedOperation::hash_output_params(OperationHash &hash)
+{
+  MixBaseOperation::hash_output_params(hash);
+  hash.add(this->m_x);
+  return true;
+}
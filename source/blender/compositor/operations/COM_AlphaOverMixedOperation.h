@@ -39,6 +39,8 @@ class AlphaOverMixedOperation : public MixBaseOperation {
    */
   void executePixelSampled(float output[4], float x, float y, PixelSampler sampler);
 
+  bool hash_output_params(OperationHash &hash);
+
   void setX(float x)
   {
     this->m_x = x;
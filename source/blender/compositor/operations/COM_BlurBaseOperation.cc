@@ -17,6 +17,7 @@
  */
 
 #include "COM_BlurBaseOperation.h"
+#include "COM_OperationHash.h"
 #include "BLI_math.h"
 #include "MEM_guardedalloc.h"
 
@@ -163,6 +164,15 @@ void BlurBaseOperation::setData(const NodeBlurData *data)
   memcpy(&m_data, data, sizeof(NodeBlurData));
 }
 
+bool BlurBaseOperation::hash_output_params(OperationHash &hash)
+{
+  hash.add(this->m_data);
+  hash.add(this->m_size);
+  hash.add(this->m_sizeavailable);
+  hash.add(this->m_extend_bounds);
+  return true;
+}
+
 void BlurBaseOperation::updateSize()
 {
   if (!this->m_sizeavailable) {
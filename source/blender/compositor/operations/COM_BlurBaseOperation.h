@@ -62,6 +62,8 @@ class BlurBaseOperation : public NodeOperation, public QualityStepHelper {
 
   void setData(const NodeBlurData *data);
 
+  bool hash_output_params(OperationHash &hash);
+
   void setSize(float size)
   {
     this->m_size = size;
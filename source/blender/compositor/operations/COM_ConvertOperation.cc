@@ -17,6 +17,7 @@
  */
 
 #include "COM_ConvertOperation.h"
+#include "COM_OperationHash.h"
 
 #include "IMB_colormanagement.h"
 
@@ -35,12 +36,41 @@ void ConvertBaseOperation::deinitExecution()
   this->m_inputOperation = nullptr;
 }
 
+bool ConvertBaseOperation::hash_output_params(OperationHash & /*hash*/)
+{
+  /* Conversions only depend on their type and input. */
+  return true;
+}
+
+void ConvertBaseOperation::update_memory_buffer_partial(MemoryBuffer *output,
+                                                        const rcti &area,
+                                                        blender::Span<MemoryBuffer *> inputs)
+{
+  MemoryBuffer *input = inputs[0];
+  const int width = BLI_rcti_size_x(&area);
+  for (int y = area.ymin; y < area.ymax; y++) {
+    this->update_memory_buffer_row(output->get_elem(area.xmin, y),
+                                   input->get_elem(area.xmin, y),
+                                   input->elem_stride(),
+                                   width);
+  }
+}
+
+void ConvertBaseOperation::update_memory_buffer_row(float * /*out*/,
+                                                    const float * /*in*/,
+                                                    int /*in_stride*/,
+                                                    int /*width*/)
+{
+  BLI_assert(!"Conversion is not a full frame operation");
+}
+
 /* ******** Value to Color ******** */
 
 ConvertValueToColorOperation::ConvertValueToColorOperation() : ConvertBaseOperation()
 {
   this->addInputSocket(COM_DT_VALUE);
   this->addOutputSocket(COM_DT_COLOR);
+  this->set_full_frame(true);
 }
 
 void ConvertValueToColorOperation::executePixelSampled(float output[4],
@@ -54,12 +84,24 @@ void ConvertValueToColorOperation::executePixelSampled(float output[4],
   output[3] = 1.0f;
 }
 
+void ConvertValueToColorOperation::update_memory_buffer_row(float *out,
+                                                            const float *in,
+                                                            const int in_stride,
+                                                            const int width)
+{
+  for (int i = 0; i < width; i++, in += in_stride, out += 4) {
+    out[0] = out[1] = out[2] = in[0];
+    out[3] = 1.0f;
+  }
+}
+
 /* ******** Color to Value ******** */
 
 ConvertColorToValueOperation::ConvertColorToValueOperation() : ConvertBaseOperation()
 {
   this->addInputSocket(COM_DT_COLOR);
   this->addOutputSocket(COM_DT_VALUE);
+  this->set_full_frame(true);
 }
 
 void ConvertColorToValueOperation::executePixelSampled(float output[4],
@@ -72,12 +114,23 @@ void ConvertColorToValueOperation::executePixelSampled(float output[4],
   output[0] = (inputColor[0] + inputColor[1] + inputColor[2]) / 3.0f;
 }
 
+void ConvertColorToValueOperation::update_memory_buffer_row(float *out,
+                                                            const float *in,
+                                                            const int in_stride,
+                                                            const int width)
+{
+  for (int i = 0; i < width; i++, in += in_stride, out += 1) {
+    out[0] = (in[0] + in[1] + in[2]) / 3.0f;
+  }
+}
+
 /* ******** Color to BW ******** */
 
 ConvertColorToBWOperation::ConvertColorToBWOperation() : ConvertBaseOperation()
 {
   this->addInputSocket(COM_DT_COLOR);
   this->addOutputSocket(COM_DT_VALUE);
+  this->set_full_frame(true);
 }
 
 void ConvertColorToBWOperation::executePixelSampled(float output[4],
@@ -90,12 +143,23 @@ void ConvertColorToBWOperation::executePixelSampled(float output[4],
   output[0] = IMB_colormanagement_get_luminance(inputColor);
 }
 
+void ConvertColorToBWOperation::update_memory_buffer_row(float *out,
+                                                         const float *in,
+                                                         const int in_stride,
+                                                         const int width)
+{
+  for (int i = 0; i < width; i++, in += in_stride, out += 1) {
+    out[0] = IMB_colormanagement_get_luminance(in);
+  }
+}
+
 /* ******** Color to Vector ******** */
 
 ConvertColorToVectorOperation::ConvertColorToVectorOperation() : ConvertBaseOperation()
 {
   this->addInputSocket(COM_DT_COLOR);
   this->addOutputSocket(COM_DT_VECTOR);
+  this->set_full_frame(true);
 }
 
 void ConvertColorToVectorOperation::executePixelSampled(float output[4],
@@ -108,12 +172,23 @@ void ConvertColorToVectorOperation::executePixelSampled(float output[4],
   copy_v3_v3(output, color);
 }
 
+void ConvertColorToVectorOperation::update_memory_buffer_row(float *out,
+                                                             const float *in,
+                                                             const int in_stride,
+                                                             const int width)
+{
+  for (int i = 0; i < width; i++, in += in_stride, out += 3) {
+    copy_v3_v3(out, in);
+  }
+}
+
 /* ******** Value to Vector ******** */
 
 ConvertValueToVectorOperation::ConvertValueToVectorOperation() : ConvertBaseOperation()
 {
   this->addInputSocket(COM_DT_VALUE);
   this->addOutputSocket(COM_DT_VECTOR);
+  this->set_full_frame(true);
 }
 
 void ConvertValueToVectorOperation::executePixelSampled(float output[4],
@@ -126,12 +201,23 @@ void ConvertValueToVectorOperation::executePixelSampled(float output[4],
   output[0] = output[1] = output[2] = value;
 }
 
+void ConvertValueToVectorOperation::update_memory_buffer_row(float *out,
+                                                             const float *in,
+                                                             const int in_stride,
+                                                             const int width)
+{
+  for (int i = 0; i < width; i++, in += in_stride, out += 3) {
+    out[0] = out[1] = out[2] = in[0];
+  }
+}
+
 /* ******** Vector to Color ******** */
 
 ConvertVectorToColorOperation::ConvertVectorToColorOperation() : ConvertBaseOperation()
 {
   this->addInputSocket(COM_DT_VECTOR);
   this->addOutputSocket(COM_DT_COLOR);
+  this->set_full_frame(true);
 }
 
 void ConvertVectorToColorOperation::executePixelSampled(float output[4],
@@ -143,12 +229,24 @@ void ConvertVectorToColorOperation::executePixelSampled(float output[4],
   output[3] = 1.0f;
 }
 
+void ConvertVectorToColorOperation::update_memory_buffer_row(float *out,
+                                                             const float *in,
+                                                             const int in_stride,
+                                                             const int width)
+{
+  for (int i = 0; i < width; i++, in += in_stride, out += 4) {
+    copy_v3_v3(out, in);
+    out[3] = 1.0f;
+  }
+}
+
 /* ******** Vector to Value ******** */
 
 ConvertVectorToValueOperation::ConvertVectorToValueOperation() : ConvertBaseOperation()
 {
   this->addInputSocket(COM_DT_VECTOR);
   this->addOutputSocket(COM_DT_VALUE);
+  this->set_full_frame(true);
 }
 
 void ConvertVectorToValueOperation::executePixelSampled(float output[4],
@@ -161,6 +259,16 @@ void ConvertVectorToValueOperation::executePixelSampled(float output[4],
   output[0] = (input[0] + input[1] + input[2]) / 3.0f;
 }
 
+void ConvertVectorToValueOperation::update_memory_buffer_row(float *out,
+                                                             const float *in,
+                                                             const int in_stride,
+                                                             const int width)
+{
+  for (int i = 0; i < width; i++, in += in_stride, out += 1) {
+    out[0] = (in[0] + in[1] + in[2]) / 3.0f;
+  }
+}
+
 /* ******** RGB to YCC ******** */
 
 ConvertRGBToYCCOperation::ConvertRGBToYCCOperation() : ConvertBaseOperation()
@@ -203,6 +311,12 @@ void ConvertRGBToYCCOperation::executePixelSampled(float output[4],
   output[3] = inputColor[3];
 }
 
+bool ConvertRGBToYCCOperation::hash_output_params(OperationHash &hash)
+{
+  hash.add(this->m_mode);
+  return true;
+}
+
 /* ******** YCC to RGB ******** */
 
 ConvertYCCToRGBOperation::ConvertYCCToRGBOperation() : ConvertBaseOperation()
@@ -249,6 +363,12 @@ void ConvertYCCToRGBOperation::executePixelSampled(float output[4],
   output[3] = inputColor[3];
 }
 
+bool ConvertYCCToRGBOperation::hash_output_params(OperationHash &hash)
+{
+  hash.add(this->m_mode);
+  return true;
+}
+
 /* ******** RGB to YUV ******** */
 
 ConvertRGBToYUVOperation::ConvertRGBToYUVOperation() : ConvertBaseOperation()
@@ -423,6 +543,12 @@ void SeparateChannelOperation::executePixelSampled(float output[4],
   output[0] = input[this->m_channel];
 }
 
+bool SeparateChannelOperation::hash_output_params(OperationHash &hash)
+{
+  hash.add(this->m_channel);
+  return true;
+}
+
 /* ******** Combine Channels ******** */
 
 CombineChannelsOperation::CombineChannelsOperation()
@@ -478,3 +604,8 @@ void CombineChannelsOperation::executePixelSampled(float output[4],
     output[3] = input[0];
   }
 }
+
+bool CombineChannelsOperation::hash_output_params(OperationHash & /*hash*/)
+{
+  return true;
+}
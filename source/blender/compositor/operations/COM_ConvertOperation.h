@@ -29,6 +29,22 @@ class ConvertBaseOperation : public NodeOperation {
 
   void initExecution();
   void deinitExecution();
+
+  bool hash_output_params(OperationHash &hash);
+
+  void update_memory_buffer_partial(MemoryBuffer *output,
+                                    const rcti &area,
+                                    blender::Span<MemoryBuffer *> inputs);
+
+ protected:
+  /**
+   * Convert a row of \a width elements for the full frame execution model. \a in_stride is 0
+   * when the input is a single element. Only called by conversions calling #set_full_frame.
+   */
+  virtual void update_memory_buffer_row(float *out,
+                                        const float *in,
+                                        int in_stride,
+                                        int width);
 };
 
 class ConvertValueToColorOperation : public ConvertBaseOperation {
@@ -36,6 +52,9 @@ class ConvertValueToColorOperation : public ConvertBaseOperation {
   ConvertValueToColorOperation();
 
   void executePixelSampled(float output[4], float x, float y, PixelSampler sampler);
+
+ protected:
+  void update_memory_buffer_row(float *out, const float *in, int in_stride, int width);
 };
 
 class ConvertColorToValueOperation : public ConvertBaseOperation {
@@ -43,6 +62,9 @@ class ConvertColorToValueOperation : public ConvertBaseOperation {
   ConvertColorToValueOperation();
 
   void executePixelSampled(float output[4], float x, float y, PixelSampler sampler);
+
+ protected:
+  void update_memory_buffer_row(float *out, const float *in, int in_stride, int width);
 };
 
 class ConvertColorToBWOperation : public ConvertBaseOperation {
@@ -50,6 +72,9 @@ class ConvertColorToBWOperation : public ConvertBaseOperation {
   ConvertColorToBWOperation();
 
   void executePixelSampled(float output[4], float x, float y, PixelSampler sampler);
+
+ protected:
+  void update_memory_buffer_row(float *out, const float *in, int in_stride, int width);
 };
 
 class ConvertColorToVectorOperation : public ConvertBaseOperation {
@@ -57,6 +82,9 @@ class ConvertColorToVectorOperation : public ConvertBaseOperation {
   ConvertColorToVectorOperation();
 
   void executePixelSampled(float output[4], float x, float y, PixelSampler sampler);
+
+ protected:
+  void update_memory_buffer_row(float *out, const float *in, int in_stride, int width);
 };
 
 class ConvertValueToVectorOperation : public ConvertBaseOperation {
@@ -64,6 +92,9 @@ class ConvertValueToVectorOperation : public ConvertBaseOperation {
   ConvertValueToVectorOperation();
 
   void executePixelSampled(float output[4], float x, float y, PixelSampler sampler);
+
+ protected:
+  void update_memory_buffer_row(float *out, const float *in, int in_stride, int width);
 };
 
 class ConvertVectorToColorOperation : public ConvertBaseOperation {
@@ -71,6 +102,9 @@ class ConvertVectorToColorOperation : public ConvertBaseOperation {
   ConvertVectorToColorOperation();
 
   void executePixelSampled(float output[4], float x, float y, PixelSampler sampler);
+
+ protected:
+  void update_memory_buffer_row(float *out, const float *in, int in_stride, int width);
 };
 
 class ConvertVectorToValueOperation : public ConvertBaseOperation {
@@ -78,6 +112,9 @@ class ConvertVectorToValueOperation : public ConvertBaseOperation {
   ConvertVectorToValueOperation();
 
   void executePixelSampled(float output[4], float x, float y, PixelSampler sampler);
+
+ protected:
+  void update_memory_buffer_row(float *out, const float *in, int in_stride, int width);
 };
 
 class ConvertRGBToYCCOperation : public ConvertBaseOperation {
@@ -89,6 +126,7 @@ class ConvertRGBToYCCOperation : public ConvertBaseOperation {
   ConvertRGBToYCCOperation();
 
   void executePixelSampled(float output[4], float x, float y, PixelSampler sampler);
+  bool hash_output_params(OperationHash &hash);
 
   /** Set the YCC mode */
   void setMode(int mode);
@@ -103,6 +141,7 @@ class ConvertYCCToRGBOperation : public ConvertBaseOperation {
   ConvertYCCToRGBOperation();
 
   void executePixelSampled(float output[4], float x, float y, PixelSampler sampler);
+  bool hash_output_params(OperationHash &hash);
 
   /** Set the YCC mode */
   void setMode(int mode);
@@ -158,6 +197,7 @@ class SeparateChannelOperation : public NodeOperation {
  public:
   SeparateChannelOperation();
   void executePixelSampled(float output[4], float x, float y, PixelSampler sampler);
+  bool hash_output_params(OperationHash &hash);
 
   void initExecution();
   void deinitExecution();
@@ -178,6 +218,7 @@ class CombineChannelsOperation : public NodeOperation {
  public:
   CombineChannelsOperation();
   void executePixelSampled(float output[4], float x, float y, PixelSampler sampler);
+  bool hash_output_params(OperationHash &hash);
 
   void initExecution();
   void deinitExecution();
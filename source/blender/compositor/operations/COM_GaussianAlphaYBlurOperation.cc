@@ -17,6 +17,7 @@
  */
 
 #include "COM_GaussianAlphaYBlurOperation.h"
+#include "COM_OperationHash.h"
 #include "BLI_math.h"
 #include "MEM_guardedalloc.h"
 
@@ -40,6 +41,14 @@ void *GaussianAlphaYBlurOperation::initializeTileData(rcti * /*rect*/)
   return buffer;
 }
 
+bool GaussianAlphaYBlurOperation::hash_output_params(OperationHash &hash)
+{
+  BlurBaseOperation::hash_output_params(hash);
+  hash.add(this->m_falloff);
+  hash.add(this->m_do_subtract);
+  return true;
+}
+
 void GaussianAlphaYBlurOperation::initExecution()
 {
   /* Until we support size input - comment this. */
@@ -49,6 +49,7 @@ class GaussianAlphaYBlurOperation : public BlurBaseOperation {
   void deinitExecution();
 
   void *initializeTileData(rcti *rect);
+  bool hash_output_params(OperationHash &hash);
   bool determineDependingAreaOfInterest(rcti *input,
                                         ReadBufferOperation *readOperation,
                                         rcti *output);
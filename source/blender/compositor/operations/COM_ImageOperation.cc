@@ -17,6 +17,7 @@
  */
 
 #include "COM_ImageOperation.h"
+#include "COM_OperationHash.h"
 
 #include "BKE_image.h"
 #include "BKE_scene.h"
@@ -102,6 +103,34 @@ void BaseImageOperation::deinitExecution()
   BKE_image_release_ibuf(this->m_image, this->m_buffer, nullptr);
 }
 
+/**
+ * Hash the pixels of the image buffer, so changes of the image or its settings causing the
+ * buffer to be loaded again are detected.
+ */
+bool BaseImageOperation::hash_output_params(OperationHash &hash)
+{
+  ImBuf *ibuf = getImBuf();
+  if (ibuf == nullptr) {
+    return true;
+  }
+
+  hash.add(ibuf->x);
+  hash.add(ibuf->y);
+  hash.add(ibuf->channels);
+  hash.add(ibuf->rect_colorspace);
+  if (ibuf->rect_float) {
+    hash.add_image_sampled(ibuf->rect_float, sizeof(float) * ibuf->channels * ibuf->x, ibuf->y);
+  }
+  if (ibuf->rect) {
+    hash.add_image_sampled(ibuf->rect, sizeof(unsigned int) * ibuf->x, ibuf->y);
+  }
+  if (ibuf->zbuf_float) {
+    hash.add_image_sampled(ibuf->zbuf_float, sizeof(float) * ibuf->x, ibuf->y);
+  }
+  BKE_image_release_ibuf(this->m_image, ibuf, nullptr);
+  return true;
+}
+
 void BaseImageOperation::determineResolution(unsigned int resolution[2],
                                              unsigned int /*preferredResolution*/[2])
 {
@@ -56,6 +56,7 @@ class BaseImageOperation : public NodeOperation {
  public:
   void initExecution();
   void deinitExecution();
+  bool hash_output_params(OperationHash &hash);
   void setImage(Image *image)
   {
     this->m_image = image;
@@ -17,6 +17,7 @@
  */
 
 #include "COM_MathBaseOperation.h"
+#include "COM_OperationHash.h"
 
 #include "BLI_math.h"
 
@@ -71,6 +72,39 @@ void MathBaseOperation::clampIfNeeded(float *color)
   }
 }
 
+bool MathBaseOperation::hash_output_params(OperationHash &hash)
+{
+  hash.add(this->m_useClamp);
+  return true;
+}
+
+void MathBaseOperation::update_memory_buffer_partial(MemoryBuffer *output,
+                                                     const rcti &area,
+                                                     blender::Span<MemoryBuffer *> inputs)
+{
+  MemoryBuffer *input1 = inputs[0];
+  MemoryBuffer *input2 = inputs[1];
+  const int width = BLI_rcti_size_x(&area);
+  for (int y = area.ymin; y < area.ymax; y++) {
+    this->update_memory_buffer_row(output->get_elem(area.xmin, y),
+                                   input1->get_elem(area.xmin, y),
+                                   input2->get_elem(area.xmin, y),
+                                   input1->elem_stride(),
+                                   input2->elem_stride(),
+                                   width);
+  }
+}
+
+void MathBaseOperation::update_memory_buffer_row(float * /*out*/,
+                                                 const float * /*in1*/,
+                                                 const float * /*in2*/,
+                                                 int /*in1_stride*/,
+                                                 int /*in2_stride*/,
+                                                 int /*width*/)
+{
+  BLI_assert(!"Math operation is not a full frame operation");
+}
+
 void MathAddOperation::executePixelSampled(float output[4], float x, float y, PixelSampler sampler)
 {
   float inputValue1[4];
@@ -84,6 +118,19 @@ void MathAddOperation::executePixelSampled(float output[4], float x, float y, Pi
   clampIfNeeded(output);
 }
 
+void MathAddOperation::update_memory_buffer_row(float *out,
+                                                const float *in1,
+                                                const float *in2,
+                                                const int in1_stride,
+                                                const int in2_stride,
+                                                const int width)
+{
+  for (int i = 0; i < width; i++, out++, in1 += in1_stride, in2 += in2_stride) {
+    out[0] = in1[0] + in2[0];
+    clampIfNeeded(out);
+  }
+}
+
 void MathSubtractOperation::executePixelSampled(float output[4],
                                                 float x,
                                                 float y,
@@ -100,6 +147,19 @@ void MathSubtractOperation::executePixelSampled(float output[4],
   clampIfNeeded(output);
 }
 
+void MathSubtractOperation::update_memory_buffer_row(float *out,
+                                                     const float *in1,
+                                                     const float *in2,
+                                                     const int in1_stride,
+                                                     const int in2_stride,
+                                                     const int width)
+{
+  for (int i = 0; i < width; i++, out++, in1 += in1_stride, in2 += in2_stride) {
+    out[0] = in1[0] - in2[0];
+    clampIfNeeded(out);
+  }
+}
+
 void MathMultiplyOperation::executePixelSampled(float output[4],
                                                 float x,
                                                 float y,
@@ -116,6 +176,19 @@ void MathMultiplyOperation::executePixelSampled(float output[4],
   clampIfNeeded(output);
 }
 
+void MathMultiplyOperation::update_memory_buffer_row(float *out,
+                                                     const float *in1,
+                                                     const float *in2,
+                                                     const int in1_stride,
+                                                     const int in2_stride,
+                                                     const int width)
+{
+  for (int i = 0; i < width; i++, out++, in1 += in1_stride, in2 += in2_stride) {
+    out[0] = in1[0] * in2[0];
+    clampIfNeeded(out);
+  }
+}
+
 void MathDivideOperation::executePixelSampled(float output[4],
                                               float x,
                                               float y,
@@ -43,6 +43,17 @@ class MathBaseOperation : public NodeOperation {
 
   void clampIfNeeded(float color[4]);
 
+  /**
+   * Compute a row of \a width elements for the full frame execution model, strides are 0 for
+   * inputs which are a single element. Only called by math operations calling #set_full_frame.
+   */
+  virtual void update_memory_buffer_row(float *out,
+                                        const float *in1,
+                                        const float *in2,
+                                        int in1_stride,
+                                        int in2_stride,
+                                        int width);
+
  public:
   /**
    * The inner loop of this operation.
@@ -64,6 +75,12 @@ class MathBaseOperation : public NodeOperation {
    */
   void determineResolution(unsigned int resolution[2], unsigned int preferredResolution[2]);
 
+  bool hash_output_params(OperationHash &hash);
+
+  void update_memory_buffer_partial(MemoryBuffer *output,
+                                    const rcti &area,
+                                    blender::Span<MemoryBuffer *> inputs);
+
   void setUseClamp(bool value)
   {
     this->m_useClamp = value;
@@ -74,22 +91,49 @@ class MathAddOperation : public MathBaseOperation {
  public:
   MathAddOperation() : MathBaseOperation()
   {
+    this->set_full_frame(true);
   }
   void executePixelSampled(float output[4], float x, float y, PixelSampler sampler);
+
+ protected:
+  void update_memory_buffer_row(float *out,
+                                const float *in1,
+                                const float *in2,
+                                int in1_stride,
+                                int in2_stride,
+                                int width);
 };
 class MathSubtractOperation : public MathBaseOperation {
  public:
   MathSubtractOperation() : MathBaseOperation()
   {
+    this->set_full_frame(true);
   }
   void executePixelSampled(float output[4], float x, float y, PixelSampler sampler);
+
+ protected:
+  void update_memory_buffer_row(float *out,
+                                const float *in1,
+                                const float *in2,
+                                int in1_stride,
+                                int in2_stride,
+                                int width);
 };
 class MathMultiplyOperation : public MathBaseOperation {
  public:
   MathMultiplyOperation() : MathBaseOperation()
   {
+    this->set_full_frame(true);
   }
   void executePixelSampled(float output[4], float x, float y, PixelSampler sampler);
+
+ protected:
+  void update_memory_buffer_row(float *out,
+                                const float *in1,
+                                const float *in2,
+                                int in1_stride,
+                                int in2_stride,
+                                int width);
 };
 class MathDivideOperation : public MathBaseOperation {
  public:
@@ -17,6 +17,7 @@
  */
 
 #include "COM_MixOperation.h"
+#include "COM_OperationHash.h"
 
 #include "BLI_math.h"
 
@@ -95,11 +96,44 @@ void MixBaseOperation::deinitExecution()
   this->m_inputColor2Operation = nullptr;
 }
 
+bool MixBaseOperation::hash_output_params(OperationHash &hash)
+{
+  hash.add(this->m_valueAlphaMultiply);
+  hash.add(this->m_useClamp);
+  return true;
+}
+
+void MixBaseOperation::update_memory_buffer_partial(MemoryBuffer *output,
+                                                    const rcti &area,
+                                                    blender::Span<MemoryBuffer *> inputs)
+{
+  MemoryBuffer *input_value = inputs[0];
+  MemoryBuffer *input_color1 = inputs[1];
+  MemoryBuffer *input_color2 = inputs[2];
+  const int width = BLI_rcti_size_x(&area);
+  PixelCursor p;
+  p.value_stride = input_value->elem_stride();
+  p.color1_stride = input_color1->elem_stride();
+  p.color2_stride = input_color2->elem_stride();
+  for (int y = area.ymin; y < area.ymax; y++) {
+    p.out = output->get_elem(area.xmin, y);
+    p.value = input_value->get_elem(area.xmin, y);
+    p.color1 = input_color1->get_elem(area.xmin, y);
+    p.color2 = input_color2->get_elem(area.xmin, y);
+    this->update_memory_buffer_row(p, width);
+  }
+}
+
+void MixBaseOperation::update_memory_buffer_row(PixelCursor & /*p*/, int /*width*/)
+{
+  BLI_assert(!"Mix operation is not a full frame operation");
+}
+
 /* ******** Mix Add Operation ******** */
 
 MixAddOperation::MixAddOperation()
 {
-  /* pass */
+  this->set_full_frame(true);
 }
 
 void MixAddOperation::executePixelSampled(float output[4], float x, float y, PixelSampler sampler)
@@ -124,11 +158,27 @@ void MixAddOperation::executePixelSampled(float output[4], float x, float y, Pix
   clampIfNeeded(output);
 }
 
+void MixAddOperation::update_memory_buffer_row(PixelCursor &p, const int width)
+{
+  for (int i = 0; i < width; i++, p.next()) {
+    float value = p.value[0];
+    if (this->useValueAlphaMultiply()) {
+      value *= p.color2[3];
+    }
+    p.out[0] = p.color1[0] + value * p.color2[0];
+    p.out[1] = p.color1[1] + value * p.color2[1];
+    p.out[2] = p.color1[2] + value * p.color2[2];
+    p.out[3] = p.color1[3];
+
+    clampIfNeeded(p.out);
+  }
+}
+
 /* ******** Mix Blend Operation ******** */
 
 MixBlendOperation::MixBlendOperation()
 {
-  /* pass */
+  this->set_full_frame(true);
 }
 
 void MixBlendOperation::executePixelSampled(float output[4],
@@ -158,6 +208,23 @@ void MixBlendOperation::executePixelSampled(float output[4],
   clampIfNeeded(output);
 }
 
+void MixBlendOperation::update_memory_buffer_row(PixelCursor &p, const int width)
+{
+  for (int i = 0; i < width; i++, p.next()) {
+    float value = p.value[0];
+    if (this->useValueAlphaMultiply()) {
+      value *= p.color2[3];
+    }
+    const float value_m = 1.0f - value;
+    p.out[0] = value_m * p.color1[0] + value * p.color2[0];
+    p.out[1] = value_m * p.color1[1] + value * p.color2[1];
+    p.out[2] = value_m * p.color1[2] + value * p.color2[2];
+    p.out[3] = p.color1[3];
+
+    clampIfNeeded(p.out);
+  }
+}
+
 /* ******** Mix Burn Operation ******** */
 
 MixColorBurnOperation::MixColorBurnOperation()
@@ -676,7 +743,7 @@ void MixLinearLightOperation::executePixelSampled(float output[4],
 
 MixMultiplyOperation::MixMultiplyOperation()
 {
-  /* pass */
+  this->set_full_frame(true);
 }
 
 void MixMultiplyOperation::executePixelSampled(float output[4],
@@ -705,6 +772,23 @@ void MixMultiplyOperation::executePixelSampled(float output[4],
   clampIfNeeded(output);
 }
 
+void MixMultiplyOperation::update_memory_buffer_row(PixelCursor &p, const int width)
+{
+  for (int i = 0; i < width; i++, p.next()) {
+    float value = p.value[0];
+    if (this->useValueAlphaMultiply()) {
+      value *= p.color2[3];
+    }
+    const float value_m = 1.0f - value;
+    p.out[0] = p.color1[0] * (value_m + value * p.color2[0]);
+    p.out[1] = p.color1[1] * (value_m + value * p.color2[1]);
+    p.out[2] = p.color1[2] * (value_m + value * p.color2[2]);
+    p.out[3] = p.color1[3];
+
+    clampIfNeeded(p.out);
+  }
+}
+
 /* ******** Mix Overlay Operation ******** */
 
 MixOverlayOperation::MixOverlayOperation()
@@ -881,7 +965,7 @@ void MixSoftLightOperation::executePixelSampled(float output[4],
 
 MixSubtractOperation::MixSubtractOperation()
 {
-  /* pass */
+  this->set_full_frame(true);
 }
 
 void MixSubtractOperation::executePixelSampled(float output[4],
@@ -909,6 +993,22 @@ void MixSubtractOperation::executePixelSampled(float output[4],
   clampIfNeeded(output);
 }
 
+void MixSubtractOperation::update_memory_buffer_row(PixelCursor &p, const int width)
+{
+  for (int i = 0; i < width; i++, p.next()) {
+    float value = p.value[0];
+    if (this->useValueAlphaMultiply()) {
+      value *= p.color2[3];
+    }
+    p.out[0] = p.color1[0] - value * p.color2[0];
+    p.out[1] = p.color1[1] - value * p.color2[1];
+    p.out[2] = p.color1[2] - value * p.color2[2];
+    p.out[3] = p.color1[3];
+
+    clampIfNeeded(p.out);
+  }
+}
+
 /* ******** Mix Value Operation ******** */
 
 MixValueOperation::MixValueOperation()
@@ -43,6 +43,34 @@ class MixBaseOperation : public NodeOperation {
     }
   }
 
+  /**
+   * Elements of the output and inputs in a row, strides are 0 for inputs which are a single
+   * element.
+   */
+  struct PixelCursor {
+    float *out;
+    const float *value;
+    const float *color1;
+    const float *color2;
+    int value_stride;
+    int color1_stride;
+    int color2_stride;
+
+    inline void next()
+    {
+      out += 4;
+      value += value_stride;
+      color1 += color1_stride;
+      color2 += color2_stride;
+    }
+  };
+
+  /**
+   * Mix a row of \a width elements for the full frame execution model. Only called by mix
+   * operations calling #set_full_frame.
+   */
+  virtual void update_memory_buffer_row(PixelCursor &p, int width);
+
  public:
   /**
    * Default constructor
@@ -66,6 +94,12 @@ class MixBaseOperation : public NodeOperation {
 
   void determineResolution(unsigned int resolution[2], unsigned int preferredResolution[2]);
 
+  bool hash_output_params(OperationHash &hash);
+
+  void update_memory_buffer_partial(MemoryBuffer *output,
+                                    const rcti &area,
+                                    blender::Span<MemoryBuffer *> inputs);
+
   void setUseValueAlphaMultiply(const bool value)
   {
     this->m_valueAlphaMultiply = value;
@@ -84,12 +118,18 @@ class MixAddOperation : public MixBaseOperation {
  public:
   MixAddOperation();
   void executePixelSampled(float output[4], float x, float y, PixelSampler sampler);
+
+ protected:
+  void update_memory_buffer_row(PixelCursor &p, int width);
 };
 
 class MixBlendOperation : public MixBaseOperation {
  public:
   MixBlendOperation();
   void executePixelSampled(float output[4], float x, float y, PixelSampler sampler);
+
+ protected:
+  void update_memory_buffer_row(PixelCursor &p, int width);
 };
 
 class MixColorBurnOperation : public MixBaseOperation {
@@ -156,6 +196,9 @@ class MixMultiplyOperation : public MixBaseOperation {
  public:
   MixMultiplyOperation();
   void executePixelSampled(float output[4], float x, float y, PixelSampler sampler);
+
+ protected:
+  void update_memory_buffer_row(PixelCursor &p, int width);
 };
 
 class MixOverlayOperation : public MixBaseOperation {
@@ -186,6 +229,9 @@ class MixSubtractOperation : public MixBaseOperation {
  public:
   MixSubtractOperation();
   void executePixelSampled(float output[4], float x, float y, PixelSampler sampler);
+
+ protected:
+  void update_memory_buffer_row(PixelCursor &p, int width);
 };
 
 class MixValueOperation : public MixBaseOperation {
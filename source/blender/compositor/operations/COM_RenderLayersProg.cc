@@ -19,6 +19,7 @@
 #include "COM_RenderLayersProg.h"
 
 #include "COM_MetaData.h"
+#include "COM_OperationHash.h"
 
 #include "BKE_image.h"
 #include "BKE_scene.h"
@@ -45,11 +46,12 @@ RenderLayersProg::RenderLayersProg(const char *passName, DataType type, int elem
   this->addOutputSocket(type);
 }
 
-void RenderLayersProg::initExecution()
+float *RenderLayersProg::get_pass_buffer()
 {
   Scene *scene = this->getScene();
   Render *re = (scene) ? RE_GetSceneRender(scene) : nullptr;
   RenderResult *rr = nullptr;
+  float *buffer = nullptr;
 
   if (re) {
     rr = RE_AcquireResultRead(re);
@@ -61,8 +63,7 @@ void RenderLayersProg::initExecution()
 
       RenderLayer *rl = RE_GetRenderLayer(rr, view_layer->name);
       if (rl) {
-        this->m_inputBuffer = RE_RenderLayerGetPass(
-            rl, this->m_passName.c_str(), this->m_viewName);
+        buffer = RE_RenderLayerGetPass(rl, this->m_passName.c_str(), this->m_viewName);
       }
     }
   }
@@ -70,6 +71,26 @@ void RenderLayersProg::initExecution()
     RE_ReleaseResult(re);
     re = nullptr;
   }
+  return buffer;
+}
+
+void RenderLayersProg::initExecution()
+{
+  this->m_inputBuffer = get_pass_buffer();
+}
+
+/**
+ * Hash the pass pixels, they change when rendering again while the node settings don't.
+ */
+bool RenderLayersProg::hash_output_params(OperationHash &hash)
+{
+  const float *buffer = get_pass_buffer();
+  hash.add(buffer != nullptr);
+  if (buffer) {
+    hash.add_image_sampled(
+        buffer, sizeof(float) * this->m_elementsize * this->getWidth(), this->getHeight());
+  }
+  return true;
 }
 
 void RenderLayersProg::doInterpolation(float output[4], float x, float y, PixelSampler sampler)
@@ -81,6 +81,8 @@ class RenderLayersProg : public NodeOperation {
 
   void doInterpolation(float output[4], float x, float y, PixelSampler sampler);
 
+  float *get_pass_buffer();
+
  public:
   /**
    * Constructor
@@ -122,6 +124,7 @@ class RenderLayersProg : public NodeOperation {
   void initExecution() override;
   void deinitExecution() override;
   void executePixelSampled(float output[4], float x, float y, PixelSampler sampler) override;
+  bool hash_output_params(OperationHash &hash) override;
 
   std::unique_ptr<MetaData> getMetaData() const override;
 };
@@ -17,6 +17,7 @@
  */
 
 #include "COM_SetColorOperation.h"
+#include "COM_OperationHash.h"
 
 SetColorOperation::SetColorOperation()
 {
@@ -37,3 +38,9 @@ void SetColorOperation::determineResolution(unsigned int resolution[2],
   resolution[0] = preferredResolution[0];
   resolution[1] = preferredResolution[1];
 }
+
+bool SetColorOperation::hash_output_params(OperationHash &hash)
+{
+  hash.add(this->m_color);
+  return true;
+}
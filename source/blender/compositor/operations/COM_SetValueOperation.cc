@@ -17,6 +17,7 @@
  */
 
 #include "COM_SetValueOperation.h"
+#include "COM_OperationHash.h"
 
 SetValueOperation::SetValueOperation()
 {
@@ -37,3 +38,9 @@ void SetValueOperation::determineResolution(unsigned int resolution[2],
   resolution[0] = preferredResolution[0];
   resolution[1] = preferredResolution[1];
 }
+
+bool SetValueOperation::hash_output_params(OperationHash &hash)
+{
+  hash.add(this->m_value);
+  return true;
+}
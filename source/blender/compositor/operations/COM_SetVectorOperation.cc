@@ -17,6 +17,7 @@
  */
 
 #include "COM_SetVectorOperation.h"
+#include "COM_OperationHash.h"
 #include "COM_defines.h"
 
 SetVectorOperation::SetVectorOperation()
@@ -40,3 +41,12 @@ void SetVectorOperation::determineResolution(unsigned int resolution[2],
   resolution[0] = preferredResolution[0];
   resolution[1] = preferredResolution[1];
 }
+
+bool SetVectorOperation::hash_output_params(OperationHash &hash)
+{
+  hash.add(this->m_x);
+  hash.add(this->m_y);
+  hash.add(this->m_z);
+  hash.add(this->m_w);
+  return true;
+}
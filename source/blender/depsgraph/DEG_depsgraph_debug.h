@@ -62,6 +62,10 @@ void DEG_debug_stats_gnuplot(const struct Depsgraph *graph,
                              const char *label,
                              const char *output_filename);
 
+/* Timing of the last evaluation in the Chrome trace event format (JSON).
+ * Requires evaluation with `--debug-depsgraph-time`. */
+void DEG_debug_stats_trace(const struct Depsgraph *graph, FILE *fp);
+
 /* ************************************************ */
 
 /* Compare two dependency graphs. */
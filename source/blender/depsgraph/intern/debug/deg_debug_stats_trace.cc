@@ -0,0 +1,87 @@
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ * The Original Code is Copyright (C) 2021 Blender Foundation.
+ * All rights reserved.
+ */
+
+/** \file
+ * \ingroup depsgraph
+ *
+ * Export of the last evaluation timing in the Chrome trace event format, which can be opened in
+ * `chrome://tracing` or https://ui.perfetto.dev to see which thread evaluated which operation.
+ */
+
+#include "DEG_depsgraph_debug.h"
+
+#include "BLI_profile.hh"
+#include "BLI_utildefines.h"
+
+#include "intern/depsgraph.h"
+#include "intern/node/deg_node_component.h"
+#include "intern/node/deg_node_id.h"
+#include "intern/node/deg_node_operation.h"
+
+namespace deg = blender::deg;
+
+namespace blender::deg {
+namespace {
+
+bool trace_operation_was_evaluated(const OperationNode *op_node)
+{
+  return op_node->stats.current_start_time != 0.0;
+}
+
+void deg_debug_stats_trace(FILE *fp, const Depsgraph *graph)
+{
+  /* Timestamps are written relative to the first evaluated operation. */
+  double first_start_time = 0.0;
+  for (const OperationNode *op_node : graph->operations) {
+    if (!trace_operation_was_evaluated(op_node)) {
+      continue;
+    }
+    if (first_start_time == 0.0 || op_node->stats.current_start_time < first_start_time) {
+      first_start_time = op_node->stats.current_start_time;
+    }
+  }
+
+  profile::TraceWriter writer{fp};
+  for (const OperationNode *op_node : graph->operations) {
+    if (!trace_operation_was_evaluated(op_node)) {
+      continue;
+    }
+    const ComponentNode *comp_node = op_node->owner;
+    const IDNode *id_node = comp_node->owner;
+    writer.event_begin(op_node->identifier(),
+                       comp_node->identifier(),
+                       op_node->stats.current_thread,
+                       op_node->stats.current_start_time - first_start_time,
+                       op_node->stats.current_time);
+    writer.event_arg("id", id_node->id_orig->name);
+    writer.event_arg("priority_ms", op_node->priority * 1e3);
+    writer.event_end();
+  }
+}
+
+}  // namespace
+}  // namespace blender::deg
+
+void DEG_debug_stats_trace(const Depsgraph *depsgraph, FILE *fp)
+{
+  if (depsgraph == nullptr) {
+    return;
+  }
+  deg::deg_debug_stats_trace(fp, (const deg::Depsgraph *)depsgraph);
+}
@@ -29,7 +29,10 @@
 
 #include "BLI_compiler_attrs.h"
 #include "BLI_gsqueue.h"
+#include "BLI_heap.h"
+#include "BLI_profile.h"
 #include "BLI_task.h"
+#include "BLI_threads.h"
 #include "BLI_utildefines.h"
 
 #include "BKE_global.h"
@@ -68,11 +71,6 @@ void schedule_children(DepsgraphEvalState *state,
                        ScheduleFunction *schedule_function,
                        ScheduleFunctionArgs... schedule_function_args);
 
-void schedule_node_to_pool(OperationNode *node, const int UNUSED(thread_id), TaskPool *pool)
-{
-  BLI_task_pool_push(pool, deg_task_run_func, node, false, nullptr);
-}
-
 /* Denotes which part of dependency graph is being evaluated. */
 enum class EvaluationStage {
   /* Stage 1: Only  Copy-on-Write operations are to be evaluated, prior to anything else.
@@ -95,32 +93,52 @@ struct DepsgraphEvalState {
   bool do_stats;
   EvaluationStage stage;
   bool need_single_thread_pass;
+  /* Operations which are ready for threaded evaluation, ordered by their priority. */
+  Heap *ready_operations;
+  SpinLock ready_operations_lock;
 };
 
+void schedule_node_to_pool(OperationNode *node, const int UNUSED(thread_id), TaskPool *pool)
+{
+  DepsgraphEvalState *state = (DepsgraphEvalState *)BLI_task_pool_user_data(pool);
+  BLI_spin_lock(&state->ready_operations_lock);
+  /* Heap gives the lowest value first. */
+  BLI_heap_insert(state->ready_operations, -(float)node->priority, node);
+  BLI_spin_unlock(&state->ready_operations_lock);
+  /* The task evaluates whichever ready operation has the highest priority at the time it runs,
+   * so the order in which the pool runs its tasks does not matter. */
+  BLI_task_pool_push(pool, deg_task_run_func, nullptr, false, nullptr);
+}
+
 void evaluate_node(const DepsgraphEvalState *state, OperationNode *operation_node)
 {
   ::Depsgraph *depsgraph = reinterpret_cast<::Depsgraph *>(state->graph);
 
   /* Sanity checks. */
   BLI_assert(!operation_node->is_noop() && "NOOP nodes should not actually be scheduled");
-  /* Perform operation. */
-  if (state->do_stats) {
-    const double start_time = PIL_check_seconds_timer();
-    operation_node->evaluate(depsgraph);
-    operation_node->stats.current_time += PIL_check_seconds_timer() - start_time;
-  }
-  else {
-    operation_node->evaluate(depsgraph);
+  /* Perform operation. Always timed, the averaged timing is used for scheduling. */
+  const double start_time = PIL_check_seconds_timer();
+  operation_node->evaluate(depsgraph);
+  const double end_time = PIL_check_seconds_timer();
+  deg_eval_stats_operation_record(operation_node, start_time, end_time, state->do_stats);
+  if (BLI_profile_is_enabled()) {
+    const ComponentNode *comp_node = operation_node->owner;
+    const string name = string(comp_node->owner->id_orig->name + 2) + " " +
+                        operation_node->identifier();
+    BLI_profile_event_add(start_time, end_time, "depsgraph", name.c_str());
   }
 }
 
-void deg_task_run_func(TaskPool *pool, void *taskdata)
+void deg_task_run_func(TaskPool *pool, void *UNUSED(taskdata))
 {
   void *userdata_v = BLI_task_pool_user_data(pool);
   DepsgraphEvalState *state = (DepsgraphEvalState *)userdata_v;
 
+  BLI_spin_lock(&state->ready_operations_lock);
+  OperationNode *operation_node = (OperationNode *)BLI_heap_pop_min(state->ready_operations);
+  BLI_spin_unlock(&state->ready_operations_lock);
+
   /* Evaluate node. */
-  OperationNode *operation_node = reinterpret_cast<OperationNode *>(taskdata);
   evaluate_node(state, operation_node);
 
   /* Schedule children. */
@@ -177,10 +195,76 @@ void calculate_pending_parents(Depsgraph *graph)
   }
 }
 
+bool need_evaluate_operation(const OperationNode *node)
+{
+  return check_operation_node_visible(const_cast<OperationNode *>(node)) &&
+         (node->flag & DEPSOP_FLAG_NEEDS_UPDATE) != 0;
+}
+
+bool is_priority_relation(const Relation *rel)
+{
+  return (rel->flag & RELATION_FLAG_CYCLIC) == 0 &&
+         need_evaluate_operation((const OperationNode *)rel->to);
+}
+
+enum {
+  PRIORITY_NOT_VISITED = 0,
+  PRIORITY_IN_PROGRESS = 1,
+  PRIORITY_DONE = 2,
+};
+
+/* Priority of an operation is its averaged evaluation time plus the highest priority of the
+ * operations depending on it, which is the estimated time of the longest (critical) path of
+ * evaluation starting at this operation. Evaluating operations on the critical path first avoids
+ * the situation where an expensive chain of operations starts last and keeps a single thread busy
+ * while all the others are idle. */
+void calculate_priorities(Depsgraph *graph)
+{
+  for (OperationNode *node : graph->operations) {
+    node->custom_flags = PRIORITY_NOT_VISITED;
+  }
+  /* Iterative depth-first traversal, chains of operations can be very long. */
+  Vector<OperationNode *> stack;
+  for (OperationNode *root : graph->operations) {
+    if (root->custom_flags != PRIORITY_NOT_VISITED || !need_evaluate_operation(root)) {
+      continue;
+    }
+    stack.append(root);
+    while (!stack.is_empty()) {
+      OperationNode *node = stack.last();
+      if (node->custom_flags == PRIORITY_NOT_VISITED) {
+        node->custom_flags = PRIORITY_IN_PROGRESS;
+        for (Relation *rel : node->outlinks) {
+          OperationNode *child = (OperationNode *)rel->to;
+          if (child->custom_flags == PRIORITY_NOT_VISITED && is_priority_relation(rel)) {
+            stack.append(child);
+          }
+        }
+        continue;
+      }
+      stack.remove_last();
+      if (node->custom_flags != PRIORITY_IN_PROGRESS) {
+        /* Was added to the stack more than once. */
+        continue;
+      }
+      double children_priority = 0.0;
+      for (Relation *rel : node->outlinks) {
+        OperationNode *child = (OperationNode *)rel->to;
+        if (child->custom_flags == PRIORITY_DONE && is_priority_relation(rel)) {
+          children_priority = std::max(children_priority, child->priority);
+        }
+      }
+      node->priority = node->stats.average_time + children_priority;
+      node->custom_flags = PRIORITY_DONE;
+    }
+  }
+}
+
 void initialize_execution(DepsgraphEvalState *state, Depsgraph *graph)
 {
   const bool do_stats = state->do_stats;
   calculate_pending_parents(graph);
+  calculate_priorities(graph);
   /* Clear tags and other things which needs to be clear. */
   for (OperationNode *node : graph->operations) {
     if (do_stats) {
@@ -379,6 +463,8 @@ void deg_evaluate_on_refresh(Depsgraph *graph)
   state.graph = graph;
   state.do_stats = graph->debug.do_time_debug();
   state.need_single_thread_pass = false;
+  state.ready_operations = BLI_heap_new();
+  BLI_spin_init(&state.ready_operations_lock);
   /* Prepare all nodes for evaluation. */
   initialize_execution(&state, graph);
 
@@ -402,6 +488,10 @@ void deg_evaluate_on_refresh(Depsgraph *graph)
     evaluate_graph_single_threaded(&state);
   }
 
+  BLI_assert(BLI_heap_is_empty(state.ready_operations));
+  BLI_heap_free(state.ready_operations, nullptr);
+  BLI_spin_end(&state.ready_operations_lock);
+
   /* Finalize statistics gathering. This is because we only gather single
    * operation timing here, without aggregating anything to avoid any extra
    * synchronization. */
@@ -23,6 +23,8 @@
 
 #include "intern/eval/deg_eval_stats.h"
 
+#include <atomic>
+
 #include "BLI_utildefines.h"
 
 #include "intern/depsgraph.h"
@@ -34,6 +36,41 @@
 
 namespace blender::deg {
 
+namespace {
+
+/* Weight of the latest sample in the averaged evaluation time. */
+const double AVERAGE_TIME_WEIGHT = 0.25;
+
+/* Small index of the current thread, used to tell threads apart in the exported timings. */
+int eval_thread_index()
+{
+  static std::atomic<int> num_threads = 0;
+  static thread_local int index = num_threads++;
+  return index;
+}
+
+}  // namespace
+
+void deg_eval_stats_operation_record(OperationNode *op_node,
+                                     const double start_time,
+                                     const double end_time,
+                                     const bool do_stats)
+{
+  Node::Stats &stats = op_node->stats;
+  const double time = end_time - start_time;
+  if (stats.average_time == 0.0) {
+    stats.average_time = time;
+  }
+  else {
+    stats.average_time += (time - stats.average_time) * AVERAGE_TIME_WEIGHT;
+  }
+  if (do_stats) {
+    stats.current_time += time;
+    stats.current_start_time = start_time;
+    stats.current_thread = eval_thread_index();
+  }
+}
+
 void deg_eval_stats_aggregate(Depsgraph *graph)
 {
   /* Reset current evaluation stats for ID and component nodes.
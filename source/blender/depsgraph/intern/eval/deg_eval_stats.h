@@ -27,6 +27,15 @@ namespace blender {
 namespace deg {
 
 struct Depsgraph;
+struct OperationNode;
+
+/* Store timing of an operation evaluation.
+ * The averaged time is always updated, the timing of the current evaluation only when gathering
+ * statistics is requested. */
+void deg_eval_stats_operation_record(OperationNode *op_node,
+                                     double start_time,
+                                     double end_time,
+                                     bool do_stats);
 
 /* Aggregate operation timings to overall component and ID nodes timing. */
 void deg_eval_stats_aggregate(Depsgraph *graph);
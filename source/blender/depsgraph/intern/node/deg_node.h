@@ -163,6 +163,13 @@ struct Node {
     void reset_current();
     /* Time spend on this node during current graph evaluation. */
     double current_time;
+    /* When this node started evaluating during current graph evaluation, and the index of the
+     * thread it was evaluated on. Only set when time debugging is enabled. */
+    double current_start_time;
+    int current_thread;
+    /* Running average of the evaluation time, kept across graph evaluations.
+     * Used as an estimate of the evaluation cost when scheduling operations. */
+    double average_time;
   };
   /* Relationships between nodes
    * The reason why all depsgraph nodes are descended from this type (apart
@@ -209,7 +209,7 @@ const char *operationCodeAsString(OperationCode opcode)
   return "UNKNOWN";
 }
 
-OperationNode::OperationNode() : name_tag(-1), flag(0)
+OperationNode::OperationNode() : priority(0.0), name_tag(-1), flag(0)
 {
 }
 
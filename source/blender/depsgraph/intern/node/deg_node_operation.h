@@ -266,6 +266,10 @@ struct OperationNode : public Node {
   uint32_t num_links_pending;
   bool scheduled;
 
+  /* Estimated time needed to evaluate this operation and the longest chain of operations which
+   * depend on it. Operations with a higher priority are evaluated first. */
+  double priority;
+
   /* Identifier for the operation being performed. */
   OperationCode opcode;
   int name_tag;
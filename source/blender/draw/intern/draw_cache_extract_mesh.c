@@ -32,6 +32,7 @@
 #include "BLI_jitter_2d.h"
 #include "BLI_math_bits.h"
 #include "BLI_math_vector.h"
+#include "BLI_profile.h"
 #include "BLI_string.h"
 #include "BLI_task.h"
 #include "BLI_utildefines.h"
@@ -5650,6 +5651,7 @@ static void extract_init(ExtractTaskData *data)
 static void extract_run(void *__restrict taskdata)
 {
   ExtractTaskData *data = (ExtractTaskData *)taskdata;
+  const double profile_start_time = BLI_profile_event_begin();
   if (data->tasktype == EXTRACT_MESH_EXTRACT) {
     mesh_extract_iter(data->mr,
                       data->iter_type,
@@ -5667,6 +5669,7 @@ static void extract_run(void *__restrict taskdata)
   else if (data->tasktype == EXTRACT_LINES_LOOSE) {
     extract_lines_loose_subbuffer(data->mr, data->cache);
   }
+  BLI_profile_event_end(profile_start_time, "draw", "Mesh Extract");
 }
 
 static void extract_init_and_run(void *__restrict taskdata)
@@ -5701,8 +5704,10 @@ static void mesh_extract_render_data_node_exec(void *__restrict task_data)
   const eMRIterType iter_type = update_task_data->iter_type;
   const eMRDataType data_flag = update_task_data->data_flag;
 
+  const double profile_start_time = BLI_profile_event_begin();
   mesh_render_data_update_normals(mr, iter_type, data_flag);
   mesh_render_data_update_looptris(mr, iter_type, data_flag);
+  BLI_profile_event_end(profile_start_time, "draw", "Mesh Extract Render Data");
 }
 
 static struct TaskNode *mesh_extract_render_data_node_create(struct TaskGraph *task_graph,
@@ -5787,9 +5792,11 @@ static void user_data_init_task_data_free(UserDataInitTaskData *taskdata)
 static void user_data_init_task_data_exec(void *__restrict task_data)
 {
   UserDataInitTaskData *extract_task_data = task_data;
+  const double profile_start_time = BLI_profile_event_begin();
   LISTBASE_FOREACH (ExtractTaskData *, td, &extract_task_data->task_datas) {
     extract_init(td);
   }
+  BLI_profile_event_end(profile_start_time, "draw", "Mesh Extract Init");
 }
 
 static struct TaskNode *user_data_init_task_node_create(struct TaskGraph *task_graph,
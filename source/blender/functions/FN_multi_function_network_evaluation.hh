@@ -39,6 +39,10 @@ class MFNetworkEvaluator : public MultiFunction {
  private:
   using Storage = MFNetworkEvaluationStorage;
 
+  bool can_evaluate_in_chunks() const;
+  void evaluate_in_chunks(IndexMask mask, MFParams params, MFContext context) const;
+  void evaluate_chunk(IndexMask mask, MFParams params, MFContext context) const;
+
   void copy_inputs_to_storage(MFParams params, Storage &storage) const;
   void copy_outputs_to_storage(
       MFParams params,
@@ -58,4 +62,12 @@ class MFNetworkEvaluator : public MultiFunction {
                                     Span<const MFInputSocket *> remaining_outputs) const;
 };
 
+/**
+ * Call a function with only single value inputs and outputs on entire arrays. The function is
+ * evaluated by a #MFNetworkEvaluator, so large arrays are processed in chunks.
+ */
+void evaluate_multi_function_on_spans(const MultiFunction &fn,
+                                      Span<GSpan> inputs,
+                                      Span<GMutableSpan> outputs);
+
 }  // namespace blender::fn
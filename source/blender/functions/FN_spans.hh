@@ -98,6 +98,14 @@ class GSpan {
     return POINTER_OFFSET(data_, type_->size() * index);
   }
 
+  GSpan slice(const int64_t start, const int64_t size) const
+  {
+    BLI_assert(start >= 0);
+    BLI_assert(size >= 0);
+    BLI_assert(start + size <= size_);
+    return GSpan(*type_, POINTER_OFFSET(data_, type_->size() * start), size);
+  }
+
   template<typename T> Span<T> typed() const
   {
     BLI_assert(type_->is<T>());
@@ -178,6 +186,14 @@ class GMutableSpan {
     BLI_assert(type_->is<T>());
     return MutableSpan<T>(static_cast<T *>(data_), size_);
   }
+
+  GMutableSpan slice(const int64_t start, const int64_t size) const
+  {
+    BLI_assert(start >= 0);
+    BLI_assert(size >= 0);
+    BLI_assert(start + size <= size_);
+    return GMutableSpan(*type_, POINTER_OFFSET(data_, type_->size() * start), size);
+  }
 };
 
 enum class VSpanCategory {
@@ -427,6 +443,31 @@ class GVSpan : public VSpanBase<void> {
     return VSpan<T>(*this);
   }
 
+  /**
+   * Get a virtual span that references the elements `[start, start + size)` of this span.
+   * A single value stays a single value, so this never copies any data.
+   */
+  GVSpan slice(const int64_t start, const int64_t size) const
+  {
+    BLI_assert(start >= 0);
+    BLI_assert(size >= 0);
+    BLI_assert(start + size <= this->virtual_size_);
+    GVSpan ref = *this;
+    ref.virtual_size_ = size;
+    switch (this->category_) {
+      case VSpanCategory::Single:
+        break;
+      case VSpanCategory::FullArray:
+        ref.data_.full_array.data = POINTER_OFFSET(this->data_.full_array.data,
+                                                   start * type_->size());
+        break;
+      case VSpanCategory::FullPointerArray:
+        ref.data_.full_pointer_array.data = this->data_.full_pointer_array.data + start;
+        break;
+    }
+    return ref;
+  }
+
   const void *as_single_element() const
   {
     BLI_assert(this->is_single_element());
@@ -28,6 +28,8 @@
  * - Avoids data copies in many cases.
  * - Every node is executed at most once.
  * - Can compute sub-functions on a single element, when the result is the same for all elements.
+ * - Large masks are evaluated in cache-sized chunks, so that intermediate buffers are reused while
+ *   they are still hot, instead of materializing every intermediate array for all elements.
  *
  * Possible improvements:
  * - Cache and reuse buffers.
@@ -135,12 +137,97 @@ MFNetworkEvaluator::MFNetworkEvaluator(Vector<const MFOutputSocket *> inputs,
   }
 }
 
+/**
+ * Large masks are split into chunks of this size, which are evaluated one after another. That
+ * way the buffers for intermediate values stay small enough to remain in the CPU cache while the
+ * entire network is evaluated on them, instead of materializing every intermediate array for the
+ * whole mask.
+ */
+static constexpr int64_t evaluation_chunk_size = 1024;
+
 void MFNetworkEvaluator::call(IndexMask mask, MFParams params, MFContext context) const
 {
   if (mask.size() == 0) {
     return;
   }
 
+  if (mask.size() > evaluation_chunk_size && this->can_evaluate_in_chunks()) {
+    this->evaluate_in_chunks(mask, params, context);
+  }
+  else {
+    this->evaluate_chunk(mask, params, context);
+  }
+}
+
+/**
+ * Vector parameters of the caller cannot be sliced, so chunked evaluation is only possible when
+ * all inputs and outputs of the network are single values. Vector sockets inside the network are
+ * fine, because their buffers are created per chunk.
+ */
+bool MFNetworkEvaluator::can_evaluate_in_chunks() const
+{
+  for (const MFOutputSocket *socket : inputs_) {
+    if (socket->data_type().category() != MFDataType::Single) {
+      return false;
+    }
+  }
+  for (const MFInputSocket *socket : outputs_) {
+    if (socket->data_type().category() != MFDataType::Single) {
+      return false;
+    }
+  }
+  return true;
+}
+
+BLI_NOINLINE void MFNetworkEvaluator::evaluate_in_chunks(IndexMask mask,
+                                                         MFParams params,
+                                                         MFContext context) const
+{
+  const Span<int64_t> indices = mask.indices();
+  const bool mask_is_range = mask.is_range();
+  Vector<int64_t> offset_indices;
+
+  for (int64_t chunk_start = 0; chunk_start < indices.size();
+       chunk_start += evaluation_chunk_size) {
+    const Span<int64_t> chunk_indices = indices.slice(
+        chunk_start, std::min(evaluation_chunk_size, indices.size() - chunk_start));
+    const int64_t offset = chunk_indices.first();
+    const int64_t chunk_array_size = chunk_indices.last() - offset + 1;
+
+    /* Shift the indices so that the chunk starts at zero. This keeps the temporary buffers, whose
+     * size depends on the largest index, as small as the chunk. */
+    IndexMask chunk_mask;
+    if (mask_is_range) {
+      chunk_mask = IndexRange(chunk_indices.size());
+    }
+    else {
+      offset_indices.clear();
+      for (const int64_t i : chunk_indices) {
+        offset_indices.append(i - offset);
+      }
+      chunk_mask = offset_indices.as_span();
+    }
+
+    MFParamsBuilder chunk_params(*this, chunk_array_size);
+    for (const int input_index : inputs_.index_range()) {
+      const int param_index = input_index;
+      const GVSpan input = params.readonly_single_input(param_index);
+      chunk_params.add_readonly_single_input(input.slice(offset, chunk_array_size));
+    }
+    for (const int output_index : outputs_.index_range()) {
+      const int param_index = output_index + inputs_.size();
+      const GMutableSpan output = params.uninitialized_single_output(param_index);
+      chunk_params.add_uninitialized_single_output(output.slice(offset, chunk_array_size));
+    }
+
+    this->evaluate_chunk(chunk_mask, chunk_params, context);
+  }
+}
+
+BLI_NOINLINE void MFNetworkEvaluator::evaluate_chunk(IndexMask mask,
+                                                     MFParams params,
+                                                     MFContext context) const
+{
   const MFNetwork &network = outputs_[0]->node().network();
   Storage storage(mask, network.socket_id_amount());
 
@@ -1055,4 +1142,46 @@ GVArraySpan MFNetworkEvaluationStorage::get_vector_input__single(const MFInputSo
 
 /** \} */
 
+/* -------------------------------------------------------------------- */
+/** \name Span Evaluation
+ * \{ */
+
+void evaluate_multi_function_on_spans(const MultiFunction &fn,
+                                      Span<GSpan> inputs,
+                                      Span<GMutableSpan> outputs)
+{
+  MFNetwork network;
+  MFFunctionNode &function_node = network.add_function(fn);
+  Vector<const MFOutputSocket *> network_inputs;
+  Vector<const MFInputSocket *> network_outputs;
+  for (MFInputSocket *socket : function_node.inputs()) {
+    MFOutputSocket &input = network.add_input(socket->name(), socket->data_type());
+    network.add_link(input, *socket);
+    network_inputs.append(&input);
+  }
+  for (MFOutputSocket *socket : function_node.outputs()) {
+    MFInputSocket &output = network.add_output(socket->name(), socket->data_type());
+    network.add_link(*socket, output);
+    network_outputs.append(&output);
+  }
+  BLI_assert(network_inputs.size() == inputs.size());
+  BLI_assert(network_outputs.size() == outputs.size());
+
+  const int64_t size = outputs.first().size();
+  MFNetworkEvaluator network_fn{std::move(network_inputs), std::move(network_outputs)};
+  MFParamsBuilder params{network_fn, size};
+  for (const GSpan input : inputs) {
+    BLI_assert(input.size() == size);
+    params.add_readonly_single_input(input);
+  }
+  for (const GMutableSpan output : outputs) {
+    BLI_assert(output.size() == size);
+    params.add_uninitialized_single_output(output);
+  }
+  MFContextBuilder context;
+  network_fn.call(IndexRange(size), params, context);
+}
+
+/** \} */
+
 }  // namespace blender::fn
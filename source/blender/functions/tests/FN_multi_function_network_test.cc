@@ -65,6 +65,124 @@ TEST(multi_function_network, Test1)
   }
 }
 
+TEST(multi_function_network, EvaluateInChunks)
+{
+  CustomMF_SI_SI_SO<int, int, int> add_fn("add", [](int a, int b) { return a + b; });
+  CustomMF_SI_SO<int, int> negate_fn("negate", [](int value) { return -value; });
+
+  MFNetwork network;
+
+  MFNode &node1 = network.add_function(add_fn);
+  MFNode &node2 = network.add_function(negate_fn);
+  MFOutputSocket &input_socket_1 = network.add_input("Input 1", MFDataType::ForSingle<int>());
+  MFOutputSocket &input_socket_2 = network.add_input("Input 2", MFDataType::ForSingle<int>());
+  MFInputSocket &output_socket = network.add_output("Output", MFDataType::ForSingle<int>());
+  network.add_link(input_socket_1, node1.input(0));
+  network.add_link(input_socket_2, node1.input(1));
+  network.add_link(node1.output(0), node2.input(0));
+  network.add_link(node2.output(0), output_socket);
+
+  MFNetworkEvaluator network_fn{{&input_socket_1, &input_socket_2}, {&output_socket}};
+
+  const int size = 5000;
+  Array<int> values(size);
+  for (const int i : values.index_range()) {
+    values[i] = i;
+  }
+
+  {
+    /* A range mask spanning multiple chunks. */
+    const int offset = 10;
+    Array<int> results(size, 0);
+
+    MFParamsBuilder params(network_fn, size);
+    params.add_readonly_single_input(values.as_span());
+    params.add_readonly_single_input(&offset);
+    params.add_uninitialized_single_output(results.as_mutable_span());
+
+    MFContextBuilder context;
+
+    network_fn.call(IndexRange(3, size - 3), params, context);
+
+    EXPECT_EQ(results[0], 0);
+    EXPECT_EQ(results[2], 0);
+    for (const int i : IndexRange(3, size - 3)) {
+      EXPECT_EQ(results[i], -(i + 10));
+    }
+  }
+  {
+    /* A mask with gaps spanning multiple chunks. */
+    Vector<int64_t> indices;
+    for (int i = 1; i < size; i += 3) {
+      indices.append(i);
+    }
+    Array<int> results(size, 0);
+
+    MFParamsBuilder params(network_fn, size);
+    params.add_readonly_single_input(values.as_span());
+    params.add_readonly_single_input(values.as_span());
+    params.add_uninitialized_single_output(results.as_mutable_span());
+
+    MFContextBuilder context;
+
+    network_fn.call(indices.as_span(), params, context);
+
+    for (const int i : IndexRange(size)) {
+      EXPECT_EQ(results[i], (i % 3 == 1) ? -2 * i : 0);
+    }
+  }
+}
+
+/* Adds its inputs and remembers the largest mask it was called with. */
+class AddRecordMaskFunction : public MultiFunction {
+ public:
+  mutable int64_t max_mask_size = 0;
+
+  AddRecordMaskFunction()
+  {
+    MFSignatureBuilder signature = this->get_builder("Add Record Mask");
+    signature.single_input<float>("A");
+    signature.single_input<float>("B");
+    signature.single_output<float>("Result");
+  }
+
+  void call(IndexMask mask, MFParams params, MFContext UNUSED(context)) const override
+  {
+    VSpan<float> a = params.readonly_single_input<float>(0, "A");
+    VSpan<float> b = params.readonly_single_input<float>(1, "B");
+    MutableSpan<float> result = params.uninitialized_single_output<float>(2, "Result");
+
+    max_mask_size = std::max(max_mask_size, mask.size());
+    for (int64_t i : mask) {
+      result[i] = a[i] + b[i];
+    }
+  }
+};
+
+TEST(multi_function_network, EvaluateOnSpans)
+{
+  AddRecordMaskFunction add_fn;
+
+  const int size = 3000;
+  Array<float> a(size);
+  Array<float> b(size);
+  for (const int i : IndexRange(size)) {
+    a[i] = i;
+    b[i] = 0.5f;
+  }
+  Array<float> results(size, 0.0f);
+
+  evaluate_multi_function_on_spans(
+      add_fn, {GSpan(a.as_span()), GSpan(b.as_span())}, {GMutableSpan(results.as_mutable_span())});
+
+  /* Arrays larger than a chunk are not passed to the function at once. */
+  EXPECT_GT(add_fn.max_mask_size, 0);
+  EXPECT_LE(add_fn.max_mask_size, 1024);
+  for (const int i : IndexRange(size)) {
+    EXPECT_EQ(results[i], i + 0.5f);
+  }
+}
+
 class ConcatVectorsFunction : public MultiFunction {
  public:
   ConcatVectorsFunction()
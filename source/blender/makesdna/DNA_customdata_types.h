@@ -53,6 +53,11 @@ typedef struct CustomDataLayer {
   char name[64];
   /** Layer data. */
   void *data;
+  /**
+   * Run-time only, counts the users of `data` when it is shared with layers of other
+   * #CustomData (see #CD_REFERENCE). Null when the data has never been shared.
+   */
+  void *sharing_info;
 } CustomDataLayer;
 
 #define MAX_CUSTOMDATA_LAYER_NAME 64
@@ -5365,6 +5365,11 @@ static void rna_def_userdef_system(BlenderRNA *brna)
        0,
        "None",
        "Requires fast storage, but uses minimum CPU resources"},
+      {USER_SEQ_DISK_CACHE_COMPRESSION_FAST,
+       "FAST",
+       0,
+       "Fast",
+       "Fast compression and decompression using multiple threads, with larger files than Low"},
       {USER_SEQ_DISK_CACHE_COMPRESSION_LOW,
        "LOW",
        0,
@@ -5430,6 +5435,24 @@ static void rna_def_userdef_system(BlenderRNA *brna)
   RNA_def_property_ui_text(prop, "Memory Cache Limit", "Memory cache limit (in megabytes)");
   RNA_def_property_update(prop, 0, "rna_Userdef_memcache_update");
 
+  prop = RNA_def_property(srna, "compositor_cache_limit", PROP_INT, PROP_NONE);
+  RNA_def_property_int_sdna(prop, NULL, "compositor_cache_limit");
+  RNA_def_property_range(prop, 1, max_memory_in_megabytes_int());
+  RNA_def_property_ui_text(
+      prop,
+      "Compositor Cache Limit",
+      "Memory used to keep compositor results across executions of full frame node trees, so "
+      "only nodes depending on edited ones are executed again (in megabytes)");
+
+  prop = RNA_def_property(srna, "geometry_nodes_cache_limit", PROP_INT, PROP_NONE);
+  RNA_def_property_int_sdna(prop, NULL, "geometry_nodes_cache_limit");
+  RNA_def_property_range(prop, 1, max_memory_in_megabytes_int());
+  RNA_def_property_ui_text(
+      prop,
+      "Geometry Nodes Cache Limit",
+      "Memory used by each geometry nodes modifier to keep node results across evaluations, so "
+      "only nodes depending on changed data are executed again (in megabytes)");
+
   /* Sequencer disk cache */
 
   prop = RNA_def_property(srna, "use_sequencer_disk_cache", PROP_BOOLEAN, PROP_NONE);
@@ -6298,6 +6321,14 @@ static void rna_def_userdef_experimental(BlenderRNA *brna)
   RNA_def_property_ui_text(
       prop, "Sculpt Mode Tilt Support", "Support for pen tablet tilt events in Sculpt Mode");
 
+  prop = RNA_def_property(srna, "use_undo_skip_unchanged", PROP_BOOLEAN, PROP_NONE);
+  RNA_def_property_boolean_sdna(prop, NULL, "use_undo_skip_unchanged", 1);
+  RNA_def_property_ui_text(prop,
+                           "Undo Skip Unchanged",
+                           "Only store data-blocks tagged for update in new global undo steps, "
+                           "re-using the previous step for the others (faster in large scenes, "
+                           "changes made without a depsgraph update may not be undone)");
+
   prop = RNA_def_property(srna, "use_asset_browser", PROP_BOOLEAN, PROP_NONE);
   RNA_def_property_boolean_sdna(prop, NULL, "use_asset_browser", 1);
   RNA_def_property_ui_text(
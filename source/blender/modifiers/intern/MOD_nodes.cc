@@ -21,8 +21,10 @@
  * \ingroup modifiers
  */
 
+#include <atomic>
 #include <cstring>
 #include <iostream>
+#include <mutex>
 #include <string>
 
 #include "MEM_guardedalloc.h"
@@ -31,6 +33,7 @@
 #include "BLI_listbase.h"
 #include "BLI_set.hh"
 #include "BLI_string.h"
+#include "BLI_task.h"
 #include "BLI_utildefines.h"
 
 #include "DNA_collection_types.h"
@@ -43,6 +46,7 @@
 #include "DNA_pointcloud_types.h"
 #include "DNA_scene_types.h"
 #include "DNA_screen_types.h"
+#include "DNA_userdef_types.h"
 
 #include "BKE_customdata.h"
 #include "BKE_global.h"
@@ -68,6 +72,7 @@
 
 #include "MOD_modifiertypes.h"
 #include "MOD_nodes.h"
+#include "MOD_nodes_evaluation_cache.hh"
 #include "MOD_ui_common.h"
 
 #include "NOD_derived_node_tree.hh"
@@ -76,6 +81,8 @@
 #include "NOD_node_tree_multi_function.hh"
 #include "NOD_type_callbacks.hh"
 
+#include "PIL_time.h"
+
 using blender::float3;
 using blender::FunctionRef;
 using blender::IndexRange;
@@ -89,7 +96,10 @@ using blender::bke::PersistentCollectionHandle;
 using blender::bke::PersistentDataHandleMap;
 using blender::bke::PersistentObjectHandle;
 using blender::fn::GMutablePointer;
+using blender::fn::GPointer;
 using blender::fn::GValueMap;
+using blender::modifiers::geometry_nodes::NodeCacheKey;
+using blender::modifiers::geometry_nodes::NodesModifierCache;
 using blender::nodes::GeoNodeExecParams;
 using namespace blender::fn::multi_function_types;
 using namespace blender::nodes::derived_node_tree_types;
@@ -252,10 +262,44 @@ static bool isDisabled(const struct Scene *UNUSED(scene),
   return false;
 }
 
+/* A node that has to be executed to compute the outputs of the node group. Nodes are executed in
+ * tasks as soon as all nodes computing their inputs are done, so that independent branches of the
+ * node tree are evaluated in parallel. */
+struct NodeTask {
+  DNode node;
+  /* Number of nodes computing inputs of this node that have not been executed yet. */
+  std::atomic<int> missing_dependencies = 0;
+  /* Nodes using outputs of this node. */
+  Vector<NodeTask *> dependents;
+  /* Nodes computing inputs of this node. */
+  Vector<NodeTask *> dependencies;
+  /* Used for values created while executing the node, because the allocator is not thread-safe.
+   * Values can be used by other nodes, so it lives as long as the evaluator. */
+  blender::LinearAllocator<> allocator;
+  /* Identifies the outputs of the node in the cache, unset when they depend on data that isn't
+   * hashed. */
+  std::optional<uint64_t> cache_key;
+  /* Outputs from a previous evaluation, the node isn't executed when they exist. */
+  const NodesModifierCache::CachedNode *cached_node = nullptr;
+  /* Copies of the outputs by socket index, added to the cache after the evaluation. */
+  Vector<GMutablePointer> outputs_to_cache;
+};
+
+/* Only results of nodes taking longer than this to execute are cached (in seconds), cheaper nodes
+ * are executed again. Caching a geometry also makes the next node copy it before modifying it. */
+static constexpr double NODE_CACHE_MIN_EXECUTION_TIME = 0.001;
+
 class GeometryNodesEvaluator {
  private:
+  using CachedUIStorage = NodesModifierCache::CachedUIStorage;
+
   blender::LinearAllocator<> allocator_;
   Map<std::pair<DInputSocket, DOutputSocket>, GMutablePointer> value_by_input_;
+  std::mutex value_by_input_mutex_;
+  Set<DOutputSocket> group_input_sockets_;
+  Set<DOutputSocket> unavailable_outputs_;
+  Map<DNode, NodeTask *> task_by_node_;
+  Vector<std::unique_ptr<NodeTask>> tasks_;
   Vector<DInputSocket> group_outputs_;
   blender::nodes::MultiFunctionByNode &mf_by_node_;
   const blender::nodes::DataTypeConversions &conversions_;
@@ -263,6 +307,11 @@ class GeometryNodesEvaluator {
   const Object *self_object_;
   const ModifierData *modifier_;
   Depsgraph *depsgraph_;
+  NodesModifierCache *cache_;
+  Map<DOutputSocket, uint64_t> group_input_cache_keys_;
+  uint64_t cache_key_seed_;
+  Map<DNode, std::optional<uint64_t>> cache_key_by_node_;
+  Map<std::string, bNodeTree *> original_trees_by_name_;
 
  public:
   GeometryNodesEvaluator(const Map<DOutputSocket, GMutablePointer> &group_input_data,
@@ -271,25 +320,44 @@ class GeometryNodesEvaluator {
                          const PersistentDataHandleMap &handle_map,
                          const Object *self_object,
                          const ModifierData *modifier,
-                         Depsgraph *depsgraph)
+                         Depsgraph *depsgraph,
+                         NodesModifierCache *cache,
+                         Map<DOutputSocket, uint64_t> group_input_cache_keys,
+                         const uint64_t cache_key_seed,
+                         Span<const blender::nodes::NodeTreeRef *> used_trees)
       : group_outputs_(std::move(group_outputs)),
         mf_by_node_(mf_by_node),
         conversions_(blender::nodes::get_implicit_type_conversions()),
         handle_map_(handle_map),
         self_object_(self_object),
         modifier_(modifier),
-        depsgraph_(depsgraph)
+        depsgraph_(depsgraph),
+        cache_(cache),
+        group_input_cache_keys_(std::move(group_input_cache_keys)),
+        cache_key_seed_(cache_key_seed)
   {
     for (auto item : group_input_data.items()) {
-      this->forward_to_inputs(item.key, item.value);
+      group_input_sockets_.add_new(item.key);
+      this->forward_to_inputs(item.key, item.value, allocator_);
+    }
+    if (cache_ != nullptr) {
+      for (const blender::nodes::NodeTreeRef *tree : used_trees) {
+        bNodeTree *btree_original = (bNodeTree *)DEG_get_original_id((ID *)tree->btree());
+        original_trees_by_name_.add(btree_original->id.name, btree_original);
+      }
     }
   }
 
   Vector<GMutablePointer> execute()
   {
+    this->create_tasks();
+    this->execute_tasks();
+    this->restore_cached_ui_storage();
+    this->add_results_to_cache();
+
     Vector<GMutablePointer> results;
     for (const DInputSocket &group_output : group_outputs_) {
-      Vector<GMutablePointer> result = this->get_input_values(group_output);
+      Vector<GMutablePointer> result = this->get_input_values(group_output, allocator_);
       results.append(result[0]);
     }
     for (GMutablePointer value : value_by_input_.values()) {
@@ -299,7 +367,311 @@ class GeometryNodesEvaluator {
   }
 
  private:
-  Vector<GMutablePointer> get_input_values(const DInputSocket socket_to_compute)
+  /* Create tasks for all nodes the group outputs depend on. */
+  void create_tasks()
+  {
+    Vector<NodeTask *> tasks_to_check;
+    for (const DInputSocket &group_output : group_outputs_) {
+      group_output.foreach_origin_socket(
+          [&](DSocket origin) { this->add_dependency(origin, nullptr, tasks_to_check); });
+    }
+
+    while (!tasks_to_check.is_empty()) {
+      NodeTask *task = tasks_to_check.pop_last();
+      for (const InputSocketRef *input_socket : task->node->inputs()) {
+        if (input_socket->is_available()) {
+          const DInputSocket socket{task->node.context(), input_socket};
+          socket.foreach_origin_socket(
+              [&](DSocket origin) { this->add_dependency(origin, task, tasks_to_check); });
+        }
+      }
+    }
+  }
+
+  void add_dependency(const DSocket origin, NodeTask *dependent, Vector<NodeTask *> &r_new_tasks)
+  {
+    if (!origin->is_output()) {
+      /* Value of unlinked input socket, retrieved when executing the dependent node. */
+      return;
+    }
+    const DOutputSocket origin_output{origin};
+    if (group_input_sockets_.contains(origin_output)) {
+      /* Already forwarded when creating the evaluator. */
+      return;
+    }
+    if (!origin_output->is_available()) {
+      /* If the output is not available, use a default value. */
+      if (unavailable_outputs_.add(origin_output)) {
+        const CPPType &type = *blender::nodes::socket_cpp_type_get(*origin->typeinfo());
+        void *buffer = allocator_.allocate(type.size(), type.alignment());
+        type.copy_to_uninitialized(type.default_value(), buffer);
+        this->forward_to_inputs(origin_output, {type, buffer}, allocator_);
+      }
+      return;
+    }
+
+    const DNode origin_node{origin.context(), &origin->node()};
+    NodeTask *task = task_by_node_.lookup_or_add_cb(origin_node, [&]() {
+      tasks_.append(std::make_unique<NodeTask>());
+      NodeTask *new_task = tasks_.last().get();
+      new_task->node = origin_node;
+      if (cache_ != nullptr) {
+        new_task->cache_key = this->get_node_cache_key(origin_node);
+        if (new_task->cache_key.has_value()) {
+          new_task->cached_node = cache_->lookup(*new_task->cache_key);
+        }
+      }
+      if (new_task->cached_node == nullptr) {
+        /* The inputs are only needed when the node has to be executed. */
+        r_new_tasks.append(new_task);
+      }
+      return new_task;
+    });
+    if (dependent != nullptr && !task->dependents.contains(dependent)) {
+      task->dependents.append(dependent);
+      dependent->dependencies.append(task);
+      dependent->missing_dependencies++;
+    }
+  }
+
+  std::optional<uint64_t> get_node_cache_key(const DNode node)
+  {
+    const std::optional<uint64_t> *cached_key = cache_key_by_node_.lookup_ptr(node);
+    if (cached_key != nullptr) {
+      return *cached_key;
+    }
+    const std::optional<uint64_t> key = this->compute_node_cache_key(node);
+    cache_key_by_node_.add_new(node, key);
+    return key;
+  }
+
+  /* The key of a node depends on the keys of all nodes it depends on, so a change invalidates the
+   * cached outputs of all nodes after it, but not the ones before. */
+  std::optional<uint64_t> compute_node_cache_key(const DNode node)
+  {
+    const bNode &bnode = *node->bnode();
+    if (bnode.id != nullptr) {
+      /* The data-block used by the node can change independently. */
+      return std::nullopt;
+    }
+
+    NodeCacheKey key;
+    key.add(cache_key_seed_);
+    for (const DTreeContext *context = node.context(); context->parent_node() != nullptr;
+         context = context->parent_context()) {
+      key.add_string(context->parent_node()->name());
+    }
+    key.add_string(node->name());
+    key.add_string(bnode.idname);
+    key.add(bnode.custom1);
+    key.add(bnode.custom2);
+    key.add(bnode.custom3);
+    key.add(bnode.custom4);
+    if (bnode.storage != nullptr) {
+      key.add_data(bnode.storage, MEM_allocN_len(bnode.storage));
+    }
+
+    for (const InputSocketRef *input_socket : node->inputs()) {
+      if (!input_socket->is_available()) {
+        continue;
+      }
+      const DInputSocket socket{node.context(), input_socket};
+      key.add(input_socket->index());
+
+      Vector<DSocket> from_sockets;
+      socket.foreach_origin_socket([&](DSocket origin) { from_sockets.append(origin); });
+      if (from_sockets.is_empty()) {
+        from_sockets.append(socket);
+      }
+      for (const DSocket from_socket : from_sockets) {
+        const std::optional<uint64_t> value_key = this->get_value_cache_key(socket, from_socket);
+        if (!value_key.has_value()) {
+          return std::nullopt;
+        }
+        key.add(*value_key);
+      }
+    }
+    return key.value();
+  }
+
+  std::optional<uint64_t> get_value_cache_key(const DInputSocket socket_to_compute,
+                                              const DSocket from_socket)
+  {
+    const CPPType &type = *blender::nodes::socket_cpp_type_get(*socket_to_compute->typeinfo());
+    if (!from_socket->is_output()) {
+      return this->get_unlinked_input_cache_key(DInputSocket(from_socket), type);
+    }
+
+    const DOutputSocket from_output_socket{from_socket};
+    if (group_input_sockets_.contains(from_output_socket)) {
+      const uint64_t *group_input_key = group_input_cache_keys_.lookup_ptr(from_output_socket);
+      if (group_input_key == nullptr) {
+        return std::nullopt;
+      }
+      return *group_input_key;
+    }
+
+    NodeCacheKey key;
+    key.add_string(type.name());
+    if (from_output_socket->is_available()) {
+      const std::optional<uint64_t> node_key = this->get_node_cache_key(
+          {from_socket.context(), &from_socket->node()});
+      if (!node_key.has_value()) {
+        return std::nullopt;
+      }
+      key.add(*node_key);
+      key.add(from_output_socket->index());
+    }
+    return key.value();
+  }
+
+  std::optional<uint64_t> get_unlinked_input_cache_key(const DInputSocket socket,
+                                                       const CPPType &required_type)
+  {
+    if (ELEM(socket->bsocket()->type, SOCK_OBJECT, SOCK_COLLECTION)) {
+      /* The referenced data-block can change independently. */
+      return std::nullopt;
+    }
+    NodeCacheKey key;
+    key.add_string(required_type.name());
+    if (required_type != CPPType::get<GeometrySet>()) {
+      GMutablePointer value = this->get_unlinked_input_value(socket, required_type, allocator_);
+      key.add(required_type.hash(value.get()));
+      value.destruct();
+    }
+    return key.value();
+  }
+
+  static bNodeTree &original_node_tree(const DNode node)
+  {
+    return *(bNodeTree *)DEG_get_original_id((ID *)node->btree());
+  }
+
+  /* Nodes found in the cache don't execute the nodes they depend on either, add the warnings and
+   * attribute hints of all of them, unless a node was executed anyway for another dependent. */
+  void restore_cached_ui_storage()
+  {
+    Set<std::pair<std::string, std::string>> nodes_with_ui_storage;
+    for (const std::unique_ptr<NodeTask> &task : tasks_) {
+      if (task->cached_node == nullptr) {
+        nodes_with_ui_storage.add(
+            {original_node_tree(task->node).id.name, task->node->bnode()->name});
+      }
+    }
+
+    const NodeTreeEvaluationContext context(*self_object_, *modifier_);
+    for (const std::unique_ptr<NodeTask> &task : tasks_) {
+      if (task->cached_node == nullptr) {
+        continue;
+      }
+      for (const CachedUIStorage &item : task->cached_node->ui_storage) {
+        bNodeTree *btree_original = original_trees_by_name_.lookup_default(item.tree_name,
+                                                                           nullptr);
+        if (btree_original == nullptr) {
+          /* The node group isn't used anymore. */
+          continue;
+        }
+        const bNode *bnode = nodeFindNodebyName(btree_original, item.node_name.c_str());
+        if (bnode == nullptr || !nodes_with_ui_storage.add({item.tree_name, item.node_name})) {
+          continue;
+        }
+        BKE_nodetree_ui_storage_add_for_node(*btree_original, context, *bnode, item.storage);
+      }
+    }
+  }
+
+  /* Warnings and attribute hints of the node and all nodes it depends on. */
+  Vector<CachedUIStorage> gather_ui_storage_to_cache(NodeTask &task)
+  {
+    const NodeTreeEvaluationContext context(*self_object_, *modifier_);
+    Vector<CachedUIStorage> ui_storage;
+    Set<std::pair<std::string, std::string>> added_nodes;
+    Set<NodeTask *> visited_tasks;
+    Vector<NodeTask *> tasks_to_check = {&task};
+    while (!tasks_to_check.is_empty()) {
+      NodeTask *current = tasks_to_check.pop_last();
+      if (!visited_tasks.add(current)) {
+        continue;
+      }
+      if (current->cached_node != nullptr) {
+        for (const CachedUIStorage &item : current->cached_node->ui_storage) {
+          if (added_nodes.add({item.tree_name, item.node_name})) {
+            ui_storage.append(item);
+          }
+        }
+        continue;
+      }
+      bNodeTree &btree_original = original_node_tree(current->node);
+      const bNode &bnode = *current->node->bnode();
+      NodeUIStorage storage = BKE_nodetree_ui_storage_copy_for_node(
+          btree_original, context, bnode);
+      const bool has_ui_storage = !storage.warnings.is_empty() ||
+                                  storage.attribute_hints.keys().begin() !=
+                                      storage.attribute_hints.keys().end();
+      if (has_ui_storage && added_nodes.add({btree_original.id.name, bnode.name})) {
+        ui_storage.append({btree_original.id.name, bnode.name, std::move(storage)});
+      }
+      tasks_to_check.extend(current->dependencies);
+    }
+    return ui_storage;
+  }
+
+  void add_results_to_cache()
+  {
+    if (cache_ == nullptr) {
+      return;
+    }
+    /* Gather everything before adding to the cache, which invalidates the cached nodes. */
+    Vector<std::pair<NodeTask *, Vector<CachedUIStorage>>> tasks_to_cache;
+    for (const std::unique_ptr<NodeTask> &task : tasks_) {
+      if (!task->outputs_to_cache.is_empty()) {
+        tasks_to_cache.append({task.get(), this->gather_ui_storage_to_cache(*task)});
+      }
+    }
+    for (auto &[task, ui_storage] : tasks_to_cache) {
+      Vector<GPointer> outputs;
+      for (const GMutablePointer value : task->outputs_to_cache) {
+        outputs.append(value);
+      }
+      cache_->add(*task->cache_key, outputs, std::move(ui_storage));
+      for (GMutablePointer value : task->outputs_to_cache) {
+        if (value.get() != nullptr) {
+          value.destruct();
+        }
+      }
+      task->outputs_to_cache.clear();
+    }
+  }
+
+  void execute_tasks()
+  {
+    TaskPool *task_pool = BLI_task_pool_create(this, TASK_PRIORITY_HIGH);
+    for (const std::unique_ptr<NodeTask> &task : tasks_) {
+      if (task->missing_dependencies == 0) {
+        BLI_task_pool_push(task_pool, execute_task_cb, task.get(), false, nullptr);
+      }
+    }
+    BLI_task_pool_work_and_wait(task_pool);
+    BLI_task_pool_free(task_pool);
+  }
+
+  static void execute_task_cb(TaskPool *__restrict pool, void *taskdata)
+  {
+    GeometryNodesEvaluator &evaluator = *(GeometryNodesEvaluator *)BLI_task_pool_user_data(pool);
+    NodeTask &task = *(NodeTask *)taskdata;
+
+    evaluator.compute_node_and_forward(task);
+
+    /* Schedule nodes which have all their inputs computed now. */
+    for (NodeTask *dependent : task.dependents) {
+      if (dependent->missing_dependencies.fetch_sub(1) == 1) {
+        BLI_task_pool_push(pool, execute_task_cb, dependent, false, nullptr);
+      }
+    }
+  }
+
+  Vector<GMutablePointer> get_input_values(const DInputSocket socket_to_compute,
+                                           blender::LinearAllocator<> &allocator)
   {
     Vector<DSocket> from_sockets;
     socket_to_compute.foreach_origin_socket([&](DSocket socket) { from_sockets.append(socket); });
@@ -307,35 +679,38 @@ class GeometryNodesEvaluator {
     if (from_sockets.is_empty()) {
       /* The input is not connected, use the value from the socket itself. */
       const CPPType &type = *blender::nodes::socket_cpp_type_get(*socket_to_compute->typeinfo());
-      return {get_unlinked_input_value(socket_to_compute, type)};
+      return {get_unlinked_input_value(socket_to_compute, type, allocator)};
     }
 
     /* Multi-input sockets contain a vector of inputs. */
     if (socket_to_compute->is_multi_input_socket()) {
-      return this->get_inputs_from_incoming_links(socket_to_compute, from_sockets);
+      return this->get_inputs_from_incoming_links(socket_to_compute, from_sockets, allocator);
     }
 
     const DSocket from_socket = from_sockets[0];
-    GMutablePointer value = this->get_input_from_incoming_link(socket_to_compute, from_socket);
+    GMutablePointer value = this->get_input_from_incoming_link(
+        socket_to_compute, from_socket, allocator);
     return {value};
   }
 
   Vector<GMutablePointer> get_inputs_from_incoming_links(const DInputSocket socket_to_compute,
-                                                         const Span<DSocket> from_sockets)
+                                                         const Span<DSocket> from_sockets,
+                                                         blender::LinearAllocator<> &allocator)
   {
     Vector<GMutablePointer> values;
     for (const int i : from_sockets.index_range()) {
       const DSocket from_socket = from_sockets[i];
       const int first_occurence = from_sockets.take_front(i).first_index_try(from_socket);
       if (first_occurence == -1) {
-        values.append(this->get_input_from_incoming_link(socket_to_compute, from_socket));
+        values.append(
+            this->get_input_from_incoming_link(socket_to_compute, from_socket, allocator));
       }
       else {
         /* If the same from-socket occurs more than once, we make a copy of the first value. This
          * can happen when a node linked to a multi-input-socket is muted. */
         GMutablePointer value = values[first_occurence];
         const CPPType *type = value.type();
-        void *copy_buffer = allocator_.allocate(type->size(), type->alignment());
+        void *copy_buffer = allocator.allocate(type->size(), type->alignment());
         type->copy_to_uninitialized(value.get(), copy_buffer);
         values.append({type, copy_buffer});
       }
@@ -344,51 +719,53 @@ class GeometryNodesEvaluator {
   }
 
   GMutablePointer get_input_from_incoming_link(const DInputSocket socket_to_compute,
-                                               const DSocket from_socket)
+                                               const DSocket from_socket,
+                                               blender::LinearAllocator<> &allocator)
   {
+    const CPPType &type = *blender::nodes::socket_cpp_type_get(*socket_to_compute->typeinfo());
+
     if (from_socket->is_output()) {
       const DOutputSocket from_output_socket{from_socket};
       const std::pair<DInputSocket, DOutputSocket> key = std::make_pair(socket_to_compute,
                                                                         from_output_socket);
-      std::optional<GMutablePointer> value = value_by_input_.pop_try(key);
+      std::optional<GMutablePointer> value = this->pop_value_from_input_socket(key);
       if (value.has_value()) {
-        /* This input has been computed before, return it directly. */
+        /* This input has been computed by a node executed before. */
         return {*value};
       }
 
-      /* Compute the socket now. */
-      this->compute_output_and_forward(from_output_socket);
-      return {value_by_input_.pop(key)};
+      /* All nodes computing inputs are executed before, so this should not happen. */
+      BLI_assert(false);
+      void *buffer = allocator.allocate(type.size(), type.alignment());
+      type.copy_to_uninitialized(type.default_value(), buffer);
+      return {type, buffer};
     }
 
     /* Get value from an unlinked input socket. */
-    const CPPType &type = *blender::nodes::socket_cpp_type_get(*socket_to_compute->typeinfo());
     const DInputSocket from_input_socket{from_socket};
-    return {get_unlinked_input_value(from_input_socket, type)};
+    return {get_unlinked_input_value(from_input_socket, type, allocator)};
   }
 
-  void compute_output_and_forward(const DOutputSocket socket_to_compute)
+  void compute_node_and_forward(NodeTask &task)
   {
-    const DNode node{socket_to_compute.context(), &socket_to_compute->node()};
+    const DNode node = task.node;
+    blender::LinearAllocator<> &allocator = task.allocator;
 
-    if (!socket_to_compute->is_available()) {
-      /* If the output is not available, use a default value. */
-      const CPPType &type = *blender::nodes::socket_cpp_type_get(*socket_to_compute->typeinfo());
-      void *buffer = allocator_.allocate(type.size(), type.alignment());
-      type.copy_to_uninitialized(type.default_value(), buffer);
-      this->forward_to_inputs(socket_to_compute, {type, buffer});
+    if (task.cached_node != nullptr) {
+      this->forward_cached_node(task);
       return;
     }
 
     /* Prepare inputs required to execute the node. */
-    GValueMap<StringRef> node_inputs_map{allocator_};
+    GValueMap<StringRef> node_inputs_map{allocator};
     for (const InputSocketRef *input_socket : node->inputs()) {
       if (input_socket->is_available()) {
-        Vector<GMutablePointer> values = this->get_input_values({node.context(), input_socket});
+        Vector<GMutablePointer> values = this->get_input_values({node.context(), input_socket},
+                                                                allocator);
         for (int i = 0; i < values.size(); ++i) {
           /* Values from Multi Input Sockets are stored in input map with the format
            * <identifier>[<index>]. */
-          blender::StringRefNull key = allocator_.copy_string(
+          blender::StringRefNull key = allocator.copy_string(
               input_socket->identifier() + (i > 0 ? ("[" + std::to_string(i)) + "]" : ""));
           node_inputs_map.add_new_direct(key, std::move(values[i]));
         }
@@ -396,21 +773,56 @@ class GeometryNodesEvaluator {
     }
 
     /* Execute the node. */
-    GValueMap<StringRef> node_outputs_map{allocator_};
+    GValueMap<StringRef> node_outputs_map{allocator};
     GeoNodeExecParams params{
         node, node_inputs_map, node_outputs_map, handle_map_, self_object_, modifier_, depsgraph_};
-    this->execute_node(node, params);
+    const double start_time = PIL_check_seconds_timer();
+    this->execute_node(node, params, allocator);
+    const bool use_cache = task.cache_key.has_value() &&
+                           PIL_check_seconds_timer() - start_time >= NODE_CACHE_MIN_EXECUTION_TIME;
 
     /* Forward computed outputs to linked input sockets. */
     for (const OutputSocketRef *output_socket : node->outputs()) {
       if (output_socket->is_available()) {
         GMutablePointer value = node_outputs_map.extract(output_socket->identifier());
-        this->forward_to_inputs({node.context(), output_socket}, value);
+        if (use_cache) {
+          const CPPType &type = *value.type();
+          void *buffer = allocator.allocate(type.size(), type.alignment());
+          type.copy_to_uninitialized(value.get(), buffer);
+          task.outputs_to_cache.append({type, buffer});
+        }
+        this->forward_to_inputs({node.context(), output_socket}, value, allocator);
+      }
+      else if (use_cache) {
+        task.outputs_to_cache.append({});
       }
     }
   }
 
-  void execute_node(const DNode node, GeoNodeExecParams params)
+  void forward_cached_node(NodeTask &task)
+  {
+    const DNode node = task.node;
+    const NodesModifierCache::CachedNode &cached_node = *task.cached_node;
+
+    for (const OutputSocketRef *output_socket : node->outputs()) {
+      if (!output_socket->is_available()) {
+        continue;
+      }
+      const CPPType &type = *blender::nodes::socket_cpp_type_get(*output_socket->typeinfo());
+      const void *cached_value = nullptr;
+      if (output_socket->index() < cached_node.outputs.size()) {
+        cached_value = cached_node.outputs[output_socket->index()].get();
+      }
+      BLI_assert(cached_value != nullptr);
+      void *buffer = task.allocator.allocate(type.size(), type.alignment());
+      type.copy_to_uninitialized(cached_value ? cached_value : type.default_value(), buffer);
+      this->forward_to_inputs({node.context(), output_socket}, {type, buffer}, task.allocator);
+    }
+  }
+
+  void execute_node(const DNode node,
+                    GeoNodeExecParams params,
+                    blender::LinearAllocator<> &allocator)
   {
     const bNode &bnode = params.node();
 
@@ -425,7 +837,7 @@ class GeometryNodesEvaluator {
     /* Use the multi-function implementation if it exists. */
     const MultiFunction *multi_function = mf_by_node_.lookup_default(node, nullptr);
     if (multi_function != nullptr) {
-      this->execute_multi_function_node(node, params, *multi_function);
+      this->execute_multi_function_node(node, params, *multi_function, allocator);
       return;
     }
 
@@ -471,7 +883,8 @@ class GeometryNodesEvaluator {
 
   void execute_multi_function_node(const DNode node,
                                    GeoNodeExecParams params,
-                                   const MultiFunction &fn)
+                                   const MultiFunction &fn,
+                                   blender::LinearAllocator<> &allocator)
   {
     MFContextBuilder fn_context;
     MFParamsBuilder fn_params{fn, 1};
@@ -487,7 +900,7 @@ class GeometryNodesEvaluator {
     for (const OutputSocketRef *socket_ref : node->outputs()) {
       if (socket_ref->is_available()) {
         const CPPType &type = *blender::nodes::socket_cpp_type_get(*socket_ref->typeinfo());
-        void *buffer = allocator_.allocate(type.size(), type.alignment());
+        void *buffer = allocator.allocate(type.size(), type.alignment());
         fn_params.add_uninitialized_single_output(GMutableSpan(type, buffer, 1));
         output_data.append(GMutablePointer(type, buffer));
       }
@@ -517,7 +930,9 @@ class GeometryNodesEvaluator {
     }
   }
 
-  void forward_to_inputs(const DOutputSocket from_socket, GMutablePointer value_to_forward)
+  void forward_to_inputs(const DOutputSocket from_socket,
+                         GMutablePointer value_to_forward,
+                         blender::LinearAllocator<> &allocator)
   {
     /* For all sockets that are linked with the from_socket push the value to their node. */
     Vector<DInputSocket> to_sockets_all;
@@ -533,7 +948,7 @@ class GeometryNodesEvaluator {
         to_sockets_same_type.append(to_socket);
       }
       else {
-        void *buffer = allocator_.allocate(to_type.size(), to_type.alignment());
+        void *buffer = allocator.allocate(to_type.size(), to_type.alignment());
         if (conversions_.is_convertible(from_type, to_type)) {
           conversions_.convert(from_type, to_type, value_to_forward.get(), buffer);
         }
@@ -565,7 +980,7 @@ class GeometryNodesEvaluator {
       add_value_to_input_socket(first_key, value_to_forward);
       for (const DInputSocket &to_socket : other_to_sockets) {
         const std::pair<DInputSocket, DOutputSocket> key = std::make_pair(to_socket, from_socket);
-        void *buffer = allocator_.allocate(type.size(), type.alignment());
+        void *buffer = allocator.allocate(type.size(), type.alignment());
         type.copy_to_uninitialized(value_to_forward.get(), buffer);
         add_value_to_input_socket(key, GMutablePointer{type, buffer});
       }
@@ -575,15 +990,24 @@ class GeometryNodesEvaluator {
   void add_value_to_input_socket(const std::pair<DInputSocket, DOutputSocket> key,
                                  GMutablePointer value)
   {
+    std::lock_guard lock{value_by_input_mutex_};
     value_by_input_.add_new(key, value);
   }
 
+  std::optional<GMutablePointer> pop_value_from_input_socket(
+      const std::pair<DInputSocket, DOutputSocket> key)
+  {
+    std::lock_guard lock{value_by_input_mutex_};
+    return value_by_input_.pop_try(key);
+  }
+
   GMutablePointer get_unlinked_input_value(const DInputSocket &socket,
-                                           const CPPType &required_type)
+                                           const CPPType &required_type,
+                                           blender::LinearAllocator<> &allocator)
   {
     bNodeSocket *bsocket = socket->bsocket();
     const CPPType &type = *blender::nodes::socket_cpp_type_get(*socket->typeinfo());
-    void *buffer = allocator_.allocate(type.size(), type.alignment());
+    void *buffer = allocator.allocate(type.size(), type.alignment());
 
     if (bsocket->type == SOCK_OBJECT) {
       Object *object = ((bNodeSocketValueObject *)bsocket->default_value)->value;
@@ -603,13 +1027,13 @@ class GeometryNodesEvaluator {
       return {type, buffer};
     }
     if (conversions_.is_convertible(type, required_type)) {
-      void *converted_buffer = allocator_.allocate(required_type.size(),
-                                                   required_type.alignment());
+      void *converted_buffer = allocator.allocate(required_type.size(),
+                                                  required_type.alignment());
       conversions_.convert(type, required_type, buffer, converted_buffer);
       type.destruct(buffer);
       return {required_type, converted_buffer};
     }
-    void *default_buffer = allocator_.allocate(required_type.size(), required_type.alignment());
+    void *default_buffer = allocator.allocate(required_type.size(), required_type.alignment());
     type.copy_to_uninitialized(type.default_value(), default_buffer);
     return {required_type, default_buffer};
   }
@@ -1042,6 +1466,14 @@ static void reset_tree_ui_storage(Span<const blender::nodes::NodeTreeRef *> tree
   }
 }
 
+static NodesModifierCache &nodes_modifier_cache_ensure(NodesModifierData &nmd)
+{
+  if (nmd.modifier.runtime == nullptr) {
+    nmd.modifier.runtime = new NodesModifierCache();
+  }
+  return *(NodesModifierCache *)nmd.modifier.runtime;
+}
+
 /**
  * Evaluate a node group to compute the output geometry.
  * Currently, this uses a fairly basic and inefficient algorithm that might compute things more
@@ -1061,7 +1493,12 @@ static GeometrySet compute_geometry(const DerivedNodeTree &tree,
   PersistentDataHandleMap handle_map;
   fill_data_handle_map(nmd->settings, tree, handle_map);
 
+  const int64_t cache_limit = (int64_t)U.geometry_nodes_cache_limit * 1024 * 1024;
+  const bool use_cache = cache_limit > 0;
+
   Map<DOutputSocket, GMutablePointer> group_inputs;
+  /* Group inputs missing here depend on data that isn't hashed. */
+  Map<DOutputSocket, uint64_t> group_input_cache_keys;
 
   const DTreeContext *root_context = &tree.root_context();
   if (group_input_sockets.size() > 0) {
@@ -1075,6 +1512,12 @@ static GeometrySet compute_geometry(const DerivedNodeTree &tree,
           allocator.construct<GeometrySet>(std::move(input_geometry_set)).release();
       group_inputs.add_new({root_context, first_input_socket}, geometry_set_in);
       remaining_input_sockets = remaining_input_sockets.drop_front(1);
+
+      NodeCacheKey key;
+      if (use_cache && blender::modifiers::geometry_nodes::geometry_set_add_to_cache_key(
+                           *geometry_set_in, key)) {
+        group_input_cache_keys.add_new({root_context, first_input_socket}, key.value());
+      }
     }
 
     /* Initialize remaining group inputs. */
@@ -1083,9 +1526,29 @@ static GeometrySet compute_geometry(const DerivedNodeTree &tree,
       void *value_in = allocator.allocate(cpp_type.size(), cpp_type.alignment());
       initialize_group_input(*nmd, handle_map, *socket->bsocket(), cpp_type, value_in);
       group_inputs.add_new({root_context, socket}, {cpp_type, value_in});
+
+      if (use_cache &&
+          !ELEM(socket->bsocket()->type, SOCK_OBJECT, SOCK_COLLECTION, SOCK_GEOMETRY)) {
+        NodeCacheKey key;
+        key.add(cpp_type.hash(value_in));
+        group_input_cache_keys.add_new({root_context, socket}, key.value());
+      }
     }
   }
 
+  NodesModifierCache *cache = nullptr;
+  if (use_cache) {
+    cache = &nodes_modifier_cache_ensure(*nmd);
+    cache->begin_evaluation(cache_limit);
+  }
+  else if (nmd->modifier.runtime != nullptr) {
+    /* Free the results of evaluations from before caching was disabled. */
+    ((NodesModifierCache *)nmd->modifier.runtime)->clear();
+  }
+  NodeCacheKey cache_key_seed;
+  cache_key_seed.add(DEG_get_ctime(ctx->depsgraph));
+  cache_key_seed.add(DEG_get_mode(ctx->depsgraph));
+
   Vector<DInputSocket> group_outputs;
   group_outputs.append({root_context, &socket_to_compute});
 
@@ -1095,7 +1558,11 @@ static GeometrySet compute_geometry(const DerivedNodeTree &tree,
                                    handle_map,
                                    ctx->object,
                                    (ModifierData *)nmd,
-                                   ctx->depsgraph};
+                                   ctx->depsgraph,
+                                   cache,
+                                   std::move(group_input_cache_keys),
+                                   cache_key_seed.value(),
+                                   tree.used_node_tree_refs()};
 
   Vector<GMutablePointer> results = evaluator.execute();
   BLI_assert(results.size() == 1);
@@ -1343,6 +1810,12 @@ static void copyData(const ModifierData *md, ModifierData *target, const int fla
   }
 }
 
+static void freeRuntimeData(void *runtime_data)
+{
+  NodesModifierCache *cache = static_cast<NodesModifierCache *>(runtime_data);
+  delete cache;
+}
+
 static void freeData(ModifierData *md)
 {
   NodesModifierData *nmd = reinterpret_cast<NodesModifierData *>(md);
@@ -1350,6 +1823,8 @@ static void freeData(ModifierData *md)
     IDP_FreeProperty_ex(nmd->settings.properties, false);
     nmd->settings.properties = nullptr;
   }
+  freeRuntimeData(md->runtime);
+  md->runtime = nullptr;
 }
 
 static void requiredDataMask(Object *UNUSED(ob),
@@ -1393,7 +1868,7 @@ ModifierTypeInfo modifierType_Nodes = {
     /* dependsOnNormals */ nullptr,
     /* foreachIDLink */ foreachIDLink,
     /* foreachTexLink */ foreachTexLink,
-    /* freeRuntimeData */ nullptr,
+    /* freeRuntimeData */ freeRuntimeData,
     /* panelRegister */ panelRegister,
     /* blendWrite */ blendWrite,
     /* blendRead */ blendRead,
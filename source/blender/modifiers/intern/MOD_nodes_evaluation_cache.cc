@@ -0,0 +1,264 @@
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ * Copyright 2021, Blender Foundation.
+ */
+
+/** \file
+ * \ingroup modifiers
+ */
+
+#include "MEM_guardedalloc.h"
+
+#include "DNA_mesh_types.h"
+#include "DNA_meshdata_types.h"
+#include "DNA_pointcloud_types.h"
+
+#include "BLI_bitmap.h"
+
+#include "BKE_customdata.h"
+#include "BKE_geometry_set.hh"
+#include "BKE_subsurf.h"
+
+#include "MOD_nodes_evaluation_cache.hh"
+
+namespace blender::modifiers::geometry_nodes {
+
+using fn::CPPType;
+using fn::GMutablePointer;
+using fn::GPointer;
+
+/** Returns false when a layer references data that isn't hashed. */
+static bool custom_data_add_to_cache_key(const CustomData &data,
+                                         const int size,
+                                         NodeCacheKey &key)
+{
+  key.add(size);
+  key.add(data.totlayer);
+  for (const CustomDataLayer &layer : Span(data.layers, data.totlayer)) {
+    key.add(layer.type);
+    key.add_string(layer.name);
+    if (layer.data == nullptr) {
+      continue;
+    }
+    if (layer.type == CD_MDEFORMVERT) {
+      /* The weights are stored in separate arrays, hash them instead of the pointers. */
+      for (const MDeformVert &dvert : Span((const MDeformVert *)layer.data, size)) {
+        key.add(dvert.totweight);
+        if (dvert.dw != nullptr) {
+          key.add_data(dvert.dw, sizeof(MDeformWeight) * dvert.totweight);
+        }
+      }
+      continue;
+    }
+    if (layer.type == CD_MDISPS) {
+      for (const MDisps &mdisps : Span((const MDisps *)layer.data, size)) {
+        key.add(mdisps.totdisp);
+        key.add(mdisps.level);
+        if (mdisps.disps != nullptr) {
+          key.add_data(mdisps.disps, sizeof(*mdisps.disps) * mdisps.totdisp);
+        }
+        key.add(mdisps.hidden != nullptr);
+        if (mdisps.hidden != nullptr) {
+          key.add_data(mdisps.hidden, BLI_BITMAP_SIZE(mdisps.totdisp));
+        }
+      }
+      continue;
+    }
+    if (layer.type == CD_GRID_PAINT_MASK) {
+      for (const GridPaintMask &mask : Span((const GridPaintMask *)layer.data, size)) {
+        key.add(mask.level);
+        if (mask.data != nullptr) {
+          const int grid_size = BKE_ccg_gridsize(mask.level);
+          key.add_data(mask.data, sizeof(float) * grid_size * grid_size);
+        }
+      }
+      continue;
+    }
+    if (layer.type == CD_BM_ELEM_PYPTR) {
+      /* Pointers to Python objects, they have no content that can be hashed. */
+      return false;
+    }
+    key.add_data(layer.data, (size_t)CustomData_sizeof(layer.type) * size);
+  }
+  return true;
+}
+
+static int64_t custom_data_size(const CustomData &data, const int size)
+{
+  int64_t total = 0;
+  for (const CustomDataLayer &layer : Span(data.layers, data.totlayer)) {
+    total += (int64_t)CustomData_sizeof(layer.type) * size;
+  }
+  return total;
+}
+
+bool geometry_set_add_to_cache_key(const GeometrySet &geometry_set, NodeCacheKey &key)
+{
+  if (geometry_set.has_instances() || geometry_set.has_volume()) {
+    /* Instances and volumes reference data that changes independently. */
+    return false;
+  }
+  const Mesh *mesh = geometry_set.get_mesh_for_read();
+  key.add(mesh != nullptr);
+  if (mesh != nullptr) {
+    if (!custom_data_add_to_cache_key(mesh->vdata, mesh->totvert, key) ||
+        !custom_data_add_to_cache_key(mesh->edata, mesh->totedge, key) ||
+        !custom_data_add_to_cache_key(mesh->ldata, mesh->totloop, key) ||
+        !custom_data_add_to_cache_key(mesh->pdata, mesh->totpoly, key)) {
+      return false;
+    }
+    key.add(mesh->totcol);
+    if (mesh->mat != nullptr) {
+      key.add_data(mesh->mat, sizeof(*mesh->mat) * mesh->totcol);
+    }
+  }
+  const PointCloud *pointcloud = geometry_set.get_pointcloud_for_read();
+  key.add(pointcloud != nullptr);
+  if (pointcloud != nullptr) {
+    if (!custom_data_add_to_cache_key(pointcloud->pdata, pointcloud->totpoint, key)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+/**
+ * Approximate memory used by a value. Geometry is shared with the nodes using it until they
+ * modify it, the size of the data is counted anyway because it is kept alive by the cache.
+ */
+static int64_t value_size(const GPointer value)
+{
+  const CPPType &type = *value.type();
+  if (type != CPPType::get<GeometrySet>()) {
+    return type.size();
+  }
+  const GeometrySet &geometry_set = *(const GeometrySet *)value.get();
+  int64_t size = sizeof(GeometrySet);
+  if (const Mesh *mesh = geometry_set.get_mesh_for_read()) {
+    size += custom_data_size(mesh->vdata, mesh->totvert);
+    size += custom_data_size(mesh->edata, mesh->totedge);
+    size += custom_data_size(mesh->ldata, mesh->totloop);
+    size += custom_data_size(mesh->pdata, mesh->totpoly);
+  }
+  if (const PointCloud *pointcloud = geometry_set.get_pointcloud_for_read()) {
+    size += custom_data_size(pointcloud->pdata, pointcloud->totpoint);
+  }
+  if (const InstancesComponent *instances =
+          geometry_set.get_component_for_read<InstancesComponent>()) {
+    size += (int64_t)instances->instances_amount() *
+            (sizeof(float4x4) + sizeof(InstancedData) + sizeof(int));
+  }
+  return size;
+}
+
+NodesModifierCache::~NodesModifierCache()
+{
+  this->clear();
+}
+
+void NodesModifierCache::begin_evaluation(const int64_t max_size)
+{
+  max_size_ = max_size;
+  clock_++;
+}
+
+const NodesModifierCache::CachedNode *NodesModifierCache::lookup(const uint64_t key)
+{
+  CachedNode *node = nodes_.lookup_ptr(key);
+  if (node != nullptr) {
+    node->last_used = clock_;
+  }
+  return node;
+}
+
+bool NodesModifierCache::add(const uint64_t key,
+                             Span<GPointer> outputs,
+                             Vector<CachedUIStorage> ui_storage)
+{
+  if (nodes_.contains(key)) {
+    return false;
+  }
+
+  int64_t size = sizeof(CachedNode);
+  for (const GPointer value : outputs) {
+    if (value.get() != nullptr) {
+      size += value_size(value);
+    }
+  }
+  if (size > max_size_) {
+    return false;
+  }
+
+  /* Free the least recently used nodes until the new one fits. */
+  while (size_ + size > max_size_) {
+    uint64_t oldest_key = 0;
+    uint64_t oldest_last_used = UINT64_MAX;
+    for (auto item : nodes_.items()) {
+      if (item.value.last_used < oldest_last_used) {
+        oldest_key = item.key;
+        oldest_last_used = item.value.last_used;
+      }
+    }
+    CachedNode oldest = nodes_.pop(oldest_key);
+    this->free_node(oldest);
+  }
+
+  CachedNode node;
+  node.size = size;
+  node.last_used = clock_;
+  node.ui_storage = std::move(ui_storage);
+  for (const GPointer value : outputs) {
+    if (value.get() == nullptr) {
+      node.outputs.append({});
+      continue;
+    }
+    const CPPType &type = *value.type();
+    void *buffer = MEM_mallocN_aligned(type.size(), type.alignment(), __func__);
+    type.copy_to_uninitialized(value.get(), buffer);
+    if (type == CPPType::get<GeometrySet>()) {
+      /* The geometry can reference data that is freed after the evaluation, e.g. the mesh passed
+       * to the modifier. */
+      static_cast<GeometrySet *>(buffer)->ensure_owns_direct_data();
+    }
+    node.outputs.append({type, buffer});
+  }
+  nodes_.add_new(key, std::move(node));
+  size_ += size;
+  return true;
+}
+
+void NodesModifierCache::clear()
+{
+  for (CachedNode &node : nodes_.values()) {
+    this->free_node(node);
+  }
+  nodes_.clear();
+  size_ = 0;
+}
+
+void NodesModifierCache::free_node(CachedNode &node)
+{
+  for (GMutablePointer value : node.outputs) {
+    if (value.get() != nullptr) {
+      value.destruct();
+      MEM_freeN(value.get());
+    }
+  }
+  node.outputs.clear();
+  size_ -= node.size;
+}
+
+}  // namespace blender::modifiers::geometry_nodes
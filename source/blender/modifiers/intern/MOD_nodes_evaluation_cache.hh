@@ -0,0 +1,134 @@
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ * Copyright 2021, Blender Foundation.
+ */
+
+/** \file
+ * \ingroup modifiers
+ *
+ * Results of geometry nodes kept across evaluations of a modifier, so that only the nodes
+ * depending on something that changed are executed again.
+ */
+
+#pragma once
+
+#include "BLI_hash_mm2a.h"
+#include "BLI_map.hh"
+#include "BLI_string_ref.hh"
+#include "BLI_vector.hh"
+
+#include "BKE_node_ui_storage.hh"
+
+#include "FN_generic_pointer.hh"
+
+struct GeometrySet;
+
+namespace blender::modifiers::geometry_nodes {
+
+/**
+ * Accumulates everything the outputs of a node depend on: the node type and settings, the keys
+ * of the values passed to its inputs and the evaluation time.
+ */
+class NodeCacheKey {
+ private:
+  uint64_t value_ = 0;
+
+ public:
+  /** Hash raw memory, in 64 bits words (MurmurHash64A). */
+  void add_data(const void *data, size_t size)
+  {
+    value_ = BLI_hash_mm64a((const unsigned char *)data, size, value_);
+  }
+
+  /** Hash the bytes of a value, structs must not contain uninitialized padding. */
+  template<typename T> void add(const T &value)
+  {
+    this->add_data(&value, sizeof(T));
+  }
+
+  void add_string(StringRef str)
+  {
+    this->add(str.size());
+    this->add_data(str.data(), str.size());
+  }
+
+  uint64_t value() const
+  {
+    return value_;
+  }
+};
+
+/**
+ * Hash the data of the geometry, e.g. to get the key of the geometry passed to the modifier.
+ * Returns false for geometry that can't be hashed.
+ */
+bool geometry_set_add_to_cache_key(const GeometrySet &geometry_set, NodeCacheKey &key);
+
+/** Outputs of nodes from previous evaluations of a modifier. */
+class NodesModifierCache {
+ public:
+  struct CachedUIStorage {
+    /** Name of the original node tree, including the ID code. */
+    std::string tree_name;
+    std::string node_name;
+    NodeUIStorage storage;
+  };
+
+  struct CachedNode {
+    /** Values by output socket index, empty pointers for outputs that are not available. */
+    Vector<fn::GMutablePointer> outputs;
+    /**
+     * Warnings and attribute hints added when the node and the nodes it depends on were executed.
+     * None of them are executed again when the node is found in the cache.
+     */
+    Vector<CachedUIStorage> ui_storage;
+    int64_t size = 0;
+    uint64_t last_used = 0;
+  };
+
+ private:
+  Map<uint64_t, CachedNode> nodes_;
+  int64_t size_ = 0;
+  int64_t max_size_ = 0;
+  uint64_t clock_ = 0;
+
+ public:
+  ~NodesModifierCache();
+
+  /** Called before every evaluation, nodes looked up afterwards are the most recently used. */
+  void begin_evaluation(int64_t max_size);
+
+  /** The cached outputs of a node or null. Must not be used after adding nodes. */
+  const CachedNode *lookup(uint64_t key);
+
+  /**
+   * Add copies of the output values of a node, freeing the least recently used nodes to stay
+   * within the maximum size. Returns false when the outputs are larger than the cache.
+   */
+  bool add(uint64_t key, Span<fn::GPointer> outputs, Vector<CachedUIStorage> ui_storage);
+
+  int64_t size() const
+  {
+    return size_;
+  }
+
+  void clear();
+
+ private:
+  void free_node(CachedNode &node);
+};
+
+}  // namespace blender::modifiers::geometry_nodes
@@ -529,6 +529,8 @@ static Mesh *normalEditModifier_do(NormalEditModifierData *enmd,
   else {
     result = mesh;
   }
+  /* Sharp edges are written directly, the edges can still be shared with other meshes. */
+  result->medge = CustomData_duplicate_referenced_layer(&result->edata, CD_MEDGE, result->totedge);
 
   const int num_verts = result->totvert;
   const int num_edges = result->totedge;
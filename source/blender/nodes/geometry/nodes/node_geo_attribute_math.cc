@@ -29,6 +29,9 @@
 #include "UI_interface.h"
 #include "UI_resources.h"
 
+#include "FN_multi_function_builder.hh"
+#include "FN_multi_function_network_evaluation.hh"
+
 #include "NOD_math_functions.hh"
 
 static bNodeSocketTemplate geo_node_attribute_math_in[] = {
@@ -159,20 +162,26 @@ static void geo_node_attribute_math_update(bNodeTree *UNUSED(ntree), bNode *node
       operation_use_input_c(operation));
 }
 
+/* The math functions are evaluated in chunks by a multi-function network, so that the loops stay
+ * within the CPU cache on large domains. */
+
 static void do_math_operation(Span<float> span_a,
                               Span<float> span_b,
                               Span<float> span_c,
                               MutableSpan<float> span_result,
                               const NodeMathOperation operation)
 {
-  bool success = try_dispatch_float_math_fl_fl_fl_to_fl(
-      operation, [&](auto math_function, const FloatMathOperationInfo &UNUSED(info)) {
-        for (const int i : IndexRange(span_result.size())) {
-          span_result[i] = math_function(span_a[i], span_b[i], span_c[i]);
-        }
+  const fn::MultiFunction *math_fn = nullptr;
+  try_dispatch_float_math_fl_fl_fl_to_fl(
+      operation, [&](auto math_function, const FloatMathOperationInfo &info) {
+        static fn::CustomMF_SI_SI_SI_SO<float, float, float, float> fn{info.title_case_name,
+                                                                       math_function};
+        math_fn = &fn;
       });
-  BLI_assert(success);
-  UNUSED_VARS_NDEBUG(success);
+  BLI_assert(math_fn != nullptr);
+  if (math_fn != nullptr) {
+    fn::evaluate_multi_function_on_spans(*math_fn, {span_a, span_b, span_c}, {span_result});
+  }
 }
 
 static void do_math_operation(Span<float> span_a,
@@ -180,28 +189,32 @@ static void do_math_operation(Span<float> span_a,
                               MutableSpan<float> span_result,
                               const NodeMathOperation operation)
 {
-  bool success = try_dispatch_float_math_fl_fl_to_fl(
-      operation, [&](auto math_function, const FloatMathOperationInfo &UNUSED(info)) {
-        for (const int i : IndexRange(span_result.size())) {
-          span_result[i] = math_function(span_a[i], span_b[i]);
-        }
+  const fn::MultiFunction *math_fn = nullptr;
+  try_dispatch_float_math_fl_fl_to_fl(
+      operation, [&](auto math_function, const FloatMathOperationInfo &info) {
+        static fn::CustomMF_SI_SI_SO<float, float, float> fn{info.title_case_name, math_function};
+        math_fn = &fn;
       });
-  BLI_assert(success);
-  UNUSED_VARS_NDEBUG(success);
+  BLI_assert(math_fn != nullptr);
+  if (math_fn != nullptr) {
+    fn::evaluate_multi_function_on_spans(*math_fn, {span_a, span_b}, {span_result});
+  }
 }
 
 static void do_math_operation(Span<float> span_input,
                               MutableSpan<float> span_result,
                               const NodeMathOperation operation)
 {
-  bool success = try_dispatch_float_math_fl_to_fl(
-      operation, [&](auto math_function, const FloatMathOperationInfo &UNUSED(info)) {
-        for (const int i : IndexRange(span_result.size())) {
-          span_result[i] = math_function(span_input[i]);
-        }
+  const fn::MultiFunction *math_fn = nullptr;
+  try_dispatch_float_math_fl_to_fl(
+      operation, [&](auto math_function, const FloatMathOperationInfo &info) {
+        static fn::CustomMF_SI_SO<float, float> fn{info.title_case_name, math_function};
+        math_fn = &fn;
       });
-  BLI_assert(success);
-  UNUSED_VARS_NDEBUG(success);
+  BLI_assert(math_fn != nullptr);
+  if (math_fn != nullptr) {
+    fn::evaluate_multi_function_on_spans(*math_fn, {span_input}, {span_result});
+  }
 }
 
 static AttributeDomain get_result_domain(const GeometryComponent &component,
@@ -22,6 +22,7 @@
 #include "DNA_mesh_types.h"
 
 #include "BKE_bvhutils.h"
+#include "BKE_geometry_set_bvh_cache.hh"
 
 #include "UI_interface.h"
 #include "UI_resources.h"
@@ -126,39 +127,17 @@ static void proximity_calc(MutableSpan<float> distance_span,
   });
 }
 
-static bool bvh_from_mesh(const Mesh *target_mesh,
-                          int target_geometry_element,
-                          BVHTreeFromMesh &r_tree_data_mesh)
+static BVHCacheType get_bvh_type(const int target_geometry_element)
 {
-  BVHCacheType bvh_type = BVHTREE_FROM_LOOPTRI;
   switch (target_geometry_element) {
     case GEO_NODE_ATTRIBUTE_PROXIMITY_TARGET_GEOMETRY_ELEMENT_POINTS:
-      bvh_type = BVHTREE_FROM_VERTS;
-      break;
+      return BVHTREE_FROM_VERTS;
     case GEO_NODE_ATTRIBUTE_PROXIMITY_TARGET_GEOMETRY_ELEMENT_EDGES:
-      bvh_type = BVHTREE_FROM_EDGES;
-      break;
+      return BVHTREE_FROM_EDGES;
     case GEO_NODE_ATTRIBUTE_PROXIMITY_TARGET_GEOMETRY_ELEMENT_FACES:
-      bvh_type = BVHTREE_FROM_LOOPTRI;
-      break;
+      return BVHTREE_FROM_LOOPTRI;
   }
-
-  /* This only updates a cache and can be considered to be logically const. */
-  BKE_bvhtree_from_mesh_get(&r_tree_data_mesh, const_cast<Mesh *>(target_mesh), bvh_type, 2);
-  if (r_tree_data_mesh.tree == nullptr) {
-    return false;
-  }
-  return true;
-}
-
-static bool bvh_from_pointcloud(const PointCloud *target_pointcloud,
-                                BVHTreeFromPointCloud &r_tree_data_pointcloud)
-{
-  BKE_bvhtree_from_pointcloud_get(&r_tree_data_pointcloud, target_pointcloud, 2);
-  if (r_tree_data_pointcloud.tree == nullptr) {
-    return false;
-  }
-  return true;
+  return BVHTREE_FROM_LOOPTRI;
 }
 
 static void attribute_calc_proximity(GeometryComponent &component,
@@ -187,21 +166,24 @@ static void attribute_calc_proximity(GeometryComponent &component,
   const NodeGeometryAttributeProximity &storage = *(const NodeGeometryAttributeProximity *)
                                                        node.storage;
 
+  /* The trees are taken from a cache that is keyed by the content of the target geometry, so
+   * they are not rebuilt when the target did not change since the last evaluation. */
   BVHTreeFromMesh tree_data_mesh;
   BVHTreeFromPointCloud tree_data_pointcloud;
-  bool bvh_mesh_success = false;
-  bool bvh_pointcloud_success = false;
+  bke::CachedBVHTreeUser mesh_tree_user;
+  bke::CachedBVHTreeUser pointcloud_tree_user;
 
   if (geometry_set_target.has_mesh()) {
-    bvh_mesh_success = bvh_from_mesh(
-        geometry_set_target.get_mesh_for_read(), storage.target_geometry_element, tree_data_mesh);
+    mesh_tree_user = bke::bvh_cache_get_for_mesh(*geometry_set_target.get_mesh_for_read(),
+                                                 get_bvh_type(storage.target_geometry_element),
+                                                 tree_data_mesh);
   }
 
   if (geometry_set_target.has_pointcloud() &&
       storage.target_geometry_element ==
           GEO_NODE_ATTRIBUTE_PROXIMITY_TARGET_GEOMETRY_ELEMENT_POINTS) {
-    bvh_pointcloud_success = bvh_from_pointcloud(geometry_set_target.get_pointcloud_for_read(),
-                                                 tree_data_pointcloud);
+    pointcloud_tree_user = bke::bvh_cache_get_for_pointcloud(
+        *geometry_set_target.get_pointcloud_for_read(), tree_data_pointcloud);
   }
 
   Span<float3> position_span = position_attribute->get_span<float3>();
@@ -218,18 +200,11 @@ static void attribute_calc_proximity(GeometryComponent &component,
                  position_span,
                  tree_data_mesh,
                  tree_data_pointcloud,
-                 bvh_mesh_success,
-                 bvh_pointcloud_success,
+                 mesh_tree_user != nullptr,
+                 pointcloud_tree_user != nullptr,
                  distance_attribute,  /* Boolean. */
                  location_attribute); /* Boolean. */
 
-  if (bvh_mesh_success) {
-    free_bvhtree_from_mesh(&tree_data_mesh);
-  }
-  if (bvh_pointcloud_success) {
-    free_bvhtree_from_pointcloud(&tree_data_pointcloud);
-  }
-
   if (distance_attribute) {
     distance_attribute.apply_span_and_save();
   }
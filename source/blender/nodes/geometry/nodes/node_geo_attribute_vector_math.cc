@@ -29,6 +29,9 @@
 #include "UI_interface.h"
 #include "UI_resources.h"
 
+#include "FN_multi_function_builder.hh"
+#include "FN_multi_function_network_evaluation.hh"
+
 #include "NOD_math_functions.hh"
 
 static bNodeSocketTemplate geo_node_attribute_vector_math_in[] = {
@@ -169,27 +172,25 @@ static void do_math_operation_fl3_fl3_to_fl3(const Float3ReadAttribute &input_a,
                                              Float3WriteAttribute result,
                                              const NodeVectorMathOperation operation)
 {
-  const int size = input_a.size();
-
   Span<float3> span_a = input_a.get_span();
   Span<float3> span_b = input_b.get_span();
   MutableSpan<float3> span_result = result.get_span_for_write_only();
 
-  bool success = try_dispatch_float_math_fl3_fl3_to_fl3(
-      operation, [&](auto math_function, const FloatMathOperationInfo &UNUSED(info)) {
-        for (const int i : IndexRange(size)) {
-          const float3 a = span_a[i];
-          const float3 b = span_b[i];
-          const float3 out = math_function(a, b);
-          span_result[i] = out;
-        }
+  const fn::MultiFunction *math_fn = nullptr;
+  try_dispatch_float_math_fl3_fl3_to_fl3(
+      operation, [&](auto math_function, const FloatMathOperationInfo &info) {
+        static fn::CustomMF_SI_SI_SO<float3, float3, float3> fn{info.title_case_name,
+                                                                math_function};
+        math_fn = &fn;
       });
 
-  result.apply_span();
-
   /* The operation is not supported by this node currently. */
-  BLI_assert(success);
-  UNUSED_VARS_NDEBUG(success);
+  BLI_assert(math_fn != nullptr);
+  if (math_fn != nullptr) {
+    fn::evaluate_multi_function_on_spans(*math_fn, {span_a, span_b}, {span_result});
+  }
+
+  result.apply_span();
 }
 
 static void do_math_operation_fl3_fl3_fl3_to_fl3(const Float3ReadAttribute &input_a,
@@ -198,29 +199,26 @@ static void do_math_operation_fl3_fl3_fl3_to_fl3(const Float3ReadAttribute &inpu
                                                  Float3WriteAttribute result,
                                                  const NodeVectorMathOperation operation)
 {
-  const int size = input_a.size();
-
   Span<float3> span_a = input_a.get_span();
   Span<float3> span_b = input_b.get_span();
   Span<float3> span_c = input_c.get_span();
   MutableSpan<float3> span_result = result.get_span_for_write_only();
 
-  bool success = try_dispatch_float_math_fl3_fl3_fl3_to_fl3(
-      operation, [&](auto math_function, const FloatMathOperationInfo &UNUSED(info)) {
-        for (const int i : IndexRange(size)) {
-          const float3 a = span_a[i];
-          const float3 b = span_b[i];
-          const float3 c = span_c[i];
-          const float3 out = math_function(a, b, c);
-          span_result[i] = out;
-        }
+  const fn::MultiFunction *math_fn = nullptr;
+  try_dispatch_float_math_fl3_fl3_fl3_to_fl3(
+      operation, [&](auto math_function, const FloatMathOperationInfo &info) {
+        static fn::CustomMF_SI_SI_SI_SO<float3, float3, float3, float3> fn{info.title_case_name,
+                                                                           math_function};
+        math_fn = &fn;
       });
 
-  result.apply_span();
-
   /* The operation is not supported by this node currently. */
-  BLI_assert(success);
-  UNUSED_VARS_NDEBUG(success);
+  BLI_assert(math_fn != nullptr);
+  if (math_fn != nullptr) {
+    fn::evaluate_multi_function_on_spans(*math_fn, {span_a, span_b, span_c}, {span_result});
+  }
+
+  result.apply_span();
 }
 
 static void do_math_operation_fl3_fl3_to_fl(const Float3ReadAttribute &input_a,
@@ -228,27 +226,25 @@ static void do_math_operation_fl3_fl3_to_fl(const Float3ReadAttribute &input_a,
                                             FloatWriteAttribute result,
                                             const NodeVectorMathOperation operation)
 {
-  const int size = input_a.size();
-
   Span<float3> span_a = input_a.get_span();
   Span<float3> span_b = input_b.get_span();
   MutableSpan<float> span_result = result.get_span_for_write_only();
 
-  bool success = try_dispatch_float_math_fl3_fl3_to_fl(
-      operation, [&](auto math_function, const FloatMathOperationInfo &UNUSED(info)) {
-        for (const int i : IndexRange(size)) {
-          const float3 a = span_a[i];
-          const float3 b = span_b[i];
-          const float out = math_function(a, b);
-          span_result[i] = out;
-        }
+  const fn::MultiFunction *math_fn = nullptr;
+  try_dispatch_float_math_fl3_fl3_to_fl(
+      operation, [&](auto math_function, const FloatMathOperationInfo &info) {
+        static fn::CustomMF_SI_SI_SO<float3, float3, float> fn{info.title_case_name,
+                                                               math_function};
+        math_fn = &fn;
       });
 
-  result.apply_span();
-
   /* The operation is not supported by this node currently. */
-  BLI_assert(success);
-  UNUSED_VARS_NDEBUG(success);
+  BLI_assert(math_fn != nullptr);
+  if (math_fn != nullptr) {
+    fn::evaluate_multi_function_on_spans(*math_fn, {span_a, span_b}, {span_result});
+  }
+
+  result.apply_span();
 }
 
 static void do_math_operation_fl3_fl_to_fl3(const Float3ReadAttribute &input_a,
@@ -256,77 +252,71 @@ static void do_math_operation_fl3_fl_to_fl3(const Float3ReadAttribute &input_a,
                                             Float3WriteAttribute result,
                                             const NodeVectorMathOperation operation)
 {
-  const int size = input_a.size();
-
   Span<float3> span_a = input_a.get_span();
   Span<float> span_b = input_b.get_span();
   MutableSpan<float3> span_result = result.get_span_for_write_only();
 
-  bool success = try_dispatch_float_math_fl3_fl_to_fl3(
-      operation, [&](auto math_function, const FloatMathOperationInfo &UNUSED(info)) {
-        for (const int i : IndexRange(size)) {
-          const float3 a = span_a[i];
-          const float b = span_b[i];
-          const float3 out = math_function(a, b);
-          span_result[i] = out;
-        }
+  const fn::MultiFunction *math_fn = nullptr;
+  try_dispatch_float_math_fl3_fl_to_fl3(
+      operation, [&](auto math_function, const FloatMathOperationInfo &info) {
+        static fn::CustomMF_SI_SI_SO<float3, float, float3> fn{info.title_case_name,
+                                                               math_function};
+        math_fn = &fn;
       });
 
-  result.apply_span();
-
   /* The operation is not supported by this node currently. */
-  BLI_assert(success);
-  UNUSED_VARS_NDEBUG(success);
+  BLI_assert(math_fn != nullptr);
+  if (math_fn != nullptr) {
+    fn::evaluate_multi_function_on_spans(*math_fn, {span_a, span_b}, {span_result});
+  }
+
+  result.apply_span();
 }
 
 static void do_math_operation_fl3_to_fl3(const Float3ReadAttribute &input_a,
                                          Float3WriteAttribute result,
                                          const NodeVectorMathOperation operation)
 {
-  const int size = input_a.size();
-
   Span<float3> span_a = input_a.get_span();
   MutableSpan<float3> span_result = result.get_span_for_write_only();
 
-  bool success = try_dispatch_float_math_fl3_to_fl3(
-      operation, [&](auto math_function, const FloatMathOperationInfo &UNUSED(info)) {
-        for (const int i : IndexRange(size)) {
-          const float3 in = span_a[i];
-          const float3 out = math_function(in);
-          span_result[i] = out;
-        }
+  const fn::MultiFunction *math_fn = nullptr;
+  try_dispatch_float_math_fl3_to_fl3(
+      operation, [&](auto math_function, const FloatMathOperationInfo &info) {
+        static fn::CustomMF_SI_SO<float3, float3> fn{info.title_case_name, math_function};
+        math_fn = &fn;
       });
 
-  result.apply_span();
-
   /* The operation is not supported by this node currently. */
-  BLI_assert(success);
-  UNUSED_VARS_NDEBUG(success);
+  BLI_assert(math_fn != nullptr);
+  if (math_fn != nullptr) {
+    fn::evaluate_multi_function_on_spans(*math_fn, {span_a}, {span_result});
+  }
+
+  result.apply_span();
 }
 
 static void do_math_operation_fl3_to_fl(const Float3ReadAttribute &input_a,
                                         FloatWriteAttribute result,
                                         const NodeVectorMathOperation operation)
 {
-  const int size = input_a.size();
-
   Span<float3> span_a = input_a.get_span();
   MutableSpan<float> span_result = result.get_span_for_write_only();
 
-  bool success = try_dispatch_float_math_fl3_to_fl(
-      operation, [&](auto math_function, const FloatMathOperationInfo &UNUSED(info)) {
-        for (const int i : IndexRange(size)) {
-          const float3 in = span_a[i];
-          const float out = math_function(in);
-          span_result[i] = out;
-        }
+  const fn::MultiFunction *math_fn = nullptr;
+  try_dispatch_float_math_fl3_to_fl(
+      operation, [&](auto math_function, const FloatMathOperationInfo &info) {
+        static fn::CustomMF_SI_SO<float3, float> fn{info.title_case_name, math_function};
+        math_fn = &fn;
       });
 
-  result.apply_span();
-
   /* The operation is not supported by this node currently. */
-  BLI_assert(success);
-  UNUSED_VARS_NDEBUG(success);
+  BLI_assert(math_fn != nullptr);
+  if (math_fn != nullptr) {
+    fn::evaluate_multi_function_on_spans(*math_fn, {span_a}, {span_result});
+  }
+
+  result.apply_span();
 }
 
 static AttributeDomain get_result_domain(const GeometryComponent &component,
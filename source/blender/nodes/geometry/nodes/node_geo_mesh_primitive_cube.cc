@@ -18,6 +18,7 @@
 
 #include "BKE_lib_id.h"
 #include "BKE_mesh.h"
+#include "BKE_mesh_primitive_cache.hh"
 
 #include "bmesh.h"
 
@@ -66,7 +67,13 @@ static void geo_node_mesh_primitive_cube_exec(GeoNodeExecParams params)
   const float3 location = params.extract_input<float3>("Location");
   const float3 rotation = params.extract_input<float3>("Rotation");
 
-  Mesh *mesh = create_cube_mesh(location, rotation, size);
+  /* The operator scales by the size, and so does the transform matrix it gets. */
+  float4x4 transform;
+  loc_eul_size_to_mat4(transform.values, location, rotation, float3(size * size));
+  Mesh *mesh = bke::mesh_primitive_cache_get(
+      {GEO_NODE_MESH_PRIMITIVE_CUBE, {0, 0}},
+      [&]() { return create_cube_mesh(float3(0), float3(0), 1.0f); },
+      transform);
   params.set_output("Geometry", GeometrySet::create_with_mesh(mesh));
 }
 
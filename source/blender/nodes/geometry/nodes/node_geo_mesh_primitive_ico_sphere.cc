@@ -18,6 +18,7 @@
 
 #include "BKE_lib_id.h"
 #include "BKE_mesh.h"
+#include "BKE_mesh_primitive_cache.hh"
 
 #include "bmesh.h"
 
@@ -72,7 +73,19 @@ static void geo_node_mesh_primitive_ico_sphere_exec(GeoNodeExecParams params)
   const float3 location = params.extract_input<float3>("Location");
   const float3 rotation = params.extract_input<float3>("Rotation");
 
-  Mesh *mesh = create_ico_sphere_mesh(location, rotation, subdivisions, radius);
+  if (radius <= 0.0f) {
+    /* Keep the result of the operator for sizes that are not a plain scale of the cached mesh. */
+    Mesh *mesh = create_ico_sphere_mesh(location, rotation, subdivisions, radius);
+    params.set_output("Geometry", GeometrySet::create_with_mesh(mesh));
+    return;
+  }
+
+  float4x4 transform;
+  loc_eul_size_to_mat4(transform.values, location, rotation, float3(radius));
+  Mesh *mesh = bke::mesh_primitive_cache_get(
+      {GEO_NODE_MESH_PRIMITIVE_ICO_SPHERE, {subdivisions, 0}},
+      [&]() { return create_ico_sphere_mesh(float3(0), float3(0), subdivisions, 1.0f); },
+      transform);
   params.set_output("Geometry", GeometrySet::create_with_mesh(mesh));
 }
 
@@ -19,6 +19,7 @@
 
 #include "BKE_lib_id.h"
 #include "BKE_mesh.h"
+#include "BKE_mesh_primitive_cache.hh"
 
 #include "UI_interface.h"
 #include "UI_resources.h"
@@ -112,7 +113,22 @@ static void geo_node_mesh_primitive_uv_sphere_exec(GeoNodeExecParams params)
   const float3 location = params.extract_input<float3>("Location");
   const float3 rotation = params.extract_input<float3>("Rotation");
 
-  Mesh *mesh = create_uv_sphere_mesh_bmesh(location, rotation, radius, segments_num, rings_num);
+  if (radius <= 0.0f) {
+    /* Without a size, all vertices are merged, so the topology is not the cached one. */
+    Mesh *mesh = create_uv_sphere_mesh_bmesh(location, rotation, radius, segments_num, rings_num);
+    params.set_output("Geometry", GeometrySet::create_with_mesh(mesh));
+    return;
+  }
+
+  /* The operator scales by the radius, and so does the transform matrix it gets. */
+  float4x4 transform;
+  loc_eul_size_to_mat4(transform.values, location, rotation, float3(radius * radius));
+  Mesh *mesh = bke::mesh_primitive_cache_get(
+      {GEO_NODE_MESH_PRIMITIVE_UV_SPHERE, {segments_num, rings_num}},
+      [&]() {
+        return create_uv_sphere_mesh_bmesh(float3(0), float3(0), 1.0f, segments_num, rings_num);
+      },
+      transform);
   params.set_output("Geometry", GeometrySet::create_with_mesh(mesh));
 }
 
@@ -16,10 +16,11 @@
 
 #include "BLI_float3.hh"
 #include "BLI_hash.h"
-#include "BLI_kdtree.h"
 #include "BLI_math_vector.h"
+#include "BLI_poisson_disk.hh"
 #include "BLI_rand.hh"
 #include "BLI_span.hh"
+#include "BLI_task.hh"
 #include "BLI_timeit.hh"
 
 #include "DNA_mesh_types.h"
@@ -92,6 +93,55 @@ static Span<MLoopTri> get_mesh_looptris(const Mesh &mesh)
   return {looptris, looptris_len};
 }
 
+struct LooptriVertices {
+  int v0_loop, v1_loop, v2_loop;
+  float3 v0_pos, v1_pos, v2_pos;
+};
+
+static LooptriVertices get_looptri_vertices(const Mesh &mesh,
+                                            const MLoopTri &looptri,
+                                            const float4x4 &transform)
+{
+  LooptriVertices vertices;
+  vertices.v0_loop = looptri.tri[0];
+  vertices.v1_loop = looptri.tri[1];
+  vertices.v2_loop = looptri.tri[2];
+  vertices.v0_pos = transform * float3(mesh.mvert[mesh.mloop[vertices.v0_loop].v].co);
+  vertices.v1_pos = transform * float3(mesh.mvert[mesh.mloop[vertices.v1_loop].v].co);
+  vertices.v2_pos = transform * float3(mesh.mvert[mesh.mloop[vertices.v2_loop].v].co);
+  return vertices;
+}
+
+/**
+ * Every looptri has its own random number generator, seeded only by the looptri index and the
+ * node's seed. That way the looptris can be sampled in parallel and the result does not depend on
+ * the order in which they are processed.
+ */
+static RandomNumberGenerator get_looptri_rng(const int looptri_index, const int seed)
+{
+  return RandomNumberGenerator(BLI_hash_int(looptri_index + seed));
+}
+
+static int sample_looptri_point_amount(const LooptriVertices &vertices,
+                                       const float base_density,
+                                       const Span<float> density_factors,
+                                       RandomNumberGenerator &looptri_rng)
+{
+  float looptri_density_factor = 1.0f;
+  if (!density_factors.is_empty()) {
+    const float v0_density_factor = std::max(0.0f, density_factors[vertices.v0_loop]);
+    const float v1_density_factor = std::max(0.0f, density_factors[vertices.v1_loop]);
+    const float v2_density_factor = std::max(0.0f, density_factors[vertices.v2_loop]);
+    looptri_density_factor = (v0_density_factor + v1_density_factor + v2_density_factor) / 3.0f;
+  }
+  const float area = area_tri_v3(vertices.v0_pos, vertices.v1_pos, vertices.v2_pos);
+
+  const float points_amount_fl = area * base_density * looptri_density_factor;
+  const float add_point_probability = fractf(points_amount_fl);
+  const bool add_point = add_point_probability > looptri_rng.get_float();
+  return (int)points_amount_fl + (int)add_point;
+}
+
 static void sample_mesh_surface(const Mesh &mesh,
                                 const float4x4 &transform,
                                 const float base_density,
@@ -102,61 +152,56 @@ static void sample_mesh_surface(const Mesh &mesh,
                                 Vector<int> &r_looptri_indices)
 {
   Span<MLoopTri> looptris = get_mesh_looptris(mesh);
+  /* Retrieve the span before sampling in parallel, it may have to be computed first. */
+  const Span<float> density_span = density_factors ? density_factors->get_span() : Span<float>();
+
+  /* Count the points of every looptri first, so that the points can be written to their final
+   * place directly in the second pass. */
+  Array<int> looptri_offsets(looptris.size() + 1);
+  parallel_for(looptris.index_range(), 1024, [&](IndexRange range) {
+    for (const int looptri_index : range) {
+      const LooptriVertices vertices = get_looptri_vertices(
+          mesh, looptris[looptri_index], transform);
+      RandomNumberGenerator looptri_rng = get_looptri_rng(looptri_index, seed);
+      looptri_offsets[looptri_index] = sample_looptri_point_amount(
+          vertices, base_density, density_span, looptri_rng);
+    }
+  });
 
+  int points_len = 0;
   for (const int looptri_index : looptris.index_range()) {
-    const MLoopTri &looptri = looptris[looptri_index];
-    const int v0_loop = looptri.tri[0];
-    const int v1_loop = looptri.tri[1];
-    const int v2_loop = looptri.tri[2];
-    const int v0_index = mesh.mloop[v0_loop].v;
-    const int v1_index = mesh.mloop[v1_loop].v;
-    const int v2_index = mesh.mloop[v2_loop].v;
-    const float3 v0_pos = transform * float3(mesh.mvert[v0_index].co);
-    const float3 v1_pos = transform * float3(mesh.mvert[v1_index].co);
-    const float3 v2_pos = transform * float3(mesh.mvert[v2_index].co);
-
-    float looptri_density_factor = 1.0f;
-    if (density_factors != nullptr) {
-      const float v0_density_factor = std::max(0.0f, (*density_factors)[v0_loop]);
-      const float v1_density_factor = std::max(0.0f, (*density_factors)[v1_loop]);
-      const float v2_density_factor = std::max(0.0f, (*density_factors)[v2_loop]);
-      looptri_density_factor = (v0_density_factor + v1_density_factor + v2_density_factor) / 3.0f;
-    }
-    const float area = area_tri_v3(v0_pos, v1_pos, v2_pos);
-
-    const int looptri_seed = BLI_hash_int(looptri_index + seed);
-    RandomNumberGenerator looptri_rng(looptri_seed);
-
-    const float points_amount_fl = area * base_density * looptri_density_factor;
-    const float add_point_probability = fractf(points_amount_fl);
-    const bool add_point = add_point_probability > looptri_rng.get_float();
-    const int point_amount = (int)points_amount_fl + (int)add_point;
-
-    for (int i = 0; i < point_amount; i++) {
-      const float3 bary_coord = looptri_rng.get_barycentric_coordinates();
-      float3 point_pos;
-      interp_v3_v3v3v3(point_pos, v0_pos, v1_pos, v2_pos, bary_coord);
-      r_positions.append(point_pos);
-      r_bary_coords.append(bary_coord);
-      r_looptri_indices.append(looptri_index);
-    }
+    const int point_amount = looptri_offsets[looptri_index];
+    looptri_offsets[looptri_index] = points_len;
+    points_len += point_amount;
   }
-}
+  looptri_offsets.last() = points_len;
 
-BLI_NOINLINE static KDTree_3d *build_kdtree(Span<Vector<float3>> positions_all,
-                                            const int initial_points_len)
-{
-  KDTree_3d *kdtree = BLI_kdtree_3d_new(initial_points_len);
+  r_positions.resize(points_len);
+  r_bary_coords.resize(points_len);
+  r_looptri_indices.resize(points_len);
 
-  int i_point = 0;
-  for (const Vector<float3> &positions : positions_all) {
-    for (const float3 position : positions) {
-      BLI_kdtree_3d_insert(kdtree, i_point, position);
-      i_point++;
+  parallel_for(looptris.index_range(), 1024, [&](IndexRange range) {
+    for (const int looptri_index : range) {
+      const int offset = looptri_offsets[looptri_index];
+      const int point_amount = looptri_offsets[looptri_index + 1] - offset;
+      if (point_amount == 0) {
+        continue;
+      }
+      const LooptriVertices vertices = get_looptri_vertices(
+          mesh, looptris[looptri_index], transform);
+      RandomNumberGenerator looptri_rng = get_looptri_rng(looptri_index, seed);
+      /* Skip the random number that decided whether to add a point in the first pass. */
+      looptri_rng.get_float();
+
+      for (const int i : IndexRange(offset, point_amount)) {
+        const float3 bary_coord = looptri_rng.get_barycentric_coordinates();
+        interp_v3_v3v3v3(
+            r_positions[i], vertices.v0_pos, vertices.v1_pos, vertices.v2_pos, bary_coord);
+        r_bary_coords[i] = bary_coord;
+        r_looptri_indices[i] = looptri_index;
+      }
     }
-  }
-  BLI_kdtree_3d_balance(kdtree);
-  return kdtree;
+  });
 }
 
 BLI_NOINLINE static void update_elimination_mask_for_close_points(
@@ -170,39 +215,16 @@ BLI_NOINLINE static void update_elimination_mask_for_close_points(
     return;
   }
 
-  KDTree_3d *kdtree = build_kdtree(positions_all, initial_points_len);
-
-  /* The elimination mask is a flattened array for every point,
-   * so keep track of the index to it separately. */
+  /* The elimination mask is a flattened array for every point, so the positions of all instances
+   * have to be flattened the same way. */
+  Array<float3> positions_flat(initial_points_len);
   for (const int i_instance : positions_all.index_range()) {
     Span<float3> positions = positions_all[i_instance];
     const int offset = instance_start_offsets[i_instance];
-
-    for (const int i : positions.index_range()) {
-      if (elimination_mask[offset + i]) {
-        continue;
-      }
-
-      struct CallbackData {
-        int index;
-        MutableSpan<bool> elimination_mask;
-      } callback_data = {offset + i, elimination_mask};
-
-      BLI_kdtree_3d_range_search_cb(
-          kdtree,
-          positions[i],
-          minimum_distance,
-          [](void *user_data, int index, const float *UNUSED(co), float UNUSED(dist_sq)) {
-            CallbackData &callback_data = *static_cast<CallbackData *>(user_data);
-            if (index != callback_data.index) {
-              callback_data.elimination_mask[index] = true;
-            }
-            return true;
-          },
-          &callback_data);
-    }
+    positions_flat.as_mutable_span().slice(offset, positions.size()).copy_from(positions);
   }
-  BLI_kdtree_3d_free(kdtree);
+
+  poisson_disk_eliminate_close_points(positions_flat, minimum_distance, elimination_mask);
 }
 
 BLI_NOINLINE static void update_elimination_mask_based_on_density_factors(
@@ -213,30 +235,34 @@ BLI_NOINLINE static void update_elimination_mask_based_on_density_factors(
     MutableSpan<bool> elimination_mask)
 {
   Span<MLoopTri> looptris = get_mesh_looptris(mesh);
-  for (const int i : bary_coords.index_range()) {
-    if (elimination_mask[i]) {
-      continue;
-    }
+  const Span<float> density_span = density_factors.get_span();
+  parallel_for(bary_coords.index_range(), 2048, [&](IndexRange range) {
+    for (const int i : range) {
+      if (elimination_mask[i]) {
+        continue;
+      }
 
-    const MLoopTri &looptri = looptris[looptri_indices[i]];
-    const float3 bary_coord = bary_coords[i];
+      const MLoopTri &looptri = looptris[looptri_indices[i]];
+      const float3 bary_coord = bary_coords[i];
 
-    const int v0_loop = looptri.tri[0];
-    const int v1_loop = looptri.tri[1];
-    const int v2_loop = looptri.tri[2];
+      const int v0_loop = looptri.tri[0];
+      const int v1_loop = looptri.tri[1];
+      const int v2_loop = looptri.tri[2];
 
-    const float v0_density_factor = std::max(0.0f, density_factors[v0_loop]);
-    const float v1_density_factor = std::max(0.0f, density_factors[v1_loop]);
-    const float v2_density_factor = std::max(0.0f, density_factors[v2_loop]);
+      const float v0_density_factor = std::max(0.0f, density_span[v0_loop]);
+      const float v1_density_factor = std::max(0.0f, density_span[v1_loop]);
+      const float v2_density_factor = std::max(0.0f, density_span[v2_loop]);
 
-    const float probablity = v0_density_factor * bary_coord.x + v1_density_factor * bary_coord.y +
-                             v2_density_factor * bary_coord.z;
+      const float probablity = v0_density_factor * bary_coord.x +
+                               v1_density_factor * bary_coord.y +
+                               v2_density_factor * bary_coord.z;
 
-    const float hash = BLI_hash_int_01(bary_coord.hash());
-    if (hash > probablity) {
-      elimination_mask[i] = true;
+      const float hash = BLI_hash_int_01(bary_coord.hash());
+      if (hash > probablity) {
+        elimination_mask[i] = true;
+      }
     }
-  }
+  });
 }
 
 BLI_NOINLINE static void eliminate_points_based_on_mask(Span<bool> elimination_mask,
@@ -39,24 +39,17 @@ static bNodeSocketTemplate geo_node_point_instance_out[] = {
 namespace blender::nodes {
 
 static void fill_new_attribute_from_input(const ReadAttribute &input_attribute,
-                                          WriteAttribute &out_attribute_a,
-                                          WriteAttribute &out_attribute_b,
-                                          Span<bool> a_or_b)
+                                          WriteAttribute &out_attribute,
+                                          IndexMask mask)
 {
-  fn::GSpan in_span = input_attribute.get_span();
-  int i_a = 0;
-  int i_b = 0;
-  for (int i_in = 0; i_in < in_span.size(); i_in++) {
-    const bool move_to_b = a_or_b[i_in];
-    if (move_to_b) {
-      out_attribute_b.set(i_b, in_span[i_in]);
-      i_b++;
-    }
-    else {
-      out_attribute_a.set(i_a, in_span[i_in]);
-      i_a++;
-    }
+  if (mask.size() == 0) {
+    return;
   }
+  /* Only the values that are copied are read, so interpolated or converted input attributes are
+   * not computed for the entire input. */
+  fn::GMutableSpan out_span = out_attribute.get_span_for_write_only();
+  input_attribute.materialize_compressed(mask, out_span);
+  out_attribute.apply_span();
 }
 
 /**
@@ -70,6 +63,17 @@ static void move_split_attributes(const GeometryComponent &in_component,
                                   GeometryComponent &out_component_b,
                                   Span<bool> a_or_b)
 {
+  Vector<int64_t> a_indices;
+  Vector<int64_t> b_indices;
+  for (const int i : a_or_b.index_range()) {
+    if (a_or_b[i]) {
+      b_indices.append(i);
+    }
+    else {
+      a_indices.append(i);
+    }
+  }
+
   Set<std::string> attribute_names = in_component.attribute_names();
 
   for (const std::string &name : attribute_names) {
@@ -104,7 +108,8 @@ static void move_split_attributes(const GeometryComponent &in_component,
       continue;
     }
 
-    fill_new_attribute_from_input(*attribute, *out_attribute_a, *out_attribute_b, a_or_b);
+    fill_new_attribute_from_input(*attribute, *out_attribute_a, a_indices.as_span());
+    fill_new_attribute_from_input(*attribute, *out_attribute_b, b_indices.as_span());
   }
 }
 
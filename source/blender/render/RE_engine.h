@@ -151,6 +151,9 @@ typedef struct RenderEngine {
   /* Depsgraph */
   struct Depsgraph *depsgraph;
   bool has_grease_pencil;
+  /* Dependency graphs kept between renders with persistent data, one per view layer, as
+   * LinkData. */
+  ListBase persistent_depsgraphs;
 
   /* callback for render pass query */
   ThreadMutex update_render_passes_mutex;
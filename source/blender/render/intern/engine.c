@@ -128,6 +128,8 @@ bool RE_engine_is_opengl(RenderEngineType *render_type)
   return (render_type->draw_engine != NULL) && DRW_engine_render_support(render_type->draw_engine);
 }
 
+static void engine_persistent_depsgraphs_free(RenderEngine *engine);
+
 /* Create, Free */
 
 RenderEngine *RE_engine_create(RenderEngineType *type)
@@ -148,6 +150,9 @@ void RE_engine_free(RenderEngine *engine)
   }
 #endif
 
+  /* Dependency graphs kept alive across frames for persistent data. */
+  engine_persistent_depsgraphs_free(engine);
+
   BLI_mutex_end(&engine->update_render_passes_mutex);
 
   MEM_freeN(engine);
@@ -599,14 +604,90 @@ RenderData *RE_engine_get_render_data(Render *re)
 }
 
 /* Depsgraph */
+
+/* With persistent data the dependency graph is kept alive between renders, so that the engine
+ * can use its recalc flags to update only the data that changed since the previous frame. */
+static bool engine_keep_depsgraph(RenderEngine *engine)
+{
+  Render *re = engine->re;
+  return (re->r.mode & R_PERSISTENT_DATA) && !(re->r.scemode & R_BUTS_PREVIEW);
+}
+
+static void engine_depsgraph_free(RenderEngine *engine)
+{
+  if (engine->depsgraph == NULL) {
+    return;
+  }
+
+  LinkData *link = BLI_findptr(
+      &engine->persistent_depsgraphs, engine->depsgraph, offsetof(LinkData, data));
+  if (link) {
+    BLI_freelinkN(&engine->persistent_depsgraphs, link);
+  }
+
+  DEG_graph_free(engine->depsgraph);
+
+  engine->depsgraph = NULL;
+}
+
+static void engine_persistent_depsgraphs_free(RenderEngine *engine)
+{
+  engine_depsgraph_free(engine);
+
+  LISTBASE_FOREACH (LinkData *, link, &engine->persistent_depsgraphs) {
+    DEG_graph_free(link->data);
+  }
+  BLI_freelistN(&engine->persistent_depsgraphs);
+}
+
+/* Find the dependency graph kept for the view layer by a previous render. Graphs built for other
+ * data are freed, since ID pointers handed to the engine would no longer match. */
+static Depsgraph *engine_persistent_depsgraph_find(RenderEngine *engine, ViewLayer *view_layer)
+{
+  Main *bmain = engine->re->main;
+  Scene *scene = engine->re->scene;
+  Depsgraph *result = NULL;
+
+  LISTBASE_FOREACH_MUTABLE (LinkData *, link, &engine->persistent_depsgraphs) {
+    Depsgraph *depsgraph = link->data;
+    ViewLayer *depsgraph_view_layer = DEG_get_input_view_layer(depsgraph);
+    if (DEG_get_bmain(depsgraph) != bmain || DEG_get_input_scene(depsgraph) != scene ||
+        BLI_findindex(&scene->view_layers, depsgraph_view_layer) == -1) {
+      DEG_graph_free(depsgraph);
+      BLI_freelinkN(&engine->persistent_depsgraphs, link);
+    }
+    else if (depsgraph_view_layer == view_layer) {
+      result = depsgraph;
+    }
+  }
+
+  return result;
+}
+
 static void engine_depsgraph_init(RenderEngine *engine, ViewLayer *view_layer)
 {
   Main *bmain = engine->re->main;
   Scene *scene = engine->re->scene;
 
+  if (engine_keep_depsgraph(engine)) {
+    engine->depsgraph = engine_persistent_depsgraph_find(engine, view_layer);
+    if (engine->depsgraph) {
+      /* Evaluate the new frame, keeping recalc flags for the engine to detect changes. */
+      BKE_scene_graph_update_for_newframe_ex(engine->depsgraph, false);
+      engine->has_grease_pencil = DRW_render_check_grease_pencil(engine->depsgraph);
+      return;
+    }
+  }
+
   engine->depsgraph = DEG_graph_new(bmain, scene, view_layer, DAG_EVAL_RENDER);
   DEG_debug_name_set(engine->depsgraph, "RENDER");
 
+  if (engine_keep_depsgraph(engine)) {
+    /* One dependency graph is kept for every view layer, so rendering multiple view layers does
+     * not build and evaluate them from scratch for every frame. */
+    BLI_addtail(&engine->persistent_depsgraphs, BLI_genericNodeN(engine->depsgraph));
+  }
+
   if (engine->re->r.scemode & R_BUTS_PREVIEW) {
     Depsgraph *depsgraph = engine->depsgraph;
     DEG_graph_relations_update(depsgraph);
@@ -615,17 +696,27 @@ static void engine_depsgraph_init(RenderEngine *engine, ViewLayer *view_layer)
     DEG_ids_clear_recalc(bmain, depsgraph);
   }
   else {
-    BKE_scene_graph_update_for_newframe(engine->depsgraph);
+    BKE_scene_graph_update_for_newframe_ex(engine->depsgraph, !engine_keep_depsgraph(engine));
   }
 
   engine->has_grease_pencil = DRW_render_check_grease_pencil(engine->depsgraph);
 }
 
-static void engine_depsgraph_free(RenderEngine *engine)
+static void engine_depsgraph_exit(RenderEngine *engine)
 {
-  DEG_graph_free(engine->depsgraph);
+  if (engine->depsgraph == NULL) {
+    return;
+  }
 
-  engine->depsgraph = NULL;
+  if (engine_keep_depsgraph(engine)) {
+    /* Changes have been synced to the engine, only report new ones on the next render. The
+     * dependency graph stays in the persistent list for the next render of this view layer. */
+    DEG_ids_clear_recalc(engine->re->main, engine->depsgraph);
+    engine->depsgraph = NULL;
+  }
+  else {
+    engine_depsgraph_free(engine);
+  }
 }
 
 void RE_engine_frame_set(RenderEngine *engine, int frame, float subframe)
@@ -699,6 +790,8 @@ bool RE_bake_engine(Render *re,
   BLI_rw_mutex_unlock(&re->partsmutex);
 
   if (type->bake) {
+    /* Baking uses the dependency graph of the caller. */
+    engine_depsgraph_free(engine);
     engine->depsgraph = depsgraph;
 
     /* update is only called so we create the engine.session */
@@ -799,8 +892,8 @@ static void engine_render_view_layer(Render *re,
     }
   }
 
-  /* Free dependency graph, if engine has not done it already. */
-  engine_depsgraph_free(engine);
+  /* Free dependency graph, if engine has not done it already and does not keep it. */
+  engine_depsgraph_exit(engine);
 }
 
 bool RE_engine_render(Render *re, bool do_all)
@@ -1026,6 +1119,9 @@ void RE_engine_free_blender_memory(RenderEngine *engine)
   if (engine->has_grease_pencil) {
     return;
   }
-  DEG_graph_free(engine->depsgraph);
-  engine->depsgraph = NULL;
+  /* Persistent data needs the dependency graph to detect changes in the next render. */
+  if (engine_keep_depsgraph(engine)) {
+    return;
+  }
+  engine_depsgraph_free(engine);
 }
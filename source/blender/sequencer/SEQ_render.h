@@ -54,6 +54,8 @@ typedef struct SeqRenderData {
   int view_id;
   /* ID of task for assigning temp cache entries to particular task(thread, etc.) */
   eSeqTaskId task_id;
+  /* Index of the thread within the task, prefetching renders on multiple threads. */
+  int thread_index;
 
   /* special case for OpenGL render */
   struct GPUOffScreen *gpu_offscreen;
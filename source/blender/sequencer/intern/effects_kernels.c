@@ -0,0 +1,696 @@
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ * Copyright 2021, Blender Foundation.
+ */
+
+/** \file
+ * \ingroup sequencer
+ *
+ * Scalar kernels define the result. SIMD kernels must match them exactly for integer math, and
+ * up to rounding for float math (the compiler may contract the scalar code to FMA).
+ */
+
+#include <string.h>
+
+#include "BLI_math_base.h"
+#include "BLI_math_color.h"
+#include "BLI_simd.h"
+#include "BLI_utildefines.h"
+
+#include "effects_kernels.h"
+
+/* -------------------------------------------------------------------- */
+/** \name Scalar Kernels
+ * \{ */
+
+static void cross_byte_scalar(const unsigned char *rt1,
+                              const unsigned char *rt2,
+                              unsigned char *rt,
+                              int width,
+                              int fac)
+{
+  const int fac_inv = 256 - fac;
+
+  for (int x = 0; x < width; x++, rt1 += 4, rt2 += 4, rt += 4) {
+    rt[0] = (fac_inv * rt1[0] + fac * rt2[0]) >> 8;
+    rt[1] = (fac_inv * rt1[1] + fac * rt2[1]) >> 8;
+    rt[2] = (fac_inv * rt1[2] + fac * rt2[2]) >> 8;
+    rt[3] = (fac_inv * rt1[3] + fac * rt2[3]) >> 8;
+  }
+}
+
+static void cross_float_scalar(
+    const float *rt1, const float *rt2, float *rt, int width, float fac)
+{
+  const float fac_inv = 1.0f - fac;
+
+  for (int x = 0; x < width; x++, rt1 += 4, rt2 += 4, rt += 4) {
+    rt[0] = fac_inv * rt1[0] + fac * rt2[0];
+    rt[1] = fac_inv * rt1[1] + fac * rt2[1];
+    rt[2] = fac_inv * rt1[2] + fac * rt2[2];
+    rt[3] = fac_inv * rt1[3] + fac * rt2[3];
+  }
+}
+
+static void add_byte_scalar(const unsigned char *cp1,
+                            const unsigned char *cp2,
+                            unsigned char *rt,
+                            int width,
+                            int fac)
+{
+  for (int x = 0; x < width; x++, cp1 += 4, cp2 += 4, rt += 4) {
+    const int m = fac * (int)cp2[3];
+    rt[0] = min_ii(cp1[0] + ((m * cp2[0]) >> 16), 255);
+    rt[1] = min_ii(cp1[1] + ((m * cp2[1]) >> 16), 255);
+    rt[2] = min_ii(cp1[2] + ((m * cp2[2]) >> 16), 255);
+    rt[3] = cp1[3];
+  }
+}
+
+static void add_float_scalar(const float *rt1, const float *rt2, float *rt, int width, float fac)
+{
+  for (int x = 0; x < width; x++, rt1 += 4, rt2 += 4, rt += 4) {
+    const float m = (1.0f - (rt1[3] * (1.0f - fac))) * rt2[3];
+    rt[0] = rt1[0] + m * rt2[0];
+    rt[1] = rt1[1] + m * rt2[1];
+    rt[2] = rt1[2] + m * rt2[2];
+    rt[3] = rt1[3];
+  }
+}
+
+static void sub_byte_scalar(const unsigned char *cp1,
+                            const unsigned char *cp2,
+                            unsigned char *rt,
+                            int width,
+                            int fac)
+{
+  for (int x = 0; x < width; x++, cp1 += 4, cp2 += 4, rt += 4) {
+    const int m = fac * (int)cp2[3];
+    rt[0] = max_ii(cp1[0] - ((m * cp2[0]) >> 16), 0);
+    rt[1] = max_ii(cp1[1] - ((m * cp2[1]) >> 16), 0);
+    rt[2] = max_ii(cp1[2] - ((m * cp2[2]) >> 16), 0);
+    rt[3] = cp1[3];
+  }
+}
+
+static void sub_float_scalar(const float *rt1, const float *rt2, float *rt, int width, float fac)
+{
+  const float fac_inv = 1.0f - fac;
+
+  for (int x = 0; x < width; x++, rt1 += 4, rt2 += 4, rt += 4) {
+    const float m = (1.0f - (rt1[3] * fac_inv)) * rt2[3];
+    rt[0] = max_ff(rt1[0] - m * rt2[0], 0.0f);
+    rt[1] = max_ff(rt1[1] - m * rt2[1], 0.0f);
+    rt[2] = max_ff(rt1[2] - m * rt2[2], 0.0f);
+    rt[3] = rt1[3];
+  }
+}
+
+/* formula:
+ * fac * (a * b) + (1 - fac) * a  =>  fac * a * (b - 1) + a
+ */
+static void mul_byte_scalar(const unsigned char *rt1,
+                            const unsigned char *rt2,
+                            unsigned char *rt,
+                            int width,
+                            int fac)
+{
+  for (int x = 0; x < width; x++, rt1 += 4, rt2 += 4, rt += 4) {
+    rt[0] = rt1[0] + ((fac * rt1[0] * (rt2[0] - 255)) >> 16);
+    rt[1] = rt1[1] + ((fac * rt1[1] * (rt2[1] - 255)) >> 16);
+    rt[2] = rt1[2] + ((fac * rt1[2] * (rt2[2] - 255)) >> 16);
+    rt[3] = rt1[3] + ((fac * rt1[3] * (rt2[3] - 255)) >> 16);
+  }
+}
+
+static void mul_float_scalar(const float *rt1, const float *rt2, float *rt, int width, float fac)
+{
+  for (int x = 0; x < width; x++, rt1 += 4, rt2 += 4, rt += 4) {
+    rt[0] = rt1[0] + fac * rt1[0] * (rt2[0] - 1.0f);
+    rt[1] = rt1[1] + fac * rt1[1] * (rt2[1] - 1.0f);
+    rt[2] = rt1[2] + fac * rt1[2] * (rt2[2] - 1.0f);
+    rt[3] = rt1[3] + fac * rt1[3] * (rt2[3] - 1.0f);
+  }
+}
+
+/* rt = rt1 over rt2  (alpha from rt1) */
+static void alphaover_byte_scalar(const unsigned char *cp1,
+                                  const unsigned char *cp2,
+                                  unsigned char *rt,
+                                  int width,
+                                  float fac)
+{
+  float tempc[4], rt1[4], rt2[4];
+
+  for (int x = 0; x < width; x++, cp1 += 4, cp2 += 4, rt += 4) {
+    straight_uchar_to_premul_float(rt1, cp1);
+    straight_uchar_to_premul_float(rt2, cp2);
+
+    const float mfac = 1.0f - fac * rt1[3];
+
+    if (fac <= 0.0f) {
+      memcpy(rt, cp2, sizeof(unsigned char[4]));
+    }
+    else if (mfac <= 0.0f) {
+      memcpy(rt, cp1, sizeof(unsigned char[4]));
+    }
+    else {
+      tempc[0] = fac * rt1[0] + mfac * rt2[0];
+      tempc[1] = fac * rt1[1] + mfac * rt2[1];
+      tempc[2] = fac * rt1[2] + mfac * rt2[2];
+      tempc[3] = fac * rt1[3] + mfac * rt2[3];
+
+      premul_float_to_straight_uchar(rt, tempc);
+    }
+  }
+}
+
+/* rt = rt1 under rt2  (alpha from rt2) */
+static void alphaunder_byte_scalar(const unsigned char *cp1,
+                                   const unsigned char *cp2,
+                                   unsigned char *rt,
+                                   int width,
+                                   float fac)
+{
+  float tempc[4], rt1[4], rt2[4];
+
+  for (int x = 0; x < width; x++, cp1 += 4, cp2 += 4, rt += 4) {
+    straight_uchar_to_premul_float(rt1, cp1);
+    straight_uchar_to_premul_float(rt2, cp2);
+
+    /* this complex optimization is because the
+     * 'skybuf' can be crossed in
+     */
+    if (rt2[3] <= 0.0f && fac >= 1.0f) {
+      memcpy(rt, cp1, sizeof(unsigned char[4]));
+    }
+    else if (rt2[3] >= 1.0f) {
+      memcpy(rt, cp2, sizeof(unsigned char[4]));
+    }
+    else {
+      const float mfac = fac * (1.0f - rt2[3]);
+
+      if (mfac <= 0) {
+        memcpy(rt, cp2, sizeof(unsigned char[4]));
+      }
+      else {
+        tempc[0] = mfac * rt1[0] + rt2[0];
+        tempc[1] = mfac * rt1[1] + rt2[1];
+        tempc[2] = mfac * rt1[2] + rt2[2];
+        tempc[3] = mfac * rt1[3] + rt2[3];
+
+        premul_float_to_straight_uchar(rt, tempc);
+      }
+    }
+  }
+}
+
+/* rt = rt1 over rt2  (alpha from rt1) */
+static void alphaover_float_scalar(
+    const float *rt1, const float *rt2, float *rt, int width, float fac)
+{
+  for (int x = 0; x < width; x++, rt1 += 4, rt2 += 4, rt += 4) {
+    const float mfac = 1.0f - (fac * rt1[3]);
+
+    if (fac <= 0.0f) {
+      memcpy(rt, rt2, sizeof(float[4]));
+    }
+    else if (mfac <= 0.0f) {
+      memcpy(rt, rt1, sizeof(float[4]));
+    }
+    else {
+      rt[0] = fac * rt1[0] + mfac * rt2[0];
+      rt[1] = fac * rt1[1] + mfac * rt2[1];
+      rt[2] = fac * rt1[2] + mfac * rt2[2];
+      rt[3] = fac * rt1[3] + mfac * rt2[3];
+    }
+  }
+}
+
+/* rt = rt1 under rt2  (alpha from rt2) */
+static void alphaunder_float_scalar(
+    const float *rt1, const float *rt2, float *rt, int width, float fac)
+{
+  for (int x = 0; x < width; x++, rt1 += 4, rt2 += 4, rt += 4) {
+    /* this complex optimization is because the
+     * 'skybuf' can be crossed in
+     */
+    if (rt2[3] <= 0 && fac >= 1.0f) {
+      memcpy(rt, rt1, sizeof(float[4]));
+    }
+    else if (rt2[3] >= 1.0f) {
+      memcpy(rt, rt2, sizeof(float[4]));
+    }
+    else {
+      const float mfac = fac * (1.0f - rt2[3]);
+
+      if (mfac == 0) {
+        memcpy(rt, rt2, sizeof(float[4]));
+      }
+      else {
+        rt[0] = mfac * rt1[0] + rt2[0];
+        rt[1] = mfac * rt1[1] + rt2[1];
+        rt[2] = mfac * rt1[2] + rt2[2];
+        rt[3] = mfac * rt1[3] + rt2[3];
+      }
+    }
+  }
+}
+
+static const SeqEffectKernels kernels_scalar = {
+    "Scalar",
+    cross_byte_scalar,
+    cross_float_scalar,
+    add_byte_scalar,
+    add_float_scalar,
+    sub_byte_scalar,
+    sub_float_scalar,
+    mul_byte_scalar,
+    mul_float_scalar,
+    alphaover_byte_scalar,
+    alphaunder_byte_scalar,
+    alphaover_float_scalar,
+    alphaunder_float_scalar,
+};
+
+/** \} */
+
+#ifdef BLI_HAVE_SSE2
+
+/* -------------------------------------------------------------------- */
+/** \name SSE2 Kernels
+ *
+ * Float kernels process one pixel per iteration. Byte kernels process four pixels per iteration
+ * in 16 bit lanes, remaining pixels are handled by the scalar kernels. Alpha over and under byte
+ * kernels convert one pixel per iteration to premultiplied float.
+ * \{ */
+
+#  define SELECT_PS(mask, a, b) _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b))
+#  define ALPHA_PS(v) _mm_shuffle_ps(v, v, _MM_SHUFFLE(3, 3, 3, 3))
+#  define ALPHA_EPI16(v) \
+    _mm_shufflehi_epi16(_mm_shufflelo_epi16(v, _MM_SHUFFLE(3, 3, 3, 3)), _MM_SHUFFLE(3, 3, 3, 3))
+
+/* Lanes of color channels, alpha lanes are zero. */
+static __m128 rgb_mask_ps(void)
+{
+  return _mm_castsi128_ps(_mm_set_epi32(0, -1, -1, -1));
+}
+
+static __m128i rgb_mask_epi16(void)
+{
+  return _mm_set_epi16(0, -1, -1, -1, 0, -1, -1, -1);
+}
+
+static void cross_byte_sse2(const unsigned char *rt1,
+                            const unsigned char *rt2,
+                            unsigned char *rt,
+                            int width,
+                            int fac)
+{
+  if (fac < 0 || fac > 256) {
+    cross_byte_scalar(rt1, rt2, rt, width, fac);
+    return;
+  }
+
+  const __m128i zero = _mm_setzero_si128();
+  const __m128i fac_v = _mm_set1_epi16((short)fac);
+  const __m128i fac_inv_v = _mm_set1_epi16((short)(256 - fac));
+  int x = 0;
+
+  /* Products fit unsigned 16 bit lanes, as factors sum up to 256. */
+  for (; x + 4 <= width; x += 4, rt1 += 16, rt2 += 16, rt += 16) {
+    const __m128i a = _mm_loadu_si128((const __m128i *)rt1);
+    const __m128i b = _mm_loadu_si128((const __m128i *)rt2);
+    const __m128i lo = _mm_srli_epi16(
+        _mm_add_epi16(_mm_mullo_epi16(_mm_unpacklo_epi8(a, zero), fac_inv_v),
+                      _mm_mullo_epi16(_mm_unpacklo_epi8(b, zero), fac_v)),
+        8);
+    const __m128i hi = _mm_srli_epi16(
+        _mm_add_epi16(_mm_mullo_epi16(_mm_unpackhi_epi8(a, zero), fac_inv_v),
+                      _mm_mullo_epi16(_mm_unpackhi_epi8(b, zero), fac_v)),
+        8);
+    _mm_storeu_si128((__m128i *)rt, _mm_packus_epi16(lo, hi));
+  }
+
+  cross_byte_scalar(rt1, rt2, rt, width - x, fac);
+}
+
+static void cross_float_sse2(const float *rt1, const float *rt2, float *rt, int width, float fac)
+{
+  const __m128 fac_v = _mm_set1_ps(fac);
+  const __m128 fac_inv_v = _mm_set1_ps(1.0f - fac);
+
+  for (int x = 0; x < width; x++, rt1 += 4, rt2 += 4, rt += 4) {
+    const __m128 a = _mm_loadu_ps(rt1);
+    const __m128 b = _mm_loadu_ps(rt2);
+    _mm_storeu_ps(rt, _mm_add_ps(_mm_mul_ps(fac_inv_v, a), _mm_mul_ps(fac_v, b)));
+  }
+}
+
+/* `(fac * alpha(b) * b) >> 16` of color channels, alpha lanes are zero. */
+static __m128i add_sub_byte_term(__m128i b, __m128i fac_v)
+{
+  const __m128i m = _mm_mullo_epi16(ALPHA_EPI16(b), fac_v);
+  return _mm_and_si128(_mm_mulhi_epu16(m, b), rgb_mask_epi16());
+}
+
+static void add_byte_sse2(const unsigned char *cp1,
+                          const unsigned char *cp2,
+                          unsigned char *rt,
+                          int width,
+                          int fac)
+{
+  if (fac < 0 || fac > 256) {
+    add_byte_scalar(cp1, cp2, rt, width, fac);
+    return;
+  }
+
+  const __m128i zero = _mm_setzero_si128();
+  const __m128i fac_v = _mm_set1_epi16((short)fac);
+  int x = 0;
+
+  for (; x + 4 <= width; x += 4, cp1 += 16, cp2 += 16, rt += 16) {
+    const __m128i a = _mm_loadu_si128((const __m128i *)cp1);
+    const __m128i b = _mm_loadu_si128((const __m128i *)cp2);
+    const __m128i lo = _mm_add_epi16(_mm_unpacklo_epi8(a, zero),
+                                     add_sub_byte_term(_mm_unpacklo_epi8(b, zero), fac_v));
+    const __m128i hi = _mm_add_epi16(_mm_unpackhi_epi8(a, zero),
+                                     add_sub_byte_term(_mm_unpackhi_epi8(b, zero), fac_v));
+    /* Saturation clamps to 255. */
+    _mm_storeu_si128((__m128i *)rt, _mm_packus_epi16(lo, hi));
+  }
+
+  add_byte_scalar(cp1, cp2, rt, width - x, fac);
+}
+
+static void add_float_sse2(const float *rt1, const float *rt2, float *rt, int width, float fac)
+{
+  const __m128 one = _mm_set1_ps(1.0f);
+  const __m128 fac_inv_v = _mm_set1_ps(1.0f - fac);
+  const __m128 rgb_mask = rgb_mask_ps();
+
+  for (int x = 0; x < width; x++, rt1 += 4, rt2 += 4, rt += 4) {
+    const __m128 a = _mm_loadu_ps(rt1);
+    const __m128 b = _mm_loadu_ps(rt2);
+    const __m128 m = _mm_mul_ps(_mm_sub_ps(one, _mm_mul_ps(ALPHA_PS(a), fac_inv_v)), ALPHA_PS(b));
+    const __m128 result = _mm_add_ps(a, _mm_mul_ps(m, b));
+    _mm_storeu_ps(rt, SELECT_PS(rgb_mask, result, a));
+  }
+}
+
+static void sub_byte_sse2(const unsigned char *cp1,
+                          const unsigned char *cp2,
+                          unsigned char *rt,
+                          int width,
+                          int fac)
+{
+  if (fac < 0 || fac > 256) {
+    sub_byte_scalar(cp1, cp2, rt, width, fac);
+    return;
+  }
+
+  const __m128i zero = _mm_setzero_si128();
+  const __m128i fac_v = _mm_set1_epi16((short)fac);
+  int x = 0;
+
+  for (; x + 4 <= width; x += 4, cp1 += 16, cp2 += 16, rt += 16) {
+    const __m128i a = _mm_loadu_si128((const __m128i *)cp1);
+    const __m128i b = _mm_loadu_si128((const __m128i *)cp2);
+    /* Saturation clamps to 0. */
+    const __m128i lo = _mm_subs_epu16(_mm_unpacklo_epi8(a, zero),
+                                      add_sub_byte_term(_mm_unpacklo_epi8(b, zero), fac_v));
+    const __m128i hi = _mm_subs_epu16(_mm_unpackhi_epi8(a, zero),
+                                      add_sub_byte_term(_mm_unpackhi_epi8(b, zero), fac_v));
+    _mm_storeu_si128((__m128i *)rt, _mm_packus_epi16(lo, hi));
+  }
+
+  sub_byte_scalar(cp1, cp2, rt, width - x, fac);
+}
+
+static void sub_float_sse2(const float *rt1, const float *rt2, float *rt, int width, float fac)
+{
+  const __m128 zero = _mm_setzero_ps();
+  const __m128 one = _mm_set1_ps(1.0f);
+  const __m128 fac_inv_v = _mm_set1_ps(1.0f - fac);
+  const __m128 rgb_mask = rgb_mask_ps();
+
+  for (int x = 0; x < width; x++, rt1 += 4, rt2 += 4, rt += 4) {
+    const __m128 a = _mm_loadu_ps(rt1);
+    const __m128 b = _mm_loadu_ps(rt2);
+    const __m128 m = _mm_mul_ps(_mm_sub_ps(one, _mm_mul_ps(ALPHA_PS(a), fac_inv_v)), ALPHA_PS(b));
+    const __m128 result = _mm_max_ps(_mm_sub_ps(a, _mm_mul_ps(m, b)), zero);
+    _mm_storeu_ps(rt, SELECT_PS(rgb_mask, result, a));
+  }
+}
+
+/* `a - ceil(fac * a * (255 - b) / 65536)`, which is the arithmetic right shift of the negative
+ * product in the scalar kernel. */
+static __m128i mul_byte_term(__m128i a, __m128i b, __m128i fac_v)
+{
+  const __m128i m = _mm_mullo_epi16(a, fac_v);
+  const __m128i b_inv = _mm_sub_epi16(_mm_set1_epi16(255), b);
+  const __m128i hi = _mm_mulhi_epu16(m, b_inv);
+  const __m128i lo = _mm_mullo_epi16(m, b_inv);
+  /* Round up when low bits are not zero, comparison mask is -1 when they are. */
+  const __m128i ceil = _mm_add_epi16(_mm_add_epi16(hi, _mm_set1_epi16(1)),
+                                     _mm_cmpeq_epi16(lo, _mm_setzero_si128()));
+  return _mm_sub_epi16(a, ceil);
+}
+
+static void mul_byte_sse2(const unsigned char *rt1,
+                          const unsigned char *rt2,
+                          unsigned char *rt,
+                          int width,
+                          int fac)
+{
+  if (fac < 0 || fac > 256) {
+    mul_byte_scalar(rt1, rt2, rt, width, fac);
+    return;
+  }
+
+  const __m128i zero = _mm_setzero_si128();
+  const __m128i fac_v = _mm_set1_epi16((short)fac);
+  int x = 0;
+
+  for (; x + 4 <= width; x += 4, rt1 += 16, rt2 += 16, rt += 16) {
+    const __m128i a = _mm_loadu_si128((const __m128i *)rt1);
+    const __m128i b = _mm_loadu_si128((const __m128i *)rt2);
+    const __m128i lo = mul_byte_term(
+        _mm_unpacklo_epi8(a, zero), _mm_unpacklo_epi8(b, zero), fac_v);
+    const __m128i hi = mul_byte_term(
+        _mm_unpackhi_epi8(a, zero), _mm_unpackhi_epi8(b, zero), fac_v);
+    _mm_storeu_si128((__m128i *)rt, _mm_packus_epi16(lo, hi));
+  }
+
+  mul_byte_scalar(rt1, rt2, rt, width - x, fac);
+}
+
+static void mul_float_sse2(const float *rt1, const float *rt2, float *rt, int width, float fac)
+{
+  const __m128 one = _mm_set1_ps(1.0f);
+  const __m128 fac_v = _mm_set1_ps(fac);
+
+  for (int x = 0; x < width; x++, rt1 += 4, rt2 += 4, rt += 4) {
+    const __m128 a = _mm_loadu_ps(rt1);
+    const __m128 b = _mm_loadu_ps(rt2);
+    _mm_storeu_ps(rt, _mm_add_ps(a, _mm_mul_ps(_mm_mul_ps(fac_v, a), _mm_sub_ps(b, one))));
+  }
+}
+
+/* Same as #straight_uchar_to_premul_float. */
+static __m128 straight_uchar_to_premul_ps(const unsigned char color[4])
+{
+  const __m128i zero = _mm_setzero_si128();
+  int packed;
+  memcpy(&packed, color, sizeof(packed));
+  const __m128i color_epi32 = _mm_unpacklo_epi16(
+      _mm_unpacklo_epi8(_mm_cvtsi32_si128(packed), zero), zero);
+  const __m128 color_ps = _mm_cvtepi32_ps(color_epi32);
+  const __m128 alpha = _mm_mul_ps(ALPHA_PS(color_ps), _mm_set1_ps(1.0f / 255.0f));
+  const __m128 fac = _mm_mul_ps(alpha, _mm_set1_ps(1.0f / 255.0f));
+  return SELECT_PS(rgb_mask_ps(), _mm_mul_ps(color_ps, fac), alpha);
+}
+
+/* Same as #premul_float_to_straight_uchar. */
+static void premul_ps_to_straight_uchar(unsigned char result[4], __m128 color)
+{
+  const __m128 zero = _mm_setzero_ps();
+  const __m128 one = _mm_set1_ps(1.0f);
+  const __m128 alpha = ALPHA_PS(color);
+  /* Color channels are not divided by zero or one alpha. */
+  const __m128 alpha_unit = _mm_or_ps(_mm_cmpeq_ps(alpha, zero), _mm_cmpeq_ps(alpha, one));
+  const __m128 alpha_inv = SELECT_PS(alpha_unit, one, _mm_div_ps(one, alpha));
+  const __m128 straight = _mm_mul_ps(color, SELECT_PS(rgb_mask_ps(), alpha_inv, one));
+
+  /* #unit_float_to_uchar_clamp, conversion truncates. */
+  __m128i value = _mm_cvttps_epi32(
+      _mm_add_ps(_mm_mul_ps(straight, _mm_set1_ps(255.0f)), _mm_set1_ps(0.5f)));
+  value = _mm_andnot_si128(_mm_castps_si128(_mm_cmple_ps(straight, zero)), value);
+  const __m128i value_max = _mm_castps_si128(
+      _mm_cmpgt_ps(straight, _mm_set1_ps(1.0f - 0.5f / 255.0f)));
+  value = _mm_or_si128(_mm_and_si128(value_max, _mm_set1_epi32(255)),
+                       _mm_andnot_si128(value_max, value));
+
+  value = _mm_packs_epi32(value, value);
+  const int packed = _mm_cvtsi128_si32(_mm_packus_epi16(value, value));
+  memcpy(result, &packed, sizeof(packed));
+}
+
+/* Pixels copied from inputs are decided on alpha alone, before converting colors. */
+static void alphaover_byte_sse2(const unsigned char *cp1,
+                                const unsigned char *cp2,
+                                unsigned char *rt,
+                                int width,
+                                float fac)
+{
+  if (fac <= 0.0f) {
+    memcpy(rt, cp2, sizeof(unsigned char[4]) * width);
+    return;
+  }
+
+  const __m128 fac_v = _mm_set1_ps(fac);
+
+  for (int x = 0; x < width; x++, cp1 += 4, cp2 += 4, rt += 4) {
+    const float mfac = 1.0f - fac * (cp1[3] * (1.0f / 255.0f));
+
+    if (mfac <= 0.0f) {
+      memcpy(rt, cp1, sizeof(unsigned char[4]));
+      continue;
+    }
+
+    const __m128 a = straight_uchar_to_premul_ps(cp1);
+    const __m128 b = straight_uchar_to_premul_ps(cp2);
+    premul_ps_to_straight_uchar(
+        rt, _mm_add_ps(_mm_mul_ps(fac_v, a), _mm_mul_ps(_mm_set1_ps(mfac), b)));
+  }
+}
+
+static void alphaunder_byte_sse2(const unsigned char *cp1,
+                                 const unsigned char *cp2,
+                                 unsigned char *rt,
+                                 int width,
+                                 float fac)
+{
+  for (int x = 0; x < width; x++, cp1 += 4, cp2 += 4, rt += 4) {
+    const float b_alpha = cp2[3] * (1.0f / 255.0f);
+
+    if (b_alpha <= 0.0f && fac >= 1.0f) {
+      memcpy(rt, cp1, sizeof(unsigned char[4]));
+      continue;
+    }
+
+    const float mfac = fac * (1.0f - b_alpha);
+
+    if (b_alpha >= 1.0f || mfac <= 0.0f) {
+      memcpy(rt, cp2, sizeof(unsigned char[4]));
+      continue;
+    }
+
+    const __m128 a = straight_uchar_to_premul_ps(cp1);
+    const __m128 b = straight_uchar_to_premul_ps(cp2);
+    premul_ps_to_straight_uchar(rt, _mm_add_ps(_mm_mul_ps(_mm_set1_ps(mfac), a), b));
+  }
+}
+
+static void alphaover_float_sse2(
+    const float *rt1, const float *rt2, float *rt, int width, float fac)
+{
+  if (fac <= 0.0f) {
+    memcpy(rt, rt2, sizeof(float[4]) * width);
+    return;
+  }
+
+  const __m128 zero = _mm_setzero_ps();
+  const __m128 one = _mm_set1_ps(1.0f);
+  const __m128 fac_v = _mm_set1_ps(fac);
+
+  for (int x = 0; x < width; x++, rt1 += 4, rt2 += 4, rt += 4) {
+    const __m128 a = _mm_loadu_ps(rt1);
+    const __m128 b = _mm_loadu_ps(rt2);
+    const __m128 mfac = _mm_sub_ps(one, _mm_mul_ps(fac_v, ALPHA_PS(a)));
+    const __m128 result = _mm_add_ps(_mm_mul_ps(fac_v, a), _mm_mul_ps(mfac, b));
+    _mm_storeu_ps(rt, SELECT_PS(_mm_cmple_ps(mfac, zero), a, result));
+  }
+}
+
+static void alphaunder_float_sse2(
+    const float *rt1, const float *rt2, float *rt, int width, float fac)
+{
+  const __m128 zero = _mm_setzero_ps();
+  const __m128 one = _mm_set1_ps(1.0f);
+  const __m128 fac_v = _mm_set1_ps(fac);
+  const __m128 fac_full = (fac >= 1.0f) ? _mm_castsi128_ps(_mm_set1_epi32(-1)) : zero;
+
+  for (int x = 0; x < width; x++, rt1 += 4, rt2 += 4, rt += 4) {
+    const __m128 a = _mm_loadu_ps(rt1);
+    const __m128 b = _mm_loadu_ps(rt2);
+    const __m128 b_alpha = ALPHA_PS(b);
+    const __m128 mfac = _mm_mul_ps(fac_v, _mm_sub_ps(one, b_alpha));
+    __m128 result = _mm_add_ps(_mm_mul_ps(mfac, a), b);
+    /* Apply conditions of scalar kernel in reverse order of precedence. */
+    result = SELECT_PS(_mm_cmpeq_ps(mfac, zero), b, result);
+    result = SELECT_PS(_mm_cmpge_ps(b_alpha, one), b, result);
+    result = SELECT_PS(_mm_and_ps(_mm_cmple_ps(b_alpha, zero), fac_full), a, result);
+    _mm_storeu_ps(rt, result);
+  }
+}
+
+#  undef SELECT_PS
+#  undef ALPHA_PS
+#  undef ALPHA_EPI16
+
+static const SeqEffectKernels kernels_sse2 = {
+    "SSE2",
+    cross_byte_sse2,
+    cross_float_sse2,
+    add_byte_sse2,
+    add_float_sse2,
+    sub_byte_sse2,
+    sub_float_sse2,
+    mul_byte_sse2,
+    mul_float_sse2,
+    alphaover_byte_sse2,
+    alphaunder_byte_sse2,
+    alphaover_float_sse2,
+    alphaunder_float_sse2,
+};
+
+/** \} */
+
+#endif /* BLI_HAVE_SSE2 */
+
+/* -------------------------------------------------------------------- */
+/** \name Kernel Selection
+ *
+ * SSE2 is part of the x86-64 baseline the build targets, so the kernels are selected at compile
+ * time, there is no runtime CPU detection.
+ * \{ */
+
+const SeqEffectKernels *seq_effect_kernels_get(void)
+{
+#ifdef BLI_HAVE_SSE2
+  return &kernels_sse2;
+#else
+  return &kernels_scalar;
+#endif
+}
+
+const SeqEffectKernels *seq_effect_kernels_scalar_get(void)
+{
+  return &kernels_scalar;
+}
+
+/** \} */
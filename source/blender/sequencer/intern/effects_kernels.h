@@ -0,0 +1,70 @@
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ * Copyright 2021, Blender Foundation.
+ */
+
+#pragma once
+
+/** \file
+ * \ingroup sequencer
+ *
+ * Per row kernels of blend effects, with SIMD implementations where supported.
+ * Byte factors are in 0..256 range, float factors in 0..1 range. Alpha over and under byte
+ * kernels blend premultiplied colors in float precision, so they take float factors.
+ */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef void (*SeqEffectKernelByte)(const unsigned char *rect1,
+                                    const unsigned char *rect2,
+                                    unsigned char *out,
+                                    int width,
+                                    int fac);
+typedef void (*SeqEffectKernelBytePremul)(const unsigned char *rect1,
+                                          const unsigned char *rect2,
+                                          unsigned char *out,
+                                          int width,
+                                          float fac);
+typedef void (*SeqEffectKernelFloat)(
+    const float *rect1, const float *rect2, float *out, int width, float fac);
+
+typedef struct SeqEffectKernels {
+  const char *name;
+
+  SeqEffectKernelByte cross_byte;
+  SeqEffectKernelFloat cross_float;
+  SeqEffectKernelByte add_byte;
+  SeqEffectKernelFloat add_float;
+  SeqEffectKernelByte sub_byte;
+  SeqEffectKernelFloat sub_float;
+  SeqEffectKernelByte mul_byte;
+  SeqEffectKernelFloat mul_float;
+  SeqEffectKernelBytePremul alphaover_byte;
+  SeqEffectKernelBytePremul alphaunder_byte;
+  SeqEffectKernelFloat alphaover_float;
+  SeqEffectKernelFloat alphaunder_float;
+} SeqEffectKernels;
+
+/* Kernels used for rendering, SIMD when the build supports it. */
+const SeqEffectKernels *seq_effect_kernels_get(void);
+/* Reference implementation, used as fallback and for comparison. */
+const SeqEffectKernels *seq_effect_kernels_scalar_get(void);
+
+#ifdef __cplusplus
+}
+#endif
@@ -23,6 +23,7 @@
 #include <memory.h>
 #include <stddef.h>
 #include <time.h>
+#include <zlib.h>
 
 #include "MEM_guardedalloc.h"
 
@@ -42,6 +43,7 @@
 #include "BLI_listbase.h"
 #include "BLI_mempool.h"
 #include "BLI_path_util.h"
+#include "BLI_task.h"
 #include "BLI_threads.h"
 
 #include "BKE_global.h"
@@ -57,6 +59,18 @@
 #include "prefetch.h"
 #include "strip_time.h"
 
+#ifdef WITH_LZO
+#  ifdef WITH_SYSTEM_LZO
+#    include <lzo/lzo1x.h>
+#  else
+#    include "minilzo.h"
+#  endif
+#  define LZO_HEAP_ALLOC(var, size) \
+    lzo_align_t __LZO_MMODEL var[((size) + (sizeof(lzo_align_t) - 1)) / sizeof(lzo_align_t)]
+#endif
+
+#define LZO_OUT_LEN(size) ((size) + (size) / 16 + 64 + 3)
+
 /**
  * Sequencer Cache Design Notes
  * ============================
@@ -90,7 +104,12 @@
  * Multiple(DCACHE_IMAGES_PER_FILE) images share the same file.
  * Each of these files contains header DiskCacheHeader followed by image data.
  * Zlib compression with user definable level can be used to compress image data(per image)
- * Images are written in order in which they are rendered.
+ * The fast compression level uses LZO instead. Image data is then split in chunks which are
+ * compressed and decompressed in parallel, preceded by a table of the compressed chunk sizes.
+ * Images are written in order in which they are rendered, by a writer thread so rendering
+ * doesn't wait for disk access. Images queued for writing before an invalidation are skipped.
+ * Compression and decompression are done outside of the disk cache lock, which only guards file
+ * access, so reading and writing threads don't wait for each other's compression.
  * Overwriting of individual entry is not possible.
  * Stored images are deleted by invalidation, or when size of all files exceeds maximum
  * size specified in user preferences.
@@ -102,11 +121,22 @@
 /* <cache type>-<resolution X>x<resolution Y>-<rendersize>%(<view_id>)-<frame no>.dcf */
 #define DCACHE_FNAME_FORMAT "%d-%dx%d-%d%%(%d)-%d.dcf"
 #define DCACHE_IMAGES_PER_FILE 100
-#define DCACHE_CURRENT_VERSION 1
+/* Version 2 stores the compression of each entry in the header, caches written by older
+ * versions are discarded. */
+#define DCACHE_CURRENT_VERSION 2
 #define COLORSPACE_NAME_MAX 64 /* XXX: defined in imb intern */
 
+/* Compression of image data, stored per header entry. */
+#define DCACHE_COMPRESSION_ZLIB 0
+#define DCACHE_COMPRESSION_LZO 1
+/* Size of the chunks of uncompressed image data compressed independently with LZO. */
+#define DCACHE_LZO_CHUNK_SIZE (1 << 20)
+/* Images queued for writing, more are not written to avoid holding too much memory. */
+#define DCACHE_WRITE_QUEUE_MAX 8
+
 typedef struct DiskCacheHeaderEntry {
   unsigned char encoding;
+  unsigned char compression;
   uint64_t frameno;
   uint64_t size_compressed;
   uint64_t size_raw;
@@ -124,8 +154,27 @@ typedef struct SeqDiskCache {
   ListBase files;
   ThreadMutex read_write_mutex;
   size_t size_total;
+
+  /* Writer thread, #DiskCacheWriteJob items are written in order. */
+  ListBase writer_thread;
+  ListBase write_queue;
+  int write_queue_len;
+  ThreadMutex write_queue_mutex;
+  ThreadCondition write_queue_cond;
+  bool stop_writer;
+  /* Incremented on invalidation, protected by read_write_mutex. */
+  int generation;
 } SeqDiskCache;
 
+typedef struct DiskCacheWriteJob {
+  struct DiskCacheWriteJob *next, *prev;
+  char path[FILE_MAX];
+  uint64_t frame_index;
+  ImBuf *ibuf;
+  /* Value of #SeqDiskCache.generation when the image was queued. */
+  int generation;
+} DiskCacheWriteJob;
+
 typedef struct DiskCacheFile {
   struct DiskCacheFile *next, *prev;
   char path[FILE_MAX];
@@ -168,6 +217,7 @@ typedef struct SeqCacheKey {
   bool is_temp_cache;   /* this cache entry will be freed before rendering next frame */
   /* ID of task for assigning temp cache entries to particular task(thread, etc.) */
   eSeqTaskId task_id;
+  int thread_index;
   int type;
 } SeqCacheKey;
 
@@ -188,6 +238,7 @@ static int seq_disk_cache_compression_level(void)
     case USER_SEQ_DISK_CACHE_COMPRESSION_NONE:
       return 0;
     case USER_SEQ_DISK_CACHE_COMPRESSION_LOW:
+    case USER_SEQ_DISK_CACHE_COMPRESSION_FAST:
       return 1;
     case USER_SEQ_DISK_CACHE_COMPRESSION_HIGH:
       return 9;
@@ -196,6 +247,16 @@ static int seq_disk_cache_compression_level(void)
   return U.sequencer_disk_cache_compression;
 }
 
+static int seq_disk_cache_compression(void)
+{
+#ifdef WITH_LZO
+  if (U.sequencer_disk_cache_compression == USER_SEQ_DISK_CACHE_COMPRESSION_FAST) {
+    return DCACHE_COMPRESSION_LZO;
+  }
+#endif
+  return DCACHE_COMPRESSION_ZLIB;
+}
+
 static size_t seq_disk_cache_size_limit(void)
 {
   return (size_t)U.sequencer_disk_cache_size_limit * (1024 * 1024 * 1024);
@@ -319,7 +380,8 @@ static bool seq_disk_cache_enforce_limits(SeqDiskCache *disk_cache)
   return true;
 }
 
-static DiskCacheFile *seq_disk_cache_get_file_entry_by_path(SeqDiskCache *disk_cache, char *path)
+static DiskCacheFile *seq_disk_cache_get_file_entry_by_path(SeqDiskCache *disk_cache,
+                                                             const char *path)
 {
   DiskCacheFile *cache_file = disk_cache->files.first;
 
@@ -333,7 +395,7 @@ static DiskCacheFile *seq_disk_cache_get_file_entry_by_path(SeqDiskCache *disk_c
 }
 
 /* Update file size and timestamp. */
-static void seq_disk_cache_update_file(SeqDiskCache *disk_cache, char *path)
+static void seq_disk_cache_update_file(SeqDiskCache *disk_cache, const char *path)
 {
   DiskCacheFile *cache_file;
   int64_t size_before;
@@ -480,6 +542,9 @@ static void seq_disk_cache_invalidate(Scene *scene,
 
   BLI_mutex_lock(&disk_cache->read_write_mutex);
 
+  /* Images queued before are outdated. */
+  disk_cache->generation++;
+
   start = seq_changed->startdisp - DCACHE_IMAGES_PER_FILE;
   end = seq_changed->enddisp;
 
@@ -488,29 +553,235 @@ static void seq_disk_cache_invalidate(Scene *scene,
   BLI_mutex_unlock(&disk_cache->read_write_mutex);
 }
 
-static size_t deflate_imbuf_to_file(ImBuf *ibuf,
-                                    FILE *file,
-                                    int level,
-                                    DiskCacheHeaderEntry *header_entry)
+#ifdef WITH_LZO
+
+typedef struct DiskCacheLZOData {
+  unsigned char *raw;
+  size_t size_raw;
+  /* Compressed chunks. When compressing, each one is in a slot of
+   * #LZO_OUT_LEN(DCACHE_LZO_CHUNK_SIZE) bytes following the table of chunk sizes. */
+  unsigned char *compressed;
+  uint32_t *chunks_size;
+  size_t *chunks_offset;
+  bool failed;
+} DiskCacheLZOData;
+
+static size_t seq_disk_cache_lzo_chunks_len(size_t size_raw)
 {
-  if (ibuf->rect) {
-    return BLI_gzip_mem_to_file_at_pos(
-        ibuf->rect, header_entry->size_raw, file, header_entry->offset, level);
+  return (size_raw + DCACHE_LZO_CHUNK_SIZE - 1) / DCACHE_LZO_CHUNK_SIZE;
+}
+
+static size_t seq_disk_cache_lzo_chunk_size_raw(size_t size_raw, int chunk)
+{
+  return MIN2((size_t)DCACHE_LZO_CHUNK_SIZE, size_raw - (size_t)chunk * DCACHE_LZO_CHUNK_SIZE);
+}
+
+static void seq_disk_cache_lzo_compress_chunk(void *__restrict userdata,
+                                              const int chunk,
+                                              const TaskParallelTLS *__restrict UNUSED(tls))
+{
+  DiskCacheLZOData *data = userdata;
+  unsigned char *in = data->raw + (size_t)chunk * DCACHE_LZO_CHUNK_SIZE;
+  unsigned char *out = data->compressed + data->chunks_offset[chunk];
+  const size_t in_len = seq_disk_cache_lzo_chunk_size_raw(data->size_raw, chunk);
+  lzo_uint out_len = 0;
+
+  LZO_HEAP_ALLOC(wrkmem, LZO1X_MEM_COMPRESS);
+  const int r = lzo1x_1_compress(in, (lzo_uint)in_len, out, &out_len, wrkmem);
+  if (r != LZO_E_OK || out_len >= in_len) {
+    /* Store uncompressed, recognized by its size when reading. */
+    memcpy(out, in, in_len);
+    out_len = in_len;
+  }
+  data->chunks_size[chunk] = (uint32_t)out_len;
+}
+
+static void seq_disk_cache_lzo_decompress_chunk(void *__restrict userdata,
+                                                const int chunk,
+                                                const TaskParallelTLS *__restrict UNUSED(tls))
+{
+  DiskCacheLZOData *data = userdata;
+  unsigned char *in = data->compressed + data->chunks_offset[chunk];
+  unsigned char *out = data->raw + (size_t)chunk * DCACHE_LZO_CHUNK_SIZE;
+  const size_t in_len = data->chunks_size[chunk];
+  const size_t expected_len = seq_disk_cache_lzo_chunk_size_raw(data->size_raw, chunk);
+
+  if (in_len == expected_len) {
+    memcpy(out, in, in_len);
+    return;
+  }
+
+  lzo_uint out_len = expected_len;
+  const int r = lzo1x_decompress_safe(in, (lzo_uint)in_len, out, &out_len, NULL);
+  if (r != LZO_E_OK || out_len != expected_len) {
+    data->failed = true;
+  }
+}
+
+/* Compress chunks in parallel, returns the table of compressed chunk sizes followed by the
+ * chunks. */
+static void *seq_disk_cache_lzo_compress(void *buf, size_t len, size_t *r_size_compressed)
+{
+  const size_t chunks_len = seq_disk_cache_lzo_chunks_len(len);
+  const size_t table_size = sizeof(uint32_t) * chunks_len;
+  unsigned char *compressed = MEM_mallocN(
+      table_size + chunks_len * LZO_OUT_LEN(DCACHE_LZO_CHUNK_SIZE), __func__);
+  DiskCacheLZOData data = {
+      .raw = buf,
+      .size_raw = len,
+      .compressed = compressed,
+      .chunks_size = (uint32_t *)compressed,
+      .chunks_offset = MEM_mallocN(sizeof(size_t) * chunks_len, __func__),
+  };
+  for (size_t chunk = 0; chunk < chunks_len; chunk++) {
+    data.chunks_offset[chunk] = table_size + chunk * LZO_OUT_LEN(DCACHE_LZO_CHUNK_SIZE);
+  }
+
+  TaskParallelSettings settings;
+  BLI_parallel_range_settings_defaults(&settings);
+  settings.min_iter_per_thread = 1;
+  BLI_task_parallel_range(0, chunks_len, &data, seq_disk_cache_lzo_compress_chunk, &settings);
+
+  /* Pack the chunks after each other, they only ever move towards the start of the buffer. */
+  size_t offset = table_size;
+  for (size_t chunk = 0; chunk < chunks_len; chunk++) {
+    memmove(compressed + offset, compressed + data.chunks_offset[chunk], data.chunks_size[chunk]);
+    offset += data.chunks_size[chunk];
+  }
+
+  MEM_freeN(data.chunks_offset);
+  *r_size_compressed = offset;
+  return compressed;
+}
+
+/* Decompress chunks in parallel, returns false on failure. */
+static bool seq_disk_cache_lzo_decompress(void *buf,
+                                          size_t len,
+                                          unsigned char *compressed,
+                                          size_t len_compressed,
+                                          bool switch_endian)
+{
+  const size_t chunks_len = seq_disk_cache_lzo_chunks_len(len);
+  const size_t table_size = sizeof(uint32_t) * chunks_len;
+  if (len_compressed < table_size) {
+    return false;
   }
 
-  return BLI_gzip_mem_to_file_at_pos(
-      ibuf->rect_float, header_entry->size_raw, file, header_entry->offset, level);
+  DiskCacheLZOData data = {
+      .raw = buf,
+      .size_raw = len,
+      .compressed = compressed,
+      .chunks_size = (uint32_t *)compressed,
+      .chunks_offset = MEM_mallocN(sizeof(size_t) * chunks_len, __func__),
+      .failed = false,
+  };
+  if (switch_endian) {
+    BLI_endian_switch_uint32_array(data.chunks_size, chunks_len);
+  }
+
+  size_t offset = table_size;
+  for (size_t chunk = 0; chunk < chunks_len; chunk++) {
+    data.chunks_offset[chunk] = offset;
+    offset += data.chunks_size[chunk];
+  }
+
+  if (offset == len_compressed) {
+    TaskParallelSettings settings;
+    BLI_parallel_range_settings_defaults(&settings);
+    settings.min_iter_per_thread = 1;
+    BLI_task_parallel_range(0, chunks_len, &data, seq_disk_cache_lzo_decompress_chunk, &settings);
+  }
+  else {
+    data.failed = true;
+  }
+
+  MEM_freeN(data.chunks_offset);
+  return !data.failed;
+}
+
+#endif /* WITH_LZO */
+
+static void *seq_disk_cache_zlib_compress(void *buf,
+                                          size_t len,
+                                          int level,
+                                          size_t *r_size_compressed)
+{
+  uLongf size_compressed = compressBound((uLong)len);
+  void *compressed = MEM_mallocN(size_compressed, __func__);
+  if (compress2(compressed, &size_compressed, buf, (uLong)len, level) != Z_OK) {
+    MEM_freeN(compressed);
+    return NULL;
+  }
+  *r_size_compressed = size_compressed;
+  return compressed;
 }
 
-static size_t inflate_file_to_imbuf(ImBuf *ibuf, FILE *file, DiskCacheHeaderEntry *header_entry)
+static bool seq_disk_cache_zlib_decompress(void *buf,
+                                           size_t len,
+                                           const unsigned char *compressed,
+                                           size_t len_compressed)
+{
+  uLongf size_raw = (uLongf)len;
+  return uncompress(buf, &size_raw, compressed, (uLong)len_compressed) == Z_OK &&
+         size_raw == len;
+}
+
+static void *seq_disk_cache_imbuf_data(ImBuf *ibuf)
 {
   if (ibuf->rect) {
-    return BLI_ungzip_file_to_mem_at_pos(
-        ibuf->rect, header_entry->size_raw, file, header_entry->offset);
+    return ibuf->rect;
   }
+  return ibuf->rect_float;
+}
 
-  return BLI_ungzip_file_to_mem_at_pos(
-      ibuf->rect_float, header_entry->size_raw, file, header_entry->offset);
+static size_t seq_disk_cache_imbuf_size_raw(ImBuf *ibuf)
+{
+  const size_t size = (size_t)ibuf->x * ibuf->y * ibuf->channels;
+  return ibuf->rect ? size : size * 4;
+}
+
+/* Compress image data, done without holding the disk cache lock. Returns NULL on failure. */
+static void *seq_disk_cache_compress_imbuf(ImBuf *ibuf,
+                                           int compression,
+                                           size_t *r_size_compressed)
+{
+  void *data = seq_disk_cache_imbuf_data(ibuf);
+  const size_t size_raw = seq_disk_cache_imbuf_size_raw(ibuf);
+
+#ifdef WITH_LZO
+  if (compression == DCACHE_COMPRESSION_LZO) {
+    return seq_disk_cache_lzo_compress(data, size_raw, r_size_compressed);
+  }
+#else
+  UNUSED_VARS(compression);
+#endif
+
+  return seq_disk_cache_zlib_compress(
+      data, size_raw, seq_disk_cache_compression_level(), r_size_compressed);
+}
+
+static bool seq_disk_cache_decompress_imbuf(ImBuf *ibuf,
+                                            const DiskCacheHeaderEntry *header_entry,
+                                            unsigned char *compressed)
+{
+  if (header_entry->compression == DCACHE_COMPRESSION_LZO) {
+#ifdef WITH_LZO
+    const bool switch_endian = (ENDIAN_ORDER == B_ENDIAN) != (header_entry->encoding == 255);
+    return seq_disk_cache_lzo_decompress(seq_disk_cache_imbuf_data(ibuf),
+                                         header_entry->size_raw,
+                                         compressed,
+                                         header_entry->size_compressed,
+                                         switch_endian);
+#else
+    /* Written by a build with LZO support. */
+    return false;
+#endif
+  }
+
+  return seq_disk_cache_zlib_decompress(seq_disk_cache_imbuf_data(ibuf),
+                                        header_entry->size_raw,
+                                        compressed,
+                                        header_entry->size_compressed);
 }
 
 static bool seq_disk_cache_read_header(FILE *file, DiskCacheHeader *header)
@@ -541,7 +812,10 @@ static size_t seq_disk_cache_write_header(FILE *file, DiskCacheHeader *header)
   return fwrite(header, sizeof(*header), 1, file);
 }
 
-static int seq_disk_cache_add_header_entry(SeqCacheKey *key, ImBuf *ibuf, DiskCacheHeader *header)
+static int seq_disk_cache_add_header_entry(uint64_t frame_index,
+                                           ImBuf *ibuf,
+                                           int compression,
+                                           DiskCacheHeader *header)
 {
   int i;
   uint64_t offset = sizeof(*header);
@@ -573,17 +847,17 @@ static int seq_disk_cache_add_header_entry(SeqCacheKey *key, ImBuf *ibuf, DiskCa
     header->entry[i].encoding = 0;
   }
 
+  header->entry[i].compression = compression;
   header->entry[i].offset = offset;
-  header->entry[i].frameno = key->frame_index;
+  header->entry[i].frameno = frame_index;
+  header->entry[i].size_raw = seq_disk_cache_imbuf_size_raw(ibuf);
 
   /* Store colorspace name of ibuf. */
   const char *colorspace_name;
   if (ibuf->rect) {
-    header->entry[i].size_raw = ibuf->x * ibuf->y * ibuf->channels;
     colorspace_name = IMB_colormanagement_get_rect_colorspace(ibuf);
   }
   else {
-    header->entry[i].size_raw = ibuf->x * ibuf->y * ibuf->channels * 4;
     colorspace_name = IMB_colormanagement_get_float_colorspace(ibuf);
   }
   BLI_strncpy(
@@ -603,11 +877,15 @@ static int seq_disk_cache_get_header_entry(SeqCacheKey *key, DiskCacheHeader *he
   return -1;
 }
 
-static bool seq_disk_cache_write_file(SeqDiskCache *disk_cache, SeqCacheKey *key, ImBuf *ibuf)
+/* Write compressed image data and its header entry, must be called with the disk cache lock. */
+static bool seq_disk_cache_write_file(SeqDiskCache *disk_cache,
+                                      const char *path,
+                                      uint64_t frame_index,
+                                      ImBuf *ibuf,
+                                      int compression,
+                                      const void *compressed,
+                                      size_t size_compressed)
 {
-  char path[FILE_MAX];
-
-  seq_disk_cache_get_file_path(disk_cache, key, path, sizeof(path));
   BLI_make_existing_file(path);
 
   FILE *file = BLI_fopen(path, "rb+");
@@ -629,27 +907,30 @@ static bool seq_disk_cache_write_file(SeqDiskCache *disk_cache, SeqCacheKey *key
     seq_disk_cache_delete_file(disk_cache, cache_file);
     return false;
   }
-  int entry_index = seq_disk_cache_add_header_entry(key, ibuf, &header);
-
-  size_t bytes_written = deflate_imbuf_to_file(
-      ibuf, file, seq_disk_cache_compression_level(), &header.entry[entry_index]);
+  int entry_index = seq_disk_cache_add_header_entry(frame_index, ibuf, compression, &header);
 
-  if (bytes_written != 0) {
-    /* Last step is writing header, as image data can be overwritten,
-     * but missing data would cause problems.
-     */
-    header.entry[entry_index].size_compressed = bytes_written;
-    seq_disk_cache_write_header(file, &header);
-    seq_disk_cache_update_file(disk_cache, path);
+  fseek(file, header.entry[entry_index].offset, 0);
+  if (fwrite(compressed, 1, size_compressed, file) != size_compressed) {
     fclose(file);
-
-    return true;
+    return false;
   }
 
-  return false;
+  /* Last step is writing header, as image data can be overwritten,
+   * but missing data would cause problems.
+   */
+  header.entry[entry_index].size_compressed = size_compressed;
+  seq_disk_cache_write_header(file, &header);
+  seq_disk_cache_update_file(disk_cache, path);
+  fclose(file);
+
+  return true;
 }
 
-static ImBuf *seq_disk_cache_read_file(SeqDiskCache *disk_cache, SeqCacheKey *key)
+/* Read the compressed data of an image, must be called with the disk cache lock. Returns NULL
+ * when the image is not cached. */
+static unsigned char *seq_disk_cache_read_compressed(SeqDiskCache *disk_cache,
+                                                     SeqCacheKey *key,
+                                                     DiskCacheHeaderEntry *r_header_entry)
 {
   char path[FILE_MAX];
   DiskCacheHeader header;
@@ -669,48 +950,178 @@ static ImBuf *seq_disk_cache_read_file(SeqDiskCache *disk_cache, SeqCacheKey *ke
   int entry_index = seq_disk_cache_get_header_entry(key, &header);
 
   /* Item not found. */
-  if (entry_index < 0) {
+  if (entry_index < 0 || header.entry[entry_index].size_compressed == 0) {
+    fclose(file);
+    return NULL;
+  }
+
+  *r_header_entry = header.entry[entry_index];
+  const size_t size_compressed = r_header_entry->size_compressed;
+  unsigned char *compressed = MEM_mallocN(size_compressed, __func__);
+  fseek(file, r_header_entry->offset, 0);
+  if (fread(compressed, 1, size_compressed, file) != size_compressed) {
     fclose(file);
+    MEM_freeN(compressed);
+    return NULL;
+  }
+
+  BLI_file_touch(path);
+  seq_disk_cache_update_file(disk_cache, path);
+  fclose(file);
+
+  return compressed;
+}
+
+static ImBuf *seq_disk_cache_read_file(SeqDiskCache *disk_cache, SeqCacheKey *key)
+{
+  DiskCacheHeaderEntry header_entry;
+
+  BLI_mutex_lock(&disk_cache->read_write_mutex);
+  unsigned char *compressed = seq_disk_cache_read_compressed(disk_cache, key, &header_entry);
+  BLI_mutex_unlock(&disk_cache->read_write_mutex);
+
+  if (compressed == NULL) {
     return NULL;
   }
 
   ImBuf *ibuf;
   uint64_t size_char = (uint64_t)key->context.rectx * key->context.recty * 4;
   uint64_t size_float = (uint64_t)key->context.rectx * key->context.recty * 16;
-  size_t expected_size;
 
-  if (header.entry[entry_index].size_raw == size_char) {
-    expected_size = size_char;
+  if (header_entry.size_raw == size_char) {
     ibuf = IMB_allocImBuf(key->context.rectx, key->context.recty, 32, IB_rect);
-    IMB_colormanagement_assign_rect_colorspace(ibuf, header.entry[entry_index].colorspace_name);
+    IMB_colormanagement_assign_rect_colorspace(ibuf, header_entry.colorspace_name);
   }
-  else if (header.entry[entry_index].size_raw == size_float) {
-    expected_size = size_float;
+  else if (header_entry.size_raw == size_float) {
     ibuf = IMB_allocImBuf(key->context.rectx, key->context.recty, 32, IB_rectfloat);
-    IMB_colormanagement_assign_float_colorspace(ibuf, header.entry[entry_index].colorspace_name);
+    IMB_colormanagement_assign_float_colorspace(ibuf, header_entry.colorspace_name);
   }
   else {
-    fclose(file);
+    MEM_freeN(compressed);
     return NULL;
   }
 
-  size_t bytes_read = inflate_file_to_imbuf(ibuf, file, &header.entry[entry_index]);
-
-  /* Sanity check. */
-  if (bytes_read != expected_size) {
-    fclose(file);
+  /* Decompress without the lock, so multiple threads (like the prefetch threads reading ahead)
+   * can read cached images in parallel. */
+  if (!seq_disk_cache_decompress_imbuf(ibuf, &header_entry, compressed)) {
     IMB_freeImBuf(ibuf);
-    return NULL;
+    ibuf = NULL;
   }
-  BLI_file_touch(path);
-  seq_disk_cache_update_file(disk_cache, path);
-  fclose(file);
+  MEM_freeN(compressed);
 
   return ibuf;
 }
 
+static DiskCacheWriteJob *seq_disk_cache_write_job_pop(SeqDiskCache *disk_cache)
+{
+  BLI_mutex_lock(&disk_cache->write_queue_mutex);
+  while (BLI_listbase_is_empty(&disk_cache->write_queue) && !disk_cache->stop_writer) {
+    BLI_condition_wait(&disk_cache->write_queue_cond, &disk_cache->write_queue_mutex);
+  }
+  DiskCacheWriteJob *job = BLI_pophead(&disk_cache->write_queue);
+  if (job != NULL) {
+    disk_cache->write_queue_len--;
+  }
+  BLI_mutex_unlock(&disk_cache->write_queue_mutex);
+  return job;
+}
+
+static void *seq_disk_cache_writer_thread(void *data)
+{
+  SeqDiskCache *disk_cache = data;
+  DiskCacheWriteJob *job;
+
+  while ((job = seq_disk_cache_write_job_pop(disk_cache))) {
+    /* Compress before taking the lock, so reading cached images isn't blocked meanwhile. */
+    const int compression = seq_disk_cache_compression();
+    size_t size_compressed = 0;
+    void *compressed = seq_disk_cache_compress_imbuf(job->ibuf, compression, &size_compressed);
+
+    bool written = false;
+    if (compressed != NULL) {
+      BLI_mutex_lock(&disk_cache->read_write_mutex);
+      /* Skip images which were invalidated while queued. */
+      if (job->generation == disk_cache->generation) {
+        written = seq_disk_cache_write_file(disk_cache,
+                                            job->path,
+                                            job->frame_index,
+                                            job->ibuf,
+                                            compression,
+                                            compressed,
+                                            size_compressed);
+      }
+      BLI_mutex_unlock(&disk_cache->read_write_mutex);
+      MEM_freeN(compressed);
+    }
+
+    if (written) {
+      seq_disk_cache_enforce_limits(disk_cache);
+    }
+    IMB_freeImBuf(job->ibuf);
+    MEM_freeN(job);
+  }
+
+  return NULL;
+}
+
+static void seq_disk_cache_writer_start(SeqDiskCache *disk_cache)
+{
+  BLI_mutex_init(&disk_cache->write_queue_mutex);
+  BLI_condition_init(&disk_cache->write_queue_cond);
+  BLI_threadpool_init(&disk_cache->writer_thread, seq_disk_cache_writer_thread, 1);
+  BLI_threadpool_insert(&disk_cache->writer_thread, disk_cache);
+}
+
+static void seq_disk_cache_writer_stop(SeqDiskCache *disk_cache)
+{
+  BLI_mutex_lock(&disk_cache->write_queue_mutex);
+  /* Pending images are not written, they would be invalidated by the next session anyway. */
+  LISTBASE_FOREACH_MUTABLE (DiskCacheWriteJob *, job, &disk_cache->write_queue) {
+    IMB_freeImBuf(job->ibuf);
+    MEM_freeN(job);
+  }
+  BLI_listbase_clear(&disk_cache->write_queue);
+  disk_cache->write_queue_len = 0;
+  disk_cache->stop_writer = true;
+  BLI_condition_notify_all(&disk_cache->write_queue_cond);
+  BLI_mutex_unlock(&disk_cache->write_queue_mutex);
+
+  BLI_threadpool_end(&disk_cache->writer_thread);
+  BLI_condition_end(&disk_cache->write_queue_cond);
+  BLI_mutex_end(&disk_cache->write_queue_mutex);
+}
+
+/* Queue image to be written by writer thread. Image is dropped when queue is full. */
+static void seq_disk_cache_write_file_async(SeqDiskCache *disk_cache,
+                                            SeqCacheKey *key,
+                                            ImBuf *ibuf)
+{
+  DiskCacheWriteJob *job = MEM_callocN(sizeof(*job), "DiskCacheWriteJob");
+  seq_disk_cache_get_file_path(disk_cache, key, job->path, sizeof(job->path));
+  job->frame_index = key->frame_index;
+
+  BLI_mutex_lock(&disk_cache->read_write_mutex);
+  job->generation = disk_cache->generation;
+  BLI_mutex_unlock(&disk_cache->read_write_mutex);
+
+  BLI_mutex_lock(&disk_cache->write_queue_mutex);
+  if (disk_cache->write_queue_len >= DCACHE_WRITE_QUEUE_MAX || disk_cache->stop_writer) {
+    BLI_mutex_unlock(&disk_cache->write_queue_mutex);
+    MEM_freeN(job);
+    return;
+  }
+  IMB_refImBuf(ibuf);
+  job->ibuf = ibuf;
+  BLI_addtail(&disk_cache->write_queue, job);
+  disk_cache->write_queue_len++;
+  BLI_condition_notify_one(&disk_cache->write_queue_cond);
+  BLI_mutex_unlock(&disk_cache->write_queue_mutex);
+}
+
 #undef DCACHE_FNAME_FORMAT
 #undef DCACHE_IMAGES_PER_FILE
+#undef DCACHE_WRITE_QUEUE_MAX
+#undef DCACHE_LZO_CHUNK_SIZE
 #undef COLORSPACE_NAME_MAX
 #undef DCACHE_CURRENT_VERSION
 
@@ -1101,11 +1512,8 @@ static void seq_disk_cache_create(Main *bmain, Scene *scene)
   BLI_mutex_lock(&cache_create_lock);
   SeqCache *cache = seq_cache_get_from_scene(scene);
 
-  if (cache == NULL) {
-    return;
-  }
-
-  if (cache->disk_cache != NULL) {
+  if (cache == NULL || cache->disk_cache != NULL) {
+    BLI_mutex_unlock(&cache_create_lock);
     return;
   }
 
@@ -1115,6 +1523,7 @@ static void seq_disk_cache_create(Main *bmain, Scene *scene)
   seq_disk_cache_handle_versioning(cache->disk_cache);
   seq_disk_cache_get_files(cache->disk_cache, seq_disk_cache_base_dir());
   cache->disk_cache->timestamp = scene->ed->disk_cache_timestamp;
+  seq_disk_cache_writer_start(cache->disk_cache);
   BLI_mutex_unlock(&cache_create_lock);
 }
 
@@ -1154,6 +1563,7 @@ static void seq_cache_populate_key(SeqCacheKey *key,
   key->link_next = NULL;
   key->is_temp_cache = true;
   key->task_id = context->task_id;
+  key->thread_index = context->thread_index;
 }
 
 static SeqCacheKey *seq_cache_allocate_key(SeqCache *cache,
@@ -1169,7 +1579,7 @@ static SeqCacheKey *seq_cache_allocate_key(SeqCache *cache,
 
 /* ***************************** API ****************************** */
 
-void seq_cache_free_temp_cache(Scene *scene, short id, int timeline_frame)
+void seq_cache_free_temp_cache(Scene *scene, short id, int thread_index, int timeline_frame)
 {
   SeqCache *cache = seq_cache_get_from_scene(scene);
   if (!cache) {
@@ -1184,7 +1594,7 @@ void seq_cache_free_temp_cache(Scene *scene, short id, int timeline_frame)
     SeqCacheKey *key = BLI_ghashIterator_getKey(&gh_iter);
     BLI_ghashIterator_step(&gh_iter);
 
-    if (key->is_temp_cache && key->task_id == id) {
+    if (key->is_temp_cache && key->task_id == id && key->thread_index == thread_index) {
       /* Use frame_index here to avoid freeing raw images if they are used for multiple frames. */
       float frame_index = seq_cache_timeline_frame_to_frame_index(
           key->seq, timeline_frame, key->type);
@@ -1210,6 +1620,7 @@ void seq_cache_destruct(Scene *scene)
   BLI_mutex_end(&cache->iterator_mutex);
 
   if (cache->disk_cache != NULL) {
+    seq_disk_cache_writer_stop(cache->disk_cache);
     BLI_freelistN(&cache->disk_cache->files);
     BLI_mutex_end(&cache->disk_cache->read_write_mutex);
     MEM_freeN(cache->disk_cache);
@@ -1360,9 +1771,7 @@ struct ImBuf *seq_cache_get(const SeqRenderData *context,
       seq_disk_cache_create(context->bmain, context->scene);
     }
 
-    BLI_mutex_lock(&cache->disk_cache->read_write_mutex);
     ibuf = seq_disk_cache_read_file(cache->disk_cache, &key);
-    BLI_mutex_unlock(&cache->disk_cache->read_write_mutex);
 
     if (ibuf == NULL) {
       return NULL;
@@ -1442,10 +1851,7 @@ void seq_cache_put(
         seq_disk_cache_create(context->bmain, context->scene);
       }
 
-      BLI_mutex_lock(&cache->disk_cache->read_write_mutex);
-      seq_disk_cache_write_file(cache->disk_cache, key, i);
-      BLI_mutex_unlock(&cache->disk_cache->read_write_mutex);
-      seq_disk_cache_enforce_limits(cache->disk_cache);
+      seq_disk_cache_write_file_async(cache->disk_cache, key, i);
     }
   }
 }
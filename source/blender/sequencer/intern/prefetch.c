@@ -34,6 +34,7 @@
 #include "DNA_windowmanager_types.h"
 
 #include "BLI_listbase.h"
+#include "BLI_math_base.h"
 #include "BLI_threads.h"
 
 #include "IMB_imbuf.h"
@@ -61,34 +62,51 @@
 #include "prefetch.h"
 #include "render.h"
 
+/* Maximum number of frames rendered at the same time. Each thread evaluates its own copy of the
+ * scene, so memory usage grows with thread count. */
+#define SEQ_PREFETCH_MAX_THREADS 16
+
+/* Thread rendering one frame at a time. Frames are claimed from #PrefetchJob in order, so
+ * threads render consecutive frames concurrently. */
+typedef struct PrefetchThread {
+  struct PrefetchJob *pfjob;
+
+  struct Scene *scene_eval;
+  struct Depsgraph *depsgraph;
+
+  /* context, with thread index unique to this thread */
+  struct SeqRenderData context;
+  struct SeqRenderData context_cpy;
+
+  /* frame being rendered */
+  float cfra;
+} PrefetchThread;
+
 typedef struct PrefetchJob {
   struct PrefetchJob *next, *prev;
 
   struct Main *bmain;
   struct Main *bmain_eval;
   struct Scene *scene;
-  struct Scene *scene_eval;
-  struct Depsgraph *depsgraph;
 
+  /* Protects prefetch area and control flags when used by multiple threads. */
   ThreadMutex prefetch_suspend_mutex;
   ThreadCondition prefetch_suspend_cond;
 
   ListBase threads;
+  PrefetchThread *prefetch_threads;
+  int num_threads;
 
-  /* context */
-  struct SeqRenderData context;
-  struct SeqRenderData context_cpy;
-  struct ListBase *seqbasep;
-  struct ListBase *seqbasep_cpy;
-
-  /* prefetch area */
+  /* prefetch area, frames before `cfra + num_frames_prefetched` are claimed by threads */
   float cfra;
   int num_frames_prefetched;
 
   /* control */
-  bool running;
-  bool waiting;
+  int num_threads_running;
+  int num_threads_waiting;
   bool stop;
+  /* Scene was changed since the depsgraphs of the threads were built. */
+  bool need_depsgraph_rebuild;
 } PrefetchJob;
 
 static bool seq_prefetch_is_playing(Main *bmain)
@@ -128,7 +146,7 @@ bool seq_prefetch_job_is_running(Scene *scene)
     return false;
   }
 
-  return pfjob->running;
+  return pfjob->num_threads_running > 0;
 }
 
 static bool seq_prefetch_job_is_waiting(Scene *scene)
@@ -139,7 +157,9 @@ static bool seq_prefetch_job_is_waiting(Scene *scene)
     return false;
   }
 
-  return pfjob->waiting;
+  /* Only consider job to be waiting when no thread is rendering. */
+  return pfjob->num_threads_running > 0 &&
+         pfjob->num_threads_waiting == pfjob->num_threads_running;
 }
 
 static Sequence *sequencer_prefetch_get_original_sequence(Sequence *seq, ListBase *seqbase)
@@ -171,8 +191,9 @@ Sequence *seq_prefetch_get_original_sequence(Sequence *seq, Scene *scene)
 SeqRenderData *seq_prefetch_get_original_context(const SeqRenderData *context)
 {
   PrefetchJob *pfjob = seq_prefetch_job_get(context->scene);
+  BLI_assert(context->thread_index >= 0 && context->thread_index < pfjob->num_threads);
 
-  return &pfjob->context;
+  return &pfjob->prefetch_threads[context->thread_index].context;
 }
 
 static bool seq_prefetch_is_cache_full(Scene *scene)
@@ -190,9 +211,9 @@ static float seq_prefetch_cfra(PrefetchJob *pfjob)
 {
   return pfjob->cfra + pfjob->num_frames_prefetched;
 }
-static AnimationEvalContext seq_prefetch_anim_eval_context(PrefetchJob *pfjob)
+static AnimationEvalContext seq_prefetch_anim_eval_context(PrefetchThread *thread)
 {
-  return BKE_animsys_eval_context_construct(pfjob->depsgraph, seq_prefetch_cfra(pfjob));
+  return BKE_animsys_eval_context_construct(thread->depsgraph, thread->cfra);
 }
 
 void seq_prefetch_get_time_range(Scene *scene, int *start, int *end)
@@ -203,37 +224,39 @@ void seq_prefetch_get_time_range(Scene *scene, int *start, int *end)
   *end = seq_prefetch_cfra(pfjob);
 }
 
-static void seq_prefetch_free_depsgraph(PrefetchJob *pfjob)
+static void seq_prefetch_free_depsgraph(PrefetchThread *thread)
 {
-  if (pfjob->depsgraph != NULL) {
-    DEG_graph_free(pfjob->depsgraph);
+  if (thread->depsgraph != NULL) {
+    DEG_graph_free(thread->depsgraph);
   }
-  pfjob->depsgraph = NULL;
-  pfjob->scene_eval = NULL;
+  thread->depsgraph = NULL;
+  thread->scene_eval = NULL;
 }
 
-static void seq_prefetch_update_depsgraph(PrefetchJob *pfjob)
+static void seq_prefetch_update_depsgraph(PrefetchThread *thread)
 {
-  DEG_evaluate_on_framechange(pfjob->depsgraph, seq_prefetch_cfra(pfjob));
+  DEG_evaluate_on_framechange(thread->depsgraph, thread->cfra);
 }
 
-static void seq_prefetch_init_depsgraph(PrefetchJob *pfjob)
+static void seq_prefetch_init_depsgraph(PrefetchThread *thread)
 {
+  PrefetchJob *pfjob = thread->pfjob;
   Main *bmain = pfjob->bmain_eval;
   Scene *scene = pfjob->scene;
   ViewLayer *view_layer = BKE_view_layer_default_render(scene);
 
-  pfjob->depsgraph = DEG_graph_new(bmain, scene, view_layer, DAG_EVAL_RENDER);
-  DEG_debug_name_set(pfjob->depsgraph, "SEQUENCER PREFETCH");
+  thread->depsgraph = DEG_graph_new(bmain, scene, view_layer, DAG_EVAL_RENDER);
+  DEG_debug_name_set(thread->depsgraph, "SEQUENCER PREFETCH");
 
   /* Make sure there is a correct evaluated scene pointer. */
-  DEG_graph_build_for_render_pipeline(pfjob->depsgraph);
+  DEG_graph_build_for_render_pipeline(thread->depsgraph);
 
   /* Update immediately so we have proper evaluated scene. */
-  seq_prefetch_update_depsgraph(pfjob);
+  thread->cfra = seq_prefetch_cfra(pfjob);
+  seq_prefetch_update_depsgraph(thread);
 
-  pfjob->scene_eval = DEG_get_evaluated_scene(pfjob->depsgraph);
-  pfjob->scene_eval->ed->cache_flag = 0;
+  thread->scene_eval = DEG_get_evaluated_scene(thread->depsgraph);
+  thread->scene_eval->ed->cache_flag = 0;
 }
 
 static void seq_prefetch_update_area(PrefetchJob *pfjob)
@@ -279,9 +302,10 @@ void SEQ_prefetch_stop(Scene *scene)
   }
 
   pfjob->stop = true;
+  pfjob->need_depsgraph_rebuild = true;
 
-  while (pfjob->running) {
-    BLI_condition_notify_one(&pfjob->prefetch_suspend_cond);
+  while (seq_prefetch_job_is_running(scene)) {
+    BLI_condition_notify_all(&pfjob->prefetch_suspend_cond);
   }
 }
 
@@ -290,32 +314,38 @@ static void seq_prefetch_update_context(const SeqRenderData *context)
   PrefetchJob *pfjob;
   pfjob = seq_prefetch_job_get(context->scene);
 
-  SEQ_render_new_render_data(pfjob->bmain_eval,
-                             pfjob->depsgraph,
-                             pfjob->scene_eval,
-                             context->rectx,
-                             context->recty,
-                             context->preview_render_size,
-                             false,
-                             &pfjob->context_cpy);
-  pfjob->context_cpy.is_prefetch_render = true;
-  pfjob->context_cpy.task_id = SEQ_TASK_PREFETCH_RENDER;
-
-  SEQ_render_new_render_data(pfjob->bmain,
-                             pfjob->depsgraph,
-                             pfjob->scene,
-                             context->rectx,
-                             context->recty,
-                             context->preview_render_size,
-                             false,
-                             &pfjob->context);
-  pfjob->context.is_prefetch_render = false;
-
-  /* Same ID as prefetch context, because context will be swapped, but we still
-   * want to assign this ID to cache entries created in this thread.
-   * This is to allow "temp cache" work correctly for both threads.
-   */
-  pfjob->context.task_id = SEQ_TASK_PREFETCH_RENDER;
+  for (int i = 0; i < pfjob->num_threads; i++) {
+    PrefetchThread *thread = &pfjob->prefetch_threads[i];
+
+    SEQ_render_new_render_data(pfjob->bmain_eval,
+                               thread->depsgraph,
+                               thread->scene_eval,
+                               context->rectx,
+                               context->recty,
+                               context->preview_render_size,
+                               false,
+                               &thread->context_cpy);
+    thread->context_cpy.is_prefetch_render = true;
+    thread->context_cpy.task_id = SEQ_TASK_PREFETCH_RENDER;
+    thread->context_cpy.thread_index = i;
+
+    SEQ_render_new_render_data(pfjob->bmain,
+                               thread->depsgraph,
+                               pfjob->scene,
+                               context->rectx,
+                               context->recty,
+                               context->preview_render_size,
+                               false,
+                               &thread->context);
+    thread->context.is_prefetch_render = false;
+
+    /* Same ID as prefetch context, because context will be swapped, but we still
+     * want to assign this ID to cache entries created in this thread.
+     * This is to allow "temp cache" work correctly for all threads.
+     */
+    thread->context.task_id = SEQ_TASK_PREFETCH_RENDER;
+    thread->context.thread_index = i;
+  }
 }
 
 static void seq_prefetch_update_scene(Scene *scene)
@@ -327,16 +357,19 @@ static void seq_prefetch_update_scene(Scene *scene)
   }
 
   pfjob->scene = scene;
-  seq_prefetch_free_depsgraph(pfjob);
-  seq_prefetch_init_depsgraph(pfjob);
+  for (int i = 0; i < pfjob->num_threads; i++) {
+    seq_prefetch_free_depsgraph(&pfjob->prefetch_threads[i]);
+    seq_prefetch_init_depsgraph(&pfjob->prefetch_threads[i]);
+  }
+  pfjob->need_depsgraph_rebuild = false;
 }
 
 static void seq_prefetch_resume(Scene *scene)
 {
   PrefetchJob *pfjob = seq_prefetch_job_get(scene);
 
-  if (pfjob && pfjob->waiting) {
-    BLI_condition_notify_one(&pfjob->prefetch_suspend_cond);
+  if (pfjob && pfjob->num_threads_waiting > 0) {
+    BLI_condition_notify_all(&pfjob->prefetch_suspend_cond);
   }
 }
 
@@ -349,11 +382,13 @@ void seq_prefetch_free(Scene *scene)
 
   SEQ_prefetch_stop(scene);
 
-  BLI_threadpool_remove(&pfjob->threads, pfjob);
   BLI_threadpool_end(&pfjob->threads);
   BLI_mutex_end(&pfjob->prefetch_suspend_mutex);
   BLI_condition_end(&pfjob->prefetch_suspend_cond);
-  seq_prefetch_free_depsgraph(pfjob);
+  for (int i = 0; i < pfjob->num_threads; i++) {
+    seq_prefetch_free_depsgraph(&pfjob->prefetch_threads[i]);
+  }
+  MEM_freeN(pfjob->prefetch_threads);
   BKE_main_free(pfjob->bmain_eval);
   MEM_freeN(pfjob);
   scene->ed->prefetch_job = NULL;
@@ -361,18 +396,18 @@ void seq_prefetch_free(Scene *scene)
 
 /* Skip frame if we need to render 3D scene strip. Rendering 3D scene requires main lock or setting
  * up render job that doesn't have API to do openGL renders which can be used for sequencer. */
-static bool seq_prefetch_do_skip_frame(PrefetchJob *pfjob, ListBase *seqbase)
+static bool seq_prefetch_do_skip_frame(PrefetchThread *thread, ListBase *seqbase)
 {
-  float cfra = seq_prefetch_cfra(pfjob);
+  float cfra = thread->cfra;
   Sequence *seq_arr[MAXSEQ + 1];
   int count = seq_get_shown_sequences(seqbase, cfra, 0, seq_arr);
-  SeqRenderData *ctx = &pfjob->context_cpy;
+  SeqRenderData *ctx = &thread->context_cpy;
   ImBuf *ibuf = NULL;
 
   /* Disable prefetching 3D scene strips, but check for disk cache. */
   for (int i = 0; i < count; i++) {
     if (seq_arr[i]->type == SEQ_TYPE_META &&
-        seq_prefetch_do_skip_frame(pfjob, &seq_arr[i]->seqbase)) {
+        seq_prefetch_do_skip_frame(thread, &seq_arr[i]->seqbase)) {
       return true;
     }
 
@@ -426,34 +461,60 @@ static bool seq_prefetch_do_skip_frame(PrefetchJob *pfjob, ListBase *seqbase)
 static bool seq_prefetch_need_suspend(PrefetchJob *pfjob)
 {
   return seq_prefetch_is_cache_full(pfjob->scene) || seq_prefetch_is_scrubbing(pfjob->bmain) ||
-         (seq_prefetch_cfra(pfjob) >= pfjob->scene->r.efra);
+         (seq_prefetch_cfra(pfjob) > pfjob->scene->r.efra);
 }
 
+/* Called with `prefetch_suspend_mutex` locked. */
 static void seq_prefetch_do_suspend(PrefetchJob *pfjob)
 {
-  BLI_mutex_lock(&pfjob->prefetch_suspend_mutex);
   while (seq_prefetch_need_suspend(pfjob) &&
          (pfjob->scene->ed->cache_flag & SEQ_CACHE_PREFETCH_ENABLE) && !pfjob->stop) {
-    pfjob->waiting = true;
+    pfjob->num_threads_waiting++;
     BLI_condition_wait(&pfjob->prefetch_suspend_cond, &pfjob->prefetch_suspend_mutex);
+    pfjob->num_threads_waiting--;
     seq_prefetch_update_area(pfjob);
   }
-  pfjob->waiting = false;
+}
+
+/* Claim next frame to be rendered by thread, suspending it if there is nothing to be prefetched.
+ * Returns false when thread should stop. */
+static bool seq_prefetch_claim_frame(PrefetchThread *thread)
+{
+  PrefetchJob *pfjob = thread->pfjob;
+  bool claimed = false;
+
+  BLI_mutex_lock(&pfjob->prefetch_suspend_mutex);
+  seq_prefetch_update_area(pfjob);
+  seq_prefetch_do_suspend(pfjob);
+
+  /* Avoid "collision" with main thread, but make sure to fetch at least few frames */
+  const bool collision = pfjob->num_frames_prefetched > 5 &&
+                         (seq_prefetch_cfra(pfjob) - pfjob->scene->r.cfra) < 2;
+
+  if ((pfjob->scene->ed->cache_flag & SEQ_CACHE_PREFETCH_ENABLE) && !pfjob->stop &&
+      !collision && seq_prefetch_cfra(pfjob) <= pfjob->scene->r.efra) {
+    thread->cfra = seq_prefetch_cfra(pfjob);
+    pfjob->num_frames_prefetched++;
+    claimed = true;
+  }
   BLI_mutex_unlock(&pfjob->prefetch_suspend_mutex);
+
+  return claimed;
 }
 
-static void *seq_prefetch_frames(void *job)
+static void *seq_prefetch_frames(void *data)
 {
-  PrefetchJob *pfjob = (PrefetchJob *)job;
+  PrefetchThread *thread = (PrefetchThread *)data;
+  PrefetchJob *pfjob = thread->pfjob;
 
-  while (seq_prefetch_cfra(pfjob) <= pfjob->scene->r.efra) {
-    pfjob->scene_eval->ed->prefetch_job = NULL;
+  while (seq_prefetch_claim_frame(thread)) {
+    thread->scene_eval->ed->prefetch_job = NULL;
 
-    seq_prefetch_update_depsgraph(pfjob);
-    AnimData *adt = BKE_animdata_from_id(&pfjob->context_cpy.scene->id);
-    AnimationEvalContext anim_eval_context = seq_prefetch_anim_eval_context(pfjob);
+    seq_prefetch_update_depsgraph(thread);
+    AnimData *adt = BKE_animdata_from_id(&thread->context_cpy.scene->id);
+    AnimationEvalContext anim_eval_context = seq_prefetch_anim_eval_context(thread);
     BKE_animsys_evaluate_animdata(
-        &pfjob->context_cpy.scene->id, adt, &anim_eval_context, ADT_RECALC_ALL, false);
+        &thread->context_cpy.scene->id, adt, &anim_eval_context, ADT_RECALC_ALL, false);
 
     /* This is quite hacky solution:
      * We need cross-reference original scene with copy for cache.
@@ -461,58 +522,63 @@ static void *seq_prefetch_frames(void *job)
      * Scene copy don't reference original scene. Perhaps, this could be done by depsgraph.
      * Set to NULL before return!
      */
-    pfjob->scene_eval->ed->prefetch_job = pfjob;
+    thread->scene_eval->ed->prefetch_job = pfjob;
 
     ListBase *seqbase = SEQ_active_seqbase_get(SEQ_editing_get(pfjob->scene, false));
-    if (seq_prefetch_do_skip_frame(pfjob, seqbase)) {
-      pfjob->num_frames_prefetched++;
+    if (seq_prefetch_do_skip_frame(thread, seqbase)) {
       continue;
     }
 
-    ImBuf *ibuf = SEQ_render_give_ibuf(&pfjob->context_cpy, seq_prefetch_cfra(pfjob), 0);
-    seq_cache_free_temp_cache(pfjob->scene, pfjob->context.task_id, seq_prefetch_cfra(pfjob));
+    ImBuf *ibuf = SEQ_render_give_ibuf(&thread->context_cpy, thread->cfra, 0);
+    seq_cache_free_temp_cache(
+        pfjob->scene, thread->context.task_id, thread->context.thread_index, thread->cfra);
     IMB_freeImBuf(ibuf);
-
-    /* Suspend thread if there is nothing to be prefetched. */
-    seq_prefetch_do_suspend(pfjob);
-
-    /* Avoid "collision" with main thread, but make sure to fetch at least few frames */
-    if (pfjob->num_frames_prefetched > 5 &&
-        (seq_prefetch_cfra(pfjob) - pfjob->scene->r.cfra) < 2) {
-      break;
-    }
-
-    if (!(pfjob->scene->ed->cache_flag & SEQ_CACHE_PREFETCH_ENABLE) || pfjob->stop) {
-      break;
-    }
-
-    seq_prefetch_update_area(pfjob);
-    pfjob->num_frames_prefetched++;
   }
 
-  seq_cache_free_temp_cache(pfjob->scene, pfjob->context.task_id, seq_prefetch_cfra(pfjob));
-  pfjob->running = false;
-  pfjob->scene_eval->ed->prefetch_job = NULL;
+  seq_cache_free_temp_cache(
+      pfjob->scene, thread->context.task_id, thread->context.thread_index, thread->cfra);
+  thread->scene_eval->ed->prefetch_job = NULL;
+
+  BLI_mutex_lock(&pfjob->prefetch_suspend_mutex);
+  pfjob->num_threads_running--;
+  BLI_mutex_unlock(&pfjob->prefetch_suspend_mutex);
 
   return NULL;
 }
 
+static int seq_prefetch_num_threads(void)
+{
+  return clamp_i(BLI_system_thread_count() - 1, 1, SEQ_PREFETCH_MAX_THREADS);
+}
+
 static PrefetchJob *seq_prefetch_start_ex(const SeqRenderData *context, float cfra)
 {
   PrefetchJob *pfjob = seq_prefetch_job_get(context->scene);
 
+  /* Number of threads changed, for example with the render threads setting. */
+  if (pfjob && pfjob->num_threads != seq_prefetch_num_threads()) {
+    seq_prefetch_free(context->scene);
+    pfjob = NULL;
+  }
+
   if (!pfjob) {
     if (context->scene->ed) {
       pfjob = (PrefetchJob *)MEM_callocN(sizeof(PrefetchJob), "PrefetchJob");
       context->scene->ed->prefetch_job = pfjob;
 
-      BLI_threadpool_init(&pfjob->threads, seq_prefetch_frames, 1);
+      pfjob->num_threads = seq_prefetch_num_threads();
+      pfjob->prefetch_threads = MEM_calloc_arrayN(
+          pfjob->num_threads, sizeof(PrefetchThread), "PrefetchThread");
+      BLI_threadpool_init(&pfjob->threads, seq_prefetch_frames, pfjob->num_threads);
       BLI_mutex_init(&pfjob->prefetch_suspend_mutex);
       BLI_condition_init(&pfjob->prefetch_suspend_cond);
 
       pfjob->bmain_eval = BKE_main_new();
       pfjob->scene = context->scene;
-      seq_prefetch_init_depsgraph(pfjob);
+      for (int i = 0; i < pfjob->num_threads; i++) {
+        pfjob->prefetch_threads[i].pfjob = pfjob;
+        seq_prefetch_init_depsgraph(&pfjob->prefetch_threads[i]);
+      }
     }
   }
   pfjob->bmain = context->bmain;
@@ -520,15 +586,20 @@ static PrefetchJob *seq_prefetch_start_ex(const SeqRenderData *context, float cf
   pfjob->cfra = cfra;
   pfjob->num_frames_prefetched = 1;
 
-  pfjob->waiting = false;
+  pfjob->num_threads_waiting = 0;
   pfjob->stop = false;
-  pfjob->running = true;
+  pfjob->num_threads_running = pfjob->num_threads;
 
-  seq_prefetch_update_scene(context->scene);
+  /* Building depsgraphs is expensive, only rebuild them when the scene was changed. */
+  if (pfjob->need_depsgraph_rebuild || pfjob->scene != context->scene) {
+    seq_prefetch_update_scene(context->scene);
+  }
   seq_prefetch_update_context(context);
 
-  BLI_threadpool_remove(&pfjob->threads, pfjob);
-  BLI_threadpool_insert(&pfjob->threads, pfjob);
+  for (int i = 0; i < pfjob->num_threads; i++) {
+    BLI_threadpool_remove(&pfjob->threads, &pfjob->prefetch_threads[i]);
+    BLI_threadpool_insert(&pfjob->threads, &pfjob->prefetch_threads[i]);
+  }
 
   return pfjob;
 }
@@ -86,7 +86,13 @@ static ImBuf *seq_render_strip_stack(const SeqRenderData *context,
                                      float timeline_frame,
                                      int chanshown);
 
-static ThreadMutex seq_render_mutex = BLI_MUTEX_INITIALIZER;
+/* Prefetch threads render concurrently, but not while the main thread renders. */
+static ThreadRWMutex seq_render_rwlock = BLI_RWLOCK_INITIALIZER;
+/* The lock prefers readers, so prefetch threads don't start new renders while the main thread
+ * waits for it, otherwise they could keep it from rendering indefinitely. */
+static ThreadMutex seq_render_writer_mutex = BLI_MUTEX_INITIALIZER;
+static ThreadCondition seq_render_writer_cond = PTHREAD_COND_INITIALIZER;
+static int seq_render_writers_waiting = 0;
 SequencerDrawView sequencer_view3d_fn = NULL; /* NULL in background mode */
 
 /* -------------------------------------------------------------------- */
@@ -231,6 +237,7 @@ void SEQ_render_new_render_data(Main *bmain,
   r_context->view_id = 0;
   r_context->gpu_offscreen = NULL;
   r_context->task_id = SEQ_TASK_MAIN_RENDER;
+  r_context->thread_index = 0;
   r_context->is_prefetch_render = false;
 }
 
@@ -1963,6 +1970,36 @@ static ImBuf *seq_render_strip_stack(const SeqRenderData *context,
   return out;
 }
 
+static void seq_render_lock(const SeqRenderData *context)
+{
+  if (context->is_prefetch_render) {
+    BLI_mutex_lock(&seq_render_writer_mutex);
+    while (seq_render_writers_waiting > 0) {
+      BLI_condition_wait(&seq_render_writer_cond, &seq_render_writer_mutex);
+    }
+    BLI_mutex_unlock(&seq_render_writer_mutex);
+
+    BLI_rw_mutex_lock(&seq_render_rwlock, THREAD_LOCK_READ);
+    return;
+  }
+
+  BLI_mutex_lock(&seq_render_writer_mutex);
+  seq_render_writers_waiting++;
+  BLI_mutex_unlock(&seq_render_writer_mutex);
+
+  BLI_rw_mutex_lock(&seq_render_rwlock, THREAD_LOCK_WRITE);
+
+  BLI_mutex_lock(&seq_render_writer_mutex);
+  seq_render_writers_waiting--;
+  BLI_condition_notify_all(&seq_render_writer_cond);
+  BLI_mutex_unlock(&seq_render_writer_mutex);
+}
+
+static void seq_render_unlock(void)
+{
+  BLI_rw_mutex_unlock(&seq_render_rwlock);
+}
+
 /**
  * \return The image buffer or NULL.
  *
@@ -1999,10 +2036,11 @@ ImBuf *SEQ_render_give_ibuf(const SeqRenderData *context, float timeline_frame,
     out = seq_cache_get(context, seq_arr[count - 1], timeline_frame, SEQ_CACHE_STORE_FINAL_OUT);
   }
 
-  seq_cache_free_temp_cache(context->scene, context->task_id, timeline_frame);
+  seq_cache_free_temp_cache(
+      context->scene, context->task_id, context->thread_index, timeline_frame);
 
   if (count && !out) {
-    BLI_mutex_lock(&seq_render_mutex);
+    seq_render_lock(context);
     out = seq_render_strip_stack(context, &state, seqbasep, timeline_frame, chanshown);
 
     if (context->is_prefetch_render) {
@@ -2012,7 +2050,7 @@ ImBuf *SEQ_render_give_ibuf(const SeqRenderData *context, float timeline_frame,
       seq_cache_put_if_possible(
           context, seq_arr[count - 1], timeline_frame, SEQ_CACHE_STORE_FINAL_OUT, out);
     }
-    BLI_mutex_unlock(&seq_render_mutex);
+    seq_render_unlock();
   }
 
   seq_prefetch_start(context, timeline_frame);
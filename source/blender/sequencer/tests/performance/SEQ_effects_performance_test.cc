@@ -0,0 +1,217 @@
+/* Apache License, Version 2.0 */
+
+#include "testing/testing.h"
+
+#include "MEM_guardedalloc.h"
+
+#include "BLI_math_base.h"
+#include "BLI_rand.h"
+#include "BLI_utildefines.h"
+
+#include "PIL_time.h"
+
+#include "effects_kernels.h"
+
+/* Compare kernels of blend effects on a 4K frame. */
+#define WIDTH 3840
+#define HEIGHT 2160
+#define NUM_RUN_AVERAGED 10
+
+struct EffectBuffers {
+  unsigned char *byte1, *byte2, *byte_out, *byte_ref;
+  float *float1, *float2, *float_out, *float_ref;
+};
+
+static void effect_buffers_init(EffectBuffers *buffers)
+{
+  const size_t size = (size_t)WIDTH * HEIGHT * 4;
+  RNG *rng = BLI_rng_new(0);
+
+  buffers->byte1 = (unsigned char *)MEM_mallocN(size, __func__);
+  buffers->byte2 = (unsigned char *)MEM_mallocN(size, __func__);
+  buffers->byte_out = (unsigned char *)MEM_mallocN(size, __func__);
+  buffers->byte_ref = (unsigned char *)MEM_mallocN(size, __func__);
+  buffers->float1 = (float *)MEM_mallocN(sizeof(float) * size, __func__);
+  buffers->float2 = (float *)MEM_mallocN(sizeof(float) * size, __func__);
+  buffers->float_out = (float *)MEM_mallocN(sizeof(float) * size, __func__);
+  buffers->float_ref = (float *)MEM_mallocN(sizeof(float) * size, __func__);
+
+  for (size_t i = 0; i < size; i++) {
+    buffers->byte1[i] = (unsigned char)BLI_rng_get_uint(rng);
+    buffers->byte2[i] = (unsigned char)BLI_rng_get_uint(rng);
+    /* Include fully transparent and opaque pixels, they take other code paths. */
+    buffers->float1[i] = clamp_f(BLI_rng_get_float(rng) * 1.2f - 0.1f, 0.0f, 1.0f);
+    buffers->float2[i] = clamp_f(BLI_rng_get_float(rng) * 1.2f - 0.1f, 0.0f, 1.0f);
+  }
+
+  BLI_rng_free(rng);
+}
+
+static void effect_buffers_free(EffectBuffers *buffers)
+{
+  MEM_freeN(buffers->byte1);
+  MEM_freeN(buffers->byte2);
+  MEM_freeN(buffers->byte_out);
+  MEM_freeN(buffers->byte_ref);
+  MEM_freeN(buffers->float1);
+  MEM_freeN(buffers->float2);
+  MEM_freeN(buffers->float_out);
+  MEM_freeN(buffers->float_ref);
+}
+
+static void effect_kernel_byte_run(SeqEffectKernelByte kernel,
+                                   const EffectBuffers *buffers,
+                                   unsigned char *out,
+                                   int fac)
+{
+  for (int y = 0; y < HEIGHT; y++) {
+    const size_t offset = (size_t)y * WIDTH * 4;
+    kernel(buffers->byte1 + offset, buffers->byte2 + offset, out + offset, WIDTH, fac);
+  }
+}
+
+static void effect_kernel_byte_premul_run(SeqEffectKernelBytePremul kernel,
+                                          const EffectBuffers *buffers,
+                                          unsigned char *out,
+                                          float fac)
+{
+  for (int y = 0; y < HEIGHT; y++) {
+    const size_t offset = (size_t)y * WIDTH * 4;
+    kernel(buffers->byte1 + offset, buffers->byte2 + offset, out + offset, WIDTH, fac);
+  }
+}
+
+static void effect_kernel_float_run(SeqEffectKernelFloat kernel,
+                                    const EffectBuffers *buffers,
+                                    float *out,
+                                    float fac)
+{
+  for (int y = 0; y < HEIGHT; y++) {
+    const size_t offset = (size_t)y * WIDTH * 4;
+    kernel(buffers->float1 + offset, buffers->float2 + offset, out + offset, WIDTH, fac);
+  }
+}
+
+static void effect_kernel_time_print(double time_ref, double time)
+{
+  printf("\tscalar: %.3f ms, SIMD: %.3f ms, speedup: %.2fx\n",
+         time_ref * 1000.0 / NUM_RUN_AVERAGED,
+         time * 1000.0 / NUM_RUN_AVERAGED,
+         time_ref / time);
+}
+
+static void effect_kernel_byte_test(const char *id,
+                                    SeqEffectKernelByte kernel_ref,
+                                    SeqEffectKernelByte kernel,
+                                    EffectBuffers *buffers)
+{
+  const size_t size = (size_t)WIDTH * HEIGHT * 4;
+
+  printf("\n%s:\n", id);
+  for (const int fac : {0, 100, 256}) {
+    effect_kernel_byte_run(kernel_ref, buffers, buffers->byte_ref, fac);
+    effect_kernel_byte_run(kernel, buffers, buffers->byte_out, fac);
+    EXPECT_EQ(memcmp(buffers->byte_ref, buffers->byte_out, size), 0) << "factor " << fac;
+  }
+
+  double time_start = PIL_check_seconds_timer();
+  for (int i = 0; i < NUM_RUN_AVERAGED; i++) {
+    effect_kernel_byte_run(kernel_ref, buffers, buffers->byte_out, 100);
+  }
+  const double time_ref = PIL_check_seconds_timer() - time_start;
+
+  time_start = PIL_check_seconds_timer();
+  for (int i = 0; i < NUM_RUN_AVERAGED; i++) {
+    effect_kernel_byte_run(kernel, buffers, buffers->byte_out, 100);
+  }
+  effect_kernel_time_print(time_ref, PIL_check_seconds_timer() - time_start);
+}
+
+static void effect_kernel_byte_premul_test(const char *id,
+                                           SeqEffectKernelBytePremul kernel_ref,
+                                           SeqEffectKernelBytePremul kernel,
+                                           EffectBuffers *buffers)
+{
+  const size_t size = (size_t)WIDTH * HEIGHT * 4;
+
+  printf("\n%s:\n", id);
+  for (const float fac : {0.0f, 0.4f, 1.0f}) {
+    effect_kernel_byte_premul_run(kernel_ref, buffers, buffers->byte_ref, fac);
+    effect_kernel_byte_premul_run(kernel, buffers, buffers->byte_out, fac);
+    /* Blending is done in float, rounding may differ by one. */
+    for (size_t i = 0; i < size; i++) {
+      ASSERT_NEAR(buffers->byte_ref[i], buffers->byte_out[i], 1) << "factor " << fac;
+    }
+  }
+
+  double time_start = PIL_check_seconds_timer();
+  for (int i = 0; i < NUM_RUN_AVERAGED; i++) {
+    effect_kernel_byte_premul_run(kernel_ref, buffers, buffers->byte_out, 0.4f);
+  }
+  const double time_ref = PIL_check_seconds_timer() - time_start;
+
+  time_start = PIL_check_seconds_timer();
+  for (int i = 0; i < NUM_RUN_AVERAGED; i++) {
+    effect_kernel_byte_premul_run(kernel, buffers, buffers->byte_out, 0.4f);
+  }
+  effect_kernel_time_print(time_ref, PIL_check_seconds_timer() - time_start);
+}
+
+static void effect_kernel_float_test(const char *id,
+                                     SeqEffectKernelFloat kernel_ref,
+                                     SeqEffectKernelFloat kernel,
+                                     EffectBuffers *buffers)
+{
+  const size_t size = (size_t)WIDTH * HEIGHT * 4;
+
+  printf("\n%s:\n", id);
+  for (const float fac : {0.0f, 0.4f, 1.0f}) {
+    effect_kernel_float_run(kernel_ref, buffers, buffers->float_ref, fac);
+    effect_kernel_float_run(kernel, buffers, buffers->float_out, fac);
+    for (size_t i = 0; i < size; i++) {
+      ASSERT_NEAR(buffers->float_ref[i], buffers->float_out[i], 1e-6f) << "factor " << fac;
+    }
+  }
+
+  double time_start = PIL_check_seconds_timer();
+  for (int i = 0; i < NUM_RUN_AVERAGED; i++) {
+    effect_kernel_float_run(kernel_ref, buffers, buffers->float_out, 0.4f);
+  }
+  const double time_ref = PIL_check_seconds_timer() - time_start;
+
+  time_start = PIL_check_seconds_timer();
+  for (int i = 0; i < NUM_RUN_AVERAGED; i++) {
+    effect_kernel_float_run(kernel, buffers, buffers->float_out, 0.4f);
+  }
+  effect_kernel_time_print(time_ref, PIL_check_seconds_timer() - time_start);
+}
+
+TEST(sequencer_effects, Kernels)
+{
+  const SeqEffectKernels *scalar = seq_effect_kernels_scalar_get();
+  const SeqEffectKernels *kernels = seq_effect_kernels_get();
+  EffectBuffers buffers;
+
+  printf("\n========== STARTING %s vs %s ==========\n", scalar->name, kernels->name);
+  effect_buffers_init(&buffers);
+
+  effect_kernel_byte_test("Cross byte", scalar->cross_byte, kernels->cross_byte, &buffers);
+  effect_kernel_float_test("Cross float", scalar->cross_float, kernels->cross_float, &buffers);
+  effect_kernel_byte_test("Add byte", scalar->add_byte, kernels->add_byte, &buffers);
+  effect_kernel_float_test("Add float", scalar->add_float, kernels->add_float, &buffers);
+  effect_kernel_byte_test("Subtract byte", scalar->sub_byte, kernels->sub_byte, &buffers);
+  effect_kernel_float_test("Subtract float", scalar->sub_float, kernels->sub_float, &buffers);
+  effect_kernel_byte_test("Multiply byte", scalar->mul_byte, kernels->mul_byte, &buffers);
+  effect_kernel_float_test("Multiply float", scalar->mul_float, kernels->mul_float, &buffers);
+  effect_kernel_byte_premul_test(
+      "Alpha Over byte", scalar->alphaover_byte, kernels->alphaover_byte, &buffers);
+  effect_kernel_float_test(
+      "Alpha Over float", scalar->alphaover_float, kernels->alphaover_float, &buffers);
+  effect_kernel_byte_premul_test(
+      "Alpha Under byte", scalar->alphaunder_byte, kernels->alphaunder_byte, &buffers);
+  effect_kernel_float_test(
+      "Alpha Under float", scalar->alphaunder_float, kernels->alphaunder_float, &buffers);
+
+  effect_buffers_free(&buffers);
+  printf("========== ENDED ==========\n\n");
+}
@@ -43,6 +43,7 @@
 
 #include "BLI_listbase.h"
 #include "BLI_path_util.h"
+#include "BLI_profile.h"
 #include "BLI_string.h"
 #include "BLI_task.h"
 #include "BLI_threads.h"
@@ -657,6 +658,9 @@ void WM_exit_ex(bContext *C, const bool do_python)
 
   DNA_sdna_current_free();
 
+  /* Writes the trace when enabled with `--profile-trace`. */
+  BLI_profile_exit();
+
   BLI_threadapi_exit();
   BLI_task_scheduler_exit();
 
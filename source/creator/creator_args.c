@@ -37,6 +37,7 @@
 #  include "BLI_listbase.h"
 #  include "BLI_mempool.h"
 #  include "BLI_path_util.h"
+#  include "BLI_profile.h"
 #  include "BLI_string.h"
 #  include "BLI_string_utf8.h"
 #  include "BLI_system.h"
@@ -599,6 +600,7 @@ static int arg_handle_print_help(int UNUSED(argc), const char **UNUSED(argv), vo
 #  endif
   BLI_args_print_arg_doc(ba, "--debug-all");
   BLI_args_print_arg_doc(ba, "--debug-io");
+  BLI_args_print_arg_doc(ba, "--profile-trace");
 
   printf("\n");
   BLI_args_print_arg_doc(ba, "--debug-fpe");
@@ -931,6 +933,21 @@ static int arg_handle_debug_mode_set(int UNUSED(argc), const char **UNUSED(argv)
   return 0;
 }
 
+static const char arg_handle_profile_trace_set_doc[] =
+    "<filename>\n"
+    "\tRecord timing of depsgraph evaluation, modifiers, draw cache extraction and file I/O,\n"
+    "\tthe trace is written to the file on exit, to be viewed in 'chrome://tracing' or Perfetto.";
+static int arg_handle_profile_trace_set(int argc, const char **argv, void *UNUSED(data))
+{
+  const char *arg_id = "--profile-trace";
+  if (argc > 1) {
+    BLI_profile_init(argv[1]);
+    return 1;
+  }
+  printf("\nError: '%s' no args given.\n", arg_id);
+  return 0;
+}
+
 #  ifdef WITH_FFMPEG
 static const char arg_handle_debug_mode_generic_set_doc_ffmpeg[] =
     "\n\t"
@@ -2126,6 +2143,7 @@ void main_args_setup(bContext *C, bArgs *ba)
   BLI_args_add(ba, NULL, "--debug-all", CB(arg_handle_debug_mode_all), NULL);
 
   BLI_args_add(ba, NULL, "--debug-io", CB(arg_handle_debug_mode_io), NULL);
+  BLI_args_add(ba, NULL, "--profile-trace", CB(arg_handle_profile_trace_set), NULL);
 
   BLI_args_add(ba, NULL, "--debug-fpe", CB(arg_handle_debug_fpe_set), NULL);
 
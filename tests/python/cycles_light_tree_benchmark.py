@@ -0,0 +1,235 @@
+# ##### BEGIN GPL LICENSE BLOCK #####
+#
+#  This program is free software; you can redistribute it and/or
+#  modify it under the terms of the GNU General Public License
+#  as published by the Free Software Foundation; either version 2
+#  of the License, or (at your option) any later version.
+#
+#  This program is distributed in the hope that it will be useful,
+#  but WITHOUT ANY WARRANTY; without even the implied warranty of
+#  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+#  GNU General Public License for more details.
+#
+#  You should have received a copy of the GNU General Public License
+#  along with this program; if not, write to the Free Software Foundation,
+#  Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+#
+# ##### END GPL LICENSE BLOCK #####
+
+# Compare the noise of Cycles light selection with and without the light tree
+# at equal render time, on a generated city with many emissive windows and
+# street lights. Run with
+# blender --factory-startup -b --python path/to/cycles_light_tree_benchmark.py -- [--time 30]
+#
+# Every mode is first calibrated to find how many samples fit in the time
+# budget. It is then rendered twice with different seeds, and the noise is
+# estimated from the difference of the two images.
+
+import argparse
+import math
+import os
+import sys
+import tempfile
+import time
+
+import bpy
+import numpy
+
+
+def create_argparse():
+    parser = argparse.ArgumentParser()
+    parser.add_argument("--time", type=float, default=30.0,
+                        help="Render time budget of one image, in seconds")
+    parser.add_argument("--blocks", type=int, default=10,
+                        help="Number of city blocks along each axis")
+    parser.add_argument("--floors", type=int, default=12,
+                        help="Number of floors of every building")
+    parser.add_argument("--resolution", type=int, default=480)
+    parser.add_argument("--device", default="CPU")
+    return parser
+
+
+def add_mesh_object(name, verts, faces, material):
+    mesh = bpy.data.meshes.new(name)
+    mesh.from_pydata(verts, [], faces)
+    mesh.materials.append(material)
+    mesh.update()
+    ob = bpy.data.objects.new(name, mesh)
+    bpy.context.scene.collection.objects.link(ob)
+    return ob
+
+
+def add_quad(verts, faces, corner, u, v):
+    base = len(verts)
+    verts += [corner,
+              tuple(corner[i] + u[i] for i in range(3)),
+              tuple(corner[i] + u[i] + v[i] for i in range(3)),
+              tuple(corner[i] + v[i] for i in range(3))]
+    faces.append((base, base + 1, base + 2, base + 3))
+
+
+def create_materials():
+    diffuse = bpy.data.materials.new("Facade")
+    diffuse.use_nodes = True
+    diffuse.node_tree.nodes["Principled BSDF"].inputs["Roughness"].default_value = 0.8
+
+    window = bpy.data.materials.new("Window")
+    window.use_nodes = True
+    nodes = window.node_tree.nodes
+    nodes.remove(nodes["Principled BSDF"])
+    emission = nodes.new("ShaderNodeEmission")
+    emission.inputs["Color"].default_value = (1.0, 0.8, 0.5, 1.0)
+    emission.inputs["Strength"].default_value = 5.0
+    window.node_tree.links.new(emission.outputs["Emission"],
+                               nodes["Material Output"].inputs["Surface"])
+    return diffuse, window
+
+
+def create_city(args):
+    scene = bpy.context.scene
+    for ob in list(bpy.data.objects):
+        bpy.data.objects.remove(ob)
+    scene.world.color = (0.0, 0.0, 0.0)
+
+    diffuse, window = create_materials()
+
+    block = 10.0
+    street = 4.0
+    floor = 1.0
+    size = block - street
+    windows_per_floor = 5
+
+    building_verts, building_faces = [], []
+    window_verts, window_faces = [], []
+
+    for bx in range(args.blocks):
+        for by in range(args.blocks):
+            x0 = bx * block
+            y0 = by * block
+            height = args.floors * floor
+            # Roof and four walls.
+            add_quad(building_verts, building_faces,
+                     (x0, y0, height), (size, 0.0, 0.0), (0.0, size, 0.0))
+            walls = (((x0, y0, 0.0), (size, 0.0, 0.0), (0.0, -1.0, 0.0)),
+                     ((x0 + size, y0, 0.0), (0.0, size, 0.0), (1.0, 0.0, 0.0)),
+                     ((x0 + size, y0 + size, 0.0), (-size, 0.0, 0.0), (0.0, 1.0, 0.0)),
+                     ((x0, y0 + size, 0.0), (0.0, -size, 0.0), (-1.0, 0.0, 0.0)))
+            for corner, u, normal in walls:
+                add_quad(building_verts, building_faces, corner, u, (0.0, 0.0, height))
+                # Windows float slightly in front of the wall.
+                step = 1.0 / windows_per_floor
+                for f in range(args.floors):
+                    for w in range(windows_per_floor):
+                        s = (w + 0.25) * step
+                        c = tuple(corner[i] + u[i] * s + normal[i] * 0.01 for i in range(3))
+                        c = (c[0], c[1], f * floor + 0.3)
+                        add_quad(window_verts, window_faces, c,
+                                 tuple(u[i] * step * 0.5 for i in range(3)),
+                                 (0.0, 0.0, 0.4))
+
+            # One street light at the corner of every block.
+            light = bpy.data.lights.new("StreetLight", 'POINT')
+            light.energy = 50.0
+            light.shadow_soft_size = 0.1
+            light.color = (1.0, 0.6, 0.3)
+            ob = bpy.data.objects.new("StreetLight", light)
+            ob.location = (x0 - street * 0.5, y0 - street * 0.5, 3.0)
+            scene.collection.objects.link(ob)
+
+    extent = args.blocks * block
+    add_quad(building_verts, building_faces,
+             (-street, -street, 0.0), (extent + street, 0.0, 0.0), (0.0, extent + street, 0.0))
+
+    add_mesh_object("Buildings", building_verts, building_faces, diffuse)
+    add_mesh_object("Windows", window_verts, window_faces, window)
+
+    camera = bpy.data.cameras.new("Camera")
+    camera.lens = 24.0
+    ob = bpy.data.objects.new("Camera", camera)
+    ob.location = (-street * 0.5, -street * 2.0, 2.0)
+    ob.rotation_euler = (math.radians(85.0), 0.0, math.radians(-30.0))
+    scene.collection.objects.link(ob)
+    scene.camera = ob
+
+    return len(window_faces), args.blocks * args.blocks
+
+
+def setup_render(args):
+    scene = bpy.context.scene
+    scene.render.engine = 'CYCLES'
+    scene.render.resolution_x = args.resolution
+    scene.render.resolution_y = args.resolution
+    scene.render.resolution_percentage = 100
+    scene.render.image_settings.file_format = 'OPEN_EXR'
+    scene.render.image_settings.color_depth = '32'
+
+    cscene = scene.cycles
+    cscene.device = args.device
+    cscene.progressive = 'PATH'
+    cscene.use_adaptive_sampling = False
+    cscene.use_denoising = False
+    cscene.light_sampling_threshold = 0.0
+    cscene.max_bounces = 2
+    cscene.sample_clamp_indirect = 0.0
+
+
+def render(samples, seed, filepath):
+    scene = bpy.context.scene
+    scene.cycles.samples = samples
+    scene.cycles.seed = seed
+    scene.render.filepath = filepath
+
+    start = time.perf_counter()
+    bpy.ops.render.render(write_still=True)
+    elapsed = time.perf_counter() - start
+
+    image = bpy.data.images.load(filepath)
+    pixels = numpy.empty(len(image.pixels), dtype=numpy.float32)
+    image.pixels.foreach_get(pixels)
+    bpy.data.images.remove(image)
+    return elapsed, pixels.reshape(-1, 4)[:, :3]
+
+
+def benchmark_mode(args, use_light_tree, tmpdir):
+    bpy.context.scene.cycles.use_light_tree = use_light_tree
+    name = "light_tree" if use_light_tree else "distribution"
+    filepath = os.path.join(tmpdir, name + ".exr")
+
+    # Separate the fixed cost of scene synchronization from the cost per sample.
+    calibration_samples = 16
+    time_one, _ = render(1, 0, filepath)
+    time_many, _ = render(calibration_samples, 0, filepath)
+    time_per_sample = max(time_many - time_one, 1e-6) / (calibration_samples - 1)
+    overhead = max(time_one - time_per_sample, 0.0)
+    samples = max(int((args.time - overhead) / time_per_sample), 1)
+
+    time_a, image_a = render(samples, 1, filepath)
+    time_b, image_b = render(samples, 2, filepath)
+
+    # Both images have the same expected value, so the variance of their
+    # difference is twice the variance of one image.
+    mean = float(numpy.mean((image_a + image_b) * 0.5))
+    rmse = float(numpy.sqrt(numpy.mean((image_a - image_b) ** 2) * 0.5))
+    return samples, (time_a + time_b) * 0.5, rmse / max(mean, 1e-8)
+
+
+def main():
+    argv = sys.argv[sys.argv.index("--") + 1:] if "--" in sys.argv else []
+    args = create_argparse().parse_args(argv)
+
+    num_windows, num_lamps = create_city(args)
+    setup_render(args)
+
+    print("Scene: %d emissive window triangles, %d street lights" %
+          (num_windows * 2, num_lamps))
+    print("%-14s %8s %10s %14s" % ("Mode", "Samples", "Time (s)", "Relative RMSE"))
+
+    with tempfile.TemporaryDirectory() as tmpdir:
+        for use_light_tree in (False, True):
+            samples, elapsed, noise = benchmark_mode(args, use_light_tree, tmpdir)
+            name = "Light tree" if use_light_tree else "Distribution"
+            print("%-14s %8d %10.2f %14.5f" % (name, samples, elapsed, noise))
+
+
+if __name__ == "__main__":
+    main()